@@ -79,6 +79,11 @@ extern volatile struct {
         uint8_t  cpu_mode;
         uint8_t  trace_mode;
     } sim65;
+    struct {
+        uint32_t period;
+        uint8_t  control;
+        uint8_t  status;
+    } timer;
 } peripherals;
 
 /* Values for the peripherals.counter.select field. */
@@ -93,6 +98,15 @@ extern volatile struct {
 #define SIM65_CPU_MODE_6502                  0x00
 #define SIM65_CPU_MODE_65C02                 0x01
 #define SIM65_CPU_MODE_6502X                 0x02
+#define SIM65_CPU_MODE_65816                 0x03
+
+/* Bitfield values for the peripherals.timer.control field. */
+#define TIMER_CONTROL_ENABLE                 0x01
+#define TIMER_CONTROL_PERIODIC               0x02
+#define TIMER_CONTROL_NMI                    0x04
+
+/* Bitfield values for the peripherals.timer.status field. */
+#define TIMER_STATUS_EXPIRED                 0x01
 
 /* Bitfield values for the peripherals.sim65.trace_mode field. */
 #define SIM65_TRACE_MODE_FIELD_INSTR_COUNTER   0x40
@@ -13,7 +13,9 @@
 
         .byte   $73, $69, $6D, $36, $35        ; 'sim65'
         .byte   2                              ; header version
-.if (.cpu .bitand ::CPU_ISET_6502X)
+.if (.cpu .bitand ::CPU_ISET_65816)
+        .byte   3
+.elseif (.cpu .bitand ::CPU_ISET_6502X)
         .byte   2
 .elseif (.cpu .bitand ::CPU_ISET_65C02)
         .byte   1
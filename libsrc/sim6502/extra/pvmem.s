@@ -0,0 +1,283 @@
+;
+; Paravirtualized memory and string functions for sim65.
+;
+; void* __fastcall__ memcpy (void* dest, const void* src, size_t n);
+; void* __fastcall__ memmove (void* dest, const void* src, size_t size);
+; void* __fastcall__ memset (void* ptr, int c, size_t n);
+; void* __fastcall__ __bzero (void* ptr, size_t n);
+; void __fastcall__ bzero (void* ptr, size_t n);
+; int __fastcall__ strcmp (const char* s1, const char* s2);
+; size_t __fastcall__ strlen (const char* s);
+;
+; Linking this module replaces the library functions by versions that let
+; sim65 do the work on the host. Each function first calls its hook. If sim65
+; runs the function natively, the hook returns the result with the carry
+; clear. Otherwise (sim65 --pvmem emulated), the carry is set, and the code
+; from libsrc/common runs as usual. It's copied here, since this module must
+; replace all of the library modules that export these functions.
+;
+
+        .export         _memcpy, memcpy_upwards, memcpy_getparams
+        .export         _memmove
+        .export         _memset, _bzero, ___bzero
+        .export         _strcmp
+        .export         _strlen, _strlen_ptr4
+        .import         popax, popptr1
+        .importzp       c_sp, ptr1, ptr2, ptr3, ptr4
+
+        .macpack        generic
+        .macpack        longbranch
+
+pv_strlen       := $FFEB
+pv_strcmp       := $FFEC
+pv_bzero        := $FFED
+pv_memset       := $FFEE
+pv_memmove      := $FFEF
+pv_memcpy       := $FFF0
+
+; ----------------------------------------------------------------------
+; memcpy, see libsrc/common/memcpy.s
+
+_memcpy:
+        jsr     pv_memcpy
+        bcs     memcpy_emulated
+        rts
+
+memcpy_emulated:
+        jsr     memcpy_getparams
+
+memcpy_upwards:                 ; assert Y = 0
+        ldx     ptr3+1          ; Get high byte of n
+        beq     @L2             ; Jump if zero
+
+@L1:    .repeat 2               ; Unroll this a bit to make it faster...
+        lda     (ptr1),Y        ; copy a byte
+        sta     (ptr2),Y
+        iny
+        .endrepeat
+        bne     @L1
+        inc     ptr1+1
+        inc     ptr2+1
+        dex                     ; Next 256 byte block
+        bne     @L1             ; Repeat if any
+
+@L2:                            ; assert Y = 0
+        ldx     ptr3            ; Get the low byte of n
+        beq     @done           ; something to copy
+
+@L3:    lda     (ptr1),Y        ; copy a byte
+        sta     (ptr2),Y
+        iny
+        dex
+        bne     @L3
+
+@done:  jmp     popax           ; Pop ptr and return as result
+
+memcpy_getparams:               ; IMPORTANT! Function has to leave with Y=0!
+        sta     ptr3
+        stx     ptr3+1          ; save n to ptr3
+
+        jsr     popptr1         ; save src to ptr1
+
+                                ; save dest to ptr2
+        iny                     ; Y=0 guaranteed by popptr1, we need '1' here...
+        lda     (c_sp),y
+        tax
+        stx     ptr2+1          ; save high byte of ptr2
+        dey                     ; Y = 0
+        lda     (c_sp),y        ; Get ptr2 low
+        sta     ptr2
+        rts
+
+; ----------------------------------------------------------------------
+; memmove, see libsrc/common/memmove.s
+
+_memmove:
+        jsr     pv_memmove
+        bcs     @emulated
+        rts
+
+@emulated:
+        jsr     memcpy_getparams
+
+        cmp     ptr1
+        txa
+        sbc     ptr1+1
+        jcc     memcpy_upwards  ; Branch if dest < src (upwards copy)
+
+        lda     ptr1+1
+        add     ptr3+1
+        sta     ptr1+1
+
+        lda     ptr2+1
+        add     ptr3+1
+        sta     ptr2+1
+
+        ldy     ptr3            ; count, low byte
+        bne     @entry          ; something to copy?
+        beq     @pageSizeCopy   ; here like bra...
+
+@copyByte:
+        lda     (ptr1),y
+        sta     (ptr2),y
+@entry:
+        dey
+        bne     @copyByte
+        lda     (ptr1),y        ; copy remaining byte
+        sta     (ptr2),y
+
+@pageSizeCopy:                  ; assert Y = 0
+        ldx     ptr3+1          ; number of pages
+        beq     @done           ; none? -> done
+
+@initBase:
+        dec     ptr1+1          ; adjust base...
+        dec     ptr2+1
+        dey                     ; in entry case: 0 -> FF
+@copyBytes:
+        .repeat 3               ; unroll this a bit to make it faster...
+        lda     (ptr1),y
+        sta     (ptr2),y
+        dey
+        .endrepeat
+        bne     @copyBytes
+        lda     (ptr1),y        ; Y = 0, copy last byte
+        sta     (ptr2),y
+        dex                     ; one page to copy less
+        bne     @initBase       ; still a page to copy?
+
+@done:  jmp     popax           ; Pop ptr and return as result
+
+; ----------------------------------------------------------------------
+; memset and bzero, see libsrc/common/memset.s
+
+_bzero:
+___bzero:
+        jsr     pv_bzero
+        bcs     @emulated
+        rts
+
+@emulated:
+        sta     ptr3
+        stx     ptr3+1          ; Save n
+        ldx     #0              ; Fill with zeros
+        beq     memset_common
+
+_memset:
+        jsr     pv_memset
+        bcs     @emulated
+        rts
+
+@emulated:
+        sta     ptr3            ; Save n
+        stx     ptr3+1
+        jsr     popax           ; Get c
+        tax
+
+memset_common:                  ; Fill value is in X!
+        ldy     #1
+        lda     (c_sp),y
+        sta     ptr1+1          ; save high byte of ptr
+        dey                     ; Y = 0
+        lda     (c_sp),y        ; Get ptr
+        sta     ptr1
+
+        lsr     ptr3+1          ; divide number of
+        ror     ptr3            ; bytes by two to increase
+        bcc     @evenCount      ; speed (ptr3 = ptr3/2)
+                                ; y is still 0 here
+        txa                     ; restore fill value
+        sta     (ptr1),y        ; save value and increase
+        inc     ptr1            ; dest. pointer
+        bne     @evenCount
+        inc     ptr1+1
+@evenCount:
+        lda     ptr1            ; build second pointer section
+        clc
+        adc     ptr3            ; ptr2 = ptr1 + (length/2) <- ptr3
+        sta     ptr2
+        lda     ptr1+1
+        adc     ptr3+1
+        sta     ptr2+1
+
+        txa                     ; restore fill value
+        ldx     ptr3+1          ; Get high byte of n
+        beq     @L2             ; Jump if zero
+
+@L1:    .repeat 2               ; Unroll this a bit to make it faster
+        sta     (ptr1),y        ; Set byte in lower section
+        sta     (ptr2),y        ; Set byte in upper section
+        iny
+        .endrepeat
+        bne     @L1
+        inc     ptr1+1
+        inc     ptr2+1
+        dex                     ; Next 256 byte block
+        bne     @L1             ; Repeat if any
+
+@L2:    ldy     ptr3            ; Get the low byte of n
+        beq     @leave          ; something to set? No -> leave
+
+@L3:    dey
+        sta     (ptr1),y        ; set bytes in low
+        sta     (ptr2),y        ; and high section
+        bne     @L3             ; flags still up to date from dey!
+@leave:
+        jmp     popax           ; Pop ptr and return as result
+
+; ----------------------------------------------------------------------
+; strcmp, see libsrc/common/strcmp.s
+
+_strcmp:
+        jsr     pv_strcmp
+        bcs     @emulated
+        rts
+
+@emulated:
+        sta     ptr2            ; Save s2
+        stx     ptr2+1
+        jsr     popptr1         ; Get s1
+
+@loop:  lda     (ptr1),y
+        cmp     (ptr2),y
+        bne     @L1
+        tax                     ; end of strings?
+        beq     @L3
+        iny
+        bne     @loop
+        inc     ptr1+1
+        inc     ptr2+1
+        bne     @loop
+
+@L1:    bcs     @L2
+        ldx     #$FF
+        rts
+
+@L2:    ldx     #$01
+@L3:    rts
+
+; ----------------------------------------------------------------------
+; strlen, see libsrc/common/strlen.s. strspn and strcspn expect s in ptr4
+; and the low byte of the length in Y, so the native version keeps these.
+
+_strlen:
+        sta     ptr4            ; Save s
+        stx     ptr4+1
+        jsr     pv_strlen
+        bcs     _strlen_ptr4
+        rts
+
+_strlen_ptr4:
+        ldx     #0              ; YX used as counter
+        ldy     #0
+
+@L1:    lda     (ptr4),y
+        beq     @L9
+        iny
+        bne     @L1
+        inc     ptr4+1
+        inx
+        bne     @L1
+
+@L9:    tya                     ; get low byte of counter, hi's all set
+        rts
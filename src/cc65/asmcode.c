@@ -38,6 +38,7 @@
 
 /* cc65 */
 #include "asmcode.h"
+#include "codeent.h"
 #include "codeseg.h"
 #include "dataseg.h"
 #include "segments.h"
@@ -109,6 +110,32 @@ int CodeRangeIsEmpty (const CodeMark* Start, const CodeMark* End)
 
 
 
+void MarkFrameCode (const CodeMark* Start, unsigned Flags, int SP)
+/* Mark all code after Start with the CEF_FRAME_* Flags and the stack pointer
+** SP, so the function's stack frame can later be made static or its locals
+** moved into the register bank. Nothing is done if neither is possible for
+** the current function anyway.
+*/
+{
+    unsigned I;
+    unsigned Count;
+
+    /* Nothing to do if the frame stays on the stack */
+    if (!CS->Code->StaticFrame && !CS->Code->AutoRegVars) {
+        return;
+    }
+
+    /* Mark the entries */
+    Count = CS_GetEntryCount (CS->Code);
+    for (I = Start->Pos; I < Count; ++I) {
+        CodeEntry* E = CS_GetEntry (CS->Code, I);
+        E->Flags   |= Flags;
+        E->FrameSP  = SP;
+    }
+}
+
+
+
 void WriteAsmOutput (void)
 /* Write the final assembler output to the output file */
 {
@@ -82,6 +82,13 @@ void MoveCode (const CodeMark* Start, const CodeMark* End, const CodeMark* Targe
 int CodeRangeIsEmpty (const CodeMark* Start, const CodeMark* End);
 /* Return true if the given code range is empty (no code between Start and End) */
 
+void MarkFrameCode (const CodeMark* Start, unsigned Flags, int SP);
+/* Mark all code after Start with the CEF_FRAME_* Flags and the stack pointer
+** SP, so the function's stack frame can later be made static or its locals
+** moved into the register bank. Nothing is done if neither is possible for
+** the current function anyway.
+*/
+
 void WriteAsmOutput (void);
 /* Write the final assembler output to the output file */
 
@@ -38,6 +38,7 @@
 
 /* common */
 #include "chartype.h"
+#include "thread.h"
 
 /* cc65 */
 #include "asmlabel.h"
@@ -52,7 +53,10 @@
 
 
 
-static struct SegContext* CurrentFunctionSegment;
+/* The label pool of the function. The optimizer works on several functions
+** at once, so each thread has its own.
+*/
+static THREAD_LOCAL struct SegContext* CurrentFunctionSegment;
 
 
 
@@ -92,7 +96,7 @@ const char* LocalLabelName (unsigned L)
 ** again.
 */
 {
-    static char Buf[64];
+    static THREAD_LOCAL char Buf[64];
     sprintf (Buf, "L%04X", L);
     return Buf;
 }
@@ -140,7 +144,7 @@ const char* LocalDataLabelName (unsigned L)
 ** created in static storage and overwritten when calling the function again.
 */
 {
-    static char Buf[64];
+    static THREAD_LOCAL char Buf[64];
     sprintf (Buf, "M%04X", L);
     return Buf;
 }
@@ -169,7 +173,7 @@ const char* PooledLiteralLabelName (unsigned L)
 ** created in static storage and overwritten when calling the function again.
 */
 {
-    static char Buf[64];
+    static THREAD_LOCAL char Buf[64];
     sprintf (Buf, "S%04X", L);
     return Buf;
 }
@@ -421,6 +421,12 @@ void AsmStatement (void)
     /* Prevent from translating the inline code string literal in asm */
     NoCharMap = 1;
 
+    /* The inline code may access the stack frame in any way, so it must
+    ** stay on the stack.
+    */
+    CS->Code->StaticFrame = 0;
+    CS->Code->AutoRegVars = 0;
+
     /* Skip the ASM */
     NextToken ();
 
@@ -195,7 +195,7 @@ void DoIncDecBitField (ExprDesc* Expr, long Val, unsigned KeepResult)
     ** the pushed address. Reload that address.
     */
     if (ED_IsLocPrimaryOrExpr (Expr)) {
-        g_getlocal (CF_PTR, AddrSP);
+        g_getlocal (CF_PTR | CF_TEMP, AddrSP);
     }
 
     /* Load the whole data chunk containing the bits to be changed */
@@ -425,7 +425,7 @@ static void OpAssignBitField (const GenDesc* Gen, ExprDesc* Expr, const char* Op
     ** the pushed address. Reload that address.
     */
     if (ED_IsLocPrimaryOrExpr (Expr)) {
-        g_getlocal (CF_PTR, AddrSP);
+        g_getlocal (CF_PTR | CF_TEMP, AddrSP);
     }
 
     /* Load the whole data chunk containing the bits to be changed */
@@ -0,0 +1,295 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 codearg.c                                 */
+/*                                                                           */
+/*                     Interned arguments of code entries                    */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#include <string.h>
+
+/* common */
+#include "chartype.h"
+#include "check.h"
+#include "hashfunc.h"
+#include "strbuf.h"
+#include "thread.h"
+#include "xmalloc.h"
+
+/* cc65 */
+#include "codearg.h"
+#include "codeent.h"
+
+
+
+/*****************************************************************************/
+/*                                 Forwards                                  */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key);
+/* Generate the hash over a key. */
+
+static const void* HT_GetKey (const void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the key */
+
+static int HT_Compare (const void* Key1, const void* Key2);
+/* Compare two keys. The function must return a value less than zero if
+** Key1 is smaller than Key2, zero if both are equal, and a value greater
+** than zero if Key1 is greater then Key2.
+*/
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Names of the predefined arguments. Must be kept in sync with argid_t */
+static const char* const ArgNames[ARG_COUNT] = {
+    "",
+    "addeqysp",
+    "aslax1",
+    "bcastax",
+    "bnega",
+    "bnegax",
+    "booleq",
+    "boolne",
+    "c_sp",
+    "c_sp+1",
+    "complax",
+    "incaxy",
+    "incsp1",
+    "incsp2",
+    "incsp3",
+    "incsp4",
+    "incsp5",
+    "incsp6",
+    "incsp7",
+    "incsp8",
+    "ldaidx",
+    "ldauidx",
+    "ldax0sp",
+    "ldaxi",
+    "ldaxidx",
+    "ldaxysp",
+    "negax",
+    "popax",
+    "ptr1",
+    "ptr1+1",
+    "pusha",
+    "pusha0",
+    "pushax",
+    "pusheax",
+    "regsave",
+    "regsave+1",
+    "shlax1",
+    "sreg",
+    "sreg+1",
+    "staspidx",
+    "stax0sp",
+    "staxysp",
+    "steaxysp",
+    "tmp1",
+    "tosaddax",
+    "tosandax",
+    "tosaslax",
+    "tosorax",
+    "tosshlax",
+    "tosshrax",
+};
+
+/* Hash table functions */
+static const HashFunctions HashFunc = {
+    HT_GenHash,
+    HT_GetKey,
+    HT_Compare
+};
+
+/* The pool of all arguments. Access is protected by the global lock */
+static HashTable ArgTab = STATIC_HASHTABLE_INITIALIZER (16381, &HashFunc);
+
+/* Number of arguments in the pool, used as the id for the next one */
+static unsigned ArgCount = 0;
+
+/* Each thread remembers the arguments it has seen, so it needs the lock only
+** for arguments that are new to the thread. Arguments are never removed from
+** the pool, so the entries stay valid.
+*/
+#define ARG_CACHE_SIZE  4096U
+static THREAD_LOCAL const CodeArg* ArgCache[ARG_CACHE_SIZE];
+
+
+
+/*****************************************************************************/
+/*                           Hash table functions                            */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key)
+/* Generate the hash over a key. */
+{
+    return HashStr (Key);
+}
+
+
+
+static const void* HT_GetKey (const void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the index */
+{
+    return ((const CodeArg*) Entry)->Str;
+}
+
+
+
+static int HT_Compare (const void* Key1, const void* Key2)
+/* Compare two keys. The function must return a value less than zero if
+** Key1 is smaller than Key2, zero if both are equal, and a value greater
+** than zero if Key1 is greater then Key2.
+*/
+{
+    return strcmp (Key1, Key2);
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+static CodeArg* NewCodeArg (const char* Str)
+/* Create a new argument for the given string and precompute everything we
+** know about it.
+*/
+{
+    StrBuf B = AUTO_STRBUF_INITIALIZER;
+
+    /* Allocate memory */
+    size_t Len = strlen (Str);
+    CodeArg* A = xmalloc (sizeof (CodeArg) + Len);
+
+    /* Initialize the fields */
+    InitHashNode (&A->Node);
+    A->Id        = ArgCount++;
+    memcpy (A->Str, Str, Len + 1);
+
+    /* Parse the string */
+    A->Parsed = ParseOpcArgStr (Str, &A->Info, &B, &A->Off);
+    if (A->Parsed) {
+        A->Base = SB_GetBuf (&B);
+    } else {
+        A->Base = "";
+        SB_Done (&B);
+    }
+
+    /* Zero page locations */
+    A->ZP = GetZPInfo (Str);
+
+    /* Calls to numeric addresses and to runtime functions do not depend on
+    ** the symbol table, so the info can be determined here.
+    */
+    if (IsDigit (Str[0]) || Str[0] == '$') {
+        A->FuncCls = GetFuncInfo (Str, &A->FuncUse, &A->FuncChg);
+    } else if (GetRuntimeFuncInfo (Str, &A->FuncUse, &A->FuncChg)) {
+        A->FuncCls = FNCLS_BUILTIN;
+    } else {
+        A->FuncCls = FNCLS_UNKNOWN;
+    }
+
+    /* Return the new argument */
+    return A;
+}
+
+
+
+void InitCodeArgs (void)
+/* Create the predefined arguments. Must be called before any code entry is
+** created.
+*/
+{
+    unsigned I;
+    for (I = 0; I < ARG_COUNT; ++I) {
+        CHECK (GetCodeArg (ArgNames[I])->Id == I);
+    }
+}
+
+
+
+const CodeArg* GetCodeArg (const char* Str)
+/* Return the argument for the given string, adding it to the pool if it is
+** not already there. A NULL pointer is the same as an empty string. The
+** function may be called from several threads at once.
+*/
+{
+    unsigned Hash;
+    CodeArg* A;
+    const CodeArg** Cached;
+
+    if (Str == 0) {
+        Str = "";
+    }
+    Hash = HashStr (Str);
+
+    /* Try the arguments seen by this thread first */
+    Cached = &ArgCache[Hash % ARG_CACHE_SIZE];
+    if (*Cached && (*Cached)->Node.Hash == Hash &&
+        strcmp ((*Cached)->Str, Str) == 0) {
+        return *Cached;
+    }
+
+    ThreadLock ();
+    A = (CodeArg*) HT_FindHash (&ArgTab, Str, Hash);
+    if (A == 0) {
+        A = NewCodeArg (Str);
+        HT_Insert (&ArgTab, A);
+    }
+    ThreadUnlock ();
+
+    *Cached = A;
+    return A;
+}
+
+
+
+fncls_t GetArgFuncInfo (const CodeArg* A, unsigned* Use, unsigned* Chg)
+/* Like GetFuncInfo, but use the information cached in the argument if the
+** function is a runtime function or a numeric address.
+*/
+{
+    if (A->FuncCls == FNCLS_UNKNOWN) {
+        return GetFuncInfo (A->Str, Use, Chg);
+    }
+    *Use = A->FuncUse;
+    *Chg = A->FuncChg;
+    return (fncls_t) A->FuncCls;
+}
@@ -0,0 +1,158 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 codearg.h                                 */
+/*                                                                           */
+/*                     Interned arguments of code entries                    */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#ifndef CODEARG_H
+#define CODEARG_H
+
+
+
+/* common */
+#include "hashtab.h"
+
+/* cc65 */
+#include "codeinfo.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Ids of the arguments the optimizer checks for. All other arguments get
+** ids starting with ARG_COUNT in the order they are first seen. Must be kept
+** in sync with the name table in codearg.c.
+*/
+typedef enum {
+    ARG_EMPTY,                  /* "" */
+    ARG_ADDEQYSP,
+    ARG_ASLAX1,
+    ARG_BCASTAX,
+    ARG_BNEGA,
+    ARG_BNEGAX,
+    ARG_BOOLEQ,
+    ARG_BOOLNE,
+    ARG_C_SP,
+    ARG_C_SP_1,                 /* "c_sp+1" */
+    ARG_COMPLAX,
+    ARG_INCAXY,
+    ARG_INCSP1,
+    ARG_INCSP2,
+    ARG_INCSP3,
+    ARG_INCSP4,
+    ARG_INCSP5,
+    ARG_INCSP6,
+    ARG_INCSP7,
+    ARG_INCSP8,
+    ARG_LDAIDX,
+    ARG_LDAUIDX,
+    ARG_LDAX0SP,
+    ARG_LDAXI,
+    ARG_LDAXIDX,
+    ARG_LDAXYSP,
+    ARG_NEGAX,
+    ARG_POPAX,
+    ARG_PTR1,
+    ARG_PTR1_1,                 /* "ptr1+1" */
+    ARG_PUSHA,
+    ARG_PUSHA0,
+    ARG_PUSHAX,
+    ARG_PUSHEAX,
+    ARG_REGSAVE,
+    ARG_REGSAVE_1,              /* "regsave+1" */
+    ARG_SHLAX1,
+    ARG_SREG,
+    ARG_SREG_1,                 /* "sreg+1" */
+    ARG_STASPIDX,
+    ARG_STAX0SP,
+    ARG_STAXYSP,
+    ARG_STEAXYSP,
+    ARG_TMP1,
+    ARG_TOSADDAX,
+    ARG_TOSANDAX,
+    ARG_TOSASLAX,
+    ARG_TOSORAX,
+    ARG_TOSSHLAX,
+    ARG_TOSSHRAX,
+    ARG_COUNT                   /* Number of predefined arguments */
+} argid_t;
+
+/* An argument string. Each distinct string exists only once per compile,
+** so two arguments are equal if the pointers are equal. Everything that can
+** be derived from the string alone is computed once when the string is
+** entered into the pool.
+*/
+typedef struct CodeArg CodeArg;
+struct CodeArg {
+    HashNode        Node;       /* Node for the hash table */
+    unsigned        Id;         /* Id of the argument */
+    const ZPInfo*   ZP;         /* Zero page info if any */
+    const char*     Base;       /* Base name from ParseOpcArgStr */
+    long            Off;        /* Offset from ParseOpcArgStr */
+    unsigned short  Info;       /* Argument info from ParseOpcArgStr */
+    unsigned char   Parsed;     /* True if ParseOpcArgStr succeeded */
+    signed char     FuncCls;    /* Function class if the info is static */
+    unsigned        FuncUse;    /* Registers used by the function */
+    unsigned        FuncChg;    /* Registers changed by the function */
+    char            Str[1];     /* The string, dynamically allocated */
+};
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void InitCodeArgs (void);
+/* Create the predefined arguments. Must be called before any code entry is
+** created.
+*/
+
+const CodeArg* GetCodeArg (const char* Str);
+/* Return the argument for the given string, adding it to the pool if it is
+** not already there. A NULL pointer is the same as an empty string. The
+** function may be called from several threads at once.
+*/
+
+fncls_t GetArgFuncInfo (const CodeArg* A, unsigned* Use, unsigned* Chg);
+/* Like GetFuncInfo, but use the information cached in the argument if the
+** function is a runtime function or a numeric address.
+*/
+
+
+
+/* End of codearg.h */
+
+#endif
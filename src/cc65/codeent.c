@@ -41,6 +41,7 @@
 #include "chartype.h"
 #include "check.h"
 #include "debugflag.h"
+#include "thread.h"
 #include "xmalloc.h"
 #include "xsprintf.h"
 
@@ -58,57 +59,12 @@
 
 
 
-/*****************************************************************************/
-/*                                   Data                                    */
-/*****************************************************************************/
-
-
-
-/* Empty argument */
-static char EmptyArg[] = "";
-
-
-
 /*****************************************************************************/
 /*                             Helper functions                              */
 /*****************************************************************************/
 
 
 
-static void FreeArg (char* Arg)
-/* Free a code entry argument */
-{
-    if (Arg != EmptyArg) {
-        xfree (Arg);
-    }
-}
-
-
-
-static char* GetArgCopy (const char* Arg)
-/* Create an argument copy for assignment */
-{
-    if (Arg && Arg[0] != '\0') {
-        /* Create a copy */
-        return xstrdup (Arg);
-    } else {
-        /* Use the empty argument string */
-        return EmptyArg;
-    }
-}
-
-
-
-static void FreeParsedArg (char* ArgBase)
-/* Free a code entry parsed argument */
-{
-    if (ArgBase != 0 && ArgBase != EmptyArg) {
-        xfree (ArgBase);
-    }
-}
-
-
-
 static void SetUseChgInfo (CodeEntry* E, const OPCDesc* D)
 /* Set the Use and Chg in E */
 {
@@ -120,7 +76,7 @@ static void SetUseChgInfo (CodeEntry* E, const OPCDesc* D)
     */
     if ((E->Info & (OF_UBRA | OF_CALL)) != 0 && E->JumpTo == 0) {
         /* A subroutine call or jump to external symbol (function exit) */
-        GetFuncInfo (E->Arg, &E->Use, &E->Chg);
+        GetArgFuncInfo (E->ArgDesc, &E->Use, &E->Chg);
     } else {
         /* Some other instruction. Use the values from the opcode description
         ** plus addressing mode info.
@@ -146,7 +102,7 @@ static void SetUseChgInfo (CodeEntry* E, const OPCDesc* D)
             case AM65_ZPX:
             case AM65_ABSX:
             case AM65_ABSY:
-                Info = GetZPInfo (E->Arg);
+                Info = E->ArgDesc->ZP;
                 if (Info && Info->ByteUse != REG_NONE) {
                     if (E->OPC == OP65_ASL || E->OPC == OP65_DEC ||
                         E->OPC == OP65_INC || E->OPC == OP65_LSR ||
@@ -168,7 +124,7 @@ static void SetUseChgInfo (CodeEntry* E, const OPCDesc* D)
             case AM65_ZPX_IND:
             case AM65_ZP_INDY:
             case AM65_ZP_IND:
-                Info = GetZPInfo (E->Arg);
+                Info = E->ArgDesc->ZP;
                 if (Info && Info->ByteUse != REG_NONE) {
                     /* These addressing modes will never change the zp loc */
                     E->Use |= Info->WordUse;
@@ -575,11 +531,11 @@ const char* MakeHexArg (unsigned Num)
 /* Convert Num into a string in the form $XY, suitable for passing it as an
 ** argument to NewCodeEntry, and return a pointer to the string.
 ** BEWARE: The function returns a pointer to a static buffer, so the value is
-** gone if you call it twice (and apart from that it's not thread and signal
-** safe).
+** gone if you call it twice (and apart from that it's not signal safe). Each
+** thread has its own buffer.
 */
 {
-    static char Buf[16];
+    static THREAD_LOCAL char Buf[16];
     xsprintf (Buf, sizeof (Buf), "$%02X", (unsigned char) Num);
     return Buf;
 }
@@ -587,14 +543,17 @@ const char* MakeHexArg (unsigned Num)
 
 
 void PreparseArg (CodeEntry* E)
-/* Parse the argument string and memorize the result for the code entry */
+/* Memorize the parsed argument string for the code entry. The argument has
+** already been parsed when it was added to the argument pool.
+*/
 {
-    StrBuf B = AUTO_STRBUF_INITIALIZER;
+    const CodeArg* A = E->ArgDesc;
 
-    /* Parse the argument string */
-    if (ParseOpcArgStr (E->Arg, &E->ArgInfo, &B, &E->ArgOff)) {
-        E->ArgBase = SB_GetBuf (&B);
+    E->ArgInfo = A->Info;
+    E->ArgOff  = A->Off;
+    E->ArgBase = A->Base;
 
+    if (A->Parsed) {
         if ((E->ArgInfo & (AIF_HAS_NAME | AIF_HAS_OFFSET)) == AIF_HAS_OFFSET) {
             E->Flags |= CEF_NUMARG;
 
@@ -604,8 +563,6 @@ void PreparseArg (CodeEntry* E)
 
     } else {
         /* Parsing fails. Issue an error/warning so that this could be spotted and fixed. */
-        E->ArgBase = EmptyArg;
-        SB_Done (&B);
         if (Debug) {
             Warning ("Parsing argument \"%s\" failed!", E->Arg);
         }
@@ -628,17 +585,20 @@ CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
     E->OPC      = D->OPC;
     E->AM       = AM;
     E->Size     = GetInsnSize (E->OPC, E->AM);
-    E->Arg      = GetArgCopy (Arg);
+    E->ArgDesc  = GetCodeArg (Arg);
+    E->Arg      = E->ArgDesc->Str;
     E->Flags    = 0;
     E->Info     = D->Info;
     E->ArgInfo  = 0;
     E->JumpTo   = JumpTo;
     E->LI       = UseLineInfo (LI);
     E->RI       = 0;
+    E->FrameSP  = 0;
+    E->Table    = 0;
 
     /* Parse the argument string if it's given */
     if (Arg == 0 || Arg[0] == '\0') {
-        E->ArgBase = EmptyArg;
+        E->ArgBase = E->Arg;
     } else {
         PreparseArg (E);
     }
@@ -660,12 +620,6 @@ CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
 void FreeCodeEntry (CodeEntry* E)
 /* Free the given code entry */
 {
-    /* Free the argument base string if we have one */
-    FreeParsedArg (E->ArgBase);
-
-    /* Free the string argument if we have one */
-    FreeArg (E->Arg);
-
     /* Cleanup the collection */
     DoneCollection (&E->Labels);
 
@@ -701,7 +655,7 @@ void CE_ReplaceOPC (CodeEntry* E, opc_t OPC)
 int CodeEntriesAreEqual (const CodeEntry* E1, const CodeEntry* E2)
 /* Check if both code entries are equal */
 {
-    return (E1->OPC == E2->OPC && E1->AM == E2->AM && strcmp (E1->Arg, E2->Arg) == 0);
+    return (E1->OPC == E2->OPC && E1->AM == E2->AM && E1->ArgDesc == E2->ArgDesc);
 }
 
 
@@ -749,14 +703,9 @@ void CE_MoveLabel (CodeLabel* L, CodeEntry* E)
 void CE_SetArg (CodeEntry* E, const char* Arg)
 /* Replace the whole argument by the new one. */
 {
-    /* Free the old parsed argument base */
-    FreeParsedArg (E->ArgBase);
-
-    /* Free the old argument */
-    FreeArg (E->Arg);
-
     /* Assign the new one */
-    E->Arg = GetArgCopy (Arg);
+    E->ArgDesc = GetCodeArg (Arg);
+    E->Arg     = E->ArgDesc->Str;
 
     /* Parse the new argument string */
     PreparseArg (E);
@@ -823,7 +772,7 @@ void CE_SetArgBaseAndOff (CodeEntry* E, const char* ArgBase, long ArgOff)
             CE_SetNumArg (E, ArgOff);
         } else {
             /* Empty argument */
-            CE_SetArg (E, EmptyArg);
+            CE_SetArg (E, "");
         }
     }
 }
@@ -1745,7 +1694,7 @@ void CE_GenRegInfo (CodeEntry* E, RegContents* InputRegs)
             Out->ZNRegs = ZNREG_NONE;
 
             /* Get the code info for the function */
-            GetFuncInfo (E->Arg, &Use, &Chg);
+            GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
             if (Chg & REG_A) {
                 Out->RegA = UNKNOWN_REGVAL;
             }
@@ -1774,7 +1723,7 @@ void CE_GenRegInfo (CodeEntry* E, RegContents* InputRegs)
             Out->PFlags |= ((Chg & PSTATE_ALL) >> PSTATE_BITS_SHIFT) * 0x0101U;
 
             /* ## FIXME: Quick hack for some known functions: */
-            if (strcmp (E->Arg, "complax") == 0) {
+            if (CE_IsArg (E, ARG_COMPLAX)) {
                 if (RegValIsKnown (In->RegA)) {
                     Out->RegA = (In->RegA ^ 0xFF);
                 }
@@ -1788,34 +1737,34 @@ void CE_GenRegInfo (CodeEntry* E, RegContents* InputRegs)
                         Out->RegX = In->RegX;
                     }
                 }
-            } else if (strcmp (E->Arg, "tosandax") == 0) {
+            } else if (CE_IsArg (E, ARG_TOSANDAX)) {
                 if (RegValIsKnown (In->RegA) && In->RegA == 0) {
                     Out->RegA = 0;
                 }
                 if (RegValIsKnown (In->RegX) && In->RegX == 0) {
                     Out->RegX = 0;
                 }
-            } else if (strcmp (E->Arg, "tosaslax") == 0) {
+            } else if (CE_IsArg (E, ARG_TOSASLAX)) {
                 if (RegValIsKnown (In->RegA) && (In->RegA & 0x0F) >= 8) {
                     Out->RegA = 0;
                 }
-            } else if (strcmp (E->Arg, "tosorax") == 0) {
+            } else if (CE_IsArg (E, ARG_TOSORAX)) {
                 if (RegValIsKnown (In->RegA) && In->RegA == 0xFF) {
                     Out->RegA = 0xFF;
                 }
                 if (RegValIsKnown (In->RegX) && In->RegX == 0xFF) {
                     Out->RegX = 0xFF;
                 }
-            } else if (strcmp (E->Arg, "tosshlax") == 0) {
+            } else if (CE_IsArg (E, ARG_TOSSHLAX)) {
                 if (RegValIsKnown (In->RegA) && (In->RegA & 0x0F) >= 8) {
                     Out->RegA = 0;
                 }
-            } else if (strcmp (E->Arg, "tosshrax") == 0) {
+            } else if (CE_IsArg (E, ARG_TOSSHRAX)) {
                 if (RegValIsKnown (In->RegA) && (In->RegA & 0x0F) >= 8) {
                     Out->RegX = 0;
                 }
-            } else if (strcmp (E->Arg, "bcastax") == 0     ||
-                       strcmp (E->Arg, "bnegax") == 0      ||
+            } else if (CE_IsArg (E, ARG_BCASTAX)     ||
+                       CE_IsArg (E, ARG_BNEGAX)      ||
                        FindBoolCmpCond (E->Arg) != CMP_INV ||
                        FindTosCmpCond (E->Arg) != CMP_INV) {
                 /* Result is boolean value, so X is zero on output */
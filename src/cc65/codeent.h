@@ -44,6 +44,7 @@
 #include "coll.h"
 
 /* cc65 */
+#include "codearg.h"
 #include "codelab.h"
 #include "lineinfo.h"
 #include "opcodes.h"
@@ -61,6 +62,14 @@
 #define CEF_USERMARK    0x0001U         /* Generic mark by user functions */
 #define CEF_NUMARG      0x0002U         /* Insn has numerical argument */
 #define CEF_DONT_REMOVE 0x0004U         /* Insn shouldn't be removed, marked by user functions */
+#define CEF_JUMPTABLE   0x0008U         /* Insn jumps through a table, see CS_AddJumpTable */
+#define CEF_FRAME_ACCESS 0x0010U        /* Insn accesses the stack frame */
+#define CEF_FRAME_PUSH  0x0020U         /* Insn pushes a local onto the stack */
+#define CEF_FRAME_ADJUST 0x0040U        /* Insn allocates or drops frame space */
+#define CEF_FRAME_MASK  (CEF_FRAME_ACCESS | CEF_FRAME_PUSH | CEF_FRAME_ADJUST)
+
+/* Forward for the jump table in codeseg.h */
+struct JumpTable;
 
 /* Code entry structure */
 typedef struct CodeEntry CodeEntry;
@@ -69,7 +78,8 @@ struct CodeEntry {
     unsigned char       AM;             /* Adressing mode */
     unsigned char       Size;           /* Estimated size */
     unsigned char       Flags;          /* Flags */
-    char*               Arg;            /* Argument as string */
+    const char*         Arg;            /* Argument as string */
+    const CodeArg*      ArgDesc;        /* Argument from the pool */
     unsigned long       Num;            /* Numeric argument */
     unsigned short      Info;           /* Additional code info */
     unsigned short      ArgInfo;        /* Additional argument info */
@@ -79,8 +89,10 @@ struct CodeEntry {
     Collection          Labels;         /* Labels for this instruction */
     LineInfo*           LI;             /* Source line info for this insn */
     RegInfo*            RI;             /* Register info for this insn */
-    char*               ArgBase;        /* Argument broken into a base and an offset, */
+    const char*         ArgBase;        /* Argument broken into a base and an offset, */
     long                ArgOff;         /* only done when requested. */
+    int                 FrameSP;        /* Stack pointer for CEF_FRAME_* */
+    struct JumpTable*   Table;          /* Table for CEF_JUMPTABLE */
 };
 
 /* */
@@ -123,7 +135,9 @@ const char* MakeHexArg (unsigned Num);
 */
 
 void PreparseArg (CodeEntry* E);
-/* Parse the argument string and memorize the result for the code entry */
+/* Memorize the parsed argument string for the code entry. The argument has
+** already been parsed when it was added to the argument pool.
+*/
 
 CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
                          CodeLabel* JumpTo, LineInfo* LI);
@@ -238,16 +252,22 @@ int CE_IsKnownImm (const CodeEntry* E, unsigned long Num);
 ** equal to Num.
 */
 
-static inline int CE_IsCallTo (const CodeEntry* E, const char* Name)
+static inline int CE_IsArg (const CodeEntry* E, argid_t Id)
+/* Check if the argument of E is the given predefined argument */
+{
+    return (E->ArgDesc->Id == (unsigned) Id);
+}
+
+static inline int CE_IsCallTo (const CodeEntry* E, argid_t Id)
 /* Check if this is a call to the given function */
 {
-    return (E->OPC == OP65_JSR && strcmp (E->Arg, Name) == 0);
+    return (E->OPC == OP65_JSR && CE_IsArg (E, Id));
 }
 
-static inline int CE_IsJumpTo (const CodeEntry* E, const char* Name)
+static inline int CE_IsJumpTo (const CodeEntry* E, argid_t Id)
 /* Check if this is a jump to the given function */
 {
-    return (E->OPC == OP65_JMP && strcmp (E->Arg, Name) == 0);
+    return (E->OPC == OP65_JMP && CE_IsArg (E, Id));
 }
 
 int CE_UseLoadFlags (CodeEntry* E);
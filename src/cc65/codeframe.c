@@ -0,0 +1,994 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                codeframe.c                                */
+/*                                                                           */
+/*           Static stack frames for functions that are not recursive        */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <string.h>
+
+/* common */
+#include "chartype.h"
+#include "coll.h"
+#include "strbuf.h"
+#include "xmalloc.h"
+#include "xsprintf.h"
+
+/* cc65 */
+#include "asmlabel.h"
+#include "codeent.h"
+#include "codeframe.h"
+#include "codeinfo.h"
+#include "codeseg.h"
+#include "dataseg.h"
+#include "datatype.h"
+#include "funcdesc.h"
+#include "ident.h"
+#include "reginfo.h"
+#include "segments.h"
+#include "symentry.h"
+#include "symtab.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* A function defined in this translation unit */
+typedef struct FrameFunc FrameFunc;
+struct FrameFunc {
+    SymEntry*       Func;               /* The function */
+    SegContext*     Seg;                /* Its segments */
+    Collection      Callees;            /* Functions called directly */
+    unsigned        Index;              /* Index in the sorted list */
+    const char*     Label;              /* Label of the frame area */
+    int             MinOffs;            /* Lowest offset used by the frame */
+    unsigned        ParamSize;          /* Size of the parameters */
+    unsigned        FastSize;           /* Size of the fastcall parameter */
+    unsigned        Size;               /* Size of the frame */
+    unsigned        Base;               /* Offset of the frame in the area */
+    unsigned char   Entry;              /* May be called from outside */
+    unsigned char   AddrTaken;          /* Address is used as data */
+    unsigned char   CallsExt;           /* Calls code outside of the unit */
+    unsigned char   Convert;            /* Frame is made static */
+};
+
+/* Inserts the replacement code for an instruction */
+typedef struct FrameEmitter FrameEmitter;
+struct FrameEmitter {
+    const FrameFunc*    F;              /* The function */
+    CodeSeg*            S;              /* Its code */
+    unsigned            Pos;            /* Insert position */
+    LineInfo*           LI;             /* Line info for the new code */
+};
+
+
+
+/*****************************************************************************/
+/*                                  Helpers                                  */
+/*****************************************************************************/
+
+
+
+static int CmpFrameFunc (void* Data attribute ((unused)),
+                         const void* Left, const void* Right)
+/* Compare function for CollSort */
+{
+    return strcmp (((const FrameFunc*) Left)->Func->AsmName,
+                   ((const FrameFunc*) Right)->Func->AsmName);
+}
+
+
+
+static FrameFunc* FindFrameFunc (const Collection* Funcs, const char* Name)
+/* Search for the function with the given assembler name in the sorted
+** collection. Return NULL if it is not found.
+*/
+{
+    int Lo = 0;
+    int Hi = (int) CollCount (Funcs) - 1;
+    while (Lo <= Hi) {
+        int Cur = (Lo + Hi) / 2;
+        FrameFunc* F = CollAtUnchecked (Funcs, Cur);
+        int Res = strcmp (F->Func->AsmName, Name);
+        if (Res == 0) {
+            return F;
+        } else if (Res < 0) {
+            Lo = Cur + 1;
+        } else {
+            Hi = Cur - 1;
+        }
+    }
+    return 0;
+}
+
+
+
+static unsigned PushSize (const CodeEntry* E)
+/* Return the number of bytes pushed by the runtime function called by E, or
+** zero if it is not a push function.
+*/
+{
+    if (CE_IsArg (E, ARG_PUSHA)) {
+        return 1;
+    } else if (CE_IsArg (E, ARG_PUSHAX)) {
+        return 2;
+    } else if (CE_IsArg (E, ARG_PUSHEAX)) {
+        return 4;
+    } else {
+        return 0;
+    }
+}
+
+
+
+static int IsAdjustFunc (const char* Name)
+/* Return true if the runtime function just moves the stack pointer */
+{
+    return (strncmp (Name, "incsp", 5) == 0 && IsDigit (Name[5]) && Name[6] == '\0') ||
+           (strncmp (Name, "decsp", 5) == 0 && IsDigit (Name[5]) && Name[6] == '\0') ||
+           strcmp (Name, "addysp") == 0                                             ||
+           strcmp (Name, "subysp") == 0;
+}
+
+
+
+static void MarkAddrTaken (Collection* Funcs, const char* Text)
+/* Mark all functions from Funcs that are used in Text as address taken */
+{
+    StrBuf Ident = AUTO_STRBUF_INITIALIZER;
+
+    while ((Text = NextIdent (Text, &Ident)) != 0) {
+        if (SB_At (&Ident, 0) == '_') {
+            FrameFunc* F = FindFrameFunc (Funcs, SB_GetConstBuf (&Ident));
+            if (F) {
+                F->AddrTaken = 1;
+            }
+        }
+    }
+
+    SB_Done (&Ident);
+}
+
+
+
+static void MarkDataRefs (Collection* Funcs, const DataSeg* S)
+/* Mark the functions from Funcs that are used in the data of S */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (&S->Lines); ++I) {
+        MarkAddrTaken (Funcs, CollConstAt (&S->Lines, I));
+    }
+}
+
+
+
+static void MarkSegRefs (Collection* Funcs, const SegContext* Seg)
+/* Mark the functions from Funcs that are used in the data of Seg */
+{
+    MarkDataRefs (Funcs, Seg->Data);
+    MarkDataRefs (Funcs, Seg->ROData);
+    MarkDataRefs (Funcs, Seg->BSS);
+}
+
+
+
+static int MayCallBack (const char* Name)
+/* Return true if the subroutine with the given name is outside of the
+** translation unit and may call one of its public functions. Runtime
+** functions and the functions declared in system headers don't do that,
+** except through function pointers. Since the functions behind such a
+** pointer have their address taken, they are handled anyway.
+*/
+{
+    if (Name[0] == '_') {
+        const SymEntry* Sym = FindGlobalSym (Name + 1);
+        return Sym == 0                                         ||
+               !IsTypeFunc (Sym->Type)                          ||
+               (GetFuncDesc (Sym->Type)->Flags & FD_SYSINC) == 0;
+    } else if (!IsAlpha (Name[0])) {
+        /* Absolute address */
+        return 1;
+    } else {
+        /* Runtime functions that call through a pointer */
+        return strcmp (Name, "callax") == 0     ||
+               strcmp (Name, "callptr4") == 0   ||
+               strcmp (Name, "jmpvec") == 0;
+    }
+}
+
+
+
+static void ScanCode (Collection* Funcs, FrameFunc* F)
+/* Collect the callees of F and mark the functions it uses otherwise */
+{
+    CodeSeg* S = F->Seg->Code;
+    unsigned I;
+
+    for (I = 0; I < CS_GetEntryCount (S); ++I) {
+
+        const CodeEntry* E = CS_GetEntry (S, I);
+
+        if (E->OPC == OP65_JSR || (E->OPC == OP65_JMP && E->JumpTo == 0)) {
+            if (E->AM == AM65_ABS) {
+                FrameFunc* Callee = FindFrameFunc (Funcs, E->Arg);
+                if (Callee) {
+                    CollAppend (&F->Callees, Callee);
+                } else if (MayCallBack (E->Arg)) {
+                    F->CallsExt = 1;
+                }
+                continue;
+            } else if ((E->Flags & CEF_JUMPTABLE) == 0) {
+                F->CallsExt = 1;
+            }
+        }
+        MarkAddrTaken (Funcs, E->Arg);
+    }
+
+    MarkSegRefs (Funcs, F->Seg);
+}
+
+
+
+static void FindReach (const Collection* Entries, const FrameFunc* F,
+                       unsigned char* Reach)
+/* Set Reach[I] for all functions that may be active while F is active */
+{
+    Collection  Stack = AUTO_COLLECTION_INITIALIZER;
+    unsigned    I;
+
+    CollAppend (&Stack, (void*) F);
+    while (CollCount (&Stack) > 0) {
+
+        const FrameFunc* G = CollPop (&Stack);
+
+        for (I = 0; I < CollCount (&G->Callees); ++I) {
+            FrameFunc* Callee = CollAtUnchecked (&G->Callees, I);
+            if (!Reach[Callee->Index]) {
+                Reach[Callee->Index] = 1;
+                CollAppend (&Stack, Callee);
+            }
+        }
+        if (G->CallsExt) {
+            for (I = 0; I < CollCount (Entries); ++I) {
+                FrameFunc* Callee = CollAtUnchecked (Entries, I);
+                if (!Reach[Callee->Index]) {
+                    Reach[Callee->Index] = 1;
+                    CollAppend (&Stack, Callee);
+                }
+            }
+        }
+    }
+
+    DoneCollection (&Stack);
+}
+
+
+
+static int IsFrameArg (const CodeEntry* E)
+/* Return true if the instruction uses the stack pointer as argument */
+{
+    return CE_IsArg (E, ARG_C_SP) || CE_IsArg (E, ARG_C_SP_1);
+}
+
+
+
+static int GetHelperOffs (const CodeEntry* E, const StackFuncInfo* H)
+/* Return the offset passed to the runtime function, or -1 if unknown */
+{
+    return H->Y >= 0? H->Y : E->RI->In.RegY;
+}
+
+
+
+static int CheckAccess (const CodeEntry* E, int* Lo, int* Hi)
+/* Check if an instruction that accesses the frame can be replaced. If it
+** accesses a known part of the frame, return its range in Lo/Hi, otherwise
+** leave them alone.
+*/
+{
+    int S = E->FrameSP;
+
+    if (E->OPC == OP65_JSR) {
+
+        const StackFuncInfo* H = GetStackFuncInfo (E->Arg);
+        int Offs;
+        if (H == 0) {
+            return 0;
+        }
+        if (H->Kind == SFK_LEAA || H->Kind == SFK_LEAAX) {
+            /* Address calculation only */
+            return 1;
+        }
+        Offs = GetHelperOffs (E, H);
+        if (Offs < 0) {
+            return 0;
+        }
+        if ((H->Kind == SFK_REGSWAP1 || H->Kind == SFK_REGSWAP2) &&
+            !RegValIsKnown (E->RI->In.RegX)) {
+            /* X contains the offset in the register bank */
+            return 0;
+        }
+        *Lo = S + Offs + H->Lo;
+        *Hi = *Lo + (int) H->Size - 1;
+        return 1;
+
+    } else if (E->AM == AM65_ZP_INDY && CE_IsArg (E, ARG_C_SP)) {
+
+        if (RegValIsKnown (E->RI->In.RegY)) {
+            *Lo = *Hi = S + E->RI->In.RegY;
+        }
+        return 1;
+
+    } else if (E->AM == AM65_ZP && IsFrameArg (E)) {
+
+        /* Only reading the stack pointer can be replaced */
+        switch (E->OPC) {
+            case OP65_ADC:
+            case OP65_AND:
+            case OP65_CMP:
+            case OP65_CPX:
+            case OP65_CPY:
+            case OP65_EOR:
+            case OP65_LDA:
+            case OP65_LDX:
+            case OP65_LDY:
+            case OP65_ORA:
+            case OP65_SBC:
+                return 1;
+            default:
+                return 0;
+        }
+
+    } else {
+
+        return strstr (E->Arg, "c_sp") == 0;
+
+    }
+}
+
+
+
+static int CheckFrame (FrameFunc* F)
+/* Check if the frame of F can be made static and set the frame layout. The
+** register info of the code must be valid.
+*/
+{
+    CodeSeg*    S = F->Seg->Code;
+    unsigned    Count = CS_GetEntryCount (S);
+    unsigned    I;
+
+    /* Determine the size of the frame */
+    F->MinOffs  = 0;
+    F->FastSize = 0;
+    for (I = 0; I < Count; ++I) {
+        const CodeEntry* E = CS_GetEntry (S, I);
+        if ((E->Flags & CEF_FRAME_PUSH) != 0) {
+            if (E->OPC == OP65_JSR) {
+                unsigned Size = PushSize (E);
+                if (Size == 0) {
+                    return 0;
+                }
+                if (E->FrameSP >= 0) {
+                    F->FastSize += Size;
+                }
+            } else if (strstr (E->Arg, "c_sp") != 0) {
+                return 0;
+            }
+            if (E->FrameSP < F->MinOffs) {
+                F->MinOffs = E->FrameSP;
+            }
+        } else if ((E->Flags & CEF_FRAME_ADJUST) != 0) {
+            if (E->OPC == OP65_JSR && !IsAdjustFunc (E->Arg)) {
+                return 0;
+            }
+            if (E->FrameSP < F->MinOffs) {
+                F->MinOffs = E->FrameSP;
+            }
+        }
+    }
+    F->Size = F->ParamSize - F->MinOffs;
+    if (F->Size == 0 || F->ParamSize - F->FastSize > 0xFF) {
+        return 0;
+    }
+
+    /* Check the accesses */
+    for (I = 0; I < Count; ++I) {
+        const CodeEntry* E = CS_GetEntry (S, I);
+        if ((E->Flags & CEF_FRAME_ACCESS) != 0) {
+            int Lo = F->MinOffs;
+            int Hi = F->MinOffs;
+            if (!CheckAccess (E, &Lo, &Hi) ||
+                Lo < F->MinOffs            ||
+                Hi >= (int) F->ParamSize) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+
+static const char* FrameAddr (const FrameFunc* F, int Offs, char* Buf, size_t Size)
+/* Return the address of the given frame offset in Buf */
+{
+    long Addr = (long) F->Base + Offs - F->MinOffs;
+    if (Addr == 0) {
+        xsprintf (Buf, Size, "%s", F->Label);
+    } else {
+        xsprintf (Buf, Size, "%s%+ld", F->Label, Addr);
+    }
+    return Buf;
+}
+
+
+
+static CodeEntry* Emit (FrameEmitter* C, opc_t OPC, am_t AM, const char* Arg,
+                        CodeLabel* JumpTo)
+/* Insert a new instruction */
+{
+    CodeEntry* X = NewCodeEntry (OPC, AM, Arg, JumpTo, C->LI);
+    CS_InsertEntry (C->S, X, C->Pos++);
+    return X;
+}
+
+
+
+static void EmitImpl (FrameEmitter* C, opc_t OPC)
+/* Insert an instruction without an argument */
+{
+    Emit (C, OPC, AM65_IMP, 0, 0);
+}
+
+
+
+static void EmitImm (FrameEmitter* C, opc_t OPC, unsigned Val)
+/* Insert an instruction with an immediate argument */
+{
+    char Buf[16];
+    xsprintf (Buf, sizeof (Buf), "$%02X", Val & 0xFF);
+    Emit (C, OPC, AM65_IMM, Buf, 0);
+}
+
+
+
+static void EmitZP (FrameEmitter* C, opc_t OPC, const char* Arg)
+/* Insert an instruction with a zero page argument */
+{
+    Emit (C, OPC, AM65_ZP, Arg, 0);
+}
+
+
+
+static void EmitFrame (FrameEmitter* C, opc_t OPC, am_t AM, int Offs)
+/* Insert an instruction that accesses the frame */
+{
+    char Buf[64];
+    Emit (C, OPC, AM, FrameAddr (C->F, Offs, Buf, sizeof (Buf)), 0);
+}
+
+
+
+static void EmitFrameImm (FrameEmitter* C, opc_t OPC, char Sel, int Offs)
+/* Insert an instruction that loads the low or high byte of a frame address */
+{
+    char Addr[64];
+    char Buf[80];
+    xsprintf (Buf, sizeof (Buf), "%c(%s)", Sel,
+              FrameAddr (C->F, Offs, Addr, sizeof (Addr)));
+    Emit (C, OPC, AM65_IMM, Buf, 0);
+}
+
+
+
+static void EmitRegSwap (FrameEmitter* C, int Reg, int Offs)
+/* Insert the code that swaps a byte of the register bank with a byte of the
+** frame, leaving the old register value in A.
+*/
+{
+    char Buf[32];
+    xsprintf (Buf, sizeof (Buf), "regbank%+d", Reg);
+    EmitZP (C, OP65_LDA, Buf);
+    EmitImpl (C, OP65_PHA);
+    EmitFrame (C, OP65_LDA, AM65_ABS, Offs);
+    EmitZP (C, OP65_STA, Buf);
+    EmitImpl (C, OP65_PLA);
+    EmitFrame (C, OP65_STA, AM65_ABS, Offs);
+}
+
+
+
+static void EmitHelper (FrameEmitter* C, const CodeEntry* E,
+                        const StackFuncInfo* H)
+/* Insert the replacement for a runtime function that accesses the frame */
+{
+    int O = E->FrameSP;
+    int Y = 0;
+
+    if (H->Kind != SFK_LEAA && H->Kind != SFK_LEAAX) {
+        Y = GetHelperOffs (E, H);
+        O += Y;
+    }
+
+    switch (H->Kind) {
+
+        case SFK_LDAX:
+            EmitImm (C, OP65_LDY, Y - 1);
+            EmitFrame (C, OP65_LDX, AM65_ABS, O);
+            EmitFrame (C, OP65_LDA, AM65_ABS, O - 1);
+            break;
+
+        case SFK_LDEAX:
+            EmitFrame (C, OP65_LDA, AM65_ABS, O);
+            EmitZP (C, OP65_STA, "sreg+1");
+            EmitFrame (C, OP65_LDA, AM65_ABS, O - 1);
+            EmitZP (C, OP65_STA, "sreg");
+            EmitImm (C, OP65_LDY, Y - 3);
+            EmitFrame (C, OP65_LDX, AM65_ABS, O - 2);
+            EmitFrame (C, OP65_LDA, AM65_ABS, O - 3);
+            break;
+
+        case SFK_STAX:
+            EmitImm (C, OP65_LDY, Y + 1);
+            EmitFrame (C, OP65_STA, AM65_ABS, O);
+            EmitFrame (C, OP65_STX, AM65_ABS, O + 1);
+            break;
+
+        case SFK_STEAX:
+            EmitFrame (C, OP65_STA, AM65_ABS, O);
+            EmitFrame (C, OP65_STX, AM65_ABS, O + 1);
+            EmitZP (C, OP65_LDY, "sreg");
+            EmitFrame (C, OP65_STY, AM65_ABS, O + 2);
+            EmitZP (C, OP65_LDY, "sreg+1");
+            EmitFrame (C, OP65_STY, AM65_ABS, O + 3);
+            EmitImm (C, OP65_LDY, Y + 3);
+            break;
+
+        case SFK_LEAA:
+        case SFK_LEAAX:
+            if (RegValIsKnown (E->RI->In.RegA) &&
+                (H->Kind == SFK_LEAA || RegValIsKnown (E->RI->In.RegX))) {
+                int Offs = E->RI->In.RegA;
+                if (H->Kind == SFK_LEAAX) {
+                    Offs += E->RI->In.RegX * 256;
+                }
+                EmitFrameImm (C, OP65_LDA, '<', O + Offs);
+                EmitFrameImm (C, OP65_LDX, '>', O + Offs);
+            } else {
+                if (H->Kind == SFK_LEAA) {
+                    EmitImm (C, OP65_LDX, 0);
+                }
+                EmitImpl (C, OP65_CLC);
+                EmitFrameImm (C, OP65_ADC, '<', O);
+                EmitImpl (C, OP65_PHA);
+                EmitImpl (C, OP65_TXA);
+                EmitFrameImm (C, OP65_ADC, '>', O);
+                EmitImpl (C, OP65_TAX);
+                EmitImpl (C, OP65_PLA);
+            }
+            break;
+
+        case SFK_ADDEQ:
+        case SFK_SUBEQ:
+        case SFK_LADDEQ:
+        case SFK_LSUBEQ:
+            if (H->Kind == SFK_ADDEQ || H->Kind == SFK_SUBEQ) {
+                EmitImm (C, OP65_LDY, Y + 1);
+            } else {
+                EmitImm (C, OP65_LDY, Y + 3);
+            }
+            if (H->Kind == SFK_ADDEQ || H->Kind == SFK_LADDEQ) {
+                EmitImpl (C, OP65_CLC);
+            } else {
+                EmitImpl (C, OP65_SEC);
+                EmitImm (C, OP65_EOR, 0xFF);
+            }
+            EmitFrame (C, OP65_ADC, AM65_ABS, O);
+            EmitFrame (C, OP65_STA, AM65_ABS, O);
+            EmitImpl (C, OP65_PHA);
+            EmitImpl (C, OP65_TXA);
+            if (H->Kind == SFK_SUBEQ || H->Kind == SFK_LSUBEQ) {
+                EmitImm (C, OP65_EOR, 0xFF);
+            }
+            EmitFrame (C, OP65_ADC, AM65_ABS, O + 1);
+            EmitFrame (C, OP65_STA, AM65_ABS, O + 1);
+            EmitImpl (C, OP65_TAX);
+            if (H->Kind == SFK_LADDEQ) {
+                EmitZP (C, OP65_LDA, "sreg");
+                EmitFrame (C, OP65_ADC, AM65_ABS, O + 2);
+                EmitFrame (C, OP65_STA, AM65_ABS, O + 2);
+                EmitZP (C, OP65_STA, "sreg");
+                EmitZP (C, OP65_LDA, "sreg+1");
+                EmitFrame (C, OP65_ADC, AM65_ABS, O + 3);
+                EmitFrame (C, OP65_STA, AM65_ABS, O + 3);
+                EmitZP (C, OP65_STA, "sreg+1");
+            } else if (H->Kind == SFK_LSUBEQ) {
+                EmitFrame (C, OP65_LDA, AM65_ABS, O + 2);
+                EmitZP (C, OP65_SBC, "sreg");
+                EmitFrame (C, OP65_STA, AM65_ABS, O + 2);
+                EmitZP (C, OP65_STA, "sreg");
+                EmitFrame (C, OP65_LDA, AM65_ABS, O + 3);
+                EmitZP (C, OP65_SBC, "sreg+1");
+                EmitFrame (C, OP65_STA, AM65_ABS, O + 3);
+                EmitZP (C, OP65_STA, "sreg+1");
+            }
+            EmitImpl (C, OP65_PLA);
+            break;
+
+        case SFK_REGSWAP1:
+        case SFK_REGSWAP2:
+            if (H->Kind == SFK_REGSWAP2) {
+                EmitImm (C, OP65_LDY, Y + 1);
+            }
+            EmitRegSwap (C, E->RI->In.RegX, O);
+            if (H->Kind == SFK_REGSWAP2) {
+                EmitRegSwap (C, E->RI->In.RegX + 1, O + 1);
+            }
+            break;
+
+    }
+}
+
+
+
+static void EmitAccess (FrameEmitter* C, const CodeEntry* E)
+/* Insert the replacement for an instruction that accesses the frame */
+{
+    if (E->OPC == OP65_JSR) {
+        EmitHelper (C, E, GetStackFuncInfo (E->Arg));
+    } else if (E->AM == AM65_ZP_INDY) {
+        if (RegValIsKnown (E->RI->In.RegY)) {
+            EmitFrame (C, E->OPC, AM65_ABS, E->FrameSP + E->RI->In.RegY);
+        } else {
+            EmitFrame (C, E->OPC, AM65_ABSY, E->FrameSP);
+        }
+    } else {
+        EmitFrameImm (C, E->OPC, CE_IsArg (E, ARG_C_SP)? '<' : '>',
+                      E->FrameSP);
+    }
+}
+
+
+
+static void EmitPush (FrameEmitter* C, const CodeEntry* E)
+/* Insert the replacement for a push of a local variable */
+{
+    unsigned Size = PushSize (E);
+
+    EmitFrame (C, OP65_STA, AM65_ABS, E->FrameSP);
+    if (Size >= 2) {
+        EmitFrame (C, OP65_STX, AM65_ABS, E->FrameSP + 1);
+    }
+    if (Size == 4) {
+        EmitZP (C, OP65_LDY, "sreg");
+        EmitFrame (C, OP65_STY, AM65_ABS, E->FrameSP + 2);
+        EmitZP (C, OP65_LDY, "sreg+1");
+        EmitFrame (C, OP65_STY, AM65_ABS, E->FrameSP + 3);
+    }
+
+    /* The push functions return with Y = 0 */
+    EmitImm (C, OP65_LDY, 0);
+}
+
+
+
+static void EmitParamCopy (FrameEmitter* C)
+/* Insert the code that moves the parameters pushed by the caller into the
+** frame, and drops them from the stack.
+*/
+{
+    const FrameFunc* F = C->F;
+    unsigned Count = F->ParamSize - F->FastSize;
+    unsigned I;
+
+    if (Count == 0) {
+        return;
+    }
+
+    if (Count * 100 <= 4 * C->S->CodeSizeFactor) {
+        for (I = 0; I < Count; ++I) {
+            EmitImm (C, OP65_LDY, I);
+            Emit (C, OP65_LDA, AM65_ZP_INDY, "c_sp", 0);
+            EmitFrame (C, OP65_STA, AM65_ABS, F->FastSize + I);
+        }
+    } else {
+        CodeEntry* X;
+        CodeLabel* L;
+        if (Count <= 128) {
+            EmitImm (C, OP65_LDY, Count - 1);
+        } else {
+            EmitImm (C, OP65_LDY, 0);
+        }
+        X = Emit (C, OP65_LDA, AM65_ZP_INDY, "c_sp", 0);
+        L = CS_GenLabel (C->S, X);
+        EmitFrame (C, OP65_STA, AM65_ABSY, F->FastSize);
+        if (Count <= 128) {
+            EmitImpl (C, OP65_DEY);
+            Emit (C, OP65_BPL, AM65_BRA, L->Name, L);
+        } else {
+            EmitImpl (C, OP65_INY);
+            EmitImm (C, OP65_CPY, Count);
+            Emit (C, OP65_BNE, AM65_BRA, L->Name, L);
+        }
+    }
+
+    /* Drop the parameters */
+    if (Count <= 8) {
+        char Buf[16];
+        xsprintf (Buf, sizeof (Buf), "incsp%u", Count);
+        Emit (C, OP65_JSR, AM65_ABS, Buf, 0);
+    } else {
+        EmitImm (C, OP65_LDY, Count);
+        Emit (C, OP65_JSR, AM65_ABS, "addysp", 0);
+    }
+}
+
+
+
+static void ConvertFrame (FrameFunc* F)
+/* Replace the stack frame of F by its static frame. The register info of
+** the code must be valid.
+*/
+{
+    FrameEmitter    C;
+    CodeSeg*        S = F->Seg->Code;
+    unsigned        I;
+
+    C.F   = F;
+    C.S   = S;
+    C.Pos = 0;
+    C.LI  = 0;
+
+    /* New labels continue the numbering of the function */
+    UseLabelPoolFromSegments (F->Seg);
+
+    /* The parameters are copied after the fastcall parameter is stored */
+    for (I = 0; I < CS_GetEntryCount (S); ++I) {
+        const CodeEntry* E = CS_GetEntry (S, I);
+        if ((E->Flags & CEF_FRAME_PUSH) != 0 && E->FrameSP >= 0) {
+            C.Pos = I + 1;
+        }
+    }
+    if (CS_GetEntryCount (S) > 0) {
+        C.LI = CS_GetEntry (S, C.Pos > 0? C.Pos - 1 : 0)->LI;
+    }
+    EmitParamCopy (&C);
+
+    /* Replace the frame accesses */
+    I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        CodeEntry* E = CS_GetEntry (S, I);
+
+        if ((E->Flags & CEF_FRAME_MASK) == 0) {
+            ++I;
+            continue;
+        }
+
+        C.Pos = I + 1;
+        C.LI  = E->LI;
+        if ((E->Flags & CEF_FRAME_PUSH) != 0) {
+            if (E->OPC == OP65_JSR) {
+                EmitPush (&C, E);
+            } else {
+                E->Flags &= ~CEF_FRAME_MASK;
+                ++I;
+                continue;
+            }
+        } else if ((E->Flags & CEF_FRAME_ACCESS) != 0) {
+            if (E->OPC == OP65_JSR || strstr (E->Arg, "c_sp") != 0) {
+                EmitAccess (&C, E);
+            } else {
+                E->Flags &= ~CEF_FRAME_MASK;
+                ++I;
+                continue;
+            }
+        }
+
+        /* Frame adjustments are just removed */
+        CS_DelEntry (S, I);
+        I = C.Pos - 1;
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void MakeStaticFrames (Collection* Funcs)
+/* Funcs contains the segment contexts of all functions that are output.
+** Build the call graph of the translation unit and move the stack frames
+** of the functions that can neither be called recursively nor from an
+** interrupt into a static memory area. Frames of functions that are never
+** active at the same time share the same memory. Only functions compiled
+** with static frames enabled are changed.
+*/
+{
+    Collection      All     = AUTO_COLLECTION_INITIALIZER;
+    Collection      Entries = AUTO_COLLECTION_INITIALIZER;
+    unsigned char*  Reach;
+    unsigned char*  Async;
+    const char*     Label;
+    unsigned        Count;
+    unsigned        Total;
+    unsigned        Changes;
+    unsigned        I, J;
+
+    /* Nothing to do if no function asks for it */
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        const SegContext* Seg = CollConstAt (Funcs, I);
+        if (Seg->Code->StaticFrame) {
+            break;
+        }
+    }
+    if (I == CollCount (Funcs)) {
+        return;
+    }
+
+    /* Collect the functions */
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        SegContext* Seg = CollAtUnchecked (Funcs, I);
+        FrameFunc* F = xmalloc (sizeof (FrameFunc));
+        F->Func      = Seg->Code->Func;
+        F->Seg       = Seg;
+        InitCollection (&F->Callees);
+        F->Index     = 0;
+        F->Label     = 0;
+        F->MinOffs   = 0;
+        F->ParamSize = GetFuncDefinitionDesc (F->Func->Type)->ParamSize;
+        F->FastSize  = 0;
+        F->Size      = 0;
+        F->Base      = 0;
+        F->Entry     = 0;
+        F->AddrTaken = 0;
+        F->CallsExt  = 0;
+        F->Convert   = 0;
+        CollAppend (&All, F);
+    }
+    CollSort (&All, CmpFrameFunc, 0);
+    Count = CollCount (&All);
+
+    /* Build the call graph */
+    MarkSegRefs (&All, GS);
+    for (I = 0; I < CS_GetEntryCount (GS->Code); ++I) {
+        MarkAddrTaken (&All, CS_GetEntry (GS->Code, I)->Arg);
+    }
+    for (I = 0; I < Count; ++I) {
+        FrameFunc* F = CollAtUnchecked (&All, I);
+        F->Index = I;
+        ScanCode (&All, F);
+    }
+    for (I = 0; I < Count; ++I) {
+        FrameFunc* F = CollAtUnchecked (&All, I);
+        if (F->AddrTaken || !SymIsLocalFunc (F->Func)) {
+            F->Entry = 1;
+            CollAppend (&Entries, F);
+        }
+    }
+
+    /* Determine which functions may be active while a function is active.
+    ** Anything that is reachable from a function with its address taken may
+    ** run asynchronously, since it may be an interrupt handler.
+    */
+    Reach = xmalloc (Count * Count);
+    memset (Reach, 0, Count * Count);
+    Async = xmalloc (Count);
+    memset (Async, 0, Count);
+    for (I = 0; I < Count; ++I) {
+        FrameFunc* F = CollAtUnchecked (&All, I);
+        FindReach (&Entries, F, Reach + I * Count);
+        if (F->AddrTaken) {
+            Async[I] = 1;
+            for (J = 0; J < Count; ++J) {
+                Async[J] |= Reach[I * Count + J];
+            }
+        }
+    }
+
+    /* Select the functions to convert */
+    for (I = 0; I < Count; ++I) {
+        FrameFunc* F = CollAtUnchecked (&All, I);
+        CodeSeg* S = F->Seg->Code;
+        if (!S->StaticFrame                                             ||
+            (GetFuncDesc (F->Func->Type)->Flags & FD_VARIADIC) != 0    ||
+            Async[I]                                                    ||
+            Reach[I * Count + I]) {
+            continue;
+        }
+        CS_GenRegInfo (S);
+        F->Convert = CheckFrame (F);
+        if (!F->Convert) {
+            CS_FreeRegInfo (S);
+        }
+    }
+
+    /* Place the frames. A frame is placed above the frames of all functions
+    ** that may be active at the same time, so the others share memory.
+    */
+    do {
+        Changes = 0;
+        for (I = 0; I < Count; ++I) {
+            FrameFunc* F = CollAtUnchecked (&All, I);
+            unsigned Base = 0;
+            if (!F->Convert) {
+                continue;
+            }
+            for (J = 0; J < Count; ++J) {
+                const FrameFunc* G = CollAtUnchecked (&All, J);
+                if (G->Convert && J != I && Reach[J * Count + I] &&
+                    G->Base + G->Size > Base) {
+                    Base = G->Base + G->Size;
+                }
+            }
+            if (Base != F->Base) {
+                F->Base = Base;
+                ++Changes;
+            }
+        }
+    } while (Changes > 0);
+
+    /* Allocate the memory area and convert the functions */
+    Total = 0;
+    for (I = 0; I < Count; ++I) {
+        const FrameFunc* F = CollAtUnchecked (&All, I);
+        if (F->Convert && F->Base + F->Size > Total) {
+            Total = F->Base + F->Size;
+        }
+    }
+    if (Total > 0) {
+        Label = xstrdup (PooledLiteralLabelName (GetPooledLiteralLabel ()));
+        DS_AddLine (GS->BSS, "%s:", Label);
+        DS_AddLine (GS->BSS, "\t.res\t%u,$00", Total);
+        for (I = 0; I < Count; ++I) {
+            FrameFunc* F = CollAtUnchecked (&All, I);
+            if (F->Convert) {
+                F->Label = Label;
+                ConvertFrame (F);
+                CS_FreeRegInfo (F->Seg->Code);
+            }
+        }
+        xfree ((char*) Label);
+    }
+
+    /* Cleanup */
+    for (I = 0; I < Count; ++I) {
+        FrameFunc* F = CollAtUnchecked (&All, I);
+        DoneCollection (&F->Callees);
+        xfree (F);
+    }
+    xfree (Async);
+    xfree (Reach);
+    DoneCollection (&Entries);
+    DoneCollection (&All);
+}
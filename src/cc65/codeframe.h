@@ -0,0 +1,59 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                codeframe.h                                */
+/*                                                                           */
+/*           Static stack frames for functions that are not recursive        */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef CODEFRAME_H
+#define CODEFRAME_H
+
+
+
+/* common */
+#include "coll.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void MakeStaticFrames (Collection* Funcs);
+/* Funcs contains the segment contexts of all functions that are output.
+** Build the call graph of the translation unit and move the stack frames
+** of the functions that can neither be called recursively nor from an
+** interrupt into a static memory area. Frames of functions that are never
+** active at the same time share the same memory. Only functions compiled
+** with static frames enabled are changed.
+*/
+
+
+
+/* End of codeframe.h */
+
+#endif
@@ -54,6 +54,7 @@
 #include "asmcode.h"
 #include "asmlabel.h"
 #include "casenode.h"
+#include "codeent.h"
 #include "codeseg.h"
 #include "dataseg.h"
 #include "error.h"
@@ -106,6 +107,18 @@ static void CheckLocalOffs (unsigned Offs)
 
 
 
+static void MarkFrameAccess (const CodeMark* Start, unsigned Flags)
+/* Mark the code after Start as an access to the stack frame, unless Flags
+** say that the stack location is a temporary.
+*/
+{
+    if ((Flags & CF_TEMP) == 0) {
+        MarkFrameCode (Start, CEF_FRAME_ACCESS, StackPtr);
+    }
+}
+
+
+
 static const char* GetLabelName (unsigned Flags, uintptr_t Label, long Offs)
 {
     static char Buf [256];              /* Label name */
@@ -528,7 +541,10 @@ void g_leave (int DoCleanup)
         if (funcargs >= 0) {
 
             /* Drop stackframe if needed */
+            CodeMark Start;
+            GetCodePos (&Start);
             g_drop (ToDrop + funcargs);
+            MarkFrameCode (&Start, CEF_FRAME_ADJUST, StackPtr);
 
         } else if (StackPtr != 0) {
 
@@ -564,11 +580,14 @@ void g_leave (int DoCleanup)
 void g_swap_regvars (int StackOffs, int RegOffs, unsigned Bytes)
 /* Swap a register variable with a location on the stack */
 {
+    CodeMark Start;
+
     /* Calculate the actual stack offset and check it */
     StackOffs -= StackPtr;
     CheckLocalOffs (StackOffs);
 
     /* Generate code */
+    GetCodePos (&Start);
     AddCodeLine ("ldy #$%02X", StackOffs & 0xFF);
     if (Bytes == 1) {
 
@@ -594,6 +613,7 @@ void g_swap_regvars (int StackOffs, int RegOffs, unsigned Bytes)
         AddCodeLine ("lda #$%02X", Bytes & 0xFF);
         AddCodeLine ("jsr regswap");
     }
+    MarkFrameAccess (&Start, CF_NONE);
 }
 
 
@@ -601,23 +621,30 @@ void g_swap_regvars (int StackOffs, int RegOffs, unsigned Bytes)
 void g_save_regvars (int RegOffs, unsigned Bytes)
 /* Save register variables */
 {
+    CodeMark Start;
+    GetCodePos (&Start);
+
     /* Don't loop for up to two bytes */
     if (Bytes == 1) {
 
         AddCodeLine ("lda regbank%+d", RegOffs);
         AddCodeLine ("jsr pusha");
+        MarkFrameCode (&Start, CEF_FRAME_PUSH, StackPtr - 1);
 
     } else if (Bytes == 2) {
 
         AddCodeLine ("lda regbank%+d", RegOffs);
         AddCodeLine ("ldx regbank%+d", RegOffs+1);
         AddCodeLine ("jsr pushax");
+        MarkFrameCode (&Start, CEF_FRAME_PUSH, StackPtr - 2);
 
     } else {
 
         /* More than two bytes - loop */
         unsigned Label = GetLocalLabel ();
         g_space (Bytes);
+        MarkFrameCode (&Start, CEF_FRAME_ADJUST, StackPtr - (int) Bytes);
+        GetCodePos (&Start);
         AddCodeLine ("ldy #$%02X", (unsigned char) (Bytes - 1));
         AddCodeLine ("ldx #$%02X", (unsigned char) Bytes);
         g_defcodelabel (Label);
@@ -626,6 +653,7 @@ void g_save_regvars (int RegOffs, unsigned Bytes)
         AddCodeLine ("dey");
         AddCodeLine ("dex");
         AddCodeLine ("bne %s", LocalLabelName (Label));
+        MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr - (int) Bytes);
 
     }
 
@@ -638,9 +666,12 @@ void g_save_regvars (int RegOffs, unsigned Bytes)
 void g_restore_regvars (int StackOffs, int RegOffs, unsigned Bytes)
 /* Restore register variables */
 {
+    CodeMark Start;
+
     /* Calculate the actual stack offset and check it */
     StackOffs -= StackPtr;
     CheckLocalOffs (StackOffs);
+    GetCodePos (&Start);
 
     /* Don't loop for up to two bytes */
     if (Bytes == 1) {
@@ -703,6 +734,7 @@ void g_restore_regvars (int StackOffs, int RegOffs, unsigned Bytes)
         AddCodeLine ("ldx tmp1");
 
     }
+    MarkFrameAccess (&Start, CF_NONE);
 }
 
 
@@ -834,7 +866,10 @@ void g_getstatic (unsigned flags, uintptr_t label, long offs)
 void g_getlocal (unsigned Flags, int Offs)
 /* Fetch specified local object (local var). */
 {
+    CodeMark Start;
+
     Offs -= StackPtr;
+    GetCodePos (&Start);
     switch (Flags & CF_TYPEMASK) {
 
         case CF_CHAR:
@@ -871,14 +906,16 @@ void g_getlocal (unsigned Flags, int Offs)
             CheckLocalOffs (Offs + 3);
             AddCodeLine ("ldy #$%02X", (unsigned char) (Offs+3));
             AddCodeLine ("jsr ldeaxysp");
+            MarkFrameAccess (&Start, Flags);
             if (Flags & CF_TEST) {
                 g_test (Flags);
             }
-            break;
+            return;
 
         default:
             typeerror (Flags);
     }
+    MarkFrameAccess (&Start, Flags);
 }
 
 
@@ -941,9 +978,11 @@ void g_leasp (int Offs)
 /* Fetch the address of the specified symbol into the primary register */
 {
     unsigned char Lo, Hi;
+    CodeMark Start;
 
     /* Calculate the offset relative to c_sp */
     Offs -= StackPtr;
+    GetCodePos (&Start);
 
     /* Get low and high byte */
     Lo = (unsigned char) Offs;
@@ -997,6 +1036,7 @@ void g_leasp (int Offs)
         AddCodeLine ("tax");
         AddCodeLine ("pla");
     }
+    MarkFrameAccess (&Start, CF_NONE);
 }
 
 
@@ -1090,8 +1130,11 @@ void g_putstatic (unsigned flags, uintptr_t label, long offs)
 void g_putlocal (unsigned Flags, int Offs, long Val)
 /* Put data into local object. */
 {
+    CodeMark Start;
+
     Offs -= StackPtr;
     CheckLocalOffs (Offs);
+    GetCodePos (&Start);
     switch (Flags & CF_TYPEMASK) {
 
         case CF_CHAR:
@@ -1145,6 +1188,7 @@ void g_putlocal (unsigned Flags, int Offs, long Val)
             typeerror (Flags);
 
     }
+    MarkFrameAccess (&Start, Flags);
 }
 
 
@@ -1614,10 +1658,12 @@ void g_addlocal (unsigned flags, int offs)
 {
     unsigned L;
     int NewOff;
+    CodeMark Start;
 
     /* Correct the offset and check it */
     NewOff = offs - StackPtr;
     CheckLocalOffs (NewOff);
+    GetCodePos (&Start);
 
     switch (flags & CF_TYPEMASK) {
 
@@ -1629,6 +1675,7 @@ void g_addlocal (unsigned flags, int offs)
             AddCodeLine ("bcc %s", LocalLabelName (L));
             AddCodeLine ("inx");
             g_defcodelabel (L);
+            MarkFrameAccess (&Start, flags);
             break;
 
         case CF_INT:
@@ -1641,6 +1688,7 @@ void g_addlocal (unsigned flags, int offs)
             AddCodeLine ("adc (c_sp),y");
             AddCodeLine ("tax");
             AddCodeLine ("pla");
+            MarkFrameAccess (&Start, flags);
             break;
 
         case CF_LONG:
@@ -1832,9 +1880,12 @@ void g_addeqstatic (unsigned flags, uintptr_t label, long offs,
 void g_addeqlocal (unsigned flags, int Offs, unsigned long val)
 /* Emit += for a local variable */
 {
+    CodeMark Start;
+
     /* Calculate the true offset, check it, load it into Y */
     Offs -= StackPtr;
     CheckLocalOffs (Offs);
+    GetCodePos (&Start);
 
     /* Check the size and determine operation */
     switch (flags & CF_TYPEMASK) {
@@ -1900,6 +1951,7 @@ void g_addeqlocal (unsigned flags, int Offs, unsigned long val)
         default:
             typeerror (flags);
     }
+    MarkFrameAccess (&Start, flags);
 }
 
 
@@ -2084,9 +2136,12 @@ void g_subeqstatic (unsigned flags, uintptr_t label, long offs,
 void g_subeqlocal (unsigned flags, int Offs, unsigned long val)
 /* Emit -= for a local variable */
 {
+    CodeMark Start;
+
     /* Calculate the true offset, check it, load it into Y */
     Offs -= StackPtr;
     CheckLocalOffs (Offs);
+    GetCodePos (&Start);
 
     /* Check the size and determine operation */
     switch (flags & CF_TYPEMASK) {
@@ -2134,6 +2189,7 @@ void g_subeqlocal (unsigned flags, int Offs, unsigned long val)
         default:
             typeerror (flags);
     }
+    MarkFrameAccess (&Start, flags);
 }
 
 
@@ -2187,6 +2243,7 @@ void g_addaddr_local (unsigned flags attribute ((unused)), int offs)
 /* Add the address of a local variable to ax */
 {
     unsigned L = 0;
+    CodeMark Start;
 
     /* Add the offset */
     offs -= StackPtr;
@@ -2196,8 +2253,10 @@ void g_addaddr_local (unsigned flags attribute ((unused)), int offs)
             g_inc (CF_INT | CF_CONST, offs);
         }
         /* Add the current stackpointer value */
+        GetCodePos (&Start);
         AddCodeLine ("jsr leaaxsp");
     } else {
+        GetCodePos (&Start);
         if (offs != 0) {
             /* We cannot address more then 256 bytes of locals anyway */
             L = GetLocalLabel();
@@ -2222,6 +2281,7 @@ void g_addaddr_local (unsigned flags attribute ((unused)), int offs)
         AddCodeLine ("tax");
         AddCodeLine ("tya");
     }
+    MarkFrameAccess (&Start, CF_NONE);
 }
 
 
@@ -4585,8 +4645,10 @@ void g_initauto (unsigned Label, unsigned Size)
 /* Initialize a local variable at stack offset zero from static data */
 {
     unsigned CodeLabel = GetLocalLabel ();
+    CodeMark Start;
 
     CheckLocalOffs (Size);
+    GetCodePos (&Start);
     if (Size <= 128) {
         AddCodeLine ("ldy #$%02X", Size-1);
         g_defcodelabel (CodeLabel);
@@ -4603,6 +4665,7 @@ void g_initauto (unsigned Label, unsigned Size)
         AddCmpCodeIfSizeNot256 ("cpy #$%02X", Size);
         AddCodeLine ("bne %s", LocalLabelName (CodeLabel));
     }
+    MarkFrameAccess (&Start, CF_NONE);
 }
 
 
@@ -4925,6 +4988,143 @@ void g_extractbitfield (unsigned Flags, unsigned FullWidthFlags, int IsSigned,
 
 
 
+/* Switch lowering limits. Smaller sets of case values use a chain of
+** compares. The table size is limited by the size of a code entry, since
+** the table is output behind the insn that jumps through it.
+*/
+#define SWITCH_BSEARCH_MIN      8       /* Min. cases for a binary search */
+#define SWITCH_TABLE_MIN        8       /* Min. cases for a jump table */
+#define SWITCH_TABLE_MAX        126     /* Max. values in a jump table */
+
+
+
+static int UseJumpTable (const Collection* Nodes, unsigned First, unsigned Last)
+/* Return true if the case values First..Last should use a jump table */
+{
+    unsigned Count = Last - First + 1;
+    unsigned Range = CN_GetValue (CollConstAt (Nodes, Last)) -
+                     CN_GetValue (CollConstAt (Nodes, First)) + 1;
+
+    /* The size of the table is added to the size of the insn that jumps
+    ** through it, which is an unsigned char. With two bytes per value and
+    ** three bytes for a "jmp (abs,x)", at most 126 values fit. With -Oi, the
+    ** binary search splits larger ranges into parts that may use a table,
+    ** otherwise the values are compared one by one.
+    */
+    if (Count < SWITCH_TABLE_MIN || Range > SWITCH_TABLE_MAX) {
+        return 0;
+    }
+
+    /* The table costs two bytes per value plus the dispatch code, the chain
+    ** about four bytes per case. The table is always faster, so weight the
+    ** sizes with the code size factor.
+    */
+    return (2 * Range + 20) * 100 <= (4 * Count + 3) * IS_Get (&CodeSizeFactor);
+}
+
+
+
+static void g_switchtable (const Collection* Nodes, unsigned First, unsigned Last,
+                           unsigned DefaultLabel)
+/* Generate a jump table for the case values First..Last. The value is in A. */
+{
+    unsigned    I;
+    unsigned    Lo    = CN_GetValue (CollConstAt (Nodes, First));
+    unsigned    Hi    = CN_GetValue (CollConstAt (Nodes, Last));
+    unsigned    Range = Hi - Lo + 1;
+    unsigned    Table = GetLocalDataLabel ();
+    CodeEntry*  Jump;
+    JumpTable*  T;
+
+    /* Make the value zero based and check the range */
+    if (Lo != 0) {
+        AddCodeLine ("sec");
+        AddCodeLine ("sbc #$%02X", Lo);
+    }
+    AddCodeLine ("cmp #$%02X", Range);
+    AddCodeLine ("jcs %s", LocalLabelName (DefaultLabel));
+
+    /* Jump through the table. The 65C02 has an indexed indirect jump, the
+    ** 6502 pushes the target address minus one and returns to it. Using Y
+    ** here keeps X for the code at the target.
+    */
+    if ((CPUIsets[CPU] & CPU_ISET_65SC02) != 0) {
+        AddCodeLine ("asl a");
+        AddCodeLine ("tax");
+        AddCodeLine ("jmp (%s,x)", LocalDataLabelName (Table));
+    } else {
+        AddCodeLine ("tay");
+        AddCodeLine ("lda %s+%u,y", LocalDataLabelName (Table), Range);
+        AddCodeLine ("pha");
+        AddCodeLine ("lda %s,y", LocalDataLabelName (Table));
+        AddCodeLine ("pha");
+        AddCodeLine ("rts");
+    }
+    Jump = CS_GetEntry (CS->Code, CS_GetEntryCount (CS->Code) - 1);
+    T = CS_AddJumpTable (Jump, LocalDataLabelName (Table),
+                         (CPUIsets[CPU] & CPU_ISET_65SC02) != 0? JT_ADDR : JT_RTS);
+
+    /* Add the targets. Values without a case go to the default label. */
+    for (I = Lo; I <= Hi; ++I) {
+        const CaseNode* N = CollConstAt (Nodes, First);
+        if (CN_GetValue (N) == I) {
+            CS_AddJumpTableLabel (CS->Code, T, LocalLabelName (CN_GetLabel (N)));
+            ++First;
+        } else {
+            CS_AddJumpTableLabel (CS->Code, T, LocalLabelName (DefaultLabel));
+        }
+    }
+}
+
+
+
+static void g_switchrange (const Collection* Nodes, unsigned First, unsigned Last,
+                           unsigned DefaultLabel)
+/* Generate code for the case values First..Last of the last level of a
+** switch statement. The value is in A.
+*/
+{
+    unsigned Count = Last - First + 1;
+
+    if (UseJumpTable (Nodes, First, Last)) {
+
+        /* Dense set of values */
+        g_switchtable (Nodes, First, Last, DefaultLabel);
+
+    } else if (Count >= SWITCH_BSEARCH_MIN && IS_Get (&CodeSizeFactor) > 100) {
+
+        /* Sparse set of values, use a binary search. This costs a branch
+        ** and a jump per level, so we do it only if speed matters.
+        */
+        unsigned        Mid        = First + Count / 2;
+        const CaseNode* N          = CollConstAt (Nodes, Mid);
+        unsigned        LowerLabel = GetLocalLabel ();
+
+        AddCodeLine ("cmp #$%02X", CN_GetValue (N));
+        g_falsejump (0, CN_GetLabel (N));
+        AddCodeLine ("jcc %s", LocalLabelName (LowerLabel));
+        g_switchrange (Nodes, Mid + 1, Last, DefaultLabel);
+        g_defcodelabel (LowerLabel);
+        g_switchrange (Nodes, First, Mid - 1, DefaultLabel);
+
+    } else {
+
+        /* Few values, compare them one by one */
+        unsigned I;
+        for (I = First; I <= Last; ++I) {
+            const CaseNode* N = CollConstAt (Nodes, I);
+            AddCodeLine ("cmp #$%02X", CN_GetValue (N));
+            g_falsejump (0, CN_GetLabel (N));
+        }
+
+        /* If we go here, we haven't found the label */
+        g_jump (DefaultLabel);
+
+    }
+}
+
+
+
 void g_switch (Collection* Nodes, unsigned DefaultLabel, unsigned Depth)
 /* Generate code for a switch statement */
 {
@@ -4935,8 +5135,9 @@ void g_switch (Collection* Nodes, unsigned DefaultLabel, unsigned Depth)
     const char* Compare;
     switch (Depth) {
         case 1:
-            Compare = "cmp #$%02X";
-            break;
+            /* The last level is handled separately */
+            g_switchrange (Nodes, 0, CollCount (Nodes) - 1, DefaultLabel);
+            return;
         case 2:
             Compare = "cpx #$%02X";
             break;
@@ -4967,28 +5168,18 @@ void g_switch (Collection* Nodes, unsigned DefaultLabel, unsigned Depth)
         /* Do the compare */
         AddCodeLine (Compare, CN_GetValue (N));
 
-        /* If this is the last level, jump directly to the case code if found */
-        if (Depth == 1) {
-
-            /* Branch if equal */
-            g_falsejump (0, CN_GetLabel (N));
-
+        /* Determine the next label */
+        if (I == CollCount (Nodes) - 1) {
+            /* Last node means not found */
+            g_truejump (0, DefaultLabel);
         } else {
-
-            /* Determine the next label */
-            if (I == CollCount (Nodes) - 1) {
-                /* Last node means not found */
-                g_truejump (0, DefaultLabel);
-            } else {
-                /* Jump to the next check */
-                NextLabel = GetLocalLabel ();
-                g_truejump (0, NextLabel);
-            }
-
-            /* Check the next level */
-            g_switch (N->Nodes, DefaultLabel, Depth-1);
-
+            /* Jump to the next check */
+            NextLabel = GetLocalLabel ();
+            g_truejump (0, NextLabel);
         }
+
+        /* Check the next level */
+        g_switch (N->Nodes, DefaultLabel, Depth-1);
     }
 
     /* If we go here, we haven't found the label */
@@ -81,6 +81,7 @@
 #define CF_FIXARGC      0x0100  /* Function has fixed arg count */
 #define CF_FORCECHAR    0x0200  /* Handle chars as chars, not ints */
 #define CF_NOKEEP       0x0400  /* Value may get destroyed when storing */
+#define CF_TEMP         0x0800  /* Stack location is a temporary */
 
 /* Type of address */
 #define CF_ADDRMASK     0xF000  /* Bit mask of address type */
@@ -384,6 +384,37 @@ static const FuncInfo FuncInfoTable[] = {
 };
 #define FuncInfoCount   (sizeof(FuncInfoTable) / sizeof(FuncInfoTable[0]))
 
+/* Table with the runtime functions that access a variable in the C stack
+** frame. The functions with an 'ysp' suffix get the offset of the last byte
+** accessed in Y, so the first one is at Y+Lo.
+*/
+/* CAUTION: table must be sorted for bsearch */
+static const StackFuncInfo StackFuncInfoTable[] = {
+/* BEGIN SORTED.SH */
+    { "addeq0sp",        0,      0,     2,      SFK_ADDEQ       },
+    { "addeqysp",       -1,      0,     2,      SFK_ADDEQ       },
+    { "laddeq0sp",       0,      0,     4,      SFK_LADDEQ      },
+    { "laddeqysp",      -1,      0,     4,      SFK_LADDEQ      },
+    { "ldax0sp",         1,     -1,     2,      SFK_LDAX        },
+    { "ldaxysp",        -1,     -1,     2,      SFK_LDAX        },
+    { "ldeax0sp",        3,     -3,     4,      SFK_LDEAX       },
+    { "ldeaxysp",       -1,     -3,     4,      SFK_LDEAX       },
+    { "leaa0sp",         0,      0,     0,      SFK_LEAA        },
+    { "leaaxsp",         0,      0,     0,      SFK_LEAAX       },
+    { "lsubeq0sp",       0,      0,     4,      SFK_LSUBEQ      },
+    { "lsubeqysp",      -1,      0,     4,      SFK_LSUBEQ      },
+    { "regswap1",       -1,      0,     1,      SFK_REGSWAP1    },
+    { "regswap2",       -1,      0,     2,      SFK_REGSWAP2    },
+    { "stax0sp",         0,      0,     2,      SFK_STAX        },
+    { "staxysp",        -1,      0,     2,      SFK_STAX        },
+    { "steax0sp",        0,      0,     4,      SFK_STEAX       },
+    { "steaxysp",       -1,      0,     4,      SFK_STEAX       },
+    { "subeq0sp",        0,      0,     2,      SFK_SUBEQ       },
+    { "subeqysp",       -1,      0,     2,      SFK_SUBEQ       },
+/* END SORTED.SH */
+};
+#define StackFuncInfoCount (sizeof(StackFuncInfoTable) / sizeof(StackFuncInfoTable[0]))
+
 /* Table with names of zero page locations used by the compiler */
 /* CAUTION: table must be sorted for bsearch */
 static const ZPInfo ZPInfoTable[] = {
@@ -502,6 +533,32 @@ static int CompareFuncInfo (const void* Key, const void* Info)
 
 
 
+int GetRuntimeFuncInfo (const char* Name, unsigned* Use, unsigned* Chg)
+/* If Name is one of the runtime functions we know, store its register
+** information into the given variables and return true. Otherwise return
+** false and leave the variables alone.
+*/
+{
+    /* Search for the function in the list of builtin functions */
+    const FuncInfo* Info = bsearch (Name, FuncInfoTable, FuncInfoCount,
+                                    sizeof(FuncInfo), CompareFuncInfo);
+
+    /* Do we know the function? */
+    if (Info == 0) {
+        return 0;
+    }
+
+    /* Use the information we have */
+    *Use = Info->Use;
+    *Chg = Info->Chg;
+    if ((*Use & (SLV_TOP | SLV_IND)) != 0) {
+        *Use |= REG_SP;
+    }
+    return 1;
+}
+
+
+
 fncls_t GetFuncInfo (const char* Name, unsigned int* Use, unsigned int* Chg)
 /* For the given function, lookup register information and store it into
 ** the given variables. If the function is unknown, assume it will use and
@@ -588,18 +645,7 @@ fncls_t GetFuncInfo (const char* Name, unsigned int* Use, unsigned int* Chg)
     } else {
 
         /* Search for the function in the list of builtin functions */
-        const FuncInfo* Info = bsearch (Name, FuncInfoTable, FuncInfoCount,
-                                        sizeof(FuncInfo), CompareFuncInfo);
-
-        /* Do we know the function? */
-        if (Info) {
-            /* Use the information we have */
-            *Use = Info->Use;
-            *Chg = Info->Chg;
-            if ((*Use & (SLV_TOP | SLV_IND)) != 0) {
-                *Use |= REG_SP;
-            }
-        } else {
+        if (!GetRuntimeFuncInfo (Name, Use, Chg)) {
             /* It's an internal function we have no information for. If in
             ** debug mode, output an additional warning, so we have a chance
             ** to fix it. Otherwise assume that the internal function will
@@ -663,6 +709,25 @@ const ZPInfo* GetZPInfo (const char* Name)
 
 
 
+static int CompareStackFuncInfo (const void* Key, const void* Info)
+/* Compare function for bsearch */
+{
+    return strcmp (Key, ((const StackFuncInfo*) Info)->Name);
+}
+
+
+
+const StackFuncInfo* GetStackFuncInfo (const char* Name)
+/* If Name is a runtime function that accesses a variable in the C stack
+** frame, return a pointer to the info struct for it, otherwise return NULL.
+*/
+{
+    return bsearch (Name, StackFuncInfoTable, StackFuncInfoCount,
+                    sizeof(StackFuncInfo), CompareStackFuncInfo);
+}
+
+
+
 static unsigned GetRegInfo2 (CodeSeg* S,
                              CodeEntry* E,
                              int Index,
@@ -690,8 +755,9 @@ static unsigned GetRegInfo2 (CodeSeg* S,
 
         /* Evaluate the used registers */
         R = E->Use;
-        if (E->OPC == OP65_RTS ||
-            ((E->Info & OF_UBRA) != 0 && E->JumpTo == 0)) {
+        if ((E->Flags & CEF_JUMPTABLE) == 0 &&
+            (E->OPC == OP65_RTS ||
+             ((E->Info & OF_UBRA) != 0 && E->JumpTo == 0))) {
             /* This instruction will leave the function */
             R |= S->ExitRegs;
         }
@@ -719,6 +785,22 @@ static unsigned GetRegInfo2 (CodeSeg* S,
             break;
         }
 
+        /* If the instruction jumps through a table, follow all entries of
+        ** the table. Registers are used if they're used by any of them.
+        */
+        if (E->Flags & CEF_JUMPTABLE) {
+
+            const JumpTable* T = CS_GetJumpTable (E);
+            unsigned U = Used;
+            unsigned I;
+
+            for (I = 0; I < CollCount (&T->Labels); ++I) {
+                const CodeLabel* L = CollConstAt (&T->Labels, I);
+                U |= GetRegInfo2 (S, L->Owner, -1, Visited, Used, Unused, Wanted);
+            }
+            return U;
+        }
+
         /* If the instruction is an RTS or RTI, we're done */
         if ((E->Info & OF_RET) != 0) {
             break;
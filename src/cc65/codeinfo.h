@@ -160,6 +160,34 @@ typedef enum {
 
 
 
+/* Runtime functions that access a variable in the C stack frame */
+typedef enum {
+    SFK_ADDEQ,          /* Add ax to a word */
+    SFK_LADDEQ,         /* Add eax to a long */
+    SFK_LDAX,           /* Load a word into ax */
+    SFK_LDEAX,          /* Load a long into eax */
+    SFK_LEAA,           /* Load the address of c_sp+a into ax */
+    SFK_LEAAX,          /* Load the address of c_sp+ax into ax */
+    SFK_LSUBEQ,         /* Subtract eax from a long */
+    SFK_REGSWAP1,       /* Swap a byte with the register bank */
+    SFK_REGSWAP2,       /* Swap a word with the register bank */
+    SFK_STAX,           /* Store ax into a word */
+    SFK_STEAX,          /* Store eax into a long */
+    SFK_SUBEQ,          /* Subtract ax from a word */
+} sfkind_t;
+
+/* Stack frame access of a runtime function */
+typedef struct StackFuncInfo StackFuncInfo;
+struct StackFuncInfo {
+    const char*     Name;       /* Name of the runtime function */
+    int             Y;          /* Offset, -1 if it is passed in Y */
+    int             Lo;         /* Offset of the first byte from the above */
+    unsigned        Size;       /* Number of bytes accessed */
+    sfkind_t        Kind;       /* What the function does */
+};
+
+
+
 /*****************************************************************************/
 /*                                   Code                                    */
 /*****************************************************************************/
@@ -169,6 +197,12 @@ typedef enum {
 int IsZPArg (const char* Arg);
 /* Exam if the main part of the arg string indicates a ZP loc */
 
+int GetRuntimeFuncInfo (const char* Name, unsigned* Use, unsigned* Chg);
+/* If Name is one of the runtime functions we know, store its register
+** information into the given variables and return true. Otherwise return
+** false and leave the variables alone.
+*/
+
 fncls_t GetFuncInfo (const char* Name, unsigned int* Use, unsigned int* Chg);
 /* For the given function, lookup register information and store it into
 ** the given variables. If the function is unknown, assume it will use and
@@ -181,6 +215,11 @@ const ZPInfo* GetZPInfo (const char* Name);
 ** struct for this symbol, otherwise return NULL.
 */
 
+const StackFuncInfo* GetStackFuncInfo (const char* Name);
+/* If Name is a runtime function that accesses a variable in the C stack
+** frame, return a pointer to the info struct for it, otherwise return NULL.
+*/
+
 unsigned GetRegInfo (struct CodeSeg* S, unsigned Index, unsigned Wanted);
 /* Determine register usage information for the instructions starting at the
 ** given index.
@@ -0,0 +1,583 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                codeinline.c                               */
+/*                                                                           */
+/*                  Inline expansion of small local functions                */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <string.h>
+
+/* common */
+#include "chartype.h"
+#include "coll.h"
+#include "strbuf.h"
+#include "xmalloc.h"
+
+/* cc65 */
+#include "asmlabel.h"
+#include "codeent.h"
+#include "codeinline.h"
+#include "codeopt.h"
+#include "codeseg.h"
+#include "dataseg.h"
+#include "datatype.h"
+#include "funcdesc.h"
+#include "ident.h"
+#include "segments.h"
+#include "symentry.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Size of the code that replaces an inlined call */
+#define INLINE_CALL_SIZE        3
+
+/* A function defined in this translation unit that may be inlined */
+typedef struct InlineFunc InlineFunc;
+struct InlineFunc {
+    SymEntry*       Func;               /* The function */
+    SegContext*     Seg;                /* Its segments */
+    unsigned        Refs;               /* References from code and data */
+    unsigned        Size;               /* Size of the code */
+    unsigned        CopySize;           /* Size of the code if inlined */
+    unsigned char   Done;               /* Code is optimized and final */
+    unsigned char   CanInline;          /* Code may be copied into a caller */
+    unsigned char   Dropped;            /* Function is not output */
+};
+
+
+
+/*****************************************************************************/
+/*                                  Helpers                                  */
+/*****************************************************************************/
+
+
+
+static int CmpInlineFunc (void* Data attribute ((unused)),
+                          const void* Left, const void* Right)
+/* Compare function for CollSort */
+{
+    return strcmp (((const InlineFunc*) Left)->Func->AsmName,
+                   ((const InlineFunc*) Right)->Func->AsmName);
+}
+
+
+
+static InlineFunc* FindInlineFunc (const Collection* Funcs, const char* Name)
+/* Search for the function with the given assembler name in the sorted
+** collection. Return NULL if it is not found.
+*/
+{
+    int Lo = 0;
+    int Hi = (int) CollCount (Funcs) - 1;
+    while (Lo <= Hi) {
+        int Cur = (Lo + Hi) / 2;
+        InlineFunc* F = CollAtUnchecked (Funcs, Cur);
+        int Res = strcmp (F->Func->AsmName, Name);
+        if (Res == 0) {
+            return F;
+        } else if (Res < 0) {
+            Lo = Cur + 1;
+        } else {
+            Hi = Cur - 1;
+        }
+    }
+    return 0;
+}
+
+
+
+static void CountRefs (Collection* Funcs, const char* Text, int Delta)
+/* Add Delta to the reference counter of all functions from Funcs that are
+** used in Text.
+*/
+{
+    StrBuf Ident = AUTO_STRBUF_INITIALIZER;
+
+    while ((Text = NextIdent (Text, &Ident)) != 0) {
+        if (SB_At (&Ident, 0) == '_') {
+            InlineFunc* F = FindInlineFunc (Funcs, SB_GetConstBuf (&Ident));
+            if (F) {
+                F->Refs += Delta;
+            }
+        }
+    }
+
+    SB_Done (&Ident);
+}
+
+
+
+static void CountCodeRefs (Collection* Funcs, CodeSeg* S, int Delta)
+/* Count the references to the functions from Funcs in the code of S */
+{
+    unsigned I;
+    for (I = 0; I < CS_GetEntryCount (S); ++I) {
+        CountRefs (Funcs, CS_GetEntry (S, I)->Arg, Delta);
+    }
+}
+
+
+
+static void CountDataRefs (Collection* Funcs, const DataSeg* S, int Delta)
+/* Count the references to the functions from Funcs in the data of S */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (&S->Lines); ++I) {
+        CountRefs (Funcs, CollConstAt (&S->Lines, I), Delta);
+    }
+}
+
+
+
+static void CountSegRefs (Collection* Funcs, SegContext* Seg, int Delta)
+/* Count the references to the functions from Funcs in all segments of Seg */
+{
+    CountCodeRefs (Funcs, Seg->Code, Delta);
+    CountDataRefs (Funcs, Seg->Data, Delta);
+    CountDataRefs (Funcs, Seg->ROData, Delta);
+    CountDataRefs (Funcs, Seg->BSS, Delta);
+}
+
+
+
+static int HasLocalLabelName (const char* Text)
+/* Return true if Text contains the name of a local code label */
+{
+    StrBuf Ident = AUTO_STRBUF_INITIALIZER;
+    int Found = 0;
+
+    while (!Found && (Text = NextIdent (Text, &Ident)) != 0) {
+        Found = IsLocalLabelName (SB_GetConstBuf (&Ident));
+    }
+
+    SB_Done (&Ident);
+    return Found;
+}
+
+
+
+static int IsCandidate (const SegContext* Seg)
+/* Return true if the function with the given segments is a candidate for
+** inlining.
+*/
+{
+    const SymEntry* Func = Seg->Code->Func;
+
+    return Seg->Code->Optimize                                  &&
+           SymIsLocalFunc (Func)                                &&
+           (GetFuncDesc (Func->Type)->Flags & FD_VARIADIC) == 0;
+}
+
+
+
+static int CanCopyCode (const SegContext* Seg)
+/* Return true if the code of the function can be copied into a caller. This
+** is not possible if the code uses its own data, accesses the return address
+** or uses labels other than as a branch target.
+*/
+{
+    CodeSeg*    S = Seg->Code;
+    unsigned    Count = CS_GetEntryCount (S);
+    unsigned    I, J;
+
+    /* Local data is in the scope of the function */
+    if (CollCount (&Seg->Data->Lines)   > 0 ||
+        CollCount (&Seg->ROData->Lines) > 0 ||
+        CollCount (&Seg->BSS->Lines)    > 0) {
+        return 0;
+    }
+
+    /* Execution must not run past the end of the code */
+    if (Count == 0 || (CS_GetEntry (S, Count - 1)->Info & OF_DEAD) == 0) {
+        return 0;
+    }
+
+    for (I = 0; I < Count; ++I) {
+
+        CodeEntry* E = CS_GetEntry (S, I);
+
+        if (E->OPC == OP65_BRK || E->OPC == OP65_RTI ||
+            E->OPC == OP65_TSX || E->OPC == OP65_TXS ||
+            (E->Flags & CEF_JUMPTABLE) != 0) {
+            return 0;
+        }
+
+        /* Labels are renamed in the copy, so they must not be used by name */
+        for (J = 0; J < CE_GetLabelCount (E); ++J) {
+            if (!IsLocalLabelName (CE_GetLabel (E, J)->Name)) {
+                return 0;
+            }
+        }
+        if (E->JumpTo == 0) {
+            if ((E->Info & OF_CBRA) != 0                        ||
+                ((E->Info & OF_UBRA) != 0 && E->AM != AM65_BRA) ||
+                HasLocalLabelName (E->Arg)) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+
+static unsigned CodeSize (CodeSeg* S)
+/* Return the size of the code of S */
+{
+    unsigned Size = 0;
+    unsigned I;
+
+    for (I = 0; I < CS_GetEntryCount (S); ++I) {
+        Size += CS_GetEntry (S, I)->Size;
+    }
+    return Size;
+}
+
+
+
+static unsigned CopySize (CodeSeg* S)
+/* Return the size of the code of S when it replaces a call. A return becomes
+** a jump behind the call, and a tail call becomes a call followed by such a
+** jump. The jump at the end is removed by the optimizer.
+*/
+{
+    unsigned Count = CS_GetEntryCount (S);
+    unsigned Size = 0;
+    unsigned I;
+
+    for (I = 0; I < Count; ++I) {
+        const CodeEntry* E = CS_GetEntry (S, I);
+        if (E->OPC == OP65_RTS) {
+            Size += 3;
+        } else if (E->OPC == OP65_JMP && E->JumpTo == 0) {
+            Size += 6;
+        } else {
+            Size += E->Size;
+        }
+    }
+    return Count > 0? Size - 3 : 0;
+}
+
+
+
+static InlineFunc* GetCallee (const Collection* Funcs, const CodeEntry* E)
+/* If E is a subroutine call of one of the functions in Funcs, return the
+** function. Otherwise return NULL.
+*/
+{
+    if (E->OPC == OP65_JSR && E->AM == AM65_ABS) {
+        return FindInlineFunc (Funcs, E->Arg);
+    }
+    return 0;
+}
+
+
+
+static int HasPendingCallee (const Collection* Funcs, const InlineFunc* F)
+/* Return true if F calls a function from Funcs that is not yet done */
+{
+    CodeSeg* S = F->Seg->Code;
+    unsigned I;
+
+    for (I = 0; I < CS_GetEntryCount (S); ++I) {
+        const InlineFunc* Callee = GetCallee (Funcs, CS_GetEntry (S, I));
+        if (Callee && Callee != F && !Callee->Done) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+static int ShouldInline (const InlineFunc* F, const CodeSeg* Caller)
+/* Decide if a call of F from Caller is replaced by the code of F */
+{
+    unsigned Limit;
+
+    /* If this call is the only reference, the function is dropped afterwards,
+    ** so the copy replaces both, the call and the function.
+    */
+    if (F->Refs == 1) {
+        Limit = (F->Size + INLINE_CALL_SIZE) * Caller->CodeSizeFactor / 100;
+    } else {
+        /* Otherwise the code may not be much larger than the call, unless
+        ** the user asked for it by declaring the function inline.
+        */
+        Limit = INLINE_CALL_SIZE * Caller->CodeSizeFactor / 100;
+        if (F->Func->Flags & SC_INLINE) {
+            Limit *= 4;
+        }
+    }
+    return F->CopySize <= Limit;
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+static unsigned InlineCall (Collection* Funcs, CodeSeg* S, unsigned Index,
+                            InlineFunc* F)
+/* Replace the subroutine call at Index in S by a copy of the code of F.
+** Return the number of entries inserted.
+*/
+{
+    CodeSeg*    Body  = F->Seg->Code;
+    unsigned    Count = CS_GetEntryCount (Body);
+    CodeEntry*  Call  = CS_GetEntry (S, Index);
+    CodeEntry*  Next  = CS_GetEntry (S, Index + 1);
+    CodeLabel*  Ret   = 0;
+    CodeEntry** Copy  = xmalloc (Count * sizeof (CodeEntry*));
+    unsigned    Pos   = Index + 1;
+    unsigned    I;
+
+    /* Copy the code. Returns become jumps behind the call. */
+    for (I = 0; I < Count; ++I) {
+
+        CodeEntry* E = CS_GetEntry (Body, I);
+        CodeEntry* X;
+
+        /* Don't create an unused label */
+        if (Ret == 0 && (E->OPC == OP65_RTS || (E->OPC == OP65_JMP && E->JumpTo == 0))) {
+            Ret = CS_GenLabel (S, Next);
+        }
+
+        if (E->OPC == OP65_RTS) {
+            X = NewCodeEntry (OP65_JMP, AM65_BRA, Ret->Name, Ret, E->LI);
+        } else if (E->OPC == OP65_JMP && E->JumpTo == 0) {
+            /* Tail call of another function */
+            Copy[I] = NewCodeEntry (OP65_JSR, AM65_ABS, E->Arg, 0, E->LI);
+            CS_InsertEntry (S, Copy[I], Pos++);
+            CountRefs (Funcs, E->Arg, 1);
+            X = NewCodeEntry (OP65_JMP, AM65_BRA, Ret->Name, Ret, E->LI);
+            CS_InsertEntry (S, X, Pos++);
+            continue;
+        } else {
+            X = NewCodeEntry (E->OPC, E->AM, E->Arg, 0, E->LI);
+            CountRefs (Funcs, X->Arg, 1);
+        }
+        Copy[I] = X;
+        CS_InsertEntry (S, X, Pos++);
+    }
+
+    /* Branches within the code get new labels */
+    for (I = 0; I < Count; ++I) {
+        CodeEntry* E = CS_GetEntry (Body, I);
+        if (E->JumpTo) {
+            unsigned Target = CS_GetEntryIndex (Body, E->JumpTo->Owner);
+            CL_AddRef (CS_GenLabel (S, Copy[Target]), Copy[I]);
+        }
+    }
+
+    /* Remove the call */
+    if (CE_HasLabel (Call)) {
+        CS_MoveLabels (S, Call, Copy[0]);
+    }
+    CS_DelEntry (S, Index);
+    --F->Refs;
+
+    xfree (Copy);
+    return Pos - Index - 1;
+}
+
+
+
+static unsigned InlineCalls (Collection* Funcs, SegContext* Seg)
+/* Inline the calls of functions from Funcs in the code of Seg. Return the
+** number of calls replaced.
+*/
+{
+    CodeSeg* S = Seg->Code;
+    unsigned Changes = 0;
+    unsigned I = 0;
+
+    if (!S->Optimize) {
+        return 0;
+    }
+
+    /* Labels are generated from the pool of the function */
+    UseLabelPoolFromSegments (Seg);
+
+    while (I < CS_GetEntryCount (S)) {
+
+        InlineFunc* F = GetCallee (Funcs, CS_GetEntry (S, I));
+
+        if (F && F->Done && F->CanInline && F->Seg != Seg &&
+            I + 1 < CS_GetEntryCount (S) && ShouldInline (F, S)) {
+            /* The inserted code is final, so skip it */
+            I += InlineCall (Funcs, S, I, F);
+            ++Changes;
+        } else {
+            ++I;
+        }
+    }
+
+    return Changes;
+}
+
+
+
+void InlineFuncs (Collection* Funcs)
+/* Funcs contains the segment contexts of all functions that are output.
+** Optimize the static and inline functions among them, and replace calls
+** of those that are small enough by a copy of their code. Functions that
+** are no longer referenced afterwards are not output. The segments that
+** were already optimized are removed from Funcs, so the remaining ones
+** must be optimized by the caller.
+*/
+{
+    Collection  Cands = AUTO_COLLECTION_INITIALIZER;
+    Collection  Round = AUTO_COLLECTION_INITIALIZER;
+    Collection  Segs  = AUTO_COLLECTION_INITIALIZER;
+    unsigned    Pending;
+    unsigned    Changes;
+    unsigned    I;
+
+    /* Collect the candidates */
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        SegContext* Seg = CollAtUnchecked (Funcs, I);
+        if (IsCandidate (Seg)) {
+            InlineFunc* F = xmalloc (sizeof (InlineFunc));
+            F->Func      = Seg->Code->Func;
+            F->Seg       = Seg;
+            F->Refs      = 0;
+            F->Size      = 0;
+            F->CopySize  = 0;
+            F->Done      = 0;
+            F->CanInline = 0;
+            F->Dropped   = 0;
+            CollAppend (&Cands, F);
+        }
+    }
+    if (CollCount (&Cands) == 0) {
+        DoneCollection (&Cands);
+        return;
+    }
+    CollSort (&Cands, CmpInlineFunc, 0);
+
+    /* Count the references to the candidates */
+    CountSegRefs (&Cands, GS, 1);
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        CountSegRefs (&Cands, CollAtUnchecked (Funcs, I), 1);
+    }
+
+    /* Finish the candidates bottom up, so the code of a callee is final when
+    ** it is copied into its callers.
+    */
+    Pending = CollCount (&Cands);
+    while (Pending > 0) {
+
+        for (I = 0; I < CollCount (&Cands); ++I) {
+            InlineFunc* F = CollAtUnchecked (&Cands, I);
+            if (!F->Done && !HasPendingCallee (&Cands, F)) {
+                CollAppend (&Round, F);
+            }
+        }
+
+        /* Recursive functions call each other, so take all of them */
+        if (CollCount (&Round) == 0) {
+            for (I = 0; I < CollCount (&Cands); ++I) {
+                InlineFunc* F = CollAtUnchecked (&Cands, I);
+                if (!F->Done) {
+                    CollAppend (&Round, F);
+                }
+            }
+        }
+
+        /* Inline the finished callees and optimize the result. The optimizer
+        ** may remove references, so count them again.
+        */
+        for (I = 0; I < CollCount (&Round); ++I) {
+            InlineFunc* F = CollAtUnchecked (&Round, I);
+            InlineCalls (&Cands, F->Seg);
+            CountCodeRefs (&Cands, F->Seg->Code, -1);
+            CollAppend (&Segs, F->Seg);
+        }
+        RunOptSegs (&Segs);
+        for (I = 0; I < CollCount (&Round); ++I) {
+            InlineFunc* F = CollAtUnchecked (&Round, I);
+            CountCodeRefs (&Cands, F->Seg->Code, 1);
+            F->Done      = 1;
+            F->CanInline = CanCopyCode (F->Seg);
+            F->Size      = CodeSize (F->Seg->Code);
+            F->CopySize  = CopySize (F->Seg->Code);
+        }
+
+        Pending -= CollCount (&Round);
+        CollDeleteAll (&Round);
+        CollDeleteAll (&Segs);
+    }
+
+    /* Inline the candidates into all other functions */
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        SegContext* Seg = CollAtUnchecked (Funcs, I);
+        if (!IsCandidate (Seg)) {
+            InlineCalls (&Cands, Seg);
+        }
+    }
+
+    /* Drop the candidates that are no longer referenced. This may remove
+    ** the last reference to another one.
+    */
+    do {
+        Changes = 0;
+        for (I = 0; I < CollCount (&Cands); ++I) {
+            InlineFunc* F = CollAtUnchecked (&Cands, I);
+            if (F->Refs == 0 && !F->Dropped) {
+                F->Func->Flags |= SC_INLINED;
+                F->Dropped = 1;
+                CountSegRefs (&Cands, F->Seg, -1);
+                ++Changes;
+            }
+        }
+    } while (Changes > 0);
+
+    /* The candidates are optimized, remove them from the list */
+    I = CollCount (Funcs);
+    while (I-- > 0) {
+        if (IsCandidate (CollAtUnchecked (Funcs, I))) {
+            CollDelete (Funcs, I);
+        }
+    }
+
+    /* Free the candidates */
+    for (I = 0; I < CollCount (&Cands); ++I) {
+        xfree (CollAtUnchecked (&Cands, I));
+    }
+    DoneCollection (&Cands);
+    DoneCollection (&Round);
+    DoneCollection (&Segs);
+}
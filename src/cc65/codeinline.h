@@ -0,0 +1,59 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                codeinline.h                               */
+/*                                                                           */
+/*                  Inline expansion of small local functions                */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef CODEINLINE_H
+#define CODEINLINE_H
+
+
+
+/* common */
+#include "coll.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void InlineFuncs (Collection* Funcs);
+/* Funcs contains the segment contexts of all functions that are output.
+** Optimize the static and inline functions among them, and replace calls
+** of those that are small enough by a copy of their code. Functions that
+** are no longer referenced afterwards are not output. The segments that
+** were already optimized are removed from Funcs, so the remaining ones
+** must be optimized by the caller.
+*/
+
+
+
+/* End of codeinline.h */
+
+#endif
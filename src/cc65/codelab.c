@@ -104,8 +104,8 @@ void CL_AddRef (CodeLabel* L, struct CodeEntry* E)
 
 
 void CL_MoveRefs (CodeLabel* OldLabel, CodeLabel* NewLabel)
-/* Move all references to OldLabel to point to NewLabel. OldLabel will have no
-** more references on return.
+/* Move all references to OldLabel to point to NewLabel. On return, OldLabel
+** is only referenced by insns jumping through a table, see CS_AddJumpTable.
 */
 {
     /* Walk through all instructions referencing the old label */
@@ -115,15 +115,20 @@ void CL_MoveRefs (CodeLabel* OldLabel, CodeLabel* NewLabel)
         /* Get the instruction that references the old label */
         CodeEntry* E = CL_GetRef (OldLabel, Count);
 
+        /* An insn jumping through a table does not jump to the label
+        ** directly. The caller must update the table.
+        */
+        if (E->Flags & CEF_JUMPTABLE) {
+            continue;
+        }
+
         /* Change the reference to the new label */
         CHECK (E->JumpTo != NULL);
         CHECK (E->JumpTo == OldLabel);
         CL_AddRef (NewLabel, E);
+        CollDelete (&OldLabel->JumpFrom, Count);
 
     }
-
-    /* There are no more references to the old label */
-    CollDeleteAll (&OldLabel->JumpFrom);
 }
 
 
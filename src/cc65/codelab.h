@@ -99,8 +99,8 @@ void CL_AddRef (CodeLabel* L, struct CodeEntry* E);
 /* Let the CodeEntry E reference the label L */
 
 void CL_MoveRefs (CodeLabel* OldLabel, CodeLabel* NewLabel);
-/* Move all references to OldLabel to point to NewLabel. OldLabel will have no
-** more references on return.
+/* Move all references to OldLabel to point to NewLabel. On return, OldLabel
+** is only referenced by insns jumping through a table, see CS_AddJumpTable.
 */
 
 void CL_Output (const CodeLabel* L);
@@ -39,15 +39,20 @@
 
 /* common */
 #include "abend.h"
+#include "attrib.h"
 #include "chartype.h"
+#include "coll.h"
 #include "cpu.h"
 #include "debugflag.h"
 #include "print.h"
 #include "strbuf.h"
+#include "thread.h"
+#include "walltime.h"
 #include "xmalloc.h"
 #include "xsprintf.h"
 
 /* cc65 */
+#include "asmlabel.h"
 #include "codeent.h"
 #include "codeinfo.h"
 #include "codeopt.h"
@@ -58,7 +63,9 @@
 #include "coptind.h"
 #include "coptjmp.h"
 #include "coptlong.h"
+#include "coptloop.h"
 #include "coptmisc.h"
+#include "coptpat.h"
 #include "coptptrload.h"
 #include "coptptrstore.h"
 #include "coptpush.h"
@@ -72,6 +79,7 @@
 #include "error.h"
 #include "global.h"
 #include "output.h"
+#include "segments.h"
 
 
 
@@ -90,9 +98,33 @@ struct OptFunc {
     unsigned long  LastRuns;            /* Last number of runs */
     unsigned long  TotalChanges;        /* Total number of changes */
     unsigned long  LastChanges;         /* Last number of changes */
+    double         TotalTime;           /* Total time spent in seconds */
+    double         LastTime;            /* Last time spent in seconds */
     char           Disabled;            /* True if function disabled */
 };
 
+/* True if the statistics of the optimizer steps are collected */
+static int CollectStats = 0;
+
+/* Pseudo step that accounts for the register info generated between the
+** steps. Calls of CS_GenRegInfo from within a step count for the step.
+*/
+static OptFunc DGenRegInfo = { 0, "GenRegInfo", 0, 0, 0, 0, 0, 0, 0, 0 };
+
+/* Segments to optimize for the threads of RunOptSegs */
+typedef struct OptQueue OptQueue;
+struct OptQueue {
+    const Collection*   Segs;           /* Segment contexts */
+    unsigned            Next;           /* Index of the next one */
+};
+
+/* A step in an optimizer group */
+typedef struct OptStep OptStep;
+struct OptStep {
+    OptFunc*       Func;                /* The optimizer function */
+    unsigned       Max;                 /* Max. number of runs in a row */
+};
+
 
 
 /*****************************************************************************/
@@ -104,128 +136,133 @@ struct OptFunc {
 /* A list of all the function descriptions */
 /* CAUTION: should be sorted by "name" */
 /* BEGIN DECL SORTED_CODEOPT.SH */
-static OptFunc DOpt65C02BitOps  = { Opt65C02BitOps,  "Opt65C02BitOps",   66, 0, 0, 0, 0, 0 };
-static OptFunc DOpt65C02Ind     = { Opt65C02Ind,     "Opt65C02Ind",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOpt65C02Stores  = { Opt65C02Stores,  "Opt65C02Stores",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptAXLoad       = { OptAXLoad,       "OptAXLoad",        50, 0, 0, 0, 0, 0 };
-static OptFunc DOptAXLoad2      = { OptAXLoad2,      "OptAXLoad2",       66, 0, 0, 0, 0, 0 };
-static OptFunc DOptAXOps        = { OptAXOps,        "OptAXOps",         50, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd1         = { OptAdd1,         "OptAdd1",         125, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd2         = { OptAdd2,         "OptAdd2",         200, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd3         = { OptAdd3,         "OptAdd3",          65, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd4         = { OptAdd4,         "OptAdd4",          90, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd5         = { OptAdd5,         "OptAdd5",         100, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd6         = { OptAdd6,         "OptAdd6",          40, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegA1       = { OptBNegA1,       "OptBNegA1",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegA2       = { OptBNegA2,       "OptBNegA2",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegAX1      = { OptBNegAX1,      "OptBNegAX1",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegAX2      = { OptBNegAX2,      "OptBNegAX2",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegAX3      = { OptBNegAX3,      "OptBNegAX3",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBNegAX4      = { OptBNegAX4,      "OptBNegAX4",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBinOps1      = { OptBinOps1,      "OptBinOps1",        0, 0, 0, 0, 0, 0 };
-static OptFunc DOptBinOps2      = { OptBinOps2,      "OptBinOps2",        0, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolCmp      = { OptBoolCmp,      "OptBoolCmp",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolTrans    = { OptBoolTrans,    "OptBoolTrans",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolUnary1   = { OptBoolUnary1,   "OptBoolUnary1",    40, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolUnary2   = { OptBoolUnary2,   "OptBoolUnary2",    40, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolUnary3   = { OptBoolUnary3,   "OptBoolUnary3",    40, 0, 0, 0, 0, 0 };
-static OptFunc DOptBranchDist   = { OptBranchDist,   "OptBranchDist",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptBranchDist2  = { OptBranchDist2,  "OptBranchDist2",    0, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp1         = { OptCmp1,         "OptCmp1",          42, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp2         = { OptCmp2,         "OptCmp2",          85, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp3         = { OptCmp3,         "OptCmp3",          75, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp4         = { OptCmp4,         "OptCmp4",          75, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp5         = { OptCmp5,         "OptCmp5",         100, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp6         = { OptCmp6,         "OptCmp6",          33, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp7         = { OptCmp7,         "OptCmp7",          85, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp8         = { OptCmp8,         "OptCmp8",          50, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp9         = { OptCmp9,         "OptCmp9",          85, 0, 0, 0, 0, 0 };
-static OptFunc DOptComplAX1     = { OptComplAX1,     "OptComplAX1",      65, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranch1  = { OptCondBranch1,  "OptCondBranch1",   80, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranch2  = { OptCondBranch2,  "OptCondBranch2",   40, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranch3  = { OptCondBranch3,  "OptCondBranch3",   40, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranchC  = { OptCondBranchC,  "OptCondBranchC",    0, 0, 0, 0, 0, 0 };
-static OptFunc DOptDeadCode     = { OptDeadCode,     "OptDeadCode",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDeadJumps    = { OptDeadJumps,    "OptDeadJumps",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDecouple     = { OptDecouple,     "OptDecouple",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDupLoads     = { OptDupLoads,     "OptDupLoads",       0, 0, 0, 0, 0, 0 };
-static OptFunc DOptGotoSPAdj    = { OptGotoSPAdj,    "OptGotoSPAdj",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptIndLoads1    = { OptIndLoads1,    "OptIndLoads1",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptIndLoads2    = { OptIndLoads2,    "OptIndLoads2",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpCascades = { OptJumpCascades, "OptJumpCascades", 100, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpTarget1  = { OptJumpTarget1,  "OptJumpTarget1",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpTarget2  = { OptJumpTarget2,  "OptJumpTarget2",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpTarget3  = { OptJumpTarget3,  "OptJumpTarget3",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoad1        = { OptLoad1,        "OptLoad1",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoad2        = { OptLoad2,        "OptLoad2",        200, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoad3        = { OptLoad3,        "OptLoad3",          0, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoadStore1   = { OptLoadStore1,   "OptLoadStore1",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoadStore2   = { OptLoadStore2,   "OptLoadStore2",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoadStoreLoad= { OptLoadStoreLoad,"OptLoadStoreLoad",  0, 0, 0, 0, 0, 0 };
-static OptFunc DOptLongAssign   = { OptLongAssign,   "OptLongAssign",   100, 0, 0, 0, 0, 0 };
-static OptFunc DOptLongCopy     = { OptLongCopy,     "OptLongCopy",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX1       = { OptNegAX1,       "OptNegAX1",       165, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX2       = { OptNegAX2,       "OptNegAX2",       200, 0, 0, 0, 0, 0 };
-static OptFunc DOptPrecalc      = { OptPrecalc,      "OptPrecalc",      100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad1     = { OptPtrLoad1,     "OptPtrLoad1",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad11    = { OptPtrLoad11,    "OptPtrLoad11",     92, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad12    = { OptPtrLoad12,    "OptPtrLoad12",     50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad13    = { OptPtrLoad13,    "OptPtrLoad13",     65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad14    = { OptPtrLoad14,    "OptPtrLoad14",    108, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad15    = { OptPtrLoad15,    "OptPtrLoad15",     86, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad16    = { OptPtrLoad16,    "OptPtrLoad16",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad17    = { OptPtrLoad17,    "OptPtrLoad17",    190, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad18    = { OptPtrLoad18,    "OptPtrLoad18",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad19    = { OptPtrLoad19,    "OptPtrLoad19",     65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad2     = { OptPtrLoad2,     "OptPtrLoad2",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad20    = { OptPtrLoad20,    "OptPtrLoad20",     90, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad3     = { OptPtrLoad3,     "OptPtrLoad3",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad4     = { OptPtrLoad4,     "OptPtrLoad4",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad5     = { OptPtrLoad5,     "OptPtrLoad5",      50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad6     = { OptPtrLoad6,     "OptPtrLoad6",      60, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad7     = { OptPtrLoad7,     "OptPtrLoad7",     140, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrStore1    = { OptPtrStore1,    "OptPtrStore1",     65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrStore2    = { OptPtrStore2,    "OptPtrStore2",     65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrStore3    = { OptPtrStore3,    "OptPtrStore3",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPush1        = { OptPush1,        "OptPush1",         65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPush2        = { OptPush2,        "OptPush2",         50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPushPop1     = { OptPushPop1,     "OptPushPop1",       0, 0, 0, 0, 0, 0 };
-static OptFunc DOptPushPop2     = { OptPushPop2,     "OptPushPop2",       0, 0, 0, 0, 0, 0 };
-static OptFunc DOptPushPop3     = { OptPushPop3,     "OptPushPop3",       0, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTS          = { OptRTS,          "OptRTS",          100, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTSJumps1    = { OptRTSJumps1,    "OptRTSJumps1",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTSJumps2    = { OptRTSJumps2,    "OptRTSJumps2",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift1       = { OptShift1,       "OptShift1",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift2       = { OptShift2,       "OptShift2",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift3       = { OptShift3,       "OptShift3",        17, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift4       = { OptShift4,       "OptShift4",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift5       = { OptShift5,       "OptShift5",       110, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift6       = { OptShift6,       "OptShift6",       200, 0, 0, 0, 0, 0 };
-static OptFunc DOptShiftBack    = { OptShiftBack,    "OptShiftBack",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptSignExtended = { OptSignExtended, "OptSignExtended",   0, 0, 0, 0, 0, 0 };
-static OptFunc DOptSize1        = { OptSize1,        "OptSize1",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSize2        = { OptSize2,        "OptSize2",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStackOps     = { OptStackOps,     "OptStackOps",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStackPtrOps  = { OptStackPtrOps,  "OptStackPtrOps",   50, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore1       = { OptStore1,       "OptStore1",        70, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore2       = { OptStore2,       "OptStore2",       115, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore3       = { OptStore3,       "OptStore3",       120, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore4       = { OptStore4,       "OptStore4",        50, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore5       = { OptStore5,       "OptStore5",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStoreLoad    = { OptStoreLoad,    "OptStoreLoad",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub1         = { OptSub1,         "OptSub1",         100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub2         = { OptSub2,         "OptSub2",         100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub3         = { OptSub3,         "OptSub3",         100, 0, 0, 0, 0, 0 };
-static OptFunc DOptTest1        = { OptTest1,        "OptTest1",         65, 0, 0, 0, 0, 0 };
-static OptFunc DOptTest2        = { OptTest2,        "OptTest2",         50, 0, 0, 0, 0, 0 };
-static OptFunc DOptTosLoadPop   = { OptTosLoadPop,   "OptTosLoadPop",    50, 0, 0, 0, 0, 0 };
-static OptFunc DOptTosPushPop   = { OptTosPushPop,   "OptTosPushPop",    33, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers1   = { OptTransfers1,   "OptTransfers1",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers2   = { OptTransfers2,   "OptTransfers2",    60, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers3   = { OptTransfers3,   "OptTransfers3",    65, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers4   = { OptTransfers4,   "OptTransfers4",    65, 0, 0, 0, 0, 0 };
-static OptFunc DOptUnusedLoads  = { OptUnusedLoads,  "OptUnusedLoads",    0, 0, 0, 0, 0, 0 };
-static OptFunc DOptUnusedStores = { OptUnusedStores, "OptUnusedStores",   0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02BitOps  = { Opt65C02BitOps,  "Opt65C02BitOps",   66, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02Ind     = { Opt65C02Ind,     "Opt65C02Ind",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02Stores  = { Opt65C02Stores,  "Opt65C02Stores",  100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAXLoad       = { OptAXLoad,       "OptAXLoad",        50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAXLoad2      = { OptAXLoad2,      "OptAXLoad2",       66, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAXOps        = { OptAXOps,        "OptAXOps",         50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd1         = { OptAdd1,         "OptAdd1",         125, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd2         = { OptAdd2,         "OptAdd2",         200, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd3         = { OptAdd3,         "OptAdd3",          65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd4         = { OptAdd4,         "OptAdd4",          90, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd5         = { OptAdd5,         "OptAdd5",         100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd6         = { OptAdd6,         "OptAdd6",          40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegA1       = { OptBNegA1,       "OptBNegA1",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegA2       = { OptBNegA2,       "OptBNegA2",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegAX1      = { OptBNegAX1,      "OptBNegAX1",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegAX2      = { OptBNegAX2,      "OptBNegAX2",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegAX3      = { OptBNegAX3,      "OptBNegAX3",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBNegAX4      = { OptBNegAX4,      "OptBNegAX4",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBinOps1      = { OptBinOps1,      "OptBinOps1",        0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBinOps2      = { OptBinOps2,      "OptBinOps2",        0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolCmp      = { OptBoolCmp,      "OptBoolCmp",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolTrans    = { OptBoolTrans,    "OptBoolTrans",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolUnary1   = { OptBoolUnary1,   "OptBoolUnary1",    40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolUnary2   = { OptBoolUnary2,   "OptBoolUnary2",    40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolUnary3   = { OptBoolUnary3,   "OptBoolUnary3",    40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBranchDist   = { OptBranchDist,   "OptBranchDist",     0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBranchDist2  = { OptBranchDist2,  "OptBranchDist2",    0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp1         = { OptCmp1,         "OptCmp1",          42, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp2         = { OptCmp2,         "OptCmp2",          85, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp3         = { OptCmp3,         "OptCmp3",          75, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp4         = { OptCmp4,         "OptCmp4",          75, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp5         = { OptCmp5,         "OptCmp5",         100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp6         = { OptCmp6,         "OptCmp6",          33, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp7         = { OptCmp7,         "OptCmp7",          85, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp8         = { OptCmp8,         "OptCmp8",          50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp9         = { OptCmp9,         "OptCmp9",          85, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptComplAX1     = { OptComplAX1,     "OptComplAX1",      65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranch1  = { OptCondBranch1,  "OptCondBranch1",   80, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranch2  = { OptCondBranch2,  "OptCondBranch2",   40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranch3  = { OptCondBranch3,  "OptCondBranch3",   40, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranchC  = { OptCondBranchC,  "OptCondBranchC",    0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDeadCode     = { OptDeadCode,     "OptDeadCode",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDeadJumps    = { OptDeadJumps,    "OptDeadJumps",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDecouple     = { OptDecouple,     "OptDecouple",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDupLoads     = { OptDupLoads,     "OptDupLoads",       0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptGotoSPAdj    = { OptGotoSPAdj,    "OptGotoSPAdj",      0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndLoads1    = { OptIndLoads1,    "OptIndLoads1",      0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndLoads2    = { OptIndLoads2,    "OptIndLoads2",      0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndVar       = { OptIndVar,       "OptIndVar",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndex1       = { OptIndex1,       "OptIndex1",         0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndex2       = { OptIndex2,       "OptIndex2",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpCascades = { OptJumpCascades, "OptJumpCascades", 100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpTarget1  = { OptJumpTarget1,  "OptJumpTarget1",  100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpTarget2  = { OptJumpTarget2,  "OptJumpTarget2",  100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpTarget3  = { OptJumpTarget3,  "OptJumpTarget3",  100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoad1        = { OptLoad1,        "OptLoad1",        100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoad2        = { OptLoad2,        "OptLoad2",        200, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoad3        = { OptLoad3,        "OptLoad3",          0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoadStore1   = { OptLoadStore1,   "OptLoadStore1",     0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoadStore2   = { OptLoadStore2,   "OptLoadStore2",     0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoadStoreLoad= { OptLoadStoreLoad,"OptLoadStoreLoad",  0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLongAssign   = { OptLongAssign,   "OptLongAssign",   100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLongCopy     = { OptLongCopy,     "OptLongCopy",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX1       = { OptNegAX1,       "OptNegAX1",       165, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX2       = { OptNegAX2,       "OptNegAX2",       200, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPrecalc      = { OptPrecalc,      "OptPrecalc",      100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrInc       = { OptPtrInc,       "OptPtrInc",         0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad1     = { OptPtrLoad1,     "OptPtrLoad1",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad11    = { OptPtrLoad11,    "OptPtrLoad11",     92, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad12    = { OptPtrLoad12,    "OptPtrLoad12",     50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad13    = { OptPtrLoad13,    "OptPtrLoad13",     65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad14    = { OptPtrLoad14,    "OptPtrLoad14",    108, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad15    = { OptPtrLoad15,    "OptPtrLoad15",     86, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad16    = { OptPtrLoad16,    "OptPtrLoad16",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad17    = { OptPtrLoad17,    "OptPtrLoad17",    190, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad18    = { OptPtrLoad18,    "OptPtrLoad18",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad19    = { OptPtrLoad19,    "OptPtrLoad19",     65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad2     = { OptPtrLoad2,     "OptPtrLoad2",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad20    = { OptPtrLoad20,    "OptPtrLoad20",     90, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad3     = { OptPtrLoad3,     "OptPtrLoad3",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad4     = { OptPtrLoad4,     "OptPtrLoad4",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad5     = { OptPtrLoad5,     "OptPtrLoad5",      50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad6     = { OptPtrLoad6,     "OptPtrLoad6",      60, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad7     = { OptPtrLoad7,     "OptPtrLoad7",     140, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrStore1    = { OptPtrStore1,    "OptPtrStore1",     65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrStore2    = { OptPtrStore2,    "OptPtrStore2",     65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrStore3    = { OptPtrStore3,    "OptPtrStore3",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPush1        = { OptPush1,        "OptPush1",         65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPush2        = { OptPush2,        "OptPush2",         50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPush3        = { OptPush3,        "OptPush3",        200, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPushPop1     = { OptPushPop1,     "OptPushPop1",       0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPushPop2     = { OptPushPop2,     "OptPushPop2",       0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPushPop3     = { OptPushPop3,     "OptPushPop3",       0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTS          = { OptRTS,          "OptRTS",          100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTSJumps1    = { OptRTSJumps1,    "OptRTSJumps1",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTSJumps2    = { OptRTSJumps2,    "OptRTSJumps2",    100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift1       = { OptShift1,       "OptShift1",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift2       = { OptShift2,       "OptShift2",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift3       = { OptShift3,       "OptShift3",        17, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift4       = { OptShift4,       "OptShift4",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift5       = { OptShift5,       "OptShift5",       110, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift6       = { OptShift6,       "OptShift6",       200, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShiftBack    = { OptShiftBack,    "OptShiftBack",      0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSignExtended = { OptSignExtended, "OptSignExtended",   0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSize1        = { OptSize1,        "OptSize1",        100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSize2        = { OptSize2,        "OptSize2",        100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStackOps     = { OptStackOps,     "OptStackOps",     100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStackPtrOps  = { OptStackPtrOps,  "OptStackPtrOps",   50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore1       = { OptStore1,       "OptStore1",        70, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore2       = { OptStore2,       "OptStore2",       115, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore3       = { OptStore3,       "OptStore3",       120, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore4       = { OptStore4,       "OptStore4",        50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore5       = { OptStore5,       "OptStore5",       100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStoreLoad    = { OptStoreLoad,    "OptStoreLoad",      0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub1         = { OptSub1,         "OptSub1",         100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub2         = { OptSub2,         "OptSub2",         100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub3         = { OptSub3,         "OptSub3",         100, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTest1        = { OptTest1,        "OptTest1",         65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTest2        = { OptTest2,        "OptTest2",         50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTosLoadPop   = { OptTosLoadPop,   "OptTosLoadPop",    50, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTosPushPop   = { OptTosPushPop,   "OptTosPushPop",    33, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers1   = { OptTransfers1,   "OptTransfers1",     0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers2   = { OptTransfers2,   "OptTransfers2",    60, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers3   = { OptTransfers3,   "OptTransfers3",    65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers4   = { OptTransfers4,   "OptTransfers4",    65, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptUnusedLoads  = { OptUnusedLoads,  "OptUnusedLoads",    0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptUnusedStores = { OptUnusedStores, "OptUnusedStores",   0, 0, 0, 0, 0, 0, 0, 0 };
 /* END DECL SORTED_CODEOPT.SH */
 
 
@@ -281,6 +318,9 @@ static OptFunc* OptFuncs[] = {
     &DOptGotoSPAdj,
     &DOptIndLoads1,
     &DOptIndLoads2,
+    &DOptIndVar,
+    &DOptIndex1,
+    &DOptIndex2,
     &DOptJumpCascades,
     &DOptJumpTarget1,
     &DOptJumpTarget2,
@@ -296,6 +336,7 @@ static OptFunc* OptFuncs[] = {
     &DOptNegAX1,
     &DOptNegAX2,
     &DOptPrecalc,
+    &DOptPtrInc,
     &DOptPtrLoad1,
     &DOptPtrLoad11,
     &DOptPtrLoad12,
@@ -318,6 +359,7 @@ static OptFunc* OptFuncs[] = {
     &DOptPtrStore3,
     &DOptPush1,
     &DOptPush2,
+    &DOptPush3,
     &DOptPushPop1,
     &DOptPushPop2,
     &DOptPushPop3,
@@ -465,6 +507,7 @@ static void ReadOptStats (const char* Name)
         char Name[32];
         unsigned long  TotalRuns;
         unsigned long  TotalChanges;
+        double         TotalTime;
 
         /* Remove trailing white space including the line terminator */
         B = Buf;
@@ -484,22 +527,29 @@ static void ReadOptStats (const char* Name)
             continue;
         }
 
-        /* Parse the line */
-        if (sscanf (B, "%31s %lu %*u %lu %*u", Name, &TotalRuns, &TotalChanges) != 3) {
+        /* Parse the line. Files written by older versions have no times. */
+        TotalTime = 0.0;
+        if (sscanf (B, "%31s %lu %*u %lu %*u %lf", Name, &TotalRuns,
+                    &TotalChanges, &TotalTime) < 3) {
             /* Syntax error */
             continue;
         }
 
         /* Search for the optimizer step. */
-        Func = FindOptFunc (Name);
+        if (strcmp (Name, DGenRegInfo.Name) == 0) {
+            Func = &DGenRegInfo;
+        } else {
+            Func = FindOptFunc (Name);
+        }
         if (Func == 0) {
             /* Not found */
             continue;
         }
 
-        /* Found the step, set the fields */
+        /* Found the step, set the fields. Times are stored in ms. */
         Func->TotalRuns    = TotalRuns;
         Func->TotalChanges = TotalChanges;
+        Func->TotalTime    = TotalTime / 1000.0;
 
     }
 
@@ -509,6 +559,22 @@ static void ReadOptStats (const char* Name)
 
 
 
+static void WriteOptStatsLine (FILE* F, const OptFunc* O)
+/* Write the statistics of one optimizer step */
+{
+    fprintf (F,
+             "%-20s %10lu %10lu %10lu %10lu %14.6f %14.6f\n",
+             O->Name,
+             O->TotalRuns,
+             O->LastRuns,
+             O->TotalChanges,
+             O->LastChanges,
+             O->TotalTime * 1000.0,
+             O->LastTime * 1000.0);
+}
+
+
+
 static void WriteOptStats (const char* Name)
 /* Write the optimizer statistics file */
 {
@@ -523,21 +589,17 @@ static void WriteOptStats (const char* Name)
 
     /* Write a header */
     fprintf (F,
-             "; Optimizer               Total      Last       Total      Last\n"
-             ";   Step                  Runs       Runs        Chg       Chg\n");
+             "; Optimizer               Total      Last       Total      Last"
+             "          Total           Last\n"
+             ";   Step                  Runs       Runs        Chg       Chg"
+             "        Time ms        Time ms\n");
 
 
     /* Write the data */
     for (I = 0; I < OPTFUNC_COUNT; ++I) {
-        const OptFunc* O = OptFuncs[I];
-        fprintf (F,
-                 "%-20s %10lu %10lu %10lu %10lu\n",
-                 O->Name,
-                 O->TotalRuns,
-                 O->LastRuns,
-                 O->TotalChanges,
-                 O->LastChanges);
+        WriteOptStatsLine (F, OptFuncs[I]);
     }
+    WriteOptStatsLine (F, &DGenRegInfo);
 
     /* Close the file, ignore errors here. */
     fclose (F);
@@ -587,6 +649,24 @@ static void WriteDebugOutput (CodeSeg* S, const char* Step)
 
 
 
+static void GenRegInfo (CodeSeg* S)
+/* Generate register info for S and account for the time if requested */
+{
+    if (CollectStats) {
+        double Start = WallTime ();
+        CS_GenRegInfo (S);
+        Start = WallTime () - Start;
+        ++DGenRegInfo.TotalRuns;
+        ++DGenRegInfo.LastRuns;
+        DGenRegInfo.TotalTime += Start;
+        DGenRegInfo.LastTime  += Start;
+    } else {
+        CS_GenRegInfo (S);
+    }
+}
+
+
+
 static unsigned RunOptFunc (CodeSeg* S, OptFunc* F, unsigned Max)
 /* Run one optimizer function Max times or until there are no more changes */
 {
@@ -603,23 +683,32 @@ static unsigned RunOptFunc (CodeSeg* S, OptFunc* F, unsigned Max)
     Changes = 0;
     do {
 
-        /* Run the function */
-        C = F->Func (S);
+        /* Run the function. Do statistics. These are shared by all threads,
+        ** so they are only collected if the functions are optimized one
+        ** after the other.
+        */
+        if (CollectStats) {
+            double Start = WallTime ();
+            C = F->Func (S);
+            Start = WallTime () - Start;
+            ++F->TotalRuns;
+            ++F->LastRuns;
+            F->TotalChanges += C;
+            F->LastChanges  += C;
+            F->TotalTime    += Start;
+            F->LastTime     += Start;
+        } else {
+            C = F->Func (S);
+        }
         Changes += C;
 
-        /* Do statistics */
-        ++F->TotalRuns;
-        ++F->LastRuns;
-        F->TotalChanges += C;
-        F->LastChanges  += C;
-
         /* If we had changes, output stuff and regenerate register info */
         if (C) {
             if (Debug) {
                 printf ("Applied %s: %u changes\n", F->Name, C);
             }
             WriteDebugOutput (S, F->Name);
-            CS_GenRegInfo (S);
+            GenRegInfo (S);
         }
 
     } while (--Max && C > 0);
@@ -706,82 +795,125 @@ static unsigned RunOptGroup2 (CodeSeg* S)
 
 
 
+/* Number of the current state of the code in RunOptGroup3 */
+static THREAD_LOCAL unsigned long OptCodeState = 0;
+
+/* The steps of group 3 in the order they are run */
+static OptStep OptGroup3[] = {
+    { &DOptNegAX1,        1 },
+    { &DOptNegAX2,        1 },
+    { &DOptStackOps,      3 },                  /* Before OptBoolUnary1 */
+    { &DOptCmp8,          1 },                  /* Before OptBoolUnary1 */
+    { &DOptBoolUnary1,    3 },
+    { &DOptBoolUnary2,    3 },
+    { &DOptBoolUnary3,    1 },
+    { &DOptBNegA1,        1 },
+    { &DOptBNegAX1,       1 },                  /* After OptBoolUnary2 */
+    { &DOptShift1,        1 },
+    { &DOptShift4,        1 },
+    { &DOptComplAX1,      1 },
+    { &DOptSub1,          1 },
+    { &DOptSub2,          1 },
+    { &DOptSub3,          1 },
+    { &DOptAdd5,          1 },
+    { &DOptAdd6,          1 },
+    { &DOptJumpCascades,  1 },
+    { &DOptDeadJumps,     1 },
+    { &DOptDeadCode,      1 },
+    { &DOptJumpTarget1,   1 },
+    { &DOptJumpTarget2,   1 },
+    { &DOptCondBranch1,   1 },
+    { &DOptCondBranch2,   1 },
+    { &DOptCondBranch3,   1 },
+    { &DOptCondBranchC,   1 },
+    { &DOptRTSJumps1,     1 },
+    { &DOptCmp6,          1 },                  /* After OptRTSJumps1 */
+    { &DOptBoolCmp,       1 },
+    { &DOptBoolTrans,     1 },
+    { &DOptBNegA2,        1 },                  /* After OptCondBranch's */
+    { &DOptBNegAX2,       1 },                  /* After OptCondBranch's */
+    { &DOptBNegAX3,       1 },                  /* After OptCondBranch's */
+    { &DOptBNegAX4,       1 },                  /* After OptCondBranch's */
+    { &DOptCmp1,          1 },
+    { &DOptCmp2,          1 },
+    { &DOptCmp8,          1 },                  /* Must run before OptCmp3 */
+    { &DOptCmp3,          1 },
+    { &DOptCmp4,          1 },
+    { &DOptCmp5,          1 },
+    { &DOptCmp7,          1 },
+    { &DOptCmp9,          1 },
+    { &DOptTest1,         1 },
+    { &DOptLoad1,         1 },
+    { &DOptJumpTarget3,   1 },                  /* After OptCondBranches2 */
+    { &DOptUnusedLoads,   1 },
+    { &DOptUnusedStores,  1 },
+    { &DOptStoreLoad,     1 },
+    { &DOptLoadStoreLoad, 1 },
+    { &DOptDupLoads,      1 },
+    { &DOptLoadStore1,    1 },
+    { &DOptTransfers1,    1 },
+    { &DOptTransfers3,    1 },
+    { &DOptTransfers4,    1 },
+    { &DOptStore1,        1 },
+    { &DOptStore5,        1 },
+    { &DOptPush3,         1 },
+    { &DOptPushPop1,      1 },
+    { &DOptPushPop2,      1 },
+    { &DOptPushPop3,      1 },
+    { &DOptPrecalc,       1 },
+    { &DOptShiftBack,     1 },
+    { &DOptSignExtended,  1 },
+    { &DOptBinOps1,       1 },
+    { &DOptBinOps2,       1 },
+    { &DOptIndex1,        1 },
+    { &DOptIndex2,        1 },
+    { &DOptPtrInc,        1 },
+};
+#define OPTGROUP3_COUNT (sizeof (OptGroup3) / sizeof (OptGroup3[0]))
+
+/* The code state in which each step of group 3 had no matches */
+static THREAD_LOCAL unsigned long OptGroup3Clean[OPTGROUP3_COUNT];
+
+
+
 static unsigned RunOptGroup3 (CodeSeg* S)
 /* Run one group of optimization steps. These steps depend on each other,
 ** that means that one step may allow another step to do additional work,
 ** so we will repeat the steps as long as we see any changes.
 */
 {
-    unsigned Changes, C;
+    unsigned Changes, C, I;
+
+    /* A step that didn't find anything to do will not find anything as long
+    ** as the code doesn't change. So we number the states of the code, and
+    ** remember for each step the state where it had no matches. Later rounds
+    ** skip the step until another step changes the code.
+    */
+    ++OptCodeState;
 
     Changes = 0;
     do {
         C = 0;
 
-        C += RunOptFunc (S, &DOptNegAX1, 1);
-        C += RunOptFunc (S, &DOptNegAX2, 1);
-        C += RunOptFunc (S, &DOptStackOps, 3);      /* Before OptBoolUnary1 */
-        C += RunOptFunc (S, &DOptCmp8, 1);          /* Before OptBoolUnary1 */
-        C += RunOptFunc (S, &DOptBoolUnary1, 3);
-        C += RunOptFunc (S, &DOptBoolUnary2, 3);
-        C += RunOptFunc (S, &DOptBoolUnary3, 1);
-        C += RunOptFunc (S, &DOptBNegA1, 1);
-        C += RunOptFunc (S, &DOptBNegAX1, 1);       /* After OptBoolUnary2 */
-        C += RunOptFunc (S, &DOptShift1, 1);
-        C += RunOptFunc (S, &DOptShift4, 1);
-        C += RunOptFunc (S, &DOptComplAX1, 1);
-        C += RunOptFunc (S, &DOptSub1, 1);
-        C += RunOptFunc (S, &DOptSub2, 1);
-        C += RunOptFunc (S, &DOptSub3, 1);
-        C += RunOptFunc (S, &DOptAdd5, 1);
-        C += RunOptFunc (S, &DOptAdd6, 1);
-        C += RunOptFunc (S, &DOptJumpCascades, 1);
-        C += RunOptFunc (S, &DOptDeadJumps, 1);
-        C += RunOptFunc (S, &DOptDeadCode, 1);
-        C += RunOptFunc (S, &DOptJumpTarget1, 1);
-        C += RunOptFunc (S, &DOptJumpTarget2, 1);
-        C += RunOptFunc (S, &DOptCondBranch1, 1);
-        C += RunOptFunc (S, &DOptCondBranch2, 1);
-        C += RunOptFunc (S, &DOptCondBranch3, 1);
-        C += RunOptFunc (S, &DOptCondBranchC, 1);
-        C += RunOptFunc (S, &DOptRTSJumps1, 1);
-        C += RunOptFunc (S, &DOptCmp6, 1);          /* After OptRTSJumps1 */
-        C += RunOptFunc (S, &DOptBoolCmp, 1);
-        C += RunOptFunc (S, &DOptBoolTrans, 1);
-        C += RunOptFunc (S, &DOptBNegA2, 1);        /* After OptCondBranch's */
-        C += RunOptFunc (S, &DOptBNegAX2, 1);       /* After OptCondBranch's */
-        C += RunOptFunc (S, &DOptBNegAX3, 1);       /* After OptCondBranch's */
-        C += RunOptFunc (S, &DOptBNegAX4, 1);       /* After OptCondBranch's */
-        C += RunOptFunc (S, &DOptCmp1, 1);
-        C += RunOptFunc (S, &DOptCmp2, 1);
-        C += RunOptFunc (S, &DOptCmp8, 1);          /* Must run before OptCmp3 */
-        C += RunOptFunc (S, &DOptCmp3, 1);
-        C += RunOptFunc (S, &DOptCmp4, 1);
-        C += RunOptFunc (S, &DOptCmp5, 1);
-        C += RunOptFunc (S, &DOptCmp7, 1);
-        C += RunOptFunc (S, &DOptCmp9, 1);
-        C += RunOptFunc (S, &DOptTest1, 1);
-        C += RunOptFunc (S, &DOptLoad1, 1);
-        C += RunOptFunc (S, &DOptJumpTarget3, 1);   /* After OptCondBranches2 */
-        C += RunOptFunc (S, &DOptUnusedLoads, 1);
-        C += RunOptFunc (S, &DOptUnusedStores, 1);
-        C += RunOptFunc (S, &DOptStoreLoad, 1);
-        C += RunOptFunc (S, &DOptLoadStoreLoad, 1);
-        C += RunOptFunc (S, &DOptDupLoads, 1);
-        C += RunOptFunc (S, &DOptLoadStore1, 1);
-        C += RunOptFunc (S, &DOptTransfers1, 1);
-        C += RunOptFunc (S, &DOptTransfers3, 1);
-        C += RunOptFunc (S, &DOptTransfers4, 1);
-        C += RunOptFunc (S, &DOptStore1, 1);
-        C += RunOptFunc (S, &DOptStore5, 1);
-        C += RunOptFunc (S, &DOptPushPop1, 1);
-        C += RunOptFunc (S, &DOptPushPop2, 1);
-        C += RunOptFunc (S, &DOptPushPop3, 1);
-        C += RunOptFunc (S, &DOptPrecalc, 1);
-        C += RunOptFunc (S, &DOptShiftBack, 1);
-        C += RunOptFunc (S, &DOptSignExtended, 1);
-        C += RunOptFunc (S, &DOptBinOps1, 1);
-        C += RunOptFunc (S, &DOptBinOps2, 1);
+        for (I = 0; I < OPTGROUP3_COUNT; ++I) {
+
+            unsigned StepChanges;
+
+            /* Skip the step if the code didn't change since its last run */
+            if (OptGroup3Clean[I] == OptCodeState) {
+                continue;
+            }
+
+            /* Run the step */
+            StepChanges = RunOptFunc (S, OptGroup3[I].Func, OptGroup3[I].Max);
+            if (StepChanges) {
+                /* The code has changed */
+                ++OptCodeState;
+                C += StepChanges;
+            } else {
+                OptGroup3Clean[I] = OptCodeState;
+            }
+        }
 
         Changes += C;
 
@@ -799,6 +931,7 @@ static unsigned RunOptGroup4 (CodeSeg* S)
 */
 {
     unsigned Changes = 0;
+    unsigned C;
 
     /* Repeat some of the steps here */
     Changes += RunOptFunc (S, &DOptShift3, 1);
@@ -811,6 +944,15 @@ static unsigned RunOptGroup4 (CodeSeg* S)
     Changes += RunOptFunc (S, &DOptLoad3, 1);
     Changes += RunOptFunc (S, &DOptDupLoads, 1);
 
+    /* Keep index variables in the y register while a loop runs. This may
+    ** leave loads unused.
+    */
+    C = RunOptFunc (S, &DOptIndVar, 1);
+    if (C) {
+        Changes += C;
+        Changes += RunOptFunc (S, &DOptUnusedLoads, 1);
+    }
+
     /* Return the number of changes */
     return Changes;
 }
@@ -946,22 +1088,9 @@ static unsigned RunOptGroup7 (CodeSeg* S)
 
 
 
-void RunOpt (CodeSeg* S)
-/* Run the optimizer */
+static void RunOptSeg (CodeSeg* S)
+/* Run the optimizer for one code segment */
 {
-    const char* StatFileName;
-
-    /* If we shouldn't run the optimizer, bail out */
-    if (!S->Optimize) {
-        return;
-    }
-
-    /* Check if we are requested to write optimizer statistics */
-    StatFileName = getenv ("CC65_OPTSTATS");
-    if (StatFileName) {
-        ReadOptStats (StatFileName);
-    }
-
     /* Print the name of the function we are working on */
     if (S->Func) {
         Print (stdout, 1, "Running optimizer for function '%s'\n", S->Func->Name);
@@ -974,7 +1103,7 @@ void RunOpt (CodeSeg* S)
     WriteDebugOutput (S, 0);
 
     /* Generate register info for all instructions */
-    CS_GenRegInfo (S);
+    GenRegInfo (S);
 
     /* Run groups of optimizations */
     RunOptGroup1 (S);
@@ -992,9 +1121,194 @@ void RunOpt (CodeSeg* S)
     if (DebugOptOutput) {
         CloseOutputFile ();
     }
+}
+
+
+
+static void OptWorker (void* Data)
+/* Thread function for RunOptSegs: Optimize segments until none are left */
+{
+    OptQueue* Q = Data;
+
+    while (1) {
+
+        SegContext* Seg;
+
+        /* Get the next segment */
+        ThreadLock ();
+        if (Q->Next >= CollCount (Q->Segs)) {
+            ThreadUnlock ();
+            break;
+        }
+        Seg = CollAtUnchecked (Q->Segs, Q->Next++);
+        ThreadUnlock ();
+
+        /* Optimize its code using its own label pool */
+        UseLabelPoolFromSegments (Seg);
+        if (Seg->Code->Optimize) {
+            RunOptSeg (Seg->Code);
+        }
+    }
+}
+
+
+
+void RunOpt (CodeSeg* S)
+/* Run the optimizer */
+{
+    const char* StatFileName;
+
+    /* If we shouldn't run the optimizer, bail out */
+    if (!S->Optimize) {
+        return;
+    }
+
+    /* Prepare the pattern tables */
+    InitOptPatterns ();
+
+    /* Check if we are requested to write optimizer statistics */
+    StatFileName = getenv ("CC65_OPTSTATS");
+    CollectStats = (StatFileName != 0 || getenv ("CC65_OPTREPORT") != 0);
+    if (StatFileName) {
+        ReadOptStats (StatFileName);
+    }
+
+    /* Optimize the code */
+    RunOptSeg (S);
 
     /* Write statistics */
     if (StatFileName) {
         WriteOptStats (StatFileName);
     }
 }
+
+
+
+void RunOptSegs (const Collection* Segs)
+/* Run the optimizer for the code of all segment contexts in Segs, using the
+** label pool of each context. The segments are optimized in parallel, unless
+** the debug output or the statistics need them one after the other.
+*/
+{
+    unsigned Count = CollCount (Segs);
+    unsigned Jobs;
+    unsigned I;
+
+    /* Determine the number of threads */
+    Jobs = OptimizerJobs? OptimizerJobs : ThreadCPUCount ();
+    if (Jobs > Count) {
+        Jobs = Count;
+    }
+
+    if (Jobs <= 1 || Debug || DebugOptOutput ||
+        getenv ("CC65_OPTSTATS") || getenv ("CC65_OPTREPORT")) {
+
+        /* Optimize the segments one after the other */
+        for (I = 0; I < Count; ++I) {
+            SegContext* Seg = CollAtUnchecked (Segs, I);
+            UseLabelPoolFromSegments (Seg);
+            RunOpt (Seg->Code);
+        }
+
+    } else {
+
+        /* The optimizer functions of the segments don't share any data
+        ** except for the statistics. The label pool of the calling thread
+        ** is left alone.
+        */
+        OptQueue Q;
+        Thread** Threads = xmalloc (Jobs * sizeof (Thread*));
+
+        InitOptPatterns ();
+        CollectStats = 0;
+        Q.Segs = Segs;
+        Q.Next = 0;
+        for (I = 0; I < Jobs; ++I) {
+            Threads[I] = ThreadStart (OptWorker, &Q);
+        }
+        for (I = 0; I < Jobs; ++I) {
+            ThreadJoin (Threads[I]);
+        }
+        xfree (Threads);
+    }
+}
+
+
+
+static int CmpOptTime (void* Data attribute ((unused)),
+                       const void* Left, const void* Right)
+/* Compare function for sorting the steps by descending time */
+{
+    const OptFunc* L = Left;
+    const OptFunc* R = Right;
+    if (L->LastTime > R->LastTime) {
+        return -1;
+    } else if (L->LastTime < R->LastTime) {
+        return 1;
+    } else {
+        return strcmp (L->Name, R->Name);
+    }
+}
+
+
+
+void WriteOptReport (const char* InputName)
+/* If requested by the environment, append a report about the time spent in
+** the optimizer steps for the current translation unit to a file.
+*/
+{
+    Collection Steps = AUTO_COLLECTION_INITIALIZER;
+    double Total = 0.0;
+    unsigned I;
+    FILE* F;
+
+    /* Check if we are requested to write a report */
+    const char* ReportName = getenv ("CC65_OPTREPORT");
+    if (ReportName == 0) {
+        return;
+    }
+
+    /* Collect the steps that did run */
+    for (I = 0; I < OPTFUNC_COUNT; ++I) {
+        if (OptFuncs[I]->LastRuns > 0) {
+            CollAppend (&Steps, OptFuncs[I]);
+        }
+    }
+    if (DGenRegInfo.LastRuns > 0) {
+        CollAppend (&Steps, &DGenRegInfo);
+    }
+    for (I = 0; I < CollCount (&Steps); ++I) {
+        Total += ((const OptFunc*) CollAtUnchecked (&Steps, I))->LastTime;
+    }
+    CollSort (&Steps, CmpOptTime, 0);
+
+    /* Try to open the file */
+    F = fopen (ReportName, "a");
+    if (F != 0) {
+
+        /* Write a header */
+        fprintf (F,
+                 "; Optimizer report for '%s': %.3f ms\n"
+                 ";   Step                  Runs    Changes      Time ms        %%\n",
+                 InputName,
+                 Total * 1000.0);
+
+        /* Write the data */
+        for (I = 0; I < CollCount (&Steps); ++I) {
+            const OptFunc* O = CollAtUnchecked (&Steps, I);
+            fprintf (F,
+                     "%-20s %10lu %10lu %12.3f %8.2f\n",
+                     O->Name,
+                     O->LastRuns,
+                     O->LastChanges,
+                     O->LastTime * 1000.0,
+                     Total > 0.0? O->LastTime * 100.0 / Total : 0.0);
+        }
+        fprintf (F, "\n");
+
+        /* Close the file, ignore errors here. */
+        fclose (F);
+    }
+
+    DoneCollection (&Steps);
+}
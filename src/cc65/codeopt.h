@@ -38,6 +38,9 @@
 
 
 
+/* common */
+#include "coll.h"
+
 /* cc65 */
 #include "codeseg.h"
 
@@ -61,6 +64,17 @@ void ListOptSteps (FILE* F);
 void RunOpt (CodeSeg* S);
 /* Run the optimizer */
 
+void RunOptSegs (const Collection* Segs);
+/* Run the optimizer for the code of all segment contexts in Segs, using the
+** label pool of each context. The segments are optimized in parallel, unless
+** the debug output or the statistics need them one after the other.
+*/
+
+void WriteOptReport (const char* InputName);
+/* If requested by the environment, append a report about the time spent in
+** the optimizer steps for the current translation unit to a file.
+*/
+
 
 
 /* End of codeopt.h */
@@ -303,7 +303,7 @@ static int Affected (LoadRegInfo* LRI, const CodeEntry* E)
 
     if (E->OPC == OP65_JSR) {
         /* Try to know about the function */
-        fncls = GetFuncInfo (E->Arg, &Use, &Chg);
+        fncls = GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
         if (fncls == FNCLS_BUILTIN) {
             /* Builtin functions are usually harmless */
             if ((ChgToCheck & Use & REG_ALL) != 0) {
@@ -445,7 +445,7 @@ void PrepairLoadRegInfoForArgCheck (CodeSeg* S, LoadRegInfo* LRI, CodeEntry* E)
         /* These insns are replaceable only if they are not modified later */
         LRI->Flags |= LI_CHECK_ARG | LI_CHECK_Y;
     } else if ((E->AM == AM65_ZP_INDY) &&
-                strcmp (E->Arg, "c_sp") == 0) {
+                CE_IsArg (E, ARG_C_SP)) {
         /* A load from the stack with known offset is also ok, but in this
         ** case we must reload the index register later. Please note that
         ** a load indirect via other zero page locations is not ok, since
@@ -556,7 +556,7 @@ unsigned int TrackLoads (LoadInfo* LI, CodeSeg* S, int I)
             /* These insns are replaceable only if they are not modified later */
             LRI->Flags |= LI_CHECK_ARG | LI_CHECK_Y;
         } else if (E->AM == AM65_ZP_INDY &&
-                   strcmp (E->Arg, "c_sp") == 0) {
+                   CE_IsArg (E, ARG_C_SP)) {
             /* A load from the stack with known offset is also ok, but in this
             ** case we must reload the index register later. Please note that
             ** a load indirect via other zero page locations is not ok, since
@@ -646,7 +646,7 @@ unsigned int TrackLoads (LoadInfo* LI, CodeSeg* S, int I)
         Tgt->Offs       = Src->Offs;
         Tgt->Flags      = Src->Flags;
 
-    } else if (CE_IsCallTo (E, "ldaxysp") && RegValIsKnown (E->RI->In.RegY)) {
+    } else if (CE_IsCallTo (E, ARG_LDAXYSP) && RegValIsKnown (E->RI->In.RegY)) {
 
         /* Both registers set, Y changed */
         LI->A.LoadIndex = I;
@@ -839,7 +839,7 @@ void AdjustStackOffset (StackOpData* D, unsigned Offs)
             if (E->OPC != OP65_JSR) {
                 /* Check against some things that should not happen */
                 CHECK (E->AM == AM65_ZP_INDY && E->RI->In.RegY >= (short) Offs);
-                CHECK (strcmp (E->Arg, "c_sp") == 0);
+                CHECK (CE_IsArg (E, ARG_C_SP));
 
                 /* We need to correct this one */
                 Correction = 2;
@@ -1238,7 +1238,7 @@ int HarmlessCall (const CodeEntry* E, int PushedBytes)
 */
 {
     unsigned Use = 0, Chg = 0;
-    if (GetFuncInfo (E->Arg, &Use, &Chg) == FNCLS_BUILTIN) {
+    if (GetArgFuncInfo (E->ArgDesc, &Use, &Chg) == FNCLS_BUILTIN) {
         if ((Chg & REG_SP) != 0) {
             return 0;
         }
@@ -2425,10 +2425,10 @@ int BackupArgAfter (CodeSeg* S, BackupInfo* B, int Idx, const CodeEntry* E, Coll
     SB_Init (&DstArg);
 
     /* We only recognize opc with an arg for now, as well as a special case for ldaxysp */
-    if ((E->OPC != OP65_JSR || strcmp (E->Arg, "ldaxysp") == 0) &&
+    if ((E->OPC != OP65_JSR || CE_IsArg (E, ARG_LDAXYSP)) &&
         E->AM != AM65_BRA) {
         /* Get size of the arg */
-        if ((E->Info & OF_LBRA) != 0 || strcmp (E->Arg, "ldaxysp") == 0) {
+        if ((E->Info & OF_LBRA) != 0 || CE_IsArg (E, ARG_LDAXYSP)) {
             ArgSize = BU_B16;
         } else {
             ArgSize = BU_B8;
@@ -2545,7 +2545,7 @@ int BackupArgAfter (CodeSeg* S, BackupInfo* B, int Idx, const CodeEntry* E, Coll
         }
     } else if (E->OPC == OP65_JSR) {
         /* For function calls we load their arguments instead */
-        GetFuncInfo (E->Arg, &Use, &Chg);
+        GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
         if ((Use & ~REG_AXY) == 0) {
             if (Use == REG_A) {
                 ArgSize = BU_B8;
@@ -2594,7 +2594,7 @@ static int LoadAAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
     O = CS_GetEntry (S, OldIdx);
 
     /* We only recognize opc with an arg for now, as well as a special case for ldaxysp */
-    if ((E->OPC != OP65_JSR || strcmp (E->Arg, "ldaxysp") == 0) &&
+    if ((E->OPC != OP65_JSR || CE_IsArg (E, ARG_LDAXYSP)) &&
         E->AM != AM65_BRA && E->AM != AM65_IMP) {
         if (E->Size != 1 && E->AM != AM65_IMP) {
 
@@ -2617,7 +2617,7 @@ static int LoadAAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
     } else if (E->OPC == OP65_JSR) {
 
         /* For other function calls we load their arguments instead */
-        GetFuncInfo (E->Arg, &Use, &Chg);
+        GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
         if ((Use & ~REG_AXY) == 0) {
             if (Use == REG_X) {
                 X = NewCodeEntry (OP65_TXA, AM65_IMP, 0, 0, E->LI);
@@ -2677,7 +2677,7 @@ static int LoadXAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
     O = CS_GetEntry (S, OldIdx);
 
     /* We only recognize opc with an arg for now, as well as a special case for ldaxysp */
-    if ((E->OPC != OP65_JSR || strcmp (E->Arg, "ldaxysp") == 0) &&
+    if ((E->OPC != OP65_JSR || CE_IsArg (E, ARG_LDAXYSP)) &&
         E->AM != AM65_BRA && E->AM != AM65_IMP) {
         if (E->Size != 1 && E->AM != AM65_IMP) {
 
@@ -2710,7 +2710,7 @@ static int LoadXAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
         }
     } else if (E->OPC == OP65_JSR) {
         /* For function calls we load their arguments instead */
-        GetFuncInfo (E->Arg, &Use, &Chg);
+        GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
         if ((Use & ~REG_AXY) == 0) {
             if (Use == REG_A) {
                 X = NewCodeEntry (OP65_TAY, AM65_IMP, 0, 0, E->LI);
@@ -2776,7 +2776,7 @@ static int LoadYAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
     O = CS_GetEntry (S, OldIdx);
 
     /* We only recognize opc with an arg for now, as well as a special case for ldaxysp */
-    if ((E->OPC != OP65_JSR || strcmp (E->Arg, "ldaxysp") == 0) &&
+    if ((E->OPC != OP65_JSR || CE_IsArg (E, ARG_LDAXYSP)) &&
         E->AM != AM65_BRA && E->AM != AM65_IMP) {
         if (E->Size != 1 && E->AM != AM65_IMP) {
 
@@ -2803,7 +2803,7 @@ static int LoadYAt (CodeSeg* S, int Idx, const LoadRegInfo* LRI, Collection* Ind
         }
     } else if (E->OPC == OP65_JSR) {
         /* For function calls we load their arguments instead */
-        GetFuncInfo (E->Arg, &Use, &Chg);
+        GetArgFuncInfo (E->ArgDesc, &Use, &Chg);
         if ((Use & ~REG_AXY) == 0) {
             if (Use == REG_A) {
                 X = NewCodeEntry (OP65_TAY, AM65_IMP, 0, 0, E->LI);
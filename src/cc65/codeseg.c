@@ -44,7 +44,9 @@
 #include "hashfunc.h"
 #include "strbuf.h"
 #include "strutil.h"
+#include "thread.h"
 #include "xmalloc.h"
+#include "xsprintf.h"
 
 /* cc65 */
 #include "asmlabel.h"
@@ -60,6 +62,17 @@
 
 
 
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Number of the last run of CS_GenRegInfo over a code segment */
+static THREAD_LOCAL unsigned long RegInfoRun = 0;
+
+
+
 /*****************************************************************************/
 /*                             Helper functions                              */
 /*****************************************************************************/
@@ -69,6 +82,8 @@
 static void CS_PrintFunctionHeader (const CodeSeg* S)
 /* Print a comment with the function signature to the output file */
 {
+    unsigned I;
+
     /* Get the associated function */
     const SymEntry* Func = S->Func;
 
@@ -78,8 +93,11 @@ static void CS_PrintFunctionHeader (const CodeSeg* S)
                      "; ");
         PrintFuncSig (OutputFile, Func->Name, Func->Type);
         WriteOutput ("\n"
-                     "; ---------------------------------------------------------------\n"
-                     "\n");
+                     "; ---------------------------------------------------------------\n");
+        for (I = 0; I < CollCount (&S->Notes); ++I) {
+            WriteOutput ("; %s\n", (const char*) CollConstAt (&S->Notes, I));
+        }
+        WriteOutput ("\n");
     }
 }
 
@@ -183,6 +201,93 @@ static void CS_RemoveLabelFromHash (CodeSeg* S, CodeLabel* L)
 
 
 
+static void CS_DelJumpTable (CodeEntry* E)
+/* Delete the jump table of E and the references from the labels in it. The
+** labels themselves are left alone, the optimizer removes them when they
+** are unused.
+*/
+{
+    unsigned I;
+    JumpTable* T = E->Table;
+
+    CHECK (T != 0);
+
+    /* Remove the references */
+    for (I = 0; I < CollCount (&T->Labels); ++I) {
+        CodeLabel* L = CollAt (&T->Labels, I);
+        int Ref = CollIndex (&L->JumpFrom, E);
+        if (Ref >= 0) {
+            CollDelete (&L->JumpFrom, Ref);
+        }
+    }
+
+    /* Delete the table */
+    DoneCollection (&T->Labels);
+    xfree (T);
+    E->Table = 0;
+    E->Flags &= ~CEF_JUMPTABLE;
+}
+
+
+
+static void CS_ReplaceJumpTableLabel (CodeEntry* E, CodeLabel* OldLabel,
+                                      CodeLabel* NewLabel)
+/* Replace OldLabel by NewLabel in the jump table of E. OldLabel is not
+** deleted even if it has no more references.
+*/
+{
+    unsigned I;
+    JumpTable* T = E->Table;
+
+    CHECK (T != 0);
+
+    /* Replace the label */
+    for (I = 0; I < CollCount (&T->Labels); ++I) {
+        if (CollAt (&T->Labels, I) == OldLabel) {
+            CollReplace (&T->Labels, NewLabel, I);
+        }
+    }
+
+    /* Move the reference */
+    CollDeleteItem (&OldLabel->JumpFrom, E);
+    if (CollIndex (&NewLabel->JumpFrom, E) < 0) {
+        CollAppend (&NewLabel->JumpFrom, E);
+    }
+}
+
+
+
+static void CS_OutputJumpTable (const CodeEntry* E)
+/* Output the jump table of E */
+{
+    unsigned I, J;
+    const JumpTable* T = E->Table;
+
+    CHECK (T != 0);
+
+    WriteOutput ("%s:\n", T->Name);
+    for (J = 0; J < (T->Format == JT_RTS? 2U : 1U); ++J) {
+        for (I = 0; I < CollCount (&T->Labels); ++I) {
+            const char* Name = ((const CodeLabel*) CollConstAt (&T->Labels, I))->Name;
+            if (I % 8 == 0) {
+                WriteOutput ("\t%s\t", T->Format == JT_RTS? ".byte" : ".addr");
+            } else {
+                WriteOutput (",");
+            }
+            if (T->Format == JT_RTS) {
+                WriteOutput ("%s(%s-1)", J == 0? "<" : ">", Name);
+            } else {
+                WriteOutput ("%s", Name);
+            }
+            if (I % 8 == 7 || I == CollCount (&T->Labels) - 1) {
+                WriteOutput ("\n");
+            }
+        }
+    }
+}
+
+
+
 static CodeLabel* PickRefLab (CodeEntry* E)
 /* Pick a reference label and move it to index 0 in E. */
 {
@@ -514,6 +619,7 @@ CodeSeg* NewCodeSeg (const char* SegName, SymEntry* Func)
     S->Func     = Func;
     InitCollection (&S->Entries);
     InitCollection (&S->Labels);
+    InitCollection (&S->Notes);
     for (I = 0; I < sizeof(S->LabelHash) / sizeof(S->LabelHash[0]); ++I) {
         S->LabelHash[I] = 0;
     }
@@ -534,6 +640,8 @@ CodeSeg* NewCodeSeg (const char* SegName, SymEntry* Func)
     /* Copy the global optimization settings */
     S->Optimize       = (unsigned char) IS_Get (&Optimize);
     S->CodeSizeFactor = (unsigned) IS_Get (&CodeSizeFactor);
+    S->StaticFrame    = (unsigned char) (S->Func != 0 && IS_Get (&StaticFrames));
+    S->AutoRegVars    = (unsigned char) (S->Func != 0 && IS_Get (&AutoRegVars));
 
     /* Return the new struct */
     return S;
@@ -612,6 +720,19 @@ void CS_AddLine (CodeSeg* S, LineInfo* LI, const char* Format, ...)
 
 
 
+void CS_AddNote (CodeSeg* S, const char* Format, ...)
+/* Add a comment line that is output in the header of the function */
+{
+    char Buf[256];
+    va_list ap;
+    va_start (ap, Format);
+    xvsprintf (Buf, sizeof (Buf), Format, ap);
+    va_end (ap);
+    CollAppend (&S->Notes, xstrdup (Buf));
+}
+
+
+
 void CS_InsertEntry (CodeSeg* S, struct CodeEntry* E, unsigned Index)
 /* Insert the code entry at the index given. Following code entries will be
 ** moved to slots with higher indices.
@@ -669,6 +790,9 @@ void CS_DelEntry (CodeSeg* S, unsigned Index)
         /* Remove the reference */
         CS_RemoveLabelRef (S, E);
     }
+    if (E->Flags & CEF_JUMPTABLE) {
+        CS_DelJumpTable (E);
+    }
 
     /* Delete the pointer to the insn */
     CollDelete (&S->Entries, Index);
@@ -895,13 +1019,17 @@ void CS_DelLabel (CodeSeg* S, CodeLabel* L)
     /* First, remove the label from the hash chain */
     CS_RemoveLabelFromHash (S, L);
 
-    /* Remove references from insns jumping to this label */
+    /* Remove references from insns jumping to this label. Insns jumping
+    ** through a table do not reference the label themselves.
+    */
     Count = CollCount (&L->JumpFrom);
     for (I = 0; I < Count; ++I) {
         /* Get the insn referencing this label */
         CodeEntry* E = CollAt (&L->JumpFrom, I);
         /* Remove the reference */
-        CE_ClearJumpTo (E);
+        if (E->JumpTo == L) {
+            CE_ClearJumpTo (E);
+        }
     }
     CollDeleteAll (&L->JumpFrom);
 
@@ -1001,6 +1129,11 @@ void CS_MergeLabels (CodeSeg* S)
             /* Move all references from this label to the reference label */
             CL_MoveRefs (L, RefLab);
 
+            /* Jump tables use the label by name */
+            while (CL_GetRefCount (L) > 0) {
+                CS_ReplaceJumpTableLabel (CL_GetRef (L, 0), L, RefLab);
+            }
+
             /* Remove the label completely. */
             CS_DelLabel (S, L);
         }
@@ -1041,6 +1174,12 @@ void CS_MoveLabels (CodeSeg* S, struct CodeEntry* Old, struct CodeEntry* New)
             /* Move references */
             CL_MoveRefs (OldLabel, NewLabel);
 
+            /* Jump tables use the label by name */
+            while (CL_GetRefCount (OldLabel) > 0) {
+                CS_ReplaceJumpTableLabel (CL_GetRef (OldLabel, 0),
+                                          OldLabel, NewLabel);
+            }
+
             /* Delete the label */
             CS_DelLabel (S, OldLabel);
 
@@ -1112,6 +1251,80 @@ void CS_MoveLabelRef (CodeSeg* S, struct CodeEntry* E, CodeLabel* L)
 
 
 
+void CS_MoveJumpTableRef (CodeSeg* S, struct CodeEntry* E,
+                          CodeLabel* OldLabel, CodeLabel* NewLabel)
+/* Change the entries for OldLabel in the jump table of E to NewLabel. If
+** this was the only reference to the old label, the old label will get
+** deleted.
+*/
+{
+    /* Replace the label */
+    CS_ReplaceJumpTableLabel (E, OldLabel, NewLabel);
+
+    /* If there are no more references, delete the label */
+    if (CollCount (&OldLabel->JumpFrom) == 0) {
+        CS_DelLabel (S, OldLabel);
+    }
+}
+
+
+
+const JumpTable* CS_GetJumpTable (const struct CodeEntry* E)
+/* Return the jump table of E, which must have one */
+{
+    CHECK (E->Table != 0);
+    return E->Table;
+}
+
+
+
+JumpTable* CS_AddJumpTable (struct CodeEntry* Jump, const char* Name,
+                            unsigned Format)
+/* Add a jump table for the insn Jump. The table is output behind the insn,
+** and the size of the insn grows with the table.
+*/
+{
+    /* Create the table */
+    JumpTable* T = xmalloc (sizeof (JumpTable));
+    T->Jump   = Jump;
+    T->Name   = GetCodeArg (Name)->Str;
+    T->Format = Format;
+    InitCollection (&T->Labels);
+
+    /* Remember the table in the insn */
+    PRECONDITION ((Jump->Flags & CEF_JUMPTABLE) == 0);
+    Jump->Flags |= CEF_JUMPTABLE;
+    Jump->Table  = T;
+
+    /* Return the new table */
+    return T;
+}
+
+
+
+void CS_AddJumpTableLabel (CodeSeg* S, JumpTable* T, const char* Name)
+/* Append a label to the jump table T. The label may not exist yet. */
+{
+    /* Find the label or create a new one */
+    unsigned Hash = HashStr (Name) % CS_LABEL_HASH_SIZE;
+    CodeLabel* L = CS_FindLabel (S, Name, Hash);
+    if (L == 0) {
+        L = CS_NewCodeLabel (S, Name, Hash);
+    }
+
+    /* The jump insn references the label without jumping to it directly */
+    if (CollIndex (&L->JumpFrom, T->Jump) < 0) {
+        CollAppend (&L->JumpFrom, T->Jump);
+    }
+
+    /* Add the label to the table. Each entry takes two bytes */
+    CHECK (T->Jump->Size <= 0xFF - 2);
+    T->Jump->Size += 2;
+    CollAppend (&T->Labels, L);
+}
+
+
+
 void CS_DelCodeRange (CodeSeg* S, unsigned First, unsigned Last)
 /* Delete all entries between first and last, both inclusive. The function
 ** can only handle basic blocks (First is the only entry, Last the only exit)
@@ -1168,6 +1381,9 @@ void CS_DelCodeRange (CodeSeg* S, unsigned First, unsigned Last)
             /* Remove the reference to the label */
             CS_RemoveLabelRef (S, E);
         }
+        if (E->Flags & CEF_JUMPTABLE) {
+            CS_DelJumpTable (E);
+        }
     }
 
     /* Second pass: Delete the instructions. If a label attached to an
@@ -1222,6 +1438,9 @@ void CS_DelCodeAfter (CodeSeg* S, unsigned Last)
             /* Remove the reference to the label */
             CS_RemoveLabelRef (S, E);
         }
+        if (E->Flags & CEF_JUMPTABLE) {
+            CS_DelJumpTable (E);
+        }
 
     }
 
@@ -1476,6 +1695,9 @@ void CS_Output (CodeSeg* S)
         }
         /* Output the code */
         CE_Output (E);
+        if (E->Flags & CEF_JUMPTABLE) {
+            CS_OutputJumpTable (E);
+        }
     }
 
     /* Prettyier formatting */
@@ -1503,6 +1725,79 @@ void CS_FreeRegInfo (CodeSeg* S)
 
 
 
+static int CS_RegInfoIsCurrent (const CodeEntry* E, const CodeEntry* P,
+                                const RegContents* In)
+/* Return true if the register info of E was generated for the current insn
+** and the given incoming register values, so it is still valid. P is the
+** previous insn if the info of E depends on it, NULL otherwise.
+*/
+{
+    const RegInfo* RI = E->RI;
+
+    /* Check the insn itself */
+    if (RI == 0                                     ||
+        RI->Arg == 0                                ||
+        RI->OPC != E->OPC                           ||
+        RI->AM != E->AM                             ||
+        RI->NumArg != CE_HasNumArg (E)              ||
+        RI->Num != E->Num                           ||
+        RI->Use != E->Use                           ||
+        RI->Chg != E->Chg                           ||
+        RI->Info != E->Info                         ||
+        RI->Labels != (CE_HasLabel (E) != 0)        ||
+        RI->Arg != E->ArgDesc) {
+        return 0;
+    }
+
+    /* Check the previous insn */
+    if (P) {
+        if (RI->PrevOPC != P->OPC                   ||
+            RI->PrevAM != P->AM                     ||
+            RI->PrevNumArg != CE_HasNumArg (P)      ||
+            RI->PrevNum != P->Num) {
+            return 0;
+        }
+    } else if (RI->PrevOPC != OP65_INVALID) {
+        return 0;
+    }
+
+    /* Check the incoming register values */
+    return RC_IsEqual (&RI->In, In);
+}
+
+
+
+static void CS_BindRegInfo (CodeEntry* E, const CodeEntry* P)
+/* Remember the insn the register info of E was generated for. P is the
+** previous insn if the info of E depends on it, NULL otherwise.
+*/
+{
+    RegInfo* RI = E->RI;
+
+    RI->Arg    = E->ArgDesc;
+    RI->OPC    = E->OPC;
+    RI->AM     = E->AM;
+    RI->NumArg = CE_HasNumArg (E);
+    RI->Num    = E->Num;
+    RI->Use    = E->Use;
+    RI->Chg    = E->Chg;
+    RI->Info   = E->Info;
+    RI->Labels = (CE_HasLabel (E) != 0);
+    if (P) {
+        RI->PrevOPC    = P->OPC;
+        RI->PrevAM     = P->AM;
+        RI->PrevNumArg = CE_HasNumArg (P);
+        RI->PrevNum    = P->Num;
+    } else {
+        RI->PrevOPC    = OP65_INVALID;
+        RI->PrevAM     = AM65_IMP;
+        RI->PrevNumArg = 0;
+        RI->PrevNum    = 0;
+    }
+}
+
+
+
 void CS_GenRegInfo (CodeSeg* S)
 /* Generate register infos for all instructions */
 {
@@ -1511,9 +1806,16 @@ void CS_GenRegInfo (CodeSeg* S)
     RegContents* CurrentRegs;   /* Current register contents */
     int WasJump;                /* True if last insn was a jump */
     int Done;                   /* All runs done flag */
-
-    /* Be sure to delete all register infos */
-    CS_FreeRegInfo (S);
+    unsigned long FirstRun;     /* Number of the first run */
+
+    /* The register info from earlier calls is kept. An insn that was already
+    ** visited in this call is marked with the number of the run, so any info
+    ** with an older number counts as missing in the first run. If neither an
+    ** insn nor its incoming register values did change, the old info is still
+    ** valid and doesn't need to be regenerated. The optimizer calls us after
+    ** each change it makes, so this saves most of the work.
+    */
+    FirstRun = RegInfoRun + 1;
 
     /* We may need two runs to get back references right */
     do {
@@ -1521,6 +1823,9 @@ void CS_GenRegInfo (CodeSeg* S)
         /* Assume we're done after this run */
         Done = 1;
 
+        /* Next run */
+        ++RegInfoRun;
+
         /* On entry, the register contents are unknown */
         RC_Invalidate (&Regs);
         RC_InvalidatePS (&Regs);
@@ -1554,7 +1859,7 @@ void CS_GenRegInfo (CodeSeg* S)
                 if (WasJump) {
                     /* Preceeding insn was an unconditional branch */
                     CodeEntry* J = CL_GetRef(Label, 0);
-                    if (J->RI) {
+                    if (J->RI && J->RI->Run >= FirstRun) {
                         Regs = J->RI->Out2;
                     } else {
                         RC_Invalidate (&Regs);
@@ -1569,7 +1874,7 @@ void CS_GenRegInfo (CodeSeg* S)
                 while (Entry < CL_GetRefCount (Label)) {
                     /* Get this entry */
                     CodeEntry* J = CL_GetRef (Label, Entry);
-                    if (J->RI == 0) {
+                    if (J->RI == 0 || J->RI->Run < FirstRun) {
                         /* No register info for this entry. This means that the
                         ** instruction that jumps here is at higher addresses and
                         ** the jump is a backward jump. We need a second run to
@@ -1610,20 +1915,36 @@ void CS_GenRegInfo (CodeSeg* S)
 
             }
 
-            /* Generate register info for this instruction */
-            CE_GenRegInfo (E, CurrentRegs);
+            /* If this insn is a branch on zero flag, we may have more info on
+            ** register contents for one of both flow directions, but only if
+            ** we've gone through a previous instruction.
+            */
+            if (LabelCount == 0 && (E->Info & OF_ZBRA) != 0) {
+                P = CS_GetPrevEntry (S, I);
+            } else {
+                P = 0;
+            }
 
             /* Remember for the next insn if this insn was an uncondition branch */
             WasJump = (E->Info & OF_UBRA) != 0;
 
+            /* Reuse the existing info if it is still valid */
+            if (CS_RegInfoIsCurrent (E, P, CurrentRegs)) {
+                E->RI->Run = RegInfoRun;
+                CurrentRegs = &E->RI->Out;
+                continue;
+            }
+
+            /* Generate register info for this instruction */
+            CE_GenRegInfo (E, CurrentRegs);
+            CS_BindRegInfo (E, P);
+            E->RI->Run = RegInfoRun;
+
             /* Output registers for this insn are input for the next */
             CurrentRegs = &E->RI->Out;
 
-            /* If this insn is a branch on zero flag, we may have more info on
-            ** register contents for one of both flow directions, but only if
-            ** we've gone through a previous instruction.
-            */
-            if (LabelCount == 0 && (E->Info & OF_ZBRA) != 0 && (P = CS_GetPrevEntry (S, I)) != 0) {
+            /* Use the previous insn for branches on zero flag */
+            if (P) {
 
                 /* Get the branch condition */
                 bc_t BC = GetBranchCond (E->OPC);
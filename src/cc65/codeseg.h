@@ -70,6 +70,22 @@ struct CodeEntry;
 /* Size of the label hash table */
 #define CS_LABEL_HASH_SIZE      29
 
+/* Formats of jump tables */
+#define JT_ADDR         0U              /* Addresses, for jmp (abs,x) */
+#define JT_RTS          1U              /* Low, then high bytes of address-1 */
+
+/* A table of code labels for an insn that jumps to one of them through the
+** table. The table is output right behind the insn. The insn is in the
+** JumpFrom list of each label, but it is not the JumpTo of the insn.
+*/
+typedef struct JumpTable JumpTable;
+struct JumpTable {
+    struct CodeEntry*   Jump;           /* Insn that jumps through the table */
+    const char*         Name;           /* Name of the table */
+    unsigned            Format;         /* JT_xxx */
+    Collection          Labels;         /* The labels, may repeat */
+};
+
 /* Code segment structure */
 typedef struct CodeSeg CodeSeg;
 struct CodeSeg {
@@ -78,10 +94,13 @@ struct CodeSeg {
     Collection      Entries;                    /* List of code entries */
     Collection      Labels;                     /* Labels for next insn */
     CodeLabel*      LabelHash[CS_LABEL_HASH_SIZE]; /* Label hash table */
+    Collection      Notes;                      /* Comments for the header */
     unsigned short  ExitRegs;                   /* Register use on exit */
 
     /* Optimization settings for this segment */
     unsigned char   Optimize;                   /* On/off switch */
+    unsigned char   StaticFrame;                /* Frame may be made static */
+    unsigned char   AutoRegVars;                /* Locals may go to regbank */
     unsigned        CodeSizeFactor;
 };
 
@@ -111,6 +130,9 @@ static inline unsigned CS_GetEntryCount (const CodeSeg* S)
     return CollCount (&S->Entries);
 }
 
+void CS_AddNote (CodeSeg* S, const char* Format, ...) attribute ((format(printf,2,3)));
+/* Add a comment line that is output in the header of the function */
+
 void CS_InsertEntry (CodeSeg* S, struct CodeEntry* E, unsigned Index);
 /* Insert the code entry at the index given. Following code entries will be
 ** moved to slots with higher indices.
@@ -223,6 +245,25 @@ void CS_MoveLabelRef (CodeSeg* S, struct CodeEntry* E, CodeLabel* L);
 ** deleted.
 */
 
+void CS_MoveJumpTableRef (CodeSeg* S, struct CodeEntry* E,
+                          CodeLabel* OldLabel, CodeLabel* NewLabel);
+/* Change the entries for OldLabel in the jump table of E to NewLabel. If
+** this was the only reference to the old label, the old label will get
+** deleted.
+*/
+
+const JumpTable* CS_GetJumpTable (const struct CodeEntry* E);
+/* Return the jump table of E, which must have one */
+
+JumpTable* CS_AddJumpTable (struct CodeEntry* Jump, const char* Name,
+                            unsigned Format);
+/* Add a jump table for the insn Jump. The table is output behind the insn,
+** and the size of the insn grows with the table.
+*/
+
+void CS_AddJumpTableLabel (CodeSeg* S, JumpTable* T, const char* Name);
+/* Append a label to the jump table T. The label may not exist yet. */
+
 void CS_DelCodeRange (CodeSeg* S, unsigned First, unsigned Last);
 /* Delete all entries between first and last, both inclusive. The function
 ** can only handle basic blocks (First is the only entry, Last the only exit)
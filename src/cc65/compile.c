@@ -38,6 +38,7 @@
 
 /* common */
 #include "addrsize.h"
+#include "coll.h"
 #include "debugflag.h"
 #include "segnames.h"
 #include "version.h"
@@ -47,7 +48,9 @@
 /* cc65 */
 #include "asmlabel.h"
 #include "asmstmt.h"
+#include "codeframe.h"
 #include "codegen.h"
+#include "codeinline.h"
 #include "codeopt.h"
 #include "compile.h"
 #include "declare.h"
@@ -594,10 +597,9 @@ void FinishCompile (void)
 /* Emit literals, debug info, do cleanup and optimizations */
 {
     SymEntry* Entry;
+    Collection Funcs = AUTO_COLLECTION_INITIALIZER;
 
-    /* Walk over all global symbols and do clean-up and optimizations for
-    ** functions.
-    */
+    /* Walk over all global symbols and do clean-up for functions */
     for (Entry = GetGlobalSymTab ()->SymHead; Entry; Entry = Entry->NextSym) {
         if (SymIsOutputFunc (Entry)) {
             /* Continue with previous label numbers */
@@ -606,10 +608,28 @@ void FinishCompile (void)
             /* Function which is defined and referenced or extern */
             MoveLiteralPool (Entry->V.F.LitPool);
             CS_MergeLabels (Entry->V.F.Seg->Code);
-            RunOpt (Entry->V.F.Seg->Code);
+            CollAppend (&Funcs, Entry->V.F.Seg);
         }
     }
 
+    /* Move the stack frames of non recursive functions into static memory.
+    ** This must be done before the code is optimized or copied.
+    */
+    MakeStaticFrames (&Funcs);
+
+    /* Inline small local functions if larger code is acceptable. This
+    ** optimizes them, and removes them from the list.
+    */
+    if (IS_Get (&CodeSizeFactor) > 100) {
+        InlineFuncs (&Funcs);
+    }
+
+    /* Optimize the functions. This is done in parallel if possible, but the
+    ** code is output later in the original order.
+    */
+    RunOptSegs (&Funcs);
+    DoneCollection (&Funcs);
+
     /* Output the literal pool */
     OutputGlobalLiteralPool ();
 
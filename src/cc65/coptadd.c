@@ -91,12 +91,12 @@ unsigned OptAdd1 (CodeSeg* S)
             CE_IsConstImm (L[0])             &&
             !CS_RangeHasLabel (S, I+1, 5)    &&
             CS_GetEntries (S, L+1, I+1, 5)   &&
-            CE_IsCallTo (L[1], "ldaxysp")    &&
-            CE_IsCallTo (L[2], "pushax")     &&
+            CE_IsCallTo (L[1], ARG_LDAXYSP)  &&
+            CE_IsCallTo (L[2], ARG_PUSHAX)   &&
             L[3]->OPC == OP65_LDY            &&
             CE_IsConstImm (L[3])             &&
-            CE_IsCallTo (L[4], "ldaxysp")    &&
-            CE_IsCallTo (L[5], "tosaddax")) {
+            CE_IsCallTo (L[4], ARG_LDAXYSP)  &&
+            CE_IsCallTo (L[5], ARG_TOSADDAX)) {
 
             CodeEntry* X;
             const char* Arg;
@@ -211,10 +211,10 @@ unsigned OptAdd2 (CodeSeg* S)
             CE_IsConstImm (L[0])                &&
             !CS_RangeHasLabel (S, I+1, 3)       &&
             CS_GetEntries (S, L+1, I+1, 3)      &&
-            CE_IsCallTo (L[1], "ldaxysp")       &&
+            CE_IsCallTo (L[1], ARG_LDAXYSP)     &&
             L[2]->OPC == OP65_LDY               &&
             CE_IsConstImm (L[2])                &&
-            CE_IsCallTo (L[3], "addeqysp")      &&
+            CE_IsCallTo (L[3], ARG_ADDEQYSP)    &&
             (GetRegInfo (S, I+4, REG_AX) & REG_AX) == 0) {
 
             /* Insert new code behind the addeqysp */
@@ -315,13 +315,13 @@ unsigned OptAdd3 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "pushax")                        &&
+        if (CE_IsCallTo (L[0], ARG_PUSHAX)                      &&
             CS_GetEntries (S, L+1, I+1, 4)                      &&
             !CS_RangeHasLabel (S, I+1, 3)                       &&
             L[1]->OPC == OP65_LDX                               &&
             CE_IsKnownImm (L[1], 0)                             &&
             L[2]->OPC == OP65_LDA                               &&
-            CE_IsCallTo (L[3], "tosaddax")) {
+            CE_IsCallTo (L[3], ARG_TOSADDAX)) {
 
             CodeEntry* X;
             CodeLabel* Label;
@@ -393,14 +393,14 @@ unsigned OptAdd4 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "pushax")                        &&
+        if (CE_IsCallTo (L[0], ARG_PUSHAX)                      &&
             CS_GetEntries (S, L+1, I+1, 3)                      &&
             !CS_RangeHasLabel (S, I+1, 3)                       &&
             L[1]->OPC == OP65_LDA                               &&
             (L[1]->AM == AM65_ABS || L[1]->AM == AM65_ZP)       &&
             L[2]->OPC == OP65_LDX                               &&
             (L[2]->AM == AM65_ABS || L[2]->AM == AM65_ZP)       &&
-            CE_IsCallTo (L[3], "tosaddax")) {
+            CE_IsCallTo (L[3], ARG_TOSADDAX)) {
 
             CodeEntry* X;
 
@@ -377,9 +377,9 @@ unsigned OptBoolUnary1 (CodeSeg* S)
         if (L[0]->OPC == OP65_JSR                   &&
             (L[1] = CS_GetNextEntry (S, I)) != 0    &&
             !CE_HasLabel (L[1])) {
-            if (strcmp (L[0]->Arg, "bnegax") == 0) {
+            if (CE_IsArg (L[0], ARG_BNEGAX)) {
                 Neg = 1;
-            } else if (strcmp (L[0]->Arg, "bcastax") == 0) {
+            } else if (CE_IsArg (L[0], ARG_BCASTAX)) {
                 Neg = 0;
             } else {
                 /* Next entry */
@@ -387,8 +387,8 @@ unsigned OptBoolUnary1 (CodeSeg* S)
                 continue;
             }
             if ((L[1]->OPC == OP65_CMP && CE_IsKnownImm (L[1], 0x0)) ||
-                CE_IsCallTo (L[1], "boolne") ||
-                CE_IsCallTo (L[1], "bcastax")) {
+                CE_IsCallTo (L[1], ARG_BOOLNE) ||
+                CE_IsCallTo (L[1], ARG_BCASTAX)) {
                 /* Delete the entry no longer needed. */
                 CS_DelEntry (S, I + 1);
 
@@ -399,8 +399,8 @@ unsigned OptBoolUnary1 (CodeSeg* S)
                 continue;
 
             } else if ((L[1]->OPC == OP65_CMP && CE_IsKnownImm (L[1], 0x1)) ||
-                CE_IsCallTo (L[1], "booleq") ||
-                CE_IsCallTo (L[1], "bnegax")) {
+                CE_IsCallTo (L[1], ARG_BOOLEQ) ||
+                CE_IsCallTo (L[1], ARG_BNEGAX)) {
                 /* Invert the previous bool conversion */
                 CE_SetArg (L[0], Neg ? "bcastax" : "bnegax");
 
@@ -453,8 +453,8 @@ unsigned OptBoolUnary2 (CodeSeg* S)
             !CE_HasLabel (L[1])                     &&
             (Cond = FindBoolCmpCond (L[0]->Arg)) != CMP_INV) {
             if ((L[1]->OPC == OP65_CMP && CE_IsKnownImm (L[1], 0x0)) ||
-                CE_IsCallTo (L[1], "boolne") ||
-                CE_IsCallTo (L[1], "bcastax")) {
+                CE_IsCallTo (L[1], ARG_BOOLNE) ||
+                CE_IsCallTo (L[1], ARG_BCASTAX)) {
                 /* Delete the entry no longer needed */
                 CS_DelEntry (S, I + 1);
 
@@ -465,8 +465,8 @@ unsigned OptBoolUnary2 (CodeSeg* S)
                 continue;
 
             } else if ((L[1]->OPC == OP65_CMP && CE_IsKnownImm (L[1], 0x1)) ||
-                CE_IsCallTo (L[1], "booleq") ||
-                CE_IsCallTo (L[1], "bnegax")) {
+                CE_IsCallTo (L[1], ARG_BOOLEQ) ||
+                CE_IsCallTo (L[1], ARG_BNEGAX)) {
                 /* Invert the bool conversion */
                 if (GetBoolCmpSuffix (Buf, GetNegatedCond (Cond)) == 0) {
                     Internal ("No inverted boolean transformer for: %s", L[0]->Arg);
@@ -525,9 +525,9 @@ unsigned OptBoolUnary3 (CodeSeg* S)
         /* Check for the sequence */
         if (!CE_HasLabel (E)) {
             /* Choose the right subroutine */
-            if (CE_IsCallTo (E, "bnegax")) {
+            if (CE_IsCallTo (E, ARG_BNEGAX)) {
                 Sub = "booleq";
-            } else if (CE_IsCallTo (E, "bcastax")) {
+            } else if (CE_IsCallTo (E, ARG_BCASTAX)) {
                 Sub = "boolne";
             }
             /* Choose the right opcode */
@@ -604,7 +604,7 @@ unsigned OptBNegA1 (CodeSeg* S)
             L[0]->OPC == OP65_LDA           &&
             (L[0]->Use & REG_X) == 0        &&
             !CE_HasLabel (L[0])             &&
-            CE_IsCallTo (L[1], "bnega")     &&
+            CE_IsCallTo (L[1], ARG_BNEGA)   &&
             !CE_HasLabel (L[1])) {
 
             /* Remove the ldx instruction */
@@ -660,7 +660,7 @@ unsigned OptBNegA2 (CodeSeg* S)
              E->OPC == OP65_TXA ||
              E->OPC == OP65_TYA)                &&
             CS_GetEntries (S, L, I+1, 2)        &&
-            CE_IsCallTo (L[0], "bnega")         &&
+            CE_IsCallTo (L[0], ARG_BNEGA)       &&
             !CE_HasLabel (L[0])                 &&
             (L[1]->Info & OF_ZBRA) != 0         &&
             !CE_HasLabel (L[1])                 &&
@@ -711,7 +711,7 @@ unsigned OptBNegAX1 (CodeSeg* S)
         CodeEntry* E = CS_GetEntry (S, I);
 
         /* Check if this is a call to bnegax, and if X is known and zero */
-        if (E->RI->In.RegX == 0 && CE_IsCallTo (E, "bnegax")) {
+        if (E->RI->In.RegX == 0 && CE_IsCallTo (E, ARG_BNEGAX)) {
 
             CodeEntry* X = NewCodeEntry (OP65_JSR, AM65_ABS, "bnega", 0, E->LI);
             CS_InsertEntry (S, X, I+1);
@@ -765,8 +765,8 @@ unsigned OptBNegAX2 (CodeSeg* S)
             CE_IsConstImm (L[0])                &&
             !CS_RangeHasLabel (S, I+1, 3)       &&
             CS_GetEntries (S, L+1, I+1, 3)      &&
-            CE_IsCallTo (L[1], "ldaxysp")       &&
-            CE_IsCallTo (L[2], "bnegax")        &&
+            CE_IsCallTo (L[1], ARG_LDAXYSP)     &&
+            CE_IsCallTo (L[2], ARG_BNEGAX)      &&
             (L[3]->Info & OF_ZBRA) != 0         &&
             (GetRegInfo (S, I + 4, PSTATE_Z) & PSTATE_Z) == 0) {
 
@@ -837,7 +837,7 @@ unsigned OptBNegAX3 (CodeSeg* S)
             CS_GetEntries (S, L, I+1, 3)        &&
             L[0]->OPC == OP65_LDX               &&
             !CE_HasLabel (L[0])                 &&
-            CE_IsCallTo (L[1], "bnegax")        &&
+            CE_IsCallTo (L[1], ARG_BNEGAX)      &&
             !CE_HasLabel (L[1])                 &&
             (L[2]->Info & OF_ZBRA) != 0         &&
             !CE_HasLabel (L[2])                 &&
@@ -906,7 +906,7 @@ unsigned OptBNegAX4 (CodeSeg* S)
             CodeEntry* X;
 
             /* Check if we're calling bnega or bnegax */
-            int ByteSized = (strcmp (L[0]->Arg, "bnega") == 0);
+            int ByteSized = CE_IsArg (L[0], ARG_BNEGA);
 
             /* Insert apropriate test code */
             if (ByteSized) {
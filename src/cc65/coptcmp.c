@@ -86,6 +86,18 @@ static int GetCmpRegVal (const CodeEntry* E)
 
 
 
+static int CarryUsedAfterBranch (CodeSeg* S, const CodeEntry* B, unsigned Index)
+/* Return true if the carry flag is used after the conditional branch B at
+** the given index, either at the branch target or when falling through.
+*/
+{
+    unsigned Target = CS_GetEntryIndex (S, B->JumpTo->Owner);
+    return (GetRegInfo (S, Index + 1, PSTATE_C) & PSTATE_C) != 0 ||
+           (GetRegInfo (S, Target, PSTATE_C) & PSTATE_C) != 0;
+}
+
+
+
 /*****************************************************************************/
 /*                        Optimizations for compares                         */
 /*****************************************************************************/
@@ -120,9 +132,9 @@ unsigned OptCmp1 (CodeSeg* S)
             !CS_RangeHasLabel (S, I+1, 2)       &&
             CS_GetEntries (S, L+1, I+1, 2)      &&
             L[1]->OPC == OP65_STX               &&
-            strcmp (L[1]->Arg, "tmp1") == 0     &&
+            CE_IsArg (L[1], ARG_TMP1)           &&
             L[2]->OPC == OP65_ORA               &&
-            strcmp (L[2]->Arg, "tmp1") == 0) {
+            CE_IsArg (L[2], ARG_TMP1)) {
 
             CodeEntry* X;
 
@@ -178,9 +190,9 @@ unsigned OptCmp2 (CodeSeg* S)
             !CS_RangeHasLabel (S, I+1, 2)       &&
             CS_GetEntries (S, L, I+1, 2)        &&
             L[0]->OPC == OP65_STX               &&
-            strcmp (L[0]->Arg, "tmp1") == 0     &&
+            CE_IsArg (L[0], ARG_TMP1)           &&
             L[1]->OPC == OP65_ORA               &&
-            strcmp (L[1]->Arg, "tmp1") == 0) {
+            CE_IsArg (L[1], ARG_TMP1)) {
 
             /* Remove the remaining instructions */
             CS_DelEntries (S, I+1, 2);
@@ -421,7 +433,7 @@ unsigned OptCmp5 (CodeSeg* S)
             CE_IsConstImm (L[0])            &&
             CS_GetEntries (S, L+1, I+1, 5)  &&
             !CE_HasLabel (L[1])             &&
-            CE_IsCallTo (L[1], "ldaxysp")   &&
+            CE_IsCallTo (L[1], ARG_LDAXYSP) &&
             IsImmCmp16 (L+2)) {
 
             if ((L[5]->Info & OF_FBRA) != 0 && L[2]->Num == 0 && L[4]->Num == 0) {
@@ -727,7 +739,8 @@ unsigned OptCmp9 (CodeSeg* S)
 **    bcc/bcs   somewhere
 **
 ** If A is not used later (which should be the case), we can branch on the N
-** flag instead of the carry flag and remove the asl.
+** flag instead of the carry flag and remove the asl. The carry is different
+** then, so it must not be used later either.
 */
 {
     unsigned Changes = 0;
@@ -759,8 +772,10 @@ unsigned OptCmp9 (CodeSeg* S)
              L[4]->OPC == OP65_BCS              ||
              L[4]->OPC == OP65_JCC              ||
              L[4]->OPC == OP65_JCS)                     &&
+            L[4]->JumpTo != 0                           &&
             !CE_HasLabel (L[4])                         &&
-            !RegAUsed (S, I+4)) {
+            !RegAUsed (S, I+4)                          &&
+            !CarryUsedAfterBranch (S, L[4], I+4)) {
 
             /* Replace the branch condition */
             switch (GetBranchCond (L[4]->OPC)) {
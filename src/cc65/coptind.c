@@ -542,151 +542,6 @@ unsigned OptDupLoads (CodeSeg* S)
 
 
 
-unsigned OptStoreLoad (CodeSeg* S)
-/* Remove a store followed by a load from the same location. */
-{
-    unsigned Changes = 0;
-
-    /* Walk over the entries */
-    unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        CodeEntry* N;
-        CodeEntry* X;
-
-        /* Get next entry */
-        CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check if it is a store instruction followed by a load from the
-        ** same address which is itself not followed by a conditional branch.
-        */
-        if ((E->Info & OF_STORE) != 0                       &&
-            (N = CS_GetNextEntry (S, I)) != 0               &&
-            !CE_HasLabel (N)                                &&
-            E->AM == N->AM                                  &&
-            ((E->OPC == OP65_STA && N->OPC == OP65_LDA) ||
-             (E->OPC == OP65_STX && N->OPC == OP65_LDX) ||
-             (E->OPC == OP65_STY && N->OPC == OP65_LDY))    &&
-            strcmp (E->Arg, N->Arg) == 0                    &&
-            (X = CS_GetNextEntry (S, I+1)) != 0             &&
-            !CE_UseLoadFlags (X)) {
-
-            /* Register has already the correct value, remove the load */
-            CS_DelEntry (S, I+1);
-
-            /* Remember, we had changes */
-            ++Changes;
-
-        }
-
-        /* Next entry */
-        ++I;
-
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
-unsigned OptLoadStore1 (CodeSeg* S)
-/* Remove an 8 bit load followed by a store into the same location. */
-{
-    unsigned Changes = 0;
-
-    /* Walk over the entries */
-    unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        CodeEntry* N;
-
-        /* Get next entry */
-        CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check if it is a load instruction followed by a store into the
-        ** same address.
-        */
-        if ((E->Info & OF_LOAD) != 0                        &&
-            (N = CS_GetNextEntry (S, I)) != 0               &&
-            !CE_HasLabel (N)                                &&
-            E->AM == N->AM                                  &&
-            ((E->OPC == OP65_LDA && N->OPC == OP65_STA) ||
-             (E->OPC == OP65_LDX && N->OPC == OP65_STX) ||
-             (E->OPC == OP65_LDY && N->OPC == OP65_STY))    &&
-            strcmp (E->Arg, N->Arg) == 0) {
-
-            /* Memory cell has already the correct value, remove the store */
-            CS_DelEntry (S, I+1);
-
-            /* Remember, we had changes */
-            ++Changes;
-        }
-
-        /* Next entry */
-        ++I;
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
-unsigned OptLoadStoreLoad (CodeSeg* S)
-/* Search for the sequence
-**
-**      ld.     xx
-**      st.     yy
-**      ld.     xx
-**
-** and remove the useless load.
-*/
-{
-    unsigned Changes = 0;
-
-    /* Walk over the entries */
-    unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        CodeEntry* L[3];
-
-        /* Get next entry */
-        L[0] = CS_GetEntry (S, I);
-
-        /* Check for the sequence */
-        if ((L[0]->OPC == OP65_LDA ||
-             L[0]->OPC == OP65_LDX ||
-             L[0]->OPC == OP65_LDY)                         &&
-            (L[0]->AM == AM65_ABS || L[0]->AM == AM65_ZP)   &&
-            !CS_RangeHasLabel (S, I+1, 3)                   &&
-            CS_GetEntries (S, L+1, I+1, 2)                  &&
-            (L[1]->OPC == OP65_STA ||
-             L[1]->OPC == OP65_STX ||
-             L[1]->OPC == OP65_STY)                         &&
-            L[2]->OPC == L[0]->OPC                          &&
-            L[2]->AM == L[0]->AM                            &&
-            strcmp (L[0]->Arg, L[2]->Arg) == 0) {
-
-            /* Remove the second load */
-            CS_DelEntry (S, I+2);
-
-            /* Remember, we had changes */
-            ++Changes;
-
-        }
-
-        /* Next entry */
-        ++I;
-
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
 unsigned OptTransfers1 (CodeSeg* S)
 /* Remove transfers from one register to another and back */
 {
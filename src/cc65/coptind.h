@@ -63,15 +63,6 @@ unsigned OptLoad3 (CodeSeg* S);
 unsigned OptDupLoads (CodeSeg* S);
 /* Remove loads of registers where the value loaded is already in the register. */
 
-unsigned OptStoreLoad (CodeSeg* S);
-/* Remove a store followed by a load from the same location. */
-
-unsigned OptLoadStore1 (CodeSeg* S);
-/* Remove an 8 bit load followed by a store into the same location. */
-
-unsigned OptLoadStoreLoad (CodeSeg* S);
-/* Remove a load, store followed by a reload of the same location. */
-
 unsigned OptTransfers1 (CodeSeg* S);
 /* Remove transfers from one register to another and back */
 
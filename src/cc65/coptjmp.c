@@ -207,7 +207,7 @@ unsigned OptBranchDist2 (CodeSeg* S)
         CodeEntry* E = CS_GetEntry (S, I);
 
        if ((CPUIsets[CPU] & (CPU_ISET_65SC02 |CPU_ISET_6502DTV)) != 0 && /* CPU has BRA */
-           (E->Info & OF_UBRA) != 0                                   && /* is a unconditional branch */
+           E->OPC == OP65_BRA                                         && /* is a BRA */
            E->JumpTo == NULL) {                                          /* target is extern */
             /* BRA jumps to external symbol and must be replaced by a JMP on the 65C02 CPU */
             CE_ReplaceOPC (E, OP65_JMP);
@@ -482,6 +482,29 @@ unsigned OptJumpCascades (CodeSeg* S)
         /* Get this entry */
         CodeEntry* E = CS_GetEntry (S, I);
 
+        /* If the insn jumps through a table, let the table entries that point
+        ** to unconditional jumps point to the final targets.
+        */
+        if (E->Flags & CEF_JUMPTABLE) {
+
+            const JumpTable* T = CS_GetJumpTable (E);
+            unsigned J;
+
+            for (J = 0; J < CollCount (&T->Labels); ++J) {
+                OldLabel = (CodeLabel*) CollConstAt (&T->Labels, J);
+                N = OldLabel->Owner;
+                if ((N->Info & OF_UBRA) != 0    &&
+                    N->JumpTo != 0              &&
+                    N->JumpTo->Owner != N) {
+
+                    /* Jump to the final jump target */
+                    CS_MoveJumpTableRef (S, E, OldLabel, N->JumpTo);
+
+                    /* Remember, we had changes */
+                    ++Changes;
+                }
+            }
+
         /* Check:
         **   - if it's a branch,
         **   - if it has a jump label,
@@ -494,12 +517,12 @@ unsigned OptJumpCascades (CodeSeg* S)
         ** code, since conditional far branches are emulated by a short branch
         ** around a jump.
         */
-        if ((E->Info & OF_BRA) != 0             &&
-            (OldLabel = E->JumpTo) != 0         &&
-            (N = OldLabel->Owner) != E          &&
-            (N->Info & OF_BRA) != 0             &&
-            ((E->Info & OF_CBRA) == 0   ||
-             N->JumpTo != 0)) {
+        } else if ((E->Info & OF_BRA) != 0             &&
+                   (OldLabel = E->JumpTo) != 0         &&
+                   (N = OldLabel->Owner) != E          &&
+                   (N->Info & OF_BRA) != 0             &&
+                   ((E->Info & OF_CBRA) == 0   ||
+                    N->JumpTo != 0)) {
 
             /* Check if we can use the final target label. That is the case,
             ** if the target branch is an absolute branch; or, if it is a
@@ -872,7 +895,11 @@ unsigned OptJumpTarget3 (CodeSeg* S)
                         }
 
                         /* Change the jump target to point to this new label */
-                        CS_MoveLabelRef (S, Jump, LN);
+                        if (Jump->JumpTo == L) {
+                            CS_MoveLabelRef (S, Jump, LN);
+                        } else {
+                            CS_MoveJumpTableRef (S, Jump, L, LN);
+                        }
 
                         /* Remember that we had changes */
                         ++Changes;
@@ -103,17 +103,17 @@ unsigned OptLongAssign (CodeSeg* S)
               L[11]->OPC == OP65_STY                               &&
               /* Check the arguments match */
               L[0]->AM == AM65_IMM                                 &&
-              !strcmp (L[1]->Arg, "sreg+1")                        &&
+              CE_IsArg (L[1], ARG_SREG_1)                          &&
               L[2]->AM == AM65_IMM                                 &&
-              !strcmp (L[3]->Arg, "sreg")                          &&
+              CE_IsArg (L[3], ARG_SREG)                            &&
               L[4]->AM == AM65_IMM                                 &&
               L[5]->AM == AM65_IMM                                 &&
               !strncmp(L[7]->Arg, L[6]->Arg, strlen(L[6]->Arg))    &&
                 !strcmp(L[7]->Arg + strlen(L[6]->Arg), "+1")       &&
-              !strcmp (L[8]->Arg, "sreg")                          &&
+              CE_IsArg (L[8], ARG_SREG)                            &&
               !strncmp(L[9]->Arg, L[6]->Arg, strlen(L[6]->Arg))    &&
                 !strcmp(L[9]->Arg + strlen(L[6]->Arg), "+2")       &&
-              !strcmp (L[10]->Arg, "sreg+1")                       &&
+              CE_IsArg (L[10], ARG_SREG_1)                         &&
               !strncmp(L[11]->Arg, L[6]->Arg, strlen(L[6]->Arg))   &&
                 !strcmp(L[11]->Arg + strlen(L[6]->Arg), "+3")      &&
               /* Check there's nothing more */
@@ -187,12 +187,12 @@ unsigned OptLongCopy (CodeSeg* S)
                 !strncmp(L[0]->Arg, L[5]->Arg, strlen(L[5]->Arg))  &&
                 !strcmp(L[0]->Arg + strlen(L[5]->Arg), "+3")       &&
               L[1]->OPC == OP65_STA                                &&
-                !strcmp (L[1]->Arg, "sreg+1")                      &&
+                CE_IsArg (L[1], ARG_SREG_1)                        &&
               L[2]->OPC == OP65_LDA                                &&
                 !strncmp(L[2]->Arg, L[5]->Arg, strlen(L[5]->Arg))  &&
                 !strcmp(L[2]->Arg + strlen(L[5]->Arg), "+2")       &&
               L[3]->OPC == OP65_STA                                &&
-                !strcmp (L[3]->Arg, "sreg")                        &&
+                CE_IsArg (L[3], ARG_SREG)                          &&
               L[4]->OPC == OP65_LDX                                &&
                 !strncmp(L[4]->Arg, L[5]->Arg, strlen(L[5]->Arg))  &&
                 !strcmp(L[4]->Arg + strlen(L[5]->Arg), "+1")       &&
@@ -202,12 +202,12 @@ unsigned OptLongCopy (CodeSeg* S)
                 !strncmp(L[7]->Arg, L[6]->Arg, strlen(L[6]->Arg))  &&
                 !strcmp(L[7]->Arg + strlen(L[6]->Arg), "+1")       &&
               L[8]->OPC == OP65_LDY                                &&
-                !strcmp (L[8]->Arg, "sreg")                        &&
+                CE_IsArg (L[8], ARG_SREG)                          &&
               L[9]->OPC == OP65_STY                                &&
                 !strncmp(L[9]->Arg, L[6]->Arg, strlen(L[6]->Arg))  &&
                 !strcmp(L[9]->Arg + strlen(L[6]->Arg), "+2")       &&
               L[10]->OPC == OP65_LDY                               &&
-                !strcmp (L[10]->Arg, "sreg+1")                     &&
+                CE_IsArg (L[10], ARG_SREG_1)                       &&
               L[11]->OPC == OP65_STY                               &&
                 !strncmp(L[11]->Arg, L[6]->Arg, strlen(L[6]->Arg)) &&
                 !strcmp(L[11]->Arg + strlen(L[6]->Arg), "+3")      &&
@@ -0,0 +1,1174 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coptloop.c                                */
+/*                                                                           */
+/*           Optimize array indexing and induction variables in loops        */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <string.h>
+
+/* common */
+#include "coll.h"
+#include "strbuf.h"
+
+/* cc65 */
+#include "codeent.h"
+#include "codeinfo.h"
+#include "coptloop.h"
+
+
+
+/*****************************************************************************/
+/*                                  Helpers                                  */
+/*****************************************************************************/
+
+
+
+static int IsMemLoc (const CodeEntry* E)
+/* Return true if E accesses a variable in memory that is not one of the
+** zero page registers used by the runtime.
+*/
+{
+    return (E->AM == AM65_ZP || E->AM == AM65_ABS)     &&
+           E->ArgDesc->Parsed                           &&
+           (E->ArgDesc->ZP == 0 || E->ArgDesc->ZP->ByteUse == REG_NONE);
+}
+
+
+
+static int SameLoc (const CodeEntry* A, const CodeEntry* B)
+/* Return true if A and B access the same location in memory */
+{
+    return A->ArgDesc == B->ArgDesc                               ||
+           (A->ArgDesc->Parsed && B->ArgDesc->Parsed            &&
+            A->ArgDesc->Off == B->ArgDesc->Off                  &&
+            strcmp (A->ArgDesc->Base, B->ArgDesc->Base) == 0);
+}
+
+
+
+static int IsHiByte (const CodeEntry* Lo, const CodeEntry* Hi)
+/* Return true if Lo and Hi access the low and high byte of a word in the zero
+** page.
+*/
+{
+    return Lo->AM == AM65_ZP && Hi->AM == AM65_ZP              &&
+           IsMemLoc (Lo) && IsMemLoc (Hi)                       &&
+           Hi->ArgDesc->Off == Lo->ArgDesc->Off + 1             &&
+           strcmp (Lo->ArgDesc->Base, Hi->ArgDesc->Base) == 0;
+}
+
+
+
+static int GetImmAddr (const CodeEntry* Lo, const CodeEntry* Hi, StrBuf* Addr)
+/* If Lo and Hi load the low and high byte of the same address as immediate
+** values, store the address into Addr and return true.
+*/
+{
+    const char* L = Lo->Arg;
+    const char* H = Hi->Arg;
+    unsigned    Len;
+
+    if (Lo->AM != AM65_IMM || Hi->AM != AM65_IMM ||
+        strncmp (L, "<(", 2) != 0 || strncmp (H, ">(", 2) != 0) {
+        return 0;
+    }
+    Len = strlen (L);
+    if (L[Len-1] != ')' || strcmp (L + 1, H + 1) != 0) {
+        return 0;
+    }
+    SB_CopyBuf (Addr, L + 2, Len - 3);
+    SB_Terminate (Addr);
+    return 1;
+}
+
+
+
+static unsigned GetPtrRegs (const CodeEntry* Lo, const CodeEntry* Hi)
+/* If Lo and Hi store into the low and high byte of ptr1, ptr2 or sreg,
+** return the register bits of the pointer, otherwise REG_NONE.
+*/
+{
+    const ZPInfo* L = Lo->ArgDesc->ZP;
+    const ZPInfo* H = Hi->ArgDesc->ZP;
+
+    if (Lo->AM != AM65_ZP || Hi->AM != AM65_ZP || L == 0 || H == 0 ||
+        L->Size != 2 || H->Size != 1 || L->WordUse != H->WordUse) {
+        return REG_NONE;
+    }
+    switch (L->WordUse) {
+        case REG_PTR1:
+        case REG_PTR2:
+        case REG_SREG:
+            return L->WordUse;
+        default:
+            return REG_NONE;
+    }
+}
+
+
+
+static int IsPointedTo (const CodeEntry* Loc)
+/* Return true if the location accessed by Loc may be accessed through a
+** pointer. This is true for all variables except the zero page locations
+** known to the runtime, because the address of any zero page variable may
+** be taken.
+*/
+{
+    return Loc->AM == AM65_ABS || Loc->ArgDesc->ZP == 0;
+}
+
+
+
+static int MayChange (const CodeEntry* E, const CodeEntry* Loc)
+/* Return true if E may change the memory location accessed by Loc */
+{
+    if ((E->Info & OF_WRITE) == 0) {
+        return 0;
+    }
+    switch (E->AM) {
+        case AM65_ZP:
+        case AM65_ABS:
+            return SameLoc (E, Loc);
+        case AM65_ZPX:
+        case AM65_ZPY:
+        case AM65_ABSX:
+        case AM65_ABSY:
+            return Loc->AM == AM65_ABS ||
+                   strcmp (E->ArgDesc->Base, Loc->ArgDesc->Base) == 0;
+        case AM65_ZPX_IND:
+        case AM65_ZP_INDY:
+        case AM65_ZP_IND:
+            return IsPointedTo (Loc);
+        default:
+            return 0;
+    }
+}
+
+
+
+static int MayAccess (const CodeEntry* E, const CodeEntry* Loc)
+/* Return true if E may read or change the memory location accessed by Loc */
+{
+    switch (E->AM) {
+        case AM65_ZP:
+        case AM65_ABS:
+            return !E->ArgDesc->Parsed || SameLoc (E, Loc);
+        case AM65_ZPX:
+        case AM65_ZPY:
+        case AM65_ABSX:
+        case AM65_ABSY:
+            return Loc->AM == AM65_ABS                                  ||
+                   !E->ArgDesc->Parsed                                  ||
+                   strcmp (E->ArgDesc->Base, Loc->ArgDesc->Base) == 0;
+        case AM65_ZPX_IND:
+            return IsPointedTo (Loc)                                    ||
+                   !E->ArgDesc->Parsed                                  ||
+                   strcmp (E->ArgDesc->Base, Loc->ArgDesc->Base) == 0;
+        case AM65_ZP_INDY:
+        case AM65_ZP_IND:
+            /* The pointer itself is read from the zero page */
+            return IsPointedTo (Loc)                                    ||
+                   !E->ArgDesc->Parsed                                  ||
+                   (strcmp (E->ArgDesc->Base, Loc->ArgDesc->Base) == 0 &&
+                    (E->ArgDesc->Off == Loc->ArgDesc->Off               ||
+                     E->ArgDesc->Off + 1 == Loc->ArgDesc->Off));
+        default:
+            return 0;
+    }
+}
+
+
+
+static int IsPtrUse (const CodeEntry* E, const CodeEntry* Ptr)
+/* Return true if E is an access through the pointer that Ptr stores into */
+{
+    return (E->AM == AM65_ZP_INDY || E->AM == AM65_ZP_IND) &&
+           E->ArgDesc == Ptr->ArgDesc;
+}
+
+
+
+static int FindPtrUses (CodeSeg* S, unsigned Start, const CodeEntry* Ptr,
+                        unsigned PtrRegs, const CodeEntry** Keep,
+                        unsigned KeepCount, Collection* Uses)
+/* Collect the accesses through the pointer stored by Ptr in the basic block
+** starting at Start, as long as none of the KeepCount locations in Keep is
+** changed. Return true if there are such accesses, the pointer isn't used
+** otherwise, and its value is not needed after the last of them.
+*/
+{
+    unsigned I = Start;
+    unsigned J;
+
+    while (I < CS_GetEntryCount (S)) {
+
+        const CodeEntry* E = CS_GetEntry (S, I);
+
+        /* The block ends at a label */
+        if (CE_HasLabel (E)) {
+            break;
+        }
+
+        /* Check how the insn uses the pointer */
+        if (IsPtrUse (E, Ptr)) {
+            CollAppend (Uses, (CodeEntry*) E);
+        } else if ((E->Use & PtrRegs) != 0) {
+            /* Used in another way */
+            return 0;
+        } else if ((E->Chg & PtrRegs) != 0) {
+            /* The pointer gets a new value */
+            break;
+        }
+
+        /* Jumps, calls and returns end the block */
+        if ((E->Info & (OF_BRA | OF_CALL | OF_RET)) != 0) {
+            break;
+        }
+
+        /* Stop if one of the locations changes */
+        for (J = 0; J < KeepCount; ++J) {
+            if (MayChange (E, Keep[J])) {
+                break;
+            }
+        }
+        ++I;
+        if (J < KeepCount) {
+            break;
+        }
+    }
+
+    /* Check the results */
+    return CollCount (Uses) > 0 && (GetRegInfo (S, I, PtrRegs) & PtrRegs) == 0;
+}
+
+
+
+static void ReplaceEntry (CodeSeg* S, CodeEntry* E, opc_t OPC, am_t AM,
+                          const char* Arg)
+/* Replace E by an insn with the given opcode and operand */
+{
+    unsigned   I = CS_GetEntryIndex (S, E);
+    CodeEntry* X = NewCodeEntry (OPC, AM, Arg, 0, E->LI);
+    CS_InsertEntry (S, X, I);
+    CS_MoveLabels (S, E, X);
+    CS_DelEntry (S, I+1);
+}
+
+
+
+static int IndexUses (CodeSeg* S, Collection* Uses, const CodeEntry* Index,
+                      am_t AM, const char* Arg)
+/* Replace the accesses in Uses that are done through a pointer with y = 0
+** by accesses through Arg in address mode AM, with the value of Index in y.
+** The y register is restored if the old value is used later. Return false
+** without any changes if this is not possible.
+*/
+{
+    Collection Loads  = AUTO_COLLECTION_INITIALIZER;
+    Collection Keep   = AUTO_COLLECTION_INITIALIZER;
+    Collection Drop   = AUTO_COLLECTION_INITIALIZER;
+    int        YIsIdx = 0;
+    int        Ok     = 1;
+    unsigned   Last   = CollCount (Uses) - 1;
+    unsigned   I, K;
+
+    /* Check what must be done for each of the accesses */
+    for (I = 0; Ok && I <= Last; ++I) {
+
+        CodeEntry* E = CollAtUnchecked (Uses, I);
+        unsigned   Pos = CS_GetEntryIndex (S, E);
+        unsigned   End;
+        int        Restore = 0;
+
+        /* Y must be zero */
+        if (E->RI == 0 || E->RI->In.RegY != 0) {
+            Ok = 0;
+            break;
+        }
+
+        /* The load of the index must not change flags that are used */
+        if (!YIsIdx) {
+            if ((E->Chg & PSTATE_ZN) != PSTATE_ZN &&
+                (GetRegInfo (S, Pos+1, PSTATE_ZN) & PSTATE_ZN) != 0) {
+                Ok = 0;
+                break;
+            }
+            CollAppend (&Loads, E);
+            YIsIdx = 1;
+        }
+
+        /* Check the code up to the next access */
+        End = (I < Last)? CS_GetEntryIndex (S, CollAtUnchecked (Uses, I+1)) :
+                          CS_GetEntryCount (S);
+        for (K = Pos + 1; K < End; ++K) {
+            CodeEntry* N = CS_GetEntry (S, K);
+            if (CE_HasLabel (N) || (N->Info & (OF_BRA | OF_CALL | OF_RET)) != 0 ||
+                MayChange (N, Index)) {
+                /* The y register may be used behind this point */
+                Restore = (GetRegInfo (S, K, REG_Y) & REG_Y) != 0;
+                YIsIdx = 0;
+                break;
+            }
+            if (N->OPC == OP65_LDY && SameLoc (N, Index) &&
+                (GetRegInfo (S, K+1, PSTATE_ZN) & PSTATE_ZN) == 0) {
+                /* A reload of the index isn't needed. The old value is
+                ** replaced here.
+                */
+                CollAppend (&Drop, N);
+                YIsIdx = 0;
+                break;
+            } else if ((N->Use & REG_Y) != 0) {
+                /* Uses the old value */
+                Restore = 1;
+                YIsIdx = 0;
+                break;
+            } else if ((N->Chg & REG_Y) != 0) {
+                /* Loads a new value */
+                YIsIdx = 0;
+                break;
+            }
+        }
+        if (K == CS_GetEntryCount (S)) {
+            YIsIdx = 0;
+        }
+        if (Restore) {
+            if ((GetRegInfo (S, Pos+1, PSTATE_ZN) & PSTATE_ZN) != 0) {
+                Ok = 0;
+                break;
+            }
+            CollAppend (&Keep, E);
+        }
+    }
+
+    /* Change the code */
+    if (Ok) {
+        for (I = 0; I <= Last; ++I) {
+            CodeEntry* E = CollAtUnchecked (Uses, I);
+            if (CollIndex (&Keep, E) >= 0) {
+                CodeEntry* X = NewCodeEntry (OP65_LDY, AM65_IMM, "$00", 0, E->LI);
+                CS_InsertEntry (S, X, CS_GetEntryIndex (S, E) + 1);
+            }
+            if (CollIndex (&Loads, E) >= 0) {
+                CodeEntry* X = NewCodeEntry (OP65_LDY, Index->AM, Index->Arg, 0, E->LI);
+                CS_InsertEntry (S, X, CS_GetEntryIndex (S, E));
+            }
+            ReplaceEntry (S, E, E->OPC, AM, Arg);
+        }
+        for (I = 0; I < CollCount (&Drop); ++I) {
+            CS_DelEntry (S, CS_GetEntryIndex (S, CollAtUnchecked (&Drop, I)));
+        }
+    }
+
+    /* Cleanup */
+    DoneCollection (&Loads);
+    DoneCollection (&Keep);
+    DoneCollection (&Drop);
+
+    /* Return the result */
+    return Ok;
+}
+
+
+
+static CodeEntry* FindIndexLoad (CodeSeg* S, unsigned I)
+/* The accumulator is used as index at I. Search backwards in the same basic
+** block for a load of the accumulator from a variable that isn't changed
+** before I, and return it. Return NULL if there is no such load.
+*/
+{
+    unsigned Count = 0;
+    while (I > 0 && Count++ < 8) {
+        CodeEntry* E;
+        if (CE_HasLabel (CS_GetEntry (S, I))) {
+            break;
+        }
+        E = CS_GetEntry (S, --I);
+        if (E->OPC == OP65_LDA) {
+            unsigned J;
+            if (!IsMemLoc (E)) {
+                break;
+            }
+            for (J = I + 1; J < I + Count; ++J) {
+                if (MayChange (CS_GetEntry (S, J), E)) {
+                    return 0;
+                }
+            }
+            return E;
+        }
+        if ((E->Chg & REG_A) != 0 || (E->Info & (OF_CALL | OF_RET)) != 0) {
+            break;
+        }
+    }
+    return 0;
+}
+
+
+
+static int ZNUnused (CodeSeg* S, unsigned I)
+/* Return true if the N and Z flags are not used at I */
+{
+    return (GetRegInfo (S, I, PSTATE_ZN) & PSTATE_ZN) == 0;
+}
+
+
+
+static int FallsInto (CodeSeg* S, unsigned I)
+/* Return true if the entry at I may be reached from the one before it */
+{
+    return I > 0 && (CS_GetEntry (S, I - 1)->Info & (OF_UBRA | OF_RET)) == 0;
+}
+
+
+
+static int RefsInside (CodeSeg* S, CodeEntry* E, unsigned First, unsigned Last)
+/* Return true if all jumps to the labels of E come from the entries in the
+** range First to Last.
+*/
+{
+    unsigned I, J;
+    for (I = 0; I < CE_GetLabelCount (E); ++I) {
+        CodeLabel* L = CE_GetLabel (E, I);
+        for (J = 0; J < CL_GetRefCount (L); ++J) {
+            unsigned Pos = CS_GetEntryIndex (S, CL_GetRef (L, J));
+            if (Pos < First || Pos > Last) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+
+
+static int AddExit (CodeSeg* S, Collection* Exits, unsigned Pos, int YIsVar)
+/* The loop is left to the entry at Pos. Add it to Exits. Return false if the
+** y register is used there but doesn't contain the value of the variable in
+** the original code.
+*/
+{
+    CodeEntry* E = CS_GetEntry (S, Pos);
+    if (!YIsVar && (GetRegInfo (S, Pos, REG_Y) & REG_Y) != 0) {
+        return 0;
+    }
+    if (CollIndex (Exits, E) < 0) {
+        CollAppend (Exits, E);
+    }
+    return 1;
+}
+
+
+
+static int PromoteIndex (CodeSeg* S, unsigned First, unsigned Last,
+                         const CodeEntry* Var)
+/* The entries from First to Last are a loop with the head at First and a jump
+** back to it at Last. Var is a load of the y register from a variable in the
+** loop. If possible, keep the variable in y while the loop runs: Its loads
+** are removed, the other accesses are replaced by register operations, and
+** the variable is loaded when the loop is entered and stored back on every
+** exit. Return true if the loop has been changed.
+*/
+{
+    Collection  Rewrite  = AUTO_COLLECTION_INITIALIZER;  /* Accesses of Var */
+    Collection  Swap     = AUTO_COLLECTION_INITIALIZER;  /* Swapped operands */
+    Collection  Exits    = AUTO_COLLECTION_INITIALIZER;  /* Exit targets */
+    Collection  Entries  = AUTO_COLLECTION_INITIALIZER;  /* Jumps into the loop */
+    Collection  HeadRefs = AUTO_COLLECTION_INITIALIZER;  /* Jumps to the head */
+    CodeEntry*  Head     = CS_GetEntry (S, First);
+    am_t        AM       = Var->AM;
+    const char* Arg      = Var->Arg;
+    unsigned    Loads    = 0;
+    int         HeadLoad = FallsInto (S, First);
+    int         YIsVar   = 0;
+    int         Ok       = 1;
+    unsigned    I, J, K;
+
+    for (I = First; Ok && I <= Last; ++I) {
+
+        CodeEntry* E = CS_GetEntry (S, I);
+
+        /* Check the jumps to this entry. The loop may be entered at other
+        ** places than the head by jumps that are followed by a load of y.
+        */
+        if (CE_HasLabel (E)) {
+            YIsVar = 0;
+            for (J = 0; Ok && J < CE_GetLabelCount (E); ++J) {
+                CodeLabel* L = CE_GetLabel (E, J);
+                for (K = 0; Ok && K < CL_GetRefCount (L); ++K) {
+                    CodeEntry* R   = CL_GetRef (L, K);
+                    unsigned   Pos = CS_GetEntryIndex (S, R);
+                    if (Pos >= First && Pos <= Last) {
+                        if (I == First) {
+                            CollAppend (&HeadRefs, R);
+                        }
+                    } else if (I == First) {
+                        HeadLoad = 1;
+                    } else if ((R->Info & OF_UBRA) != 0             &&
+                               (R->Flags & CEF_JUMPTABLE) == 0      &&
+                               ZNUnused (S, I)) {
+                        CollAppend (&Entries, R);
+                    } else {
+                        Ok = 0;
+                    }
+                }
+            }
+            if (!Ok) {
+                break;
+            }
+        }
+
+        /* Subroutines may change y or access the variable */
+        if ((E->Info & (OF_CALL | OF_RET)) != 0 || (E->Flags & CEF_JUMPTABLE) != 0) {
+            Ok = 0;
+            break;
+        }
+
+        /* Check the accesses of the variable */
+        if ((E->AM == AM65_ZP || E->AM == AM65_ABS) && SameLoc (E, Var)) {
+            switch (E->OPC) {
+
+                case OP65_LDY:
+                    /* Removed */
+                    Ok = ZNUnused (S, I + 1);
+                    YIsVar = 1;
+                    ++Loads;
+                    break;
+
+                case OP65_STY:
+                    /* Removed */
+                    Ok = YIsVar;
+                    break;
+
+                case OP65_LDA:
+                    /* Replaced by tya */
+                    break;
+
+                case OP65_STA:
+                    /* Replaced by tay */
+                    Ok = ZNUnused (S, I + 1);
+                    YIsVar = 0;
+                    break;
+
+                case OP65_INC:
+                case OP65_DEC:
+                    /* Replaced by iny/dey */
+                    YIsVar = 0;
+                    break;
+
+                case OP65_ADC:
+                case OP65_AND:
+                case OP65_EOR:
+                case OP65_ORA:
+                    /* The operands are swapped, so "lda M; clc; adc var"
+                    ** is replaced by "tya; clc; adc M".
+                    */
+                    J = I;
+                    if (J > First + 1                               &&
+                        CS_GetEntry (S, J - 1)->OPC == OP65_CLC     &&
+                        !CE_HasLabel (CS_GetEntry (S, J - 1))) {
+                        --J;
+                    }
+                    if (J > First && !CE_HasLabel (E)                   &&
+                        CS_GetEntry (S, J - 1)->OPC == OP65_LDA         &&
+                        !MayAccess (CS_GetEntry (S, J - 1), Var)) {
+                        CollAppend (&Swap, CS_GetEntry (S, J - 1));
+                    } else {
+                        Ok = 0;
+                    }
+                    break;
+
+                default:
+                    Ok = 0;
+                    break;
+            }
+            CollAppend (&Rewrite, E);
+            continue;
+        }
+
+        /* Other insns must not use y unless it contains the variable, must
+        ** not change it, and must not access the variable.
+        */
+        if (MayAccess (E, Var)                                  ||
+            (E->Chg & REG_Y) != 0                               ||
+            ((E->Use & REG_Y) != 0 && !YIsVar)) {
+            Ok = 0;
+            break;
+        }
+
+        /* Remember the exits */
+        if ((E->Info & OF_BRA) != 0) {
+            unsigned Pos;
+            if (E->JumpTo == 0) {
+                Ok = 0;
+                break;
+            }
+            Pos = CS_GetEntryIndex (S, E->JumpTo->Owner);
+            if (Pos < First || Pos > Last) {
+                Ok = AddExit (S, &Exits, Pos, YIsVar);
+            }
+        }
+    }
+
+    /* The loop may also be left at the end */
+    if (Ok && (CS_GetEntry (S, Last)->Info & OF_UBRA) == 0) {
+        Ok = Last + 1 < CS_GetEntryCount (S) &&
+             AddExit (S, &Exits, Last + 1, YIsVar);
+    }
+
+    /* There must be loads to remove, and the stores on exit must not be
+    ** reached from outside of the loop.
+    */
+    Ok = Ok && Loads > 0;
+    for (I = 0; Ok && I < CollCount (&Exits); ++I) {
+        CodeEntry* E   = CollAtUnchecked (&Exits, I);
+        unsigned   Pos = CS_GetEntryIndex (S, E);
+        Ok = RefsInside (S, E, First, Last) &&
+             (Pos == Last + 1 || !FallsInto (S, Pos));
+    }
+
+    /* Load y when entering the loop at the head. This isn't needed if the
+    ** first insn stores to the variable.
+    */
+    if (Ok && HeadLoad) {
+        if (Head->OPC == OP65_STA && Head->AM == AM && SameLoc (Head, Var)) {
+            HeadLoad = 0;
+        } else {
+            Ok = ZNUnused (S, First);
+        }
+    }
+
+    if (Ok) {
+
+        /* Store the variable on exit */
+        for (I = 0; I < CollCount (&Exits); ++I) {
+            CodeEntry* E = CollAtUnchecked (&Exits, I);
+            CodeEntry* X = NewCodeEntry (OP65_STY, AM, Arg, 0, E->LI);
+            CS_InsertEntry (S, X, CS_GetEntryIndex (S, E));
+            CS_MoveLabels (S, E, X);
+        }
+
+        /* Load the variable before the jumps into the loop */
+        for (I = 0; I < CollCount (&Entries); ++I) {
+            CodeEntry* E = CollAtUnchecked (&Entries, I);
+            CodeEntry* X = NewCodeEntry (OP65_LDY, AM, Arg, 0, E->LI);
+            CS_InsertEntry (S, X, CS_GetEntryIndex (S, E));
+            CS_MoveLabels (S, E, X);
+        }
+
+        /* Load the variable before the head. The jumps from inside of the
+        ** loop go to a new label behind the load.
+        */
+        if (HeadLoad) {
+            CodeEntry* X = NewCodeEntry (OP65_LDY, AM, Arg, 0, Head->LI);
+            CodeLabel* L;
+            CS_InsertEntry (S, X, CS_GetEntryIndex (S, Head));
+            CS_MoveLabels (S, Head, X);
+            L = CS_GenLabel (S, Head);
+            for (I = 0; I < CollCount (&HeadRefs); ++I) {
+                CS_MoveLabelRef (S, CollAtUnchecked (&HeadRefs, I), L);
+            }
+        }
+
+        /* Replace the accesses of the variable */
+        for (I = 0, K = 0; I < CollCount (&Rewrite); ++I) {
+            CodeEntry* E = CollAtUnchecked (&Rewrite, I);
+            switch (E->OPC) {
+                case OP65_LDY:
+                case OP65_STY:
+                    CS_DelEntry (S, CS_GetEntryIndex (S, E));
+                    break;
+                case OP65_LDA:
+                    ReplaceEntry (S, E, OP65_TYA, AM65_IMP, 0);
+                    break;
+                case OP65_STA:
+                    ReplaceEntry (S, E, OP65_TAY, AM65_IMP, 0);
+                    break;
+                case OP65_INC:
+                    ReplaceEntry (S, E, OP65_INY, AM65_IMP, 0);
+                    break;
+                case OP65_DEC:
+                    ReplaceEntry (S, E, OP65_DEY, AM65_IMP, 0);
+                    break;
+                default: {
+                    CodeEntry* L = CollAtUnchecked (&Swap, K++);
+                    ReplaceEntry (S, E, E->OPC, L->AM, L->Arg);
+                    ReplaceEntry (S, L, OP65_TYA, AM65_IMP, 0);
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Cleanup */
+    DoneCollection (&Rewrite);
+    DoneCollection (&Swap);
+    DoneCollection (&Exits);
+    DoneCollection (&Entries);
+    DoneCollection (&HeadRefs);
+
+    /* Return the result */
+    return Ok;
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+unsigned OptIndex1 (CodeSeg* S)
+/* Search for the sequence
+**
+**      lda     zp
+**      ldx     zp+1
+**      sta     ptr
+**      stx     ptr+1
+**
+** where ptr is ptr1, ptr2 or sreg, and replace the following accesses
+** through (ptr),y in the same basic block by (zp),y, provided that ptr is
+** not used otherwise. If the loads are the low and high byte of a constant
+** address, the accesses are replaced by absolute indexed ones. A load of
+** the y register between the loads and the stores is allowed.
+*/
+{
+    unsigned   Changes = 0;
+    StrBuf     Addr = AUTO_STRBUF_INITIALIZER;
+    Collection Uses = AUTO_COLLECTION_INITIALIZER;
+
+    /* Walk over the entries */
+    unsigned I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        CodeEntry* L[5];
+        unsigned   St;
+        unsigned   PtrRegs;
+
+        /* Get next entry */
+        L[0] = CS_GetEntry (S, I);
+
+        /* Check for the sequence. St is the index of the first store. */
+        if ((L[0]->OPC == OP65_LDA || L[0]->OPC == OP65_LDX)    &&
+            CS_GetEntries (S, L+1, I+1, 4)                      &&
+            L[1]->OPC == (L[0]->OPC == OP65_LDA? OP65_LDX : OP65_LDA)) {
+            St = (L[2]->OPC == OP65_LDY)? 3 : 2;
+        } else {
+            ++I;
+            continue;
+        }
+        if (L[St]->OPC == OP65_STA                              &&
+            L[St+1]->OPC == OP65_STX                            &&
+            (PtrRegs = GetPtrRegs (L[St], L[St+1])) != REG_NONE &&
+            !CS_RangeHasLabel (S, I+1, St+1)) {
+
+            const CodeEntry* Lo = (L[0]->OPC == OP65_LDA)? L[0] : L[1];
+            const CodeEntry* Hi = (L[0]->OPC == OP65_LDA)? L[1] : L[0];
+            const CodeEntry* Keep[2];
+            unsigned         J;
+
+            Keep[0] = Lo;
+            Keep[1] = Hi;
+            CollDeleteAll (&Uses);
+            if (IsHiByte (Lo, Hi) &&
+                FindPtrUses (S, I+St+2, L[St], PtrRegs, Keep, 2, &Uses)) {
+
+                /* Use the zero page pointer directly */
+                for (J = 0; J < CollCount (&Uses); ++J) {
+                    CodeEntry* E = CollAtUnchecked (&Uses, J);
+                    ReplaceEntry (S, E, E->OPC, E->AM, Lo->Arg);
+                }
+
+            } else if (GetImmAddr (Lo, Hi, &Addr) &&
+                       FindPtrUses (S, I+St+2, L[St], PtrRegs, Keep, 0, &Uses)) {
+
+                /* Use absolute addressing */
+                for (J = 0; J < CollCount (&Uses); ++J) {
+                    CodeEntry* E = CollAtUnchecked (&Uses, J);
+                    ReplaceEntry (S, E, E->OPC,
+                                  (E->AM == AM65_ZP_INDY)? AM65_ABSY : AM65_ABS,
+                                  SB_GetConstBuf (&Addr));
+                }
+
+            } else {
+                ++I;
+                continue;
+            }
+
+            /* The pointer isn't needed any longer. The loads are removed
+            ** later if their values are unused.
+            */
+            CS_DelEntries (S, I+St, 2);
+
+            /* Remember, we had changes */
+            ++Changes;
+        }
+
+        /* Next entry */
+        ++I;
+
+    }
+
+    /* Cleanup */
+    SB_Done (&Addr);
+    DoneCollection (&Uses);
+
+    /* Return the number of changes made */
+    return Changes;
+}
+
+
+
+unsigned OptIndex2 (CodeSeg* S)
+/* Search for the address calculation of an array element with an unsigned
+** char index
+**
+**      lda     #<(addr)        lda     index
+**      ldx     #>(addr)        clc
+**      clc                     adc     zp
+**      adc     index           ldx     zp+1
+**      bcc     L               bcc     L
+**      inx                     inx
+** L:   sta     ptr        L:   sta     ptr
+**      stx     ptr+1           stx     ptr+1
+**
+** and replace the following accesses through (ptr),y with y = 0 in the same
+** basic block by accesses through addr,y or (zp),y with the index in y. The
+** calculation is removed if its result isn't used otherwise.
+*/
+{
+    unsigned   Changes = 0;
+    StrBuf     Addr = AUTO_STRBUF_INITIALIZER;
+    Collection Uses = AUTO_COLLECTION_INITIALIZER;
+
+    /* Walk over the entries */
+    unsigned I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        CodeEntry*       L[8];
+        const CodeEntry* Lo;
+        const CodeEntry* Hi;
+        const CodeEntry* Index;
+        const CodeEntry* Keep[3];
+        unsigned         First;
+        unsigned         PtrRegs;
+        unsigned         Pos;
+        am_t             AM;
+        const char*      Arg;
+
+        /* Get next entry */
+        L[0] = CS_GetEntry (S, I);
+
+        /* Check for the common end of the sequence */
+        if (!CS_GetEntries (S, L+1, I+1, 7)                     ||
+            L[4]->OPC != OP65_BCC                               ||
+            L[4]->JumpTo == 0                                   ||
+            L[4]->JumpTo->Owner != L[6]                         ||
+            CL_GetRefCount (L[4]->JumpTo) != 1                  ||
+            CE_GetLabelCount (L[6]) != 1                        ||
+            L[5]->OPC != OP65_INX                               ||
+            L[6]->OPC != OP65_STA                               ||
+            L[7]->OPC != OP65_STX                               ||
+            (PtrRegs = GetPtrRegs (L[6], L[7])) == REG_NONE     ||
+            CS_RangeHasLabel (S, I+1, 5)                        ||
+            CE_HasLabel (L[7])) {
+            ++I;
+            continue;
+        }
+
+        /* Check the start of the sequence */
+        First = I;
+        if (L[2]->OPC == OP65_CLC && L[3]->OPC == OP65_ADC &&
+            ((L[0]->OPC == OP65_LDA && L[1]->OPC == OP65_LDX) ||
+             (L[0]->OPC == OP65_LDX && L[1]->OPC == OP65_LDA))) {
+            /* Base in A/X, index added */
+            Lo    = (L[0]->OPC == OP65_LDA)? L[0] : L[1];
+            Hi    = (L[0]->OPC == OP65_LDA)? L[1] : L[0];
+            Index = L[3];
+        } else if (L[1]->OPC == OP65_CLC && L[2]->OPC == OP65_ADC &&
+                   L[3]->OPC == OP65_LDX) {
+            /* Index in A, base added */
+            Lo    = L[2];
+            Hi    = L[3];
+            if (L[0]->OPC == OP65_LDA) {
+                Index = L[0];
+            } else {
+                Index = FindIndexLoad (S, I+1);
+                First = I+1;
+            }
+        } else if (L[0]->OPC == OP65_CLC && L[1]->OPC == OP65_LDA &&
+                   L[2]->OPC == OP65_ADC && L[3]->OPC == OP65_LDX) {
+            /* The same with the clc first */
+            Lo    = L[2];
+            Hi    = L[3];
+            Index = L[1];
+        } else {
+            ++I;
+            continue;
+        }
+        if (Index == 0 || !IsMemLoc (Index)) {
+            ++I;
+            continue;
+        }
+
+        /* Check the base */
+        CollDeleteAll (&Uses);
+        Keep[0] = Index;
+        Keep[1] = Lo;
+        Keep[2] = Hi;
+        if (IsHiByte (Lo, Hi)) {
+            AM  = AM65_ZP_INDY;
+            Arg = Lo->Arg;
+            if (!FindPtrUses (S, I+8, L[6], PtrRegs, Keep, 3, &Uses)) {
+                ++I;
+                continue;
+            }
+        } else if (GetImmAddr (Lo, Hi, &Addr)) {
+            AM  = AM65_ABSY;
+            Arg = SB_GetConstBuf (&Addr);
+            if (!FindPtrUses (S, I+8, L[6], PtrRegs, Keep, 1, &Uses)) {
+                ++I;
+                continue;
+            }
+        } else {
+            ++I;
+            continue;
+        }
+
+        /* Replace the accesses */
+        if (!IndexUses (S, &Uses, Index, AM, Arg)) {
+            ++I;
+            continue;
+        }
+
+        /* Remove the calculation if the registers and flags are unused,
+        ** otherwise just the stores.
+        */
+        Pos = I + 8;
+        if ((GetRegInfo (S, Pos, REG_AX | PSTATE_CZVN) & (REG_AX | PSTATE_CZVN)) == 0) {
+            CS_DelEntries (S, First, Pos - First);
+        } else {
+            CS_DelEntries (S, I+6, 2);
+        }
+
+        /* Remember, we had changes */
+        ++Changes;
+
+        /* Next entry */
+        ++I;
+    }
+
+    /* Cleanup */
+    SB_Done (&Addr);
+    DoneCollection (&Uses);
+
+    /* Return the number of changes made */
+    return Changes;
+}
+
+
+
+unsigned OptPtrInc (CodeSeg* S)
+/* Search for the sequence
+**
+**      lda     #c
+**      clc
+**      adc     ptr
+**      sta     ptr
+**      lda     #$00
+**      adc     ptr+1
+**      sta     ptr+1
+**
+** and replace it by an increment of the pointer in memory, provided that
+** the register and flags are not used later.
+*/
+{
+    unsigned Changes = 0;
+
+    /* Walk over the entries */
+    unsigned I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        CodeEntry* L[7];
+        CodeEntry* Imm;
+        CodeEntry* Lo;
+
+        /* Get next entry */
+        L[0] = CS_GetEntry (S, I);
+
+        /* Check for the sequence */
+        if (I + 7 >= CS_GetEntryCount (S)                       ||
+            !CS_GetEntries (S, L+1, I+1, 6)                     ||
+            CS_RangeHasLabel (S, I+1, 6)                        ||
+            L[2]->OPC != OP65_ADC                               ||
+            L[3]->OPC != OP65_STA                               ||
+            L[5]->OPC != OP65_ADC                               ||
+            L[6]->OPC != OP65_STA) {
+            ++I;
+            continue;
+        }
+
+        /* The first three insns are clc, a load and an add of the immediate
+        ** value and the low byte in any order.
+        */
+        if (L[0]->OPC == OP65_CLC && L[1]->OPC == OP65_LDA) {
+            Imm = L[1];
+            Lo  = L[2];
+        } else if (L[0]->OPC == OP65_LDA && L[1]->OPC == OP65_CLC) {
+            Imm = L[0];
+            Lo  = L[2];
+        } else {
+            ++I;
+            continue;
+        }
+        if (Imm->AM != AM65_IMM) {
+            CodeEntry* T = Imm;
+            Imm = Lo;
+            Lo  = T;
+        }
+        if (!CE_IsConstImm (Imm) || Imm->Num == 0 || Imm->Num > 0xFF ||
+            !IsMemLoc (Lo) || !SameLoc (Lo, L[3]) || L[3]->AM != Lo->AM) {
+            ++I;
+            continue;
+        }
+
+        /* The high byte gets the carry */
+        if (!((L[4]->OPC == OP65_LDA && CE_IsKnownImm (L[4], 0)) ||
+              (L[4]->OPC == OP65_TYA && L[4]->RI && L[4]->RI->In.RegY == 0) ||
+              (L[4]->OPC == OP65_TXA && L[4]->RI && L[4]->RI->In.RegX == 0)) ||
+            L[5]->AM != Lo->AM                                  ||
+            !SameLoc (L[5], L[6])                               ||
+            L[6]->AM != Lo->AM                                  ||
+            L[5]->ArgDesc->Off != Lo->ArgDesc->Off + 1          ||
+            strcmp (L[5]->ArgDesc->Base, Lo->ArgDesc->Base) != 0) {
+            ++I;
+            continue;
+        }
+
+        /* A and the flags must be unused */
+        if ((GetRegInfo (S, I+7, REG_A | PSTATE_CZVN) & (REG_A | PSTATE_CZVN)) == 0) {
+
+            CodeEntry* X;
+            CodeLabel* Label;
+            unsigned   IP = I;
+
+            if (Imm->Num == 1) {
+                /* inc ptr */
+                X = NewCodeEntry (OP65_INC, Lo->AM, Lo->Arg, 0, L[3]->LI);
+                CS_InsertEntry (S, X, IP++);
+            } else {
+                /* lda ptr */
+                X = NewCodeEntry (OP65_LDA, Lo->AM, Lo->Arg, 0, L[2]->LI);
+                CS_InsertEntry (S, X, IP++);
+
+                /* clc */
+                X = NewCodeEntry (OP65_CLC, AM65_IMP, 0, 0, L[2]->LI);
+                CS_InsertEntry (S, X, IP++);
+
+                /* adc #c */
+                X = NewCodeEntry (OP65_ADC, AM65_IMM, Imm->Arg, 0, L[2]->LI);
+                CS_InsertEntry (S, X, IP++);
+
+                /* sta ptr */
+                X = NewCodeEntry (OP65_STA, Lo->AM, Lo->Arg, 0, L[3]->LI);
+                CS_InsertEntry (S, X, IP++);
+            }
+
+            /* bne/bcc L */
+            Label = CS_GenLabel (S, CS_GetEntry (S, IP + 7));
+            X = NewCodeEntry ((Imm->Num == 1)? OP65_BNE : OP65_BCC, AM65_BRA,
+                              Label->Name, Label, L[5]->LI);
+            CS_InsertEntry (S, X, IP++);
+
+            /* inc ptr+1 */
+            X = NewCodeEntry (OP65_INC, L[6]->AM, L[6]->Arg, 0, L[6]->LI);
+            CS_InsertEntry (S, X, IP++);
+
+            /* Move the labels and remove the old code */
+            CS_MoveLabels (S, L[0], CS_GetEntry (S, I));
+            CS_DelEntries (S, IP, 7);
+
+            /* Remember, we had changes */
+            ++Changes;
+        }
+
+        /* Next entry */
+        ++I;
+
+    }
+
+    /* Return the number of changes made */
+    return Changes;
+}
+
+
+
+unsigned OptIndVar (CodeSeg* S)
+/* Search for loops that use an unsigned char variable in memory as index in
+** the y register. If the y register isn't used otherwise in the loop, keep
+** the variable in y while the loop runs, and store it back when the loop is
+** left.
+*/
+{
+    unsigned Changes = 0;
+
+    /* Walk over the entries */
+    unsigned I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        /* Get next entry */
+        CodeEntry* E = CS_GetEntry (S, I);
+
+        /* Check for a jump back. Inner loops come first, so an outer loop
+        ** isn't changed if its inner loop is.
+        */
+        if ((E->Info & OF_BRA) != 0 && E->JumpTo != 0) {
+
+            unsigned First = CS_GetEntryIndex (S, E->JumpTo->Owner);
+            unsigned J;
+
+            for (J = First; J <= I; ++J) {
+                const CodeEntry* V = CS_GetEntry (S, J);
+                if (V->OPC == OP65_LDY && IsMemLoc (V) &&
+                    PromoteIndex (S, First, I, V)) {
+
+                    /* Continue behind the loop */
+                    I = CS_GetEntryIndex (S, E);
+
+                    /* Remember, we had changes */
+                    ++Changes;
+                    break;
+                }
+            }
+        }
+
+        /* Next entry */
+        ++I;
+
+    }
+
+    /* Return the number of changes made */
+    return Changes;
+}
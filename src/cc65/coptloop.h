@@ -0,0 +1,104 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coptloop.h                                */
+/*                                                                           */
+/*           Optimize array indexing and induction variables in loops        */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef COPTLOOP_H
+#define COPTLOOP_H
+
+
+
+/* cc65 */
+#include "codeseg.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+unsigned OptIndex1 (CodeSeg* S);
+/* Search for the sequence
+**
+**      lda     zp
+**      ldx     zp+1
+**      sta     ptr
+**      stx     ptr+1
+**
+** where ptr is ptr1, ptr2 or sreg, and replace the following accesses
+** through (ptr),y in the same basic block by (zp),y, provided that ptr is
+** not used otherwise. If the loads are the low and high byte of a constant
+** address, the accesses are replaced by absolute indexed ones.
+*/
+
+unsigned OptIndex2 (CodeSeg* S);
+/* Search for the address calculation of an array element with an unsigned
+** char index
+**
+**      lda     #<(addr)        lda     index
+**      ldx     #>(addr)        clc
+**      clc                     adc     zp
+**      adc     index           ldx     zp+1
+**      bcc     L               bcc     L
+**      inx                     inx
+** L:   sta     ptr        L:   sta     ptr
+**      stx     ptr+1           stx     ptr+1
+**
+** and replace the following accesses through (ptr),y with y = 0 in the same
+** basic block by accesses through addr,y or (zp),y with the index in y. The
+** calculation is removed if its result isn't used otherwise.
+*/
+
+unsigned OptPtrInc (CodeSeg* S);
+/* Search for the sequence
+**
+**      lda     #c
+**      clc
+**      adc     ptr
+**      sta     ptr
+**      lda     #$00
+**      adc     ptr+1
+**      sta     ptr+1
+**
+** and replace it by an increment of the pointer in memory, provided that
+** the register and flags are not used later.
+*/
+
+unsigned OptIndVar (CodeSeg* S);
+/* Search for loops that use an unsigned char variable in memory as index in
+** the y register. If the y register isn't used otherwise in the loop, keep
+** the variable in y while the loop runs, and store it back when the loop is
+** left.
+*/
+
+
+
+/* End of coptloop.h */
+
+#endif
@@ -278,102 +278,6 @@ unsigned OptDecouple (CodeSeg* S)
 
 
 
-unsigned OptIndLoads1 (CodeSeg* S)
-/* Change
-**
-**     lda      (zp),y
-**
-** into
-**
-**     lda      (zp,x)
-**
-** provided that x and y are both zero.
-*/
-{
-    unsigned Changes = 0;
-    unsigned I;
-
-    /* Walk over the entries */
-    I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        /* Get next entry */
-        CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check if it's what we're looking for */
-        if (E->OPC == OP65_LDA          &&
-            E->AM == AM65_ZP_INDY       &&
-            E->RI->In.RegY == 0         &&
-            E->RI->In.RegX == 0) {
-
-            /* Replace by the same insn with other addressing mode */
-            CodeEntry* X = NewCodeEntry (E->OPC, AM65_ZPX_IND, E->Arg, 0, E->LI);
-            CS_InsertEntry (S, X, I+1);
-
-            /* Remove the old insn */
-            CS_DelEntry (S, I);
-            ++Changes;
-        }
-
-        /* Next entry */
-        ++I;
-
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
-unsigned OptIndLoads2 (CodeSeg* S)
-/* Change
-**
-**     lda      (zp,x)
-**
-** into
-**
-**     lda      (zp),y
-**
-** provided that x and y are both zero.
-*/
-{
-    unsigned Changes = 0;
-    unsigned I;
-
-    /* Walk over the entries */
-    I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        /* Get next entry */
-        CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check if it's what we're looking for */
-        if (E->OPC == OP65_LDA          &&
-            E->AM == AM65_ZPX_IND       &&
-            E->RI->In.RegY == 0         &&
-            E->RI->In.RegX == 0) {
-
-            /* Replace by the same insn with other addressing mode */
-            CodeEntry* X = NewCodeEntry (E->OPC, AM65_ZP_INDY, E->Arg, 0, E->LI);
-            CS_InsertEntry (S, X, I+1);
-
-            /* Remove the old insn */
-            CS_DelEntry (S, I);
-            ++Changes;
-        }
-
-        /* Next entry */
-        ++I;
-
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
 /*****************************************************************************/
 /*                        Optimize stack pointer ops                         */
 /*****************************************************************************/
@@ -521,7 +425,7 @@ unsigned OptAXLoad (CodeSeg* S)
             E->Arg[6]  == '\0'                            &&
             (N = CS_GetNextEntry (S, I)) != 0             &&
             (N->OPC == OP65_JSR || N->OPC == OP65_JMP)    &&
-            strcmp (N->Arg, "ldaxi") == 0                 &&
+            CE_IsArg (N, ARG_LDAXI)                       &&
             !CE_HasLabel (N)) {
 
             CodeEntry* X;
@@ -557,52 +461,6 @@ unsigned OptAXLoad (CodeSeg* S)
 
 
 
-unsigned OptTosLoadPop (CodeSeg* S)
-/* Merge jsr ldax0sp / jsr|jmp incsp2 into jsr|jmp popax */
-{
-    unsigned Changes = 0;
-    unsigned I;
-
-    /* Walk over the entries */
-    I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        const CodeEntry* N;
-
-        /* Get the next entry */
-        const CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check for the sequence */
-        if (CE_IsCallTo (E, "ldax0sp")                               &&
-            (N = CS_GetNextEntry (S, I)) != 0                        &&
-            (CE_IsCallTo (N, "incsp2") || CE_IsJumpTo (N, "incsp2")) &&
-            !CE_HasLabel (N)) {
-
-            CodeEntry* X;
-
-            X = NewCodeEntry (N->OPC, AM65_ABS, "popax", 0, N->LI);
-            CS_InsertEntry (S, X, I+2);
-
-            /* Delete the old code */
-            CS_DelEntries (S, I, 2);
-
-            /* Remember we had changes */
-            ++Changes;
-
-        } else {
-
-            /* Next entry */
-            ++I;
-        }
-
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
 unsigned OptAXLoad2 (CodeSeg* S)
 /* Merge ldy/jsr incaxy/jsr ldaxi into ldy/jsr ldaxidx */
 {
@@ -625,9 +483,9 @@ unsigned OptAXLoad2 (CodeSeg* S)
             CE_IsConstImm (E[0])                             &&
             CS_GetEntries (S, E+1, I+1, 2)                   &&
             E[1]->OPC == OP65_JSR                            &&
-            strcmp (E[1]->Arg, "incaxy") == 0                &&
+            CE_IsArg (E[1], ARG_INCAXY)                      &&
             (E[2]->OPC == OP65_JSR || E[2]->OPC == OP65_JMP) &&
-            strcmp (E[2]->Arg, "ldaxi") == 0                 &&
+            CE_IsArg (E[2], ARG_LDAXI)                       &&
             !CS_RangeHasLabel (S, I, 3)) {
 
             /* Replace with ldy (y+1) / jsr ldaxidx */
@@ -684,9 +542,9 @@ unsigned OptGotoSPAdj (CodeSeg* S)
             L[1]->AM == AM65_ABS             &&
             L[2]->OPC == OP65_CLC            &&
             L[3]->OPC == OP65_ADC            &&
-            strcmp (L[3]->Arg, "c_sp") == 0    &&
+            CE_IsArg (L[3], ARG_C_SP)          &&
             L[6]->OPC == OP65_ADC            &&
-            strcmp (L[6]->Arg, "c_sp+1") == 0  &&
+            CE_IsArg (L[6], ARG_C_SP_1)        &&
             L[9]->OPC == OP65_JMP) {
             adjustment = FindSPAdjustment (L[1]->Arg);
 
@@ -779,52 +637,6 @@ unsigned OptGotoSPAdj (CodeSeg* S)
 
 
 
-unsigned OptLoadStore2 (CodeSeg* S)
-/* Remove 16 bit stack loads followed by a store into the same location. */
-{
-    unsigned Changes = 0;
-
-    /* Walk over the entries */
-    unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
-
-        CodeEntry* N;
-
-        /* Get next entry */
-        CodeEntry* E = CS_GetEntry (S, I);
-
-        /* Check if this is a 16 bit load followed by a store into the same
-        ** address.
-        */
-        if (CE_IsCallTo (E, "ldaxysp")          &&  /* Stack load ... */
-            RegValIsKnown (E->RI->In.RegY)      &&  /* ... with known offs */
-            (N = CS_GetNextEntry (S, I)) != 0   &&  /* Next insn ... */
-            !CE_HasLabel (N)                    &&  /* ... without label ... */
-            N->OPC == OP65_LDY                  &&  /* ... is LDY */
-            CE_IsKnownImm (N, E->RI->In.RegY-1) &&  /* Same offset as load */
-            (N = CS_GetNextEntry (S, I+1)) != 0 &&  /* Next insn ... */
-            !CE_HasLabel (N)                    &&  /* ... without label ... */
-            CE_IsCallTo (N, "staxysp")) {           /* ... is store */
-
-            /* Found - remove it. Leave the load in place. If it's unused, it
-            ** will get removed by later steps.
-            */
-            CS_DelEntries (S, I+1, 2);
-
-            /* Remember, we had changes */
-            ++Changes;
-        }
-
-        /* Next entry */
-        ++I;
-    }
-
-    /* Return the number of changes made */
-    return Changes;
-}
-
-
-
 unsigned OptLoad1 (CodeSeg* S)
 /* Search for a call to ldaxysp where X is not used later and replace it by
 ** a load of just the A register.
@@ -843,7 +655,7 @@ unsigned OptLoad1 (CodeSeg* S)
         E = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (E, "ldaxysp")          &&
+        if (CE_IsCallTo (E, ARG_LDAXYSP)        &&
             RegValIsKnown (E->RI->In.RegY)      &&
             !RegXUsed (S, I+1)) {
 
@@ -893,7 +705,7 @@ unsigned OptLoad2 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "ldaxysp")) {
+        if (CE_IsCallTo (L[0], ARG_LDAXYSP)) {
 
             CodeEntry* X;
 
@@ -1214,9 +1026,9 @@ unsigned OptTosPushPop (CodeSeg* S)
         const CodeEntry* E = CS_GetEntry (S, I);
 
         /* Check for decspn, incspn, subysp or addysp */
-        if (CE_IsCallTo (E, "pushax")                              &&
+        if (CE_IsCallTo (E, ARG_PUSHAX)                            &&
             (N = CS_GetNextEntry (S, I)) != 0                      &&
-            (CE_IsCallTo (N, "popax") || CE_IsJumpTo (N, "popax")) &&
+            (CE_IsCallTo (N, ARG_POPAX) || CE_IsJumpTo (N, ARG_POPAX)) &&
             !CE_HasLabel (N)) {
 
             /* Insert an rts if jmp popax */
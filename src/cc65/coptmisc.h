@@ -67,30 +67,6 @@ unsigned OptDecouple (CodeSeg* S);
 ** Provided that the register values are known of course.
 */
 
-unsigned OptIndLoads1 (CodeSeg* S);
-/* Change
-**
-**     lda      (zp),y
-**
-** into
-**
-**     lda      (zp,x)
-**
-** provided that x and y are both zero.
-*/
-
-unsigned OptIndLoads2 (CodeSeg* S);
-/* Change
-**
-**     lda      (zp,x)
-**
-** into
-**
-**     lda      (zp),y
-**
-** provided that x and y are both zero.
-*/
-
 unsigned OptStackPtrOps (CodeSeg* S);
 /* Merge adjacent calls to decsp/incax into one. NOTE: This function won't merge all
 ** known cases!
@@ -110,9 +86,6 @@ unsigned OptAXLoad2 (CodeSeg* S);
 unsigned OptGotoSPAdj (CodeSeg* S);
 /* Optimize SP adjustment for forward 'goto' */
 
-unsigned OptLoadStore2 (CodeSeg* S);
-/* Remove 16 bit stack loads followed by a store into the same location. */
-
 unsigned OptLoad1 (CodeSeg* S);
 /* Search for a call to ldaxysp where X is not used later and replace it by
 ** a load of just the A register.
@@ -131,9 +104,6 @@ unsigned OptBinOps2 (CodeSeg* S);
 ** by something simpler.
 */
 
-unsigned OptTosLoadPop (CodeSeg* S);
-/* Merge jsr ldax0sp / jsr|jmp incsp2 into jsr|jmp popax */
-
 unsigned OptTosPushPop (CodeSeg* S);
 /* Merge jsr pushax/j?? popax */
 
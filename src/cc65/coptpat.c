@@ -0,0 +1,691 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coptpat.c                                 */
+/*                                                                           */
+/*                       Table driven peephole patterns                      */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+/* common */
+#include "attrib.h"
+#include "check.h"
+#include "coll.h"
+#include "xmalloc.h"
+
+/* cc65 */
+#include "codeent.h"
+#include "codeinfo.h"
+#include "coptpat.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* A pattern is a sequence of instructions together with the instructions
+** that replace them. All pattern tables are compiled in. An optimizer step
+** applies all patterns of its table in one pass over the code. At a given
+** position, only the patterns whose first instruction may match are tried:
+** Patterns starting with a call or jump to a named routine are found by the
+** name of the routine, all others by the opcode of their first instruction.
+*/
+
+/* Maximum number of instructions matched and inserted by a pattern */
+#define PAT_MAX_INSNS   4
+#define PAT_MAX_REPL    2
+
+/* Flags for the instructions to match */
+#define PI_NONE         0x00U
+#define PI_NOLABEL      0x01U   /* Insn must not have a label */
+#define PI_SAMEARG      0x02U   /* Same AM and argument as insn Ref */
+#define PI_NOFLAGUSE    0x04U   /* Insn must not use the flags of a load */
+#define PI_DELETE       0x08U   /* Delete the insn if the pattern matches */
+
+/* Flags for the instructions to insert */
+#define PR_NONE         0x00U
+#define PR_OPC          0x01U   /* Use the opcode of insn Ref */
+#define PR_ARG          0x02U   /* Use the argument of insn Ref */
+
+/* Bit for an addressing mode in PatInsn.AMs */
+#define PAT_AM(AM)      (1U << (AM))
+
+/* One instruction to match */
+typedef struct PatInsn PatInsn;
+struct PatInsn {
+    opc_t           OPC;        /* Opcode, OP65_INVALID matches any insn */
+    opc_t           AltOPC;     /* Alternative opcode or OP65_INVALID */
+    unsigned        AMs;        /* Set of addressing modes, zero for any */
+    argid_t         Arg;        /* Argument, ARG_EMPTY matches any argument */
+    unsigned        Flags;      /* PI_xxx */
+    unsigned        Ref;        /* Index of the insn compared by PI_SAMEARG */
+};
+
+/* One instruction to insert. Line info is taken from insn Ref. Branches and
+** jumps to labels cannot be inserted this way.
+*/
+typedef struct PatRepl PatRepl;
+struct PatRepl {
+    opc_t           OPC;        /* Opcode unless PR_OPC is given */
+    am_t            AM;         /* Addressing mode */
+    const char*     Arg;        /* Argument unless PR_ARG is given */
+    unsigned        Flags;      /* PR_xxx */
+    unsigned        Ref;        /* Index of the insn referenced */
+};
+
+/* A pattern. If it matches, the insns of Repl are inserted behind the matched
+** insns, then all matched insns with PI_DELETE are removed.
+*/
+typedef struct OptPattern OptPattern;
+struct OptPattern {
+    unsigned        Count;                  /* Number of insns to match */
+    PatInsn         Insns[PAT_MAX_INSNS];   /* Insns to match */
+    unsigned        ReplCount;              /* Number of insns to insert */
+    PatRepl         Repl[PAT_MAX_REPL];     /* Insns to insert */
+
+    /* Additional check called for a sequence that matches Insns, or NULL */
+    int             (*Check) (CodeSeg* S, unsigned I, CodeEntry* const* L);
+};
+
+/* Index of a pattern table */
+typedef struct PatIndex PatIndex;
+struct PatIndex {
+    unsigned        Start[OP65_COUNT];  /* AMs that may start a pattern */
+    Collection      Calls;              /* By called routine, sorted */
+    Collection      ByOPC[OP65_COUNT];  /* All others by opcode */
+};
+
+/* A table of patterns that make up one optimizer step */
+typedef struct PatSet PatSet;
+struct PatSet {
+    const OptPattern*   Patterns;       /* The table */
+    unsigned            Count;          /* Number of patterns in the table */
+    PatIndex*           Index;          /* Index built by InitOptPatterns */
+};
+
+/* Define a set for a pattern table */
+#define PAT_SET(Table)  { Table, sizeof (Table) / sizeof (Table[0]), 0 }
+
+/* Shortcuts for the tables: Any insn, and a placeholder for no insertion */
+#define PI_ANY          { OP65_INVALID, OP65_INVALID, 0, ARG_EMPTY, PI_NONE, 0 }
+#define PR_UNUSED       { OP65_INVALID, AM65_IMP, 0, PR_NONE, 0 }
+
+
+
+/*****************************************************************************/
+/*                              Pattern checks                               */
+/*****************************************************************************/
+
+
+
+static int CheckIndLoads (CodeSeg* S attribute ((unused)),
+                          unsigned I attribute ((unused)),
+                          CodeEntry* const* L)
+/* Check that X and Y are both zero */
+{
+    return L[0]->RI->In.RegY == 0 && L[0]->RI->In.RegX == 0;
+}
+
+
+
+static int CheckLoadStore2 (CodeSeg* S attribute ((unused)),
+                            unsigned I attribute ((unused)),
+                            CodeEntry* const* L)
+/* Check that the stack load and store use the same offset */
+{
+    return RegValIsKnown (L[0]->RI->In.RegY) &&
+           CE_IsKnownImm (L[1], L[0]->RI->In.RegY-1);
+}
+
+
+
+static int CheckLoadStoreLoad (CodeSeg* S, unsigned I, CodeEntry* const* L)
+/* Check for a register store, and no labels behind the first load */
+{
+    return (L[1]->OPC == OP65_STA ||
+            L[1]->OPC == OP65_STX ||
+            L[1]->OPC == OP65_STY)                      &&
+           !CS_RangeHasLabel (S, I+1, 3);
+}
+
+
+
+/*****************************************************************************/
+/*                              Pattern tables                               */
+/*****************************************************************************/
+
+
+
+/* lda (zp),y -> lda (zp,x) if x and y are both zero */
+static const OptPattern IndLoads1Patterns[] = {
+    {
+        1, {
+            { OP65_LDA, OP65_INVALID, PAT_AM (AM65_ZP_INDY), 0, PI_DELETE, 0 },
+        },
+        1, {
+            { OP65_INVALID, AM65_ZPX_IND, 0, PR_OPC | PR_ARG, 0 },
+        },
+        CheckIndLoads
+    },
+};
+
+/* lda (zp,x) -> lda (zp),y if x and y are both zero */
+static const OptPattern IndLoads2Patterns[] = {
+    {
+        1, {
+            { OP65_LDA, OP65_INVALID, PAT_AM (AM65_ZPX_IND), 0, PI_DELETE, 0 },
+        },
+        1, {
+            { OP65_INVALID, AM65_ZP_INDY, 0, PR_OPC | PR_ARG, 0 },
+        },
+        CheckIndLoads
+    },
+};
+
+/* ld? xx / st? xx -> ld? xx */
+static const OptPattern LoadStore1Patterns[] = {
+    {
+        2, {
+            { OP65_LDA, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_STA, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+    {
+        2, {
+            { OP65_LDX, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_STX, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+    {
+        2, {
+            { OP65_LDY, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_STY, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+};
+
+/* jsr ldaxysp / ldy #yy-1 / jsr staxysp -> jsr ldaxysp */
+static const OptPattern LoadStore2Patterns[] = {
+    {
+        3, {
+            { OP65_JSR, OP65_INVALID, 0, ARG_LDAXYSP, PI_NONE, 0 },
+            { OP65_LDY, OP65_INVALID, 0, 0, PI_NOLABEL | PI_DELETE, 0 },
+            { OP65_JSR, OP65_INVALID, 0, ARG_STAXYSP, PI_NOLABEL | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, CheckLoadStore2
+    },
+};
+
+/* ld? xx / st? yy / ld? xx -> ld? xx / st? yy */
+static const OptPattern LoadStoreLoadPatterns[] = {
+    {
+        3, {
+            { OP65_LDA, OP65_INVALID, PAT_AM (AM65_ABS) | PAT_AM (AM65_ZP), 0, PI_NONE, 0 },
+            PI_ANY,
+            { OP65_LDA, OP65_INVALID, 0, 0, PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, CheckLoadStoreLoad
+    },
+    {
+        3, {
+            { OP65_LDX, OP65_INVALID, PAT_AM (AM65_ABS) | PAT_AM (AM65_ZP), 0, PI_NONE, 0 },
+            PI_ANY,
+            { OP65_LDX, OP65_INVALID, 0, 0, PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, CheckLoadStoreLoad
+    },
+    {
+        3, {
+            { OP65_LDY, OP65_INVALID, PAT_AM (AM65_ABS) | PAT_AM (AM65_ZP), 0, PI_NONE, 0 },
+            PI_ANY,
+            { OP65_LDY, OP65_INVALID, 0, 0, PI_SAMEARG | PI_DELETE, 0 },
+        },
+        0, { PR_UNUSED }, CheckLoadStoreLoad
+    },
+};
+
+/* st? xx / ld? xx -> st? xx if the flags of the load are not used */
+static const OptPattern StoreLoadPatterns[] = {
+    {
+        3, {
+            { OP65_STA, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_LDA, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+            { OP65_INVALID, OP65_INVALID, 0, 0, PI_NOFLAGUSE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+    {
+        3, {
+            { OP65_STX, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_LDX, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+            { OP65_INVALID, OP65_INVALID, 0, 0, PI_NOFLAGUSE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+    {
+        3, {
+            { OP65_STY, OP65_INVALID, 0, 0, PI_NONE, 0 },
+            { OP65_LDY, OP65_INVALID, 0, 0, PI_NOLABEL | PI_SAMEARG | PI_DELETE, 0 },
+            { OP65_INVALID, OP65_INVALID, 0, 0, PI_NOFLAGUSE, 0 },
+        },
+        0, { PR_UNUSED }, 0
+    },
+};
+
+/* jsr ldax0sp / jsr|jmp incsp2 -> jsr|jmp popax */
+static const OptPattern TosLoadPopPatterns[] = {
+    {
+        2, {
+            { OP65_JSR, OP65_INVALID, 0, ARG_LDAX0SP, PI_DELETE, 0 },
+            { OP65_JSR, OP65_JMP, 0, ARG_INCSP2, PI_NOLABEL | PI_DELETE, 0 },
+        },
+        1, {
+            { OP65_INVALID, AM65_ABS, "popax", PR_OPC, 1 },
+        },
+        0
+    },
+};
+
+/* The sets, one per optimizer step */
+static PatSet IndLoads1     = PAT_SET (IndLoads1Patterns);
+static PatSet IndLoads2     = PAT_SET (IndLoads2Patterns);
+static PatSet LoadStore1    = PAT_SET (LoadStore1Patterns);
+static PatSet LoadStore2    = PAT_SET (LoadStore2Patterns);
+static PatSet LoadStoreLoad = PAT_SET (LoadStoreLoadPatterns);
+static PatSet StoreLoad     = PAT_SET (StoreLoadPatterns);
+static PatSet TosLoadPop    = PAT_SET (TosLoadPopPatterns);
+
+/* List of all sets */
+static PatSet* PatSets[] = {
+    &IndLoads1,
+    &IndLoads2,
+    &LoadStore1,
+    &LoadStore2,
+    &LoadStoreLoad,
+    &StoreLoad,
+    &TosLoadPop,
+};
+#define PATSET_COUNT    (sizeof (PatSets) / sizeof (PatSets[0]))
+
+
+
+/*****************************************************************************/
+/*                              Helper functions                             */
+/*****************************************************************************/
+
+
+
+static int IsCallPattern (const OptPattern* P)
+/* Return true if the pattern starts with a call or jump to a named routine */
+{
+    return (P->Insns[0].OPC == OP65_JSR || P->Insns[0].OPC == OP65_JMP) &&
+           P->Insns[0].Arg != ARG_EMPTY;
+}
+
+
+
+static int CmpCallPatterns (void* Data attribute ((unused)),
+                            const void* Left, const void* Right)
+/* Compare function for sorting the patterns by called routine */
+{
+    const OptPattern* L = Left;
+    const OptPattern* R = Right;
+    int Res = (int) L->Insns[0].Arg - (int) R->Insns[0].Arg;
+    if (Res == 0) {
+        /* Keep the order of the table */
+        Res = (L < R)? -1 : (L > R);
+    }
+    return Res;
+}
+
+
+
+static PatIndex* BuildIndex (const PatSet* Set)
+/* Build the index for a set of patterns */
+{
+    unsigned I, J;
+
+    /* Create an empty index */
+    PatIndex* Index = xmalloc (sizeof (PatIndex));
+    memset (Index->Start, 0, sizeof (Index->Start));
+    InitCollection (&Index->Calls);
+    for (J = 0; J < OP65_COUNT; ++J) {
+        InitCollection (&Index->ByOPC[J]);
+    }
+
+    /* Add the patterns */
+    for (I = 0; I < Set->Count; ++I) {
+        const OptPattern* P = Set->Patterns + I;
+        const PatInsn* First = P->Insns;
+        unsigned AMs = First->AMs? First->AMs : ~0U;
+        CHECK (P->Count > 0 && P->Count <= PAT_MAX_INSNS);
+        CHECK (P->ReplCount <= PAT_MAX_REPL);
+        if (First->OPC == OP65_INVALID) {
+            for (J = 0; J < OP65_COUNT; ++J) {
+                CollAppend (&Index->ByOPC[J], (void*) P);
+                Index->Start[J] |= AMs;
+            }
+        } else {
+            if (IsCallPattern (P)) {
+                CollAppend (&Index->Calls, (void*) P);
+            } else {
+                CollAppend (&Index->ByOPC[First->OPC], (void*) P);
+                if (First->AltOPC != OP65_INVALID) {
+                    CollAppend (&Index->ByOPC[First->AltOPC], (void*) P);
+                }
+            }
+            Index->Start[First->OPC] |= AMs;
+            if (First->AltOPC != OP65_INVALID) {
+                Index->Start[First->AltOPC] |= AMs;
+            }
+        }
+    }
+    CollSort (&Index->Calls, CmpCallPatterns, 0);
+
+    /* Return the new index */
+    return Index;
+}
+
+
+
+static int MatchInsn (const PatInsn* P, CodeEntry* E, CodeEntry* const* L)
+/* Check if E matches the pattern insn P except for the opcode. L contains the
+** insns matched so far.
+*/
+{
+    if (P->AMs != 0 && (P->AMs & PAT_AM (E->AM)) == 0) {
+        return 0;
+    }
+    if (P->Arg != ARG_EMPTY && !CE_IsArg (E, P->Arg)) {
+        return 0;
+    }
+    if ((P->Flags & PI_NOLABEL) != 0 && CE_HasLabel (E)) {
+        return 0;
+    }
+    if ((P->Flags & PI_SAMEARG) != 0 &&
+        (E->AM != L[P->Ref]->AM || E->ArgDesc != L[P->Ref]->ArgDesc)) {
+        return 0;
+    }
+    if ((P->Flags & PI_NOFLAGUSE) != 0 && CE_UseLoadFlags (E)) {
+        return 0;
+    }
+    return 1;
+}
+
+
+
+static int MatchPattern (CodeSeg* S, unsigned I, const OptPattern* P, CodeEntry** L)
+/* Check if the code at index I matches the pattern. On success, the matched
+** insns are returned in L.
+*/
+{
+    unsigned J;
+
+    /* The pattern must fit into the code */
+    if (I + P->Count > CS_GetEntryCount (S)) {
+        return 0;
+    }
+
+    /* Check the insns. Most candidates fail because of the opcode, so
+    ** check this first.
+    */
+    for (J = 0; J < P->Count; ++J) {
+        const PatInsn* PI = P->Insns + J;
+        CodeEntry* E = CollAtUnchecked (&S->Entries, I + J);
+        if (PI->OPC != OP65_INVALID && E->OPC != PI->OPC && E->OPC != PI->AltOPC) {
+            return 0;
+        }
+        L[J] = E;
+        if (!MatchInsn (PI, E, L)) {
+            return 0;
+        }
+    }
+
+    /* Do additional checks */
+    return P->Check == 0 || P->Check (S, I, L);
+}
+
+
+
+static void ApplyPattern (CodeSeg* S, unsigned I, const OptPattern* P, CodeEntry* const* L)
+/* Replace the matched code at index I */
+{
+    unsigned J;
+
+    /* Insert the new insns behind the matched ones */
+    for (J = 0; J < P->ReplCount; ++J) {
+        const PatRepl* R = P->Repl + J;
+        const CodeEntry* E = L[R->Ref];
+        CodeEntry* X = NewCodeEntry ((R->Flags & PR_OPC)? E->OPC : R->OPC,
+                                     R->AM,
+                                     (R->Flags & PR_ARG)? E->Arg : R->Arg,
+                                     0,
+                                     E->LI);
+        CS_InsertEntry (S, X, I + P->Count + J);
+    }
+
+    /* Delete old insns. Start from the rear, so labels move forward. */
+    J = P->Count;
+    while (J--) {
+        if (P->Insns[J].Flags & PI_DELETE) {
+            CS_DelEntry (S, I + J);
+        }
+    }
+}
+
+
+
+static const OptPattern* FindPattern (CodeSeg* S, unsigned I, CodeEntry* E,
+                                      const PatIndex* Index, CodeEntry** L)
+/* Find the first pattern that matches the code at index I. E is the entry
+** at this index.
+*/
+{
+    const Collection* List;
+    unsigned J;
+
+    /* Try the patterns for a called routine */
+    if ((E->OPC == OP65_JSR || E->OPC == OP65_JMP) && CollCount (&Index->Calls) > 0) {
+
+        /* Binary search for the first pattern for this routine */
+        unsigned Id = E->ArgDesc->Id;
+        unsigned Lo = 0;
+        unsigned Hi = CollCount (&Index->Calls);
+        while (Lo < Hi) {
+            unsigned Mid = (Lo + Hi) / 2;
+            const OptPattern* P = CollAtUnchecked (&Index->Calls, Mid);
+            if ((unsigned) P->Insns[0].Arg < Id) {
+                Lo = Mid + 1;
+            } else {
+                Hi = Mid;
+            }
+        }
+
+        /* Try all patterns for the routine */
+        for (J = Lo; J < CollCount (&Index->Calls); ++J) {
+            const OptPattern* P = CollAtUnchecked (&Index->Calls, J);
+            if ((unsigned) P->Insns[0].Arg != Id) {
+                break;
+            }
+            if (MatchPattern (S, I, P, L)) {
+                return P;
+            }
+        }
+    }
+
+    /* Try the patterns for the opcode */
+    List = &Index->ByOPC[E->OPC];
+    for (J = 0; J < CollCount (List); ++J) {
+        const OptPattern* P = CollAtUnchecked (List, J);
+        if (MatchPattern (S, I, P, L)) {
+            return P;
+        }
+    }
+
+    /* Nothing found */
+    return 0;
+}
+
+
+
+static unsigned RunPatterns (CodeSeg* S, const PatSet* Set)
+/* Apply the patterns of a set in one pass over the code */
+{
+    unsigned Changes = 0;
+    const PatIndex* Index = Set->Index;
+
+    /* Walk over the entries */
+    unsigned I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        CodeEntry* L[PAT_MAX_INSNS];
+        const OptPattern* P;
+
+        /* Get next entry */
+        CodeEntry* E = CS_GetEntry (S, I);
+
+        /* Check for a pattern starting here. Opcode and addressing mode
+        ** rule out most insns, so check them first.
+        */
+        if ((Index->Start[E->OPC] & PAT_AM (E->AM)) != 0   &&
+            (P = FindPattern (S, I, E, Index, L)) != 0) {
+
+            /* Replace the code */
+            ApplyPattern (S, I, P, L);
+
+            /* Remember, we had changes */
+            ++Changes;
+        }
+
+        /* Next entry */
+        ++I;
+
+    }
+
+    /* Return the number of changes made */
+    return Changes;
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void InitOptPatterns (void)
+/* Build the indices of the pattern tables. Must be called before any of the
+** steps below is run, and before the optimizer starts any threads.
+*/
+{
+    unsigned I;
+    for (I = 0; I < PATSET_COUNT; ++I) {
+        if (PatSets[I]->Index == 0) {
+            PatSets[I]->Index = BuildIndex (PatSets[I]);
+        }
+    }
+}
+
+
+
+unsigned OptIndLoads1 (CodeSeg* S)
+/* Change
+**
+**     lda      (zp),y
+**
+** into
+**
+**     lda      (zp,x)
+**
+** provided that x and y are both zero.
+*/
+{
+    return RunPatterns (S, &IndLoads1);
+}
+
+
+
+unsigned OptIndLoads2 (CodeSeg* S)
+/* Change
+**
+**     lda      (zp,x)
+**
+** into
+**
+**     lda      (zp),y
+**
+** provided that x and y are both zero.
+*/
+{
+    return RunPatterns (S, &IndLoads2);
+}
+
+
+
+unsigned OptLoadStore1 (CodeSeg* S)
+/* Remove an 8 bit load followed by a store into the same location. */
+{
+    return RunPatterns (S, &LoadStore1);
+}
+
+
+
+unsigned OptLoadStore2 (CodeSeg* S)
+/* Remove 16 bit stack loads followed by a store into the same location. */
+{
+    return RunPatterns (S, &LoadStore2);
+}
+
+
+
+unsigned OptLoadStoreLoad (CodeSeg* S)
+/* Remove a load, store followed by a reload of the same location. */
+{
+    return RunPatterns (S, &LoadStoreLoad);
+}
+
+
+
+unsigned OptStoreLoad (CodeSeg* S)
+/* Remove a store followed by a load from the same location. */
+{
+    return RunPatterns (S, &StoreLoad);
+}
+
+
+
+unsigned OptTosLoadPop (CodeSeg* S)
+/* Merge jsr ldax0sp / jsr|jmp incsp2 into jsr|jmp popax */
+{
+    return RunPatterns (S, &TosLoadPop);
+}
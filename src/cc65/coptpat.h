@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coptpat.h                                 */
+/*                                                                           */
+/*                       Table driven peephole patterns                      */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef COPTPAT_H
+#define COPTPAT_H
+
+
+
+/* cc65 */
+#include "codeseg.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void InitOptPatterns (void);
+/* Build the indices of the pattern tables. Must be called before any of the
+** steps below is run, and before the optimizer starts any threads.
+*/
+
+unsigned OptIndLoads1 (CodeSeg* S);
+/* Change
+**
+**     lda      (zp),y
+**
+** into
+**
+**     lda      (zp,x)
+**
+** provided that x and y are both zero.
+*/
+
+unsigned OptIndLoads2 (CodeSeg* S);
+/* Change
+**
+**     lda      (zp,x)
+**
+** into
+**
+**     lda      (zp),y
+**
+** provided that x and y are both zero.
+*/
+
+unsigned OptLoadStore1 (CodeSeg* S);
+/* Remove an 8 bit load followed by a store into the same location. */
+
+unsigned OptLoadStore2 (CodeSeg* S);
+/* Remove 16 bit stack loads followed by a store into the same location. */
+
+unsigned OptLoadStoreLoad (CodeSeg* S);
+/* Remove a load, store followed by a reload of the same location. */
+
+unsigned OptStoreLoad (CodeSeg* S);
+/* Remove a store followed by a load from the same location. */
+
+unsigned OptTosLoadPop (CodeSeg* S);
+/* Merge jsr ldax0sp / jsr|jmp incsp2 into jsr|jmp popax */
+
+
+
+/* End of coptpat.h */
+
+#endif
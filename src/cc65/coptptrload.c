@@ -101,7 +101,7 @@ unsigned OptPtrLoad1 (CodeSeg* S)
             L[6]->OPC == OP65_TYA               &&
             L[7]->OPC == OP65_LDY               &&
             CE_IsKnownImm (L[7], 0)             &&
-            CE_IsCallTo (L[8], "ldauidx")       &&
+            CE_IsCallTo (L[8], ARG_LDAUIDX)     &&
             !CS_RangeHasLabel (S, I+1, 8)) {
 
             CodeEntry* X;
@@ -217,7 +217,7 @@ unsigned OptPtrLoad2 (CodeSeg* S)
             L[5]->OPC == OP65_TAX               &&
             L[6]->OPC == OP65_PLA               &&
             L[7]->OPC == OP65_LDY               &&
-            CE_IsCallTo (L[8], "ldauidx")       &&
+            CE_IsCallTo (L[8], ARG_LDAUIDX)     &&
             !CS_RangeHasLabel (S, I+1, 8)) {
 
             CodeEntry* X;
@@ -304,7 +304,7 @@ unsigned OptPtrLoad3 (CodeSeg* S)
             L[5]->OPC == OP65_INX                            &&
             L[6]->OPC == OP65_LDY                            &&
             CE_IsKnownImm (L[6], 0)                          &&
-            CE_IsCallTo (L[7], "ldauidx")                    &&
+            CE_IsCallTo (L[7], ARG_LDAUIDX)                  &&
             !CS_RangeHasLabel (S, I+1, 5)                    &&
             !CE_HasLabel (L[7])                              &&
             /* Check the label last because this is quite costly */
@@ -409,7 +409,7 @@ unsigned OptPtrLoad4 (CodeSeg* S)
             !CE_HasLabel (L[6])                              &&
             L[7]->OPC == OP65_LDY                            &&
             CE_IsKnownImm (L[7], 0)                          &&
-            CE_IsCallTo (L[8], "ldauidx")                    &&
+            CE_IsCallTo (L[8], ARG_LDAUIDX)                  &&
             !CE_HasLabel (L[8])                              &&
             /* Check the label last because this is quite costly */
             (Len = strlen (L[0]->Arg)) > 3                   &&
@@ -492,7 +492,7 @@ unsigned OptPtrLoad5 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "pushax")                &&
+        if (CE_IsCallTo (L[0], ARG_PUSHAX)              &&
             CS_GetEntries (S, L+1, I+1, 5)              &&
             L[1]->OPC == OP65_LDX                       &&
             CE_IsKnownImm (L[1], 0)                     &&
@@ -500,10 +500,10 @@ unsigned OptPtrLoad5 (CodeSeg* S)
             (L[2]->AM == AM65_ABS       ||
              L[2]->AM == AM65_ZP        ||
              L[2]->AM == AM65_IMM)                      &&
-            CE_IsCallTo (L[3], "tosaddax")              &&
+            CE_IsCallTo (L[3], ARG_TOSADDAX)            &&
             L[4]->OPC == OP65_LDY                       &&
             CE_IsKnownImm (L[4], 0)                     &&
-            CE_IsCallTo (L[5], "ldauidx")               &&
+            CE_IsCallTo (L[5], ARG_LDAUIDX)             &&
             !CS_RangeHasLabel (S, I+1, 5)) {
 
             CodeEntry* X;
@@ -581,7 +581,7 @@ unsigned OptPtrLoad6 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "pushax")                &&
+        if (CE_IsCallTo (L[0], ARG_PUSHAX)              &&
             CS_GetEntries (S, L+1, I+1, 6)              &&
             L[1]->OPC == OP65_LDY                       &&
             CE_IsConstImm (L[1])                        &&
@@ -590,10 +590,10 @@ unsigned OptPtrLoad6 (CodeSeg* S)
             CE_IsKnownImm (L[2], 0)                     &&
             L[3]->OPC == OP65_LDA                       &&
             L[3]->AM == AM65_ZP_INDY                    &&
-            CE_IsCallTo (L[4], "tosaddax")              &&
+            CE_IsCallTo (L[4], ARG_TOSADDAX)            &&
             L[5]->OPC == OP65_LDY                       &&
             CE_IsKnownImm (L[5], 0)                     &&
-            CE_IsCallTo (L[6], "ldauidx")               &&
+            CE_IsCallTo (L[6], ARG_LDAUIDX)             &&
             !CS_RangeHasLabel (S, I+1, 6)               &&
             !RegYUsed (S, I+7)) {
 
@@ -694,8 +694,8 @@ unsigned OptPtrLoad7 (CodeSeg* S)
 
         /* Check for the sequence */
         if (L[0]->OPC == OP65_JSR                               &&
-            (strcmp (L[0]->Arg, "aslax1") == 0          ||
-             strcmp (L[0]->Arg, "shlax1") == 0)                 &&
+            (CE_IsArg (L[0], ARG_ASLAX1)                ||
+             CE_IsArg (L[0], ARG_SHLAX1))                       &&
             CS_GetEntries (S, L+1, I+1, 9)                      &&
             L[1]->OPC == OP65_CLC                               &&
             L[2]->OPC == OP65_ADC                               &&
@@ -705,7 +705,7 @@ unsigned OptPtrLoad7 (CodeSeg* S)
             L[6]->OPC == OP65_TAX                               &&
             L[7]->OPC == OP65_TYA                               &&
             L[8]->OPC == OP65_LDY                               &&
-            CE_IsCallTo (L[9], "ldaxidx")                       &&
+            CE_IsCallTo (L[9], ARG_LDAXIDX)                     &&
             !CS_RangeHasLabel (S, I+1, 9)) {
 
             CodeEntry* X;
@@ -877,7 +877,7 @@ unsigned OptPtrLoad11 (CodeSeg* S)
             L[3]->OPC == OP65_INX                            &&
             L[4]->OPC == OP65_LDY                            &&
             CE_IsKnownImm (L[4], 0)                          &&
-            CE_IsCallTo (L[5], "ldauidx")                    &&
+            CE_IsCallTo (L[5], ARG_LDAUIDX)                  &&
             !CS_RangeHasLabel (S, I+1, 3)                    &&
             !CE_HasLabel (L[5])) {
 
@@ -981,10 +981,10 @@ unsigned OptPtrLoad12 (CodeSeg* S)
             strcmp (L[1]->Arg+Len, "+1") == 0                   &&
             L[2]->OPC == OP65_STA                               &&
             L[2]->AM == AM65_ZP                                 &&
-            strcmp (L[2]->Arg, "regsave") == 0                  &&
+            CE_IsArg (L[2], ARG_REGSAVE)                        &&
             L[3]->OPC == OP65_STX                               &&
             L[3]->AM == AM65_ZP                                 &&
-            strcmp (L[3]->Arg, "regsave+1") == 0                &&
+            CE_IsArg (L[3], ARG_REGSAVE_1)                      &&
             L[4]->OPC == OP65_CLC                               &&
             L[5]->OPC == OP65_ADC                               &&
             CE_IsKnownImm (L[5], 1)                             &&
@@ -1000,13 +1000,13 @@ unsigned OptPtrLoad12 (CodeSeg* S)
             strcmp (L[9]->Arg, L[1]->Arg) == 0                  &&
             L[10]->OPC == OP65_LDA                              &&
             L[10]->AM == AM65_ZP                                &&
-            strcmp (L[10]->Arg, "regsave") == 0                 &&
+            CE_IsArg (L[10], ARG_REGSAVE)                       &&
             L[11]->OPC == OP65_LDX                              &&
             L[11]->AM == AM65_ZP                                &&
-            strcmp (L[11]->Arg, "regsave+1") == 0               &&
+            CE_IsArg (L[11], ARG_REGSAVE_1)                     &&
             L[12]->OPC == OP65_LDY                              &&
             CE_IsConstImm (L[12])                               &&
-            CE_IsCallTo (L[13], "ldauidx")) {
+            CE_IsCallTo (L[13], ARG_LDAUIDX)) {
 
             CodeEntry* X;
             CodeLabel* Label;
@@ -1104,7 +1104,7 @@ unsigned OptPtrLoad13 (CodeSeg* S)
             strncmp (L[0]->Arg, L[1]->Arg, Len) == 0            &&
             strcmp (L[1]->Arg + Len, "+1") == 0                 &&
             L[2]->OPC == OP65_LDY                               &&
-            CE_IsCallTo (L[3], "ldauidx")) {
+            CE_IsCallTo (L[3], ARG_LDAUIDX)) {
 
             CodeEntry* X;
 
@@ -1178,7 +1178,7 @@ unsigned OptPtrLoad14 (CodeSeg* S)
             strcmp (L[1]->Arg + Len, "+1") == 0                 &&
             (L[2]->Chg & REG_AX) == 0                           &&
             L[3]->OPC == OP65_LDY                               &&
-            CE_IsCallTo (L[4], "ldauidx")) {
+            CE_IsCallTo (L[4], ARG_LDAUIDX)) {
 
             CodeEntry* X;
 
@@ -1248,13 +1248,13 @@ unsigned OptPtrLoad15 (CodeSeg* S)
             strncmp (L[0]->Arg, L[1]->Arg, Len) == 0            &&
             strcmp (L[1]->Arg + Len, "+1") == 0) {
 
-            unsigned PushAX = CE_IsCallTo (L[2], "pushax");
+            unsigned PushAX = CE_IsCallTo (L[2], ARG_PUSHAX);
 
             /* Check for the remainder of the sequence */
             if (CS_GetEntries (S, L+3, I+3, 1 + PushAX)         &&
                 !CS_RangeHasLabel (S, I+3, 1 + PushAX)          &&
                 L[2+PushAX]->OPC == OP65_LDY                    &&
-                CE_IsCallTo (L[3+PushAX], "ldaxidx")) {
+                CE_IsCallTo (L[3+PushAX], ARG_LDAXIDX)) {
 
                 CodeEntry* X;
 
@@ -1328,7 +1328,7 @@ unsigned OptPtrLoad16 (CodeSeg* S)
         /* Check for the sequence */
         if (L[0]->OPC == OP65_LDY               &&
             CS_GetEntries (S, L+1, I+1, 1)      &&
-            CE_IsCallTo (L[1], "ldauidx")       &&
+            CE_IsCallTo (L[1], ARG_LDAUIDX)     &&
             !CE_HasLabel (L[1])) {
 
             CodeEntry* X;
@@ -1408,7 +1408,7 @@ unsigned OptPtrLoad17 (CodeSeg* S)
         /* Check for the sequence */
         if (L[0]->OPC == OP65_LDY               &&
             CS_GetEntries (S, L+1, I+1, 1)      &&
-            CE_IsCallTo (L[1], "ldaxidx")       &&
+            CE_IsCallTo (L[1], ARG_LDAXIDX)     &&
             !CE_HasLabel (L[1])) {
 
             CodeEntry* X;
@@ -1509,7 +1509,7 @@ unsigned OptPtrLoad18 (CodeSeg* S)
             L[5]->OPC == OP65_INX                            &&
             L[6]->OPC == OP65_LDY                            &&
             CE_IsKnownImm (L[6], 0)                          &&
-            CE_IsCallTo (L[7], "ldauidx")                    &&
+            CE_IsCallTo (L[7], ARG_LDAUIDX)                  &&
             !CS_RangeHasLabel (S, I+1, 5)                    &&
             !CE_HasLabel (L[7])                              &&
             L[0]->Arg[0] == '$'                              &&
@@ -1613,9 +1613,9 @@ unsigned OptPtrLoad19 (CodeSeg* S)
             strlen (L[4]->Arg) > 3                              &&
             strlen (L[7]->Arg) > 3                              &&
             strcmp (L[4]->Arg+1, L[7]->Arg+1) == 0              &&
-            (strcmp (L[2]->Arg, "aslax1") == 0          ||
-             strcmp (L[2]->Arg, "shlax1") == 0)                 &&
-            CE_IsCallTo (L[11], "ldaxidx")                      &&
+            (CE_IsArg (L[2], ARG_ASLAX1)                ||
+             CE_IsArg (L[2], ARG_SHLAX1))                       &&
+            CE_IsCallTo (L[11], ARG_LDAXIDX)                    &&
             !CS_RangeHasLabel (S, I+1, 11)) {
 
             CodeEntry* X;
@@ -1698,16 +1698,16 @@ unsigned OptPtrLoad20 (CodeSeg* S)
         /* Get the next entry */
         E[0] = CS_GetEntry (S, I);
 
-        if ((CE_IsCallTo(E[0], "ldax0sp") ||
-             CE_IsCallTo(E[0], "ldaxysp"))      &&
+        if ((CE_IsCallTo(E[0], ARG_LDAX0SP) ||
+             CE_IsCallTo(E[0], ARG_LDAXYSP))    &&
             CS_GetEntries (S, E+1, I+1, 2) != 0 &&
             E[1]->OPC == OP65_STA               &&
-            strcmp (E[1]->Arg, "ptr1") == 0     &&
+            CE_IsArg (E[1], ARG_PTR1)           &&
             E[2]->OPC == OP65_STX               &&
-            strcmp (E[2]->Arg, "ptr1+1") == 0   &&
+            CE_IsArg (E[2], ARG_PTR1_1)         &&
             !CS_RangeHasLabel (S, I+1, 2)) {
 
-            if (strcmp (E[0]->Arg, "ldaxysp") == 0) {
+            if (CE_IsArg (E[0], ARG_LDAXYSP)) {
                 CE_SetArg (E[0], "ldptr1ysp");
             } else {
                 CE_SetArg (E[0], "ldptr10sp");
@@ -38,6 +38,7 @@
 /* common */
 #include "chartype.h"
 #include "strbuf.h"
+#include "thread.h"
 #include "xmalloc.h"
 #include "xsprintf.h"
 
@@ -137,7 +138,7 @@ static const char* LoadAXImm (CodeSeg* S, unsigned I)
 ** storage which is overwritten with each call.
 */
 {
-    static StrBuf Buf = STATIC_STRBUF_INITIALIZER;
+    static THREAD_LOCAL StrBuf Buf = STATIC_STRBUF_INITIALIZER;
     CodeEntry* L[2];
     CodeEntry* ALoad;
     CodeEntry* XLoad;
@@ -292,12 +293,12 @@ unsigned OptPtrStore1 (CodeSeg* S)
             L[2]->JumpTo != 0                                   &&
             L[2]->JumpTo->Owner == L[4]                         &&
             L[3]->OPC == OP65_INX                               &&
-            CE_IsCallTo (L[4], "pushax")                        &&
+            CE_IsCallTo (L[4], ARG_PUSHAX)                      &&
             L[5]->OPC == OP65_LDX                               &&
             L[6]->OPC == OP65_LDA                               &&
             L[7]->OPC == OP65_LDY                               &&
             CE_IsKnownImm (L[7], 0)                             &&
-            CE_IsCallTo (L[8], "staspidx")                      &&
+            CE_IsCallTo (L[8], ARG_STASPIDX)                    &&
             !CS_RangeHasLabel (S, I+1, 3)                       &&
             !CS_RangeHasLabel (S, I+5, 4)) {
 
@@ -462,18 +463,18 @@ unsigned OptPtrStore2 (CodeSeg* S)
             L[2]->JumpTo != 0                                   &&
             L[2]->JumpTo->Owner == L[4]                         &&
             L[3]->OPC == OP65_INX                               &&
-            CE_IsCallTo (L[4], "pushax")                        &&
+            CE_IsCallTo (L[4], ARG_PUSHAX)                      &&
             L[5]->OPC == OP65_LDY                               &&
             CE_IsConstImm (L[5])                                &&
             L[6]->OPC == OP65_LDX                               &&
             L[7]->OPC == OP65_LDA                               &&
             L[7]->AM == AM65_ZP_INDY                            &&
-            strcmp (L[7]->Arg, "c_sp") == 0                     &&
+            CE_IsArg (L[7], ARG_C_SP)                           &&
             L[8]->OPC == OP65_LDY                               &&
             (L[8]->AM == AM65_ABS                       ||
              L[8]->AM == AM65_ZP                        ||
              L[8]->AM == AM65_IMM)                              &&
-            CE_IsCallTo (L[9], "staspidx")                      &&
+            CE_IsCallTo (L[9], ARG_STASPIDX)                    &&
             !CS_RangeHasLabel (S, I+1, 3)                       &&
             !CS_RangeHasLabel (S, I+5, 5)) {
 
@@ -666,19 +667,19 @@ unsigned OptPtrStore3 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "pushax")            &&
+        if (CE_IsCallTo (L[0], ARG_PUSHAX)          &&
             CS_GetEntries (S, L+1, I+1, 3)          &&
             L[1]->OPC == OP65_LDY                   &&
             CE_IsConstImm (L[1])                    &&
             !CE_HasLabel (L[1])                     &&
-            CE_IsCallTo (L[2], "ldauidx")           &&
+            CE_IsCallTo (L[2], ARG_LDAUIDX)         &&
             !CE_HasLabel (L[2])                     &&
             (K = OptPtrStore1Sub (S, I+3, L+3)) > 0 &&
             CS_GetEntries (S, L+3+K, I+3+K, 2)      &&
             L[3+K]->OPC == OP65_LDY                 &&
             CE_IsConstImm (L[3+K])                  &&
             !CE_HasLabel (L[3+K])                   &&
-            CE_IsCallTo (L[4+K], "staspidx")        &&
+            CE_IsCallTo (L[4+K], ARG_STASPIDX)      &&
             !CE_HasLabel (L[4+K])) {
 
 
@@ -33,6 +33,11 @@
 
 
 
+#include <string.h>
+
+/* common */
+#include "xsprintf.h"
+
 /* cc65 */
 #include "codeent.h"
 #include "codeinfo.h"
@@ -40,6 +45,311 @@
 
 
 
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Zero page locations that may hold a pushed argument */
+typedef struct ArgLoc ArgLoc;
+struct ArgLoc {
+    const char* Name;           /* Name of the location */
+    unsigned    Regs;           /* Register mask */
+};
+static const ArgLoc ArgLocs[] = {
+    { "ptr1",       REG_PTR1    },
+    { "ptr2",       REG_PTR2    },
+    { "sreg",       REG_SREG    },
+    { "regsave",    REG_SAVE    },
+};
+#define ARGLOC_COUNT    (sizeof (ArgLocs) / sizeof (ArgLocs[0]))
+
+
+
+/*****************************************************************************/
+/*                                  Helpers                                  */
+/*****************************************************************************/
+
+
+
+static unsigned GetPushSize (const CodeEntry* E)
+/* Return the number of bytes pushed by E, or zero if E is no push that
+** OptPush3 can handle.
+*/
+{
+    if (E->OPC == OP65_JSR) {
+        if (CE_IsCallTo (E, ARG_PUSHA)) {
+            return 1;
+        } else if (CE_IsCallTo (E, ARG_PUSHA0) || CE_IsCallTo (E, ARG_PUSHAX)) {
+            return 2;
+        }
+    }
+    return 0;
+}
+
+
+
+static int IsPop (const CodeEntry* E, unsigned Size)
+/* Return true if E is a call or a tail call of incspN with N == Size */
+{
+    return (E->OPC == OP65_JSR || (E->OPC == OP65_JMP && E->JumpTo == 0)) &&
+           Size >= 1 && Size <= 8                                       &&
+           CE_IsArg (E, ARG_INCSP1 + Size - 1);
+}
+
+
+
+static int GetArgAccess (const CodeEntry* E, unsigned* Offs, unsigned* Width)
+/* Check how E accesses the C stack. Return zero if it doesn't, a positive
+** value if it accesses the bytes Offs up to Offs+Width-1, and a negative
+** value if the access can't be determined.
+*/
+{
+    int Y = E->RI? E->RI->In.RegY : UNKNOWN_REGVAL;
+
+    if (E->AM == AM65_ZP_INDY && CE_IsArg (E, ARG_C_SP)) {
+        *Offs  = Y;
+        *Width = 1;
+        return RegValIsKnown (Y)? 1 : -1;
+    } else if (E->AM == AM65_ZP_IND && CE_IsArg (E, ARG_C_SP)) {
+        *Offs  = 0;
+        *Width = 1;
+        return 1;
+    } else if (E->OPC == OP65_JSR) {
+        *Width = 2;
+        if (CE_IsCallTo (E, ARG_LDAX0SP) || CE_IsCallTo (E, ARG_STAX0SP)) {
+            *Offs = 0;
+            return 1;
+        } else if (CE_IsCallTo (E, ARG_LDAXYSP)) {
+            *Offs = Y - 1;
+            return Y >= 1? 1 : -1;
+        } else if (CE_IsCallTo (E, ARG_STAXYSP)) {
+            *Offs = Y;
+            return RegValIsKnown (Y)? 1 : -1;
+        }
+        /* Other subroutines may use the stack */
+        return -1;
+    } else if (strstr (E->Arg, "c_sp") != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+
+
+static int IsClosedRange (CodeSeg* S, unsigned First, unsigned Last)
+/* Return true if there are no jumps into or out of the given range */
+{
+    unsigned I, J, K;
+    int Closed = 1;
+
+    for (I = First; I <= Last; ++I) {
+        CE_SetMark (CS_GetEntry (S, I));
+    }
+    for (I = First; Closed && I <= Last; ++I) {
+        CodeEntry* E = CS_GetEntry (S, I);
+        if (E->JumpTo && !CE_HasMark (E->JumpTo->Owner)) {
+            Closed = 0;
+        }
+        for (J = 0; Closed && J < CE_GetLabelCount (E); ++J) {
+            CodeLabel* L = CE_GetLabel (E, J);
+            for (K = 0; K < CL_GetRefCount (L); ++K) {
+                if (!CE_HasMark (CL_GetRef (L, K))) {
+                    Closed = 0;
+                    break;
+                }
+            }
+        }
+    }
+    CS_ResetMarks (S, First, Last);
+
+    return Closed;
+}
+
+
+
+static unsigned FindArgRange (CodeSeg* S, unsigned Push, unsigned Size,
+                              unsigned* Used)
+/* Search for the end of the code that accesses the argument pushed at the
+** given index. Return the index of the last pop of the argument or zero if
+** the argument can't be replaced. On success, Used has a bit set for each
+** byte of the argument that is used.
+*/
+{
+    unsigned I;
+
+    *Used = 0;
+    for (I = Push + 1; I < CS_GetEntryCount (S); ++I) {
+
+        const CodeEntry* E = CS_GetEntry (S, I);
+        unsigned Offs, Width;
+        int Access;
+
+        /* Check for a pop of the argument */
+        if (IsPop (E, Size)) {
+            if (IsClosedRange (S, Push + 1, I)) {
+                return I;
+            } else if (E->OPC == OP65_JSR) {
+                return 0;
+            }
+            continue;
+        }
+
+        /* The code must not leave the range in other ways */
+        if ((E->Info & OF_RET) != 0                     ||
+            E->OPC == OP65_BRK                          ||
+            (E->Flags & CEF_JUMPTABLE) != 0             ||
+            ((E->Info & OF_BRA) != 0 && E->JumpTo == 0)) {
+            return 0;
+        }
+
+        /* Check the stack accesses */
+        Access = GetArgAccess (E, &Offs, &Width);
+        if (Access < 0 || (Access > 0 && Offs + Width > Size)) {
+            return 0;
+        } else if (Access > 0) {
+            *Used |= ((1U << Width) - 1) << Offs;
+        }
+    }
+    return 0;
+}
+
+
+
+static const ArgLoc* FindArgLoc (CodeSeg* S, unsigned Push, unsigned Last)
+/* Find a zero page location that is not used in the given range and is free
+** afterwards.
+*/
+{
+    unsigned I, J;
+
+    for (I = 0; I < ARGLOC_COUNT; ++I) {
+        const ArgLoc* Loc = ArgLocs + I;
+        for (J = Push + 1; J <= Last; ++J) {
+            const CodeEntry* E = CS_GetEntry (S, J);
+            if (((E->Use | E->Chg) & Loc->Regs) != 0 ||
+                strstr (E->Arg, Loc->Name) != 0) {
+                break;
+            }
+        }
+        if (J > Last && (GetRegInfo (S, Push + 1, Loc->Regs) & Loc->Regs) == 0) {
+            return Loc;
+        }
+    }
+    return 0;
+}
+
+
+
+static const char* MakeArgLocArg (char* Buf, unsigned Size,
+                                  const ArgLoc* Loc, unsigned Offs)
+/* Return the name of a byte in the given location */
+{
+    if (Offs == 0) {
+        return Loc->Name;
+    }
+    xsprintf (Buf, Size, "%s+%u", Loc->Name, Offs);
+    return Buf;
+}
+
+
+
+static void InsertLoadY (CodeSeg* S, unsigned Index, unsigned Y, LineInfo* LI)
+/* If the value of Y is used at Index, insert a load of Y there */
+{
+    if ((GetRegInfo (S, Index, REG_Y) & REG_Y) != 0) {
+        CodeEntry* X = NewCodeEntry (OP65_LDY, AM65_IMM, MakeHexArg (Y), 0, LI);
+        CS_InsertEntry (S, X, Index);
+    }
+}
+
+
+
+static void RemoveEntry (CodeSeg* S, unsigned Index)
+/* Delete the entry at Index, moving its labels to the next entry */
+{
+    CodeEntry* E = CS_GetEntry (S, Index);
+    if (CE_HasLabel (E)) {
+        CS_MoveLabels (S, E, CS_GetEntry (S, Index + 1));
+    }
+    CS_DelEntry (S, Index);
+}
+
+
+
+static void ReplaceArg (CodeSeg* S, unsigned Push, unsigned Last,
+                        unsigned Size, unsigned Used, const ArgLoc* Loc)
+/* Replace the argument pushed at index Push and removed up to index Last by
+** the given zero page location.
+*/
+{
+    char        Buf[32];
+    CodeEntry*  E;
+    CodeEntry*  X;
+    unsigned    I, Pos;
+
+    /* Work backwards, so the register info of the entries still to be
+    ** handled is valid.
+    */
+    I = Last + 1;
+    while (I-- > Push + 1) {
+
+        unsigned Offs, Width;
+
+        E   = CS_GetEntry (S, I);
+        Pos = I + 1;
+
+        if (IsPop (E, Size)) {
+            if (E->OPC == OP65_JMP) {
+                X = NewCodeEntry (OP65_RTS, AM65_IMP, 0, 0, E->LI);
+                CS_InsertEntry (S, X, Pos);
+            }
+        } else if (GetArgAccess (E, &Offs, &Width) <= 0) {
+            continue;
+        } else if (Width == 1) {
+            X = NewCodeEntry (E->OPC, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, Offs), 0, E->LI);
+            CS_InsertEntry (S, X, Pos);
+        } else if (CE_IsCallTo (E, ARG_LDAX0SP) || CE_IsCallTo (E, ARG_LDAXYSP)) {
+            X = NewCodeEntry (OP65_LDX, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, Offs + 1), 0, E->LI);
+            CS_InsertEntry (S, X, Pos++);
+            X = NewCodeEntry (OP65_LDA, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, Offs), 0, E->LI);
+            CS_InsertEntry (S, X, Pos++);
+            InsertLoadY (S, Pos, Offs, E->LI);
+        } else {
+            X = NewCodeEntry (OP65_STA, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, Offs), 0, E->LI);
+            CS_InsertEntry (S, X, Pos++);
+            X = NewCodeEntry (OP65_STX, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, Offs + 1), 0, E->LI);
+            CS_InsertEntry (S, X, Pos++);
+            InsertLoadY (S, Pos, Offs + 1, E->LI);
+        }
+        RemoveEntry (S, I);
+    }
+
+    /* Store the argument instead of pushing it. pusha0 clears X, and all
+    ** pushes clear Y.
+    */
+    E   = CS_GetEntry (S, Push);
+    Pos = Push + 1;
+    if (CE_IsCallTo (E, ARG_PUSHA0) &&
+        ((Used & 0x02) != 0 || (GetRegInfo (S, Pos, REG_X) & REG_X) != 0)) {
+        X = NewCodeEntry (OP65_LDX, AM65_IMM, MakeHexArg (0), 0, E->LI);
+        CS_InsertEntry (S, X, Pos++);
+    }
+    if (Used & 0x01) {
+        X = NewCodeEntry (OP65_STA, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, 0), 0, E->LI);
+        CS_InsertEntry (S, X, Pos++);
+    }
+    if (Used & 0x02) {
+        X = NewCodeEntry (OP65_STX, AM65_ZP, MakeArgLocArg (Buf, sizeof (Buf), Loc, 1), 0, E->LI);
+        CS_InsertEntry (S, X, Pos++);
+    }
+    InsertLoadY (S, Pos, 0, E->LI);
+    RemoveEntry (S, Push);
+}
+
+
+
 /*****************************************************************************/
 /*                                   Code                                    */
 /*****************************************************************************/
@@ -75,12 +385,12 @@ unsigned OptPush1 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "ldaxysp")               &&
+        if (CE_IsCallTo (L[0], ARG_LDAXYSP)             &&
             RegValIsKnown (L[0]->RI->In.RegY)           &&
             L[0]->RI->In.RegY < 0xFE                    &&
             (L[1] = CS_GetNextEntry (S, I)) != 0        &&
             !CE_HasLabel (L[1])                         &&
-            CE_IsCallTo (L[1], "pushax")                &&
+            CE_IsCallTo (L[1], ARG_PUSHAX)              &&
             ((R = (GetRegInfo (S, I+2, REG_AXY))) & REG_AX) == 0) {
 
             /* Insert new code behind the pushax */
@@ -152,10 +462,10 @@ unsigned OptPush2 (CodeSeg* S)
         L[0] = CS_GetEntry (S, I);
 
         /* Check for the sequence */
-        if (CE_IsCallTo (L[0], "ldaxidx")               &&
+        if (CE_IsCallTo (L[0], ARG_LDAXIDX)             &&
             (L[1] = CS_GetNextEntry (S, I)) != 0        &&
             !CE_HasLabel (L[1])                         &&
-            CE_IsCallTo (L[1], "pushax")) {
+            CE_IsCallTo (L[1], ARG_PUSHAX)) {
 
             /* Insert new code behind the pushax */
             CodeEntry* X;
@@ -180,3 +490,54 @@ unsigned OptPush2 (CodeSeg* S)
     /* Return the number of changes made */
     return Changes;
 }
+
+
+
+unsigned OptPush3 (CodeSeg* S)
+/* Replace an argument that is pushed by
+**
+**     jsr     pusha/pusha0/pushax
+**
+** and removed by
+**
+**     jsr     incspN
+**
+** by a zero page location, if the code in between doesn't call subroutines
+** other than the stack load and store helpers, and accesses the argument
+** with known offsets only. The code of leaf functions and inlined functions
+** often looks like this.
+*/
+{
+    unsigned I;
+    unsigned Changes = 0;
+
+    /* Walk over the entries */
+    I = 0;
+    while (I < CS_GetEntryCount (S)) {
+
+        /* Get next entry */
+        CodeEntry*    E = CS_GetEntry (S, I);
+        unsigned      Size = GetPushSize (E);
+        unsigned      Last, Used;
+        const ArgLoc* Loc;
+
+        /* Check for the sequence */
+        if (Size > 0                                            &&
+            (Last = FindArgRange (S, I, Size, &Used)) != 0      &&
+            (Loc = FindArgLoc (S, I, Last)) != 0) {
+
+            /* Replace the stack accesses */
+            ReplaceArg (S, I, Last, Size, Used, Loc);
+
+            /* Remember, we had changes */
+            ++Changes;
+        }
+
+        /* Next entry */
+        ++I;
+
+    }
+
+    /* Return the number of changes made */
+    return Changes;
+}
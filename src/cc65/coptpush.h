@@ -76,6 +76,22 @@ unsigned OptPush2 (CodeSeg* S);
 */
 
 
+unsigned OptPush3 (CodeSeg* S);
+/* Replace an argument that is pushed by
+**
+**     jsr     pusha/pusha0/pushax
+**
+** and removed by
+**
+**     jsr     incspN
+**
+** by a zero page location, if the code in between doesn't call subroutines
+** other than the stack load and store helpers, and accesses the argument
+** with known offsets only. The code of leaf functions and inlined functions
+** often looks like this.
+*/
+
+
 
 /* End of coptpush.h */
 
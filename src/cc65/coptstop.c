@@ -536,10 +536,10 @@ static unsigned Opt_tosaddax (StackOpData* D)
         CE_IsKnownImm (D->NextEntry, 0)                         &&
         !CE_HasLabel (D->NextEntry)                             &&
         (N = CS_GetNextEntry (D->Code, D->OpIndex + 1)) != 0    &&
-        (CE_IsCallTo (N, "ldauidx")                     ||
-         CE_IsCallTo (N, "ldaidx"))) {
+        (CE_IsCallTo (N, ARG_LDAUIDX)                   ||
+         CE_IsCallTo (N, ARG_LDAIDX))) {
 
-        int Signed = (strcmp (N->Arg, "ldaidx") == 0);
+        int Signed = CE_IsArg (N, ARG_LDAIDX);
 
         /* Store the value into the zeropage instead of pushing it */
         AddStoreLhsX (D);
@@ -1912,7 +1912,7 @@ unsigned OptStackOps (CodeSeg* S)
                     Data.Lhs.X.ChgIndex = I;
                     Data.Lhs.Y.ChgIndex = I;
                 }
-                if (CE_IsCallTo (E, "pushax")) {
+                if (CE_IsCallTo (E, ARG_PUSHAX)) {
                     /* Disallow removing Lhs loads if the registers are used */
                     SetIfOperandLoadUnremovable (&Data.Lhs, Data.UsedRegs);
 
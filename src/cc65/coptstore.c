@@ -82,10 +82,10 @@ unsigned OptStore1 (CodeSeg* S)
             L[0]->Num < 0xFF                                &&
             !CS_RangeHasLabel (S, I+1, 3)                   &&
             CS_GetEntries (S, L+1, I+1, 3)                  &&
-            CE_IsCallTo (L[1], "staxysp")                   &&
+            CE_IsCallTo (L[1], ARG_STAXYSP)                 &&
             L[2]->OPC == OP65_LDY                           &&
             CE_IsKnownImm (L[2], L[0]->Num + 1)             &&
-            CE_IsCallTo (L[3], "ldaxysp")) {
+            CE_IsCallTo (L[3], ARG_LDAXYSP)) {
 
             /* Register has already the correct value, remove the loads */
             CS_DelEntries (S, I+2, 2);
@@ -126,7 +126,7 @@ unsigned OptStore2 (CodeSeg* S)
         const RegInfo* RI = E->RI;
 
         /* Check for the call */
-        if (CE_IsCallTo (E, "staxysp")          &&
+        if (CE_IsCallTo (E, ARG_STAXYSP)        &&
             RegValIsKnown (RI->In.RegA)         &&
             RegValIsKnown (RI->In.RegX)         &&
             RegValIsKnown (RI->In.RegY)         &&
@@ -196,7 +196,7 @@ unsigned OptStore3 (CodeSeg* S)
         const RegInfo* RI = E->RI;
 
         /* Check for the call */
-        if (CE_IsCallTo (E, "steaxysp")         &&
+        if (CE_IsCallTo (E, ARG_STEAXYSP)       &&
             RegValIsKnown (RI->In.RegA)         &&
             RegValIsKnown (RI->In.RegX)         &&
             RegValIsKnown (RI->In.RegY)         &&
@@ -387,8 +387,9 @@ unsigned OptStore5 (CodeSeg* S)
 **      lda     foo
 **      sta     something
 **
-** if the new value of X is not used later. That replacement doesn't save any
-** cycles or bytes; but, it keeps the old value of X, which may be reused later.
+** if the new value of X is not used later, and something-else is neither foo
+** nor something. That replacement doesn't save any cycles or bytes; but, it
+** keeps the old value of X, which may be reused later.
 */
 {
     unsigned Changes = 0;
@@ -408,6 +409,8 @@ unsigned OptStore5 (CodeSeg* S)
             L[1]->OPC == OP65_LDX               &&
             L[2]->OPC == OP65_STA               &&
             L[3]->OPC == OP65_STX               &&
+            strcmp (L[3]->Arg, L[0]->Arg) != 0  &&
+            strcmp (L[3]->Arg, L[2]->Arg) != 0  &&
             !RegXUsed (S, I+4)) {
 
             CodeEntry* E = CS_GetEntry (S, I+1);
@@ -136,10 +136,10 @@ unsigned OptSub2 (CodeSeg* S)
             CS_GetEntries (S, L, I+1, 5)                   &&
             L[0]->OPC == OP65_SEC                          &&
             L[1]->OPC == OP65_STA                          &&
-            strcmp (L[1]->Arg, "tmp1") == 0                &&
+            CE_IsArg (L[1], ARG_TMP1)                      &&
             L[2]->OPC == OP65_LDA                          &&
             L[3]->OPC == OP65_SBC                          &&
-            strcmp (L[3]->Arg, "tmp1") == 0                &&
+            CE_IsArg (L[3], ARG_TMP1)                      &&
             L[4]->OPC == OP65_STA                          &&
             strcmp (L[4]->Arg, L[2]->Arg) == 0) {
 
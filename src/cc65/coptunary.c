@@ -67,7 +67,7 @@ unsigned OptNegAX1 (CodeSeg* S)
         CodeEntry* E = CS_GetEntry (S, I);
 
         /* Check if this is a call to negax, and if X isn't used later */
-        if (CE_IsCallTo (E, "negax") && !RegXUsed (S, I+1)) {
+        if (CE_IsCallTo (E, ARG_NEGAX) && !RegXUsed (S, I+1)) {
 
             CodeEntry* X;
 
@@ -130,7 +130,7 @@ unsigned OptNegAX2 (CodeSeg* S)
 
         /* Check if this is a call to negax, and if X is known and zero */
         if (E->RI->In.RegX == 0                 &&
-            CE_IsCallTo (E, "negax")            &&
+            CE_IsCallTo (E, ARG_NEGAX)          &&
             (P = CS_GetNextEntry (S, I)) != 0) {
 
             CodeEntry* X;
@@ -211,7 +211,7 @@ unsigned OptComplAX1 (CodeSeg* S)
         CodeEntry* E = CS_GetEntry (S, I);
 
         /* Check if this is a call to negax, and if X isn't used later */
-        if (CE_IsCallTo (E, "complax") && !RegXUsed (S, I+1)) {
+        if (CE_IsCallTo (E, ARG_COMPLAX) && !RegXUsed (S, I+1)) {
 
             CodeEntry* X;
 
@@ -55,6 +55,8 @@
 #include "funcdesc.h"
 #include "function.h"
 #include "global.h"
+#include "input.h"
+#include "lineinfo.h"
 #include "litpool.h"
 #include "pragma.h"
 #include "scanner.h"
@@ -2064,6 +2066,12 @@ static void ParseFuncDecl (Declarator* D, declmode_t Mode, TypeCode Qualifiers)
     /* Create a new function descriptor */
     FuncDesc* F = NewFuncDesc ();
 
+    /* Remember if the function is declared in a system include file */
+    if (CurTok.LI != 0 && CurTok.LI->File != 0 &&
+        CurTok.LI->File->InputFile->Type == IT_SYSINC) {
+        F->Flags |= FD_SYSINC;
+    }
+
     /* Enter a new lexical level */
     EnterFunctionLevel ();
 
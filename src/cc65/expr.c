@@ -916,7 +916,7 @@ static unsigned FunctionArgList (FuncDesc* Func, int IsFastcall, ExprDesc* ED)
                     }
                     FrameOffs -= ArgSize;
                     /* Store */
-                    g_putlocal (Flags | CF_NOKEEP, FrameOffs, Expr.IVal);
+                    g_putlocal (Flags | CF_NOKEEP | CF_TEMP, FrameOffs, Expr.IVal);
                 } else {
                     /* Push the argument */
                     g_push (Flags, Expr.IVal);
@@ -1073,7 +1073,7 @@ static void FunctionCall (ExprDesc* Expr)
                     PtrOnStack = 0;
                 } else {
                     /* Load from the saved copy */
-                    g_getlocal (CF_PTR, PtrOffs);
+                    g_getlocal (CF_PTR | CF_TEMP, PtrOffs);
                 }
             } else {
                 /* Load from original location */
@@ -2076,6 +2076,12 @@ void hie10 (ExprDesc* Expr)
                     /* Continue anyway, just to avoid further warnings */
                     Expr->Type = GetUnderlyingType (Expr->Type);
                 }
+                /* A local whose address is known may be changed through
+                ** pointers, so it cannot live in the register bank.
+                */
+                if (ED_IsLocStack (Expr) && Expr->Sym != 0) {
+                    Expr->Sym->Flags |= SC_ADDRTAKEN;
+                }
                 /* The & operator yields an rvalue address */
                 ED_AddrExpr (Expr);
             }
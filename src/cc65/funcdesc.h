@@ -54,9 +54,10 @@
 #define FD_OLDSTYLE_INTRET      0x0020U /* K&R func has implicit int return    */
 #define FD_UNNAMED_PARAMS       0x0040U /* Function has unnamed params         */
 #define FD_CALL_WRAPPER         0x0080U /* This function is used as a wrapper  */
+#define FD_SYSINC               0x0200U /* Declared in a system include file   */
 
 /* Bits that must be ignored when comparing funcs */
-#define FD_IGNORE   (FD_INCOMPLETE_PARAM | FD_OLDSTYLE | FD_OLDSTYLE_INTRET | FD_UNNAMED_PARAMS | FD_CALL_WRAPPER)
+#define FD_IGNORE   (FD_INCOMPLETE_PARAM | FD_OLDSTYLE | FD_OLDSTYLE_INTRET | FD_UNNAMED_PARAMS | FD_CALL_WRAPPER | FD_SYSINC)
 
 #define WRAPPED_CALL_USE_BANK   0x0100U /* WrappedCall uses .bank() */
 
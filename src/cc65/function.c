@@ -40,6 +40,7 @@
 /* cc65 */
 #include "asmcode.h"
 #include "asmlabel.h"
+#include "codeent.h"
 #include "codegen.h"
 #include "error.h"
 #include "expr.h"
@@ -47,6 +48,7 @@
 #include "global.h"
 #include "litpool.h"
 #include "locals.h"
+#include "regalloc.h"
 #include "scanner.h"
 #include "stackptr.h"
 #include "standard.h"
@@ -309,10 +311,13 @@ void F_AllocLocalSpace (Function* F)
     if (F->Reserved > 0) {
 
         /* Create space on the stack */
+        CodeMark Start;
+        GetCodePos (&Start);
         g_space (F->Reserved);
 
         /* Correct the stack pointer */
         StackPtr -= F->Reserved;
+        MarkFrameCode (&Start, CEF_FRAME_ADJUST, StackPtr);
 
         /* Nothing more reserved */
         F->Reserved = 0;
@@ -454,6 +459,8 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
     const Type* RType;          /* Real type used for struct parameters */
     const Type* ReturnType;     /* Return type */
     int         StmtFlags;      /* Flow control flags for the function compound */
+    CodeMark    Body;           /* Start of the function body */
+    CodeMark    Exit;           /* Start of the exit code */
 
     /* Remember this function descriptor used for definition */
     GetFuncDesc (Func->Type)->FuncDef = D;
@@ -545,6 +552,7 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
     /* If this is a fastcall function, push the last parameter onto the stack */
     if (D->ParamCount > 0 && IsFastcallFunc (Func->Type)) {
         unsigned Flags;
+        CodeMark Start;
 
         /* Generate the push */
         /* Handle struct/union specially */
@@ -553,7 +561,11 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
         } else {
             Flags = CG_TypeOf (D->LastParam->Type) | CF_FORCECHAR;
         }
+        GetCodePos (&Start);
         g_push (Flags, 0);
+
+        /* The parameter is the lowest one in the frame */
+        MarkFrameCode (&Start, CEF_FRAME_PUSH, 0);
     }
 
     /* Generate function entry code if needed */
@@ -628,6 +640,7 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
     CurrentFunc->TopLevelSP = StackPtr;
 
     /* Now process statements in this block checking for unreachable code */
+    GetCodePos (&Body);
     StmtFlags = StatementBlock (0);
 
     /* Check if this function is missing a return value */
@@ -647,6 +660,7 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
     }
 
     /* Output the function exit code label */
+    GetCodePos (&Exit);
     g_defcodelabel (F_GetRetLab (CurrentFunc));
 
     /* Restore the register variables (not necessary for the main function in
@@ -661,6 +675,9 @@ void NewFunc (SymEntry* Func, FuncDesc* D)
     /* Generate the exit code */
     g_leave (CleanupOnExit);
 
+    /* Move the most used locals into the free part of the register bank */
+    AllocAutoRegVars (CurrentFunc, &Body, &Exit, CleanupOnExit);
+
     /* Emit references to imports/exports */
     EmitExternals ();
 
@@ -52,6 +52,7 @@ unsigned char DumpUserMacros    = 0;    /* Output user macros */
 unsigned char PreprocessOnly    = 0;    /* Just preprocess the input */
 unsigned char DebugOptOutput    = 0;    /* Output debug stuff */
 unsigned      RegisterSpace     = 6;    /* Space available for register vars */
+unsigned      OptimizerJobs     = 1;    /* Threads for the optimizer, 0 = CPU cores */
 
 /* Stackable options */
 IntStack WritableStrings    = INTSTACK(0);  /* Literal strings are r/w */
@@ -59,8 +60,10 @@ IntStack LocalStrings       = INTSTACK(0);  /* Emit string literals immediately
 IntStack InlineStdFuncs     = INTSTACK(0);  /* Inline some standard functions */
 IntStack EagerlyInlineFuncs = INTSTACK(0);  /* Eagerly inline some known functions */
 IntStack EnableRegVars      = INTSTACK(0);  /* Enable register variables */
+IntStack AutoRegVars        = INTSTACK(0);  /* Move hot locals into the register bank */
 IntStack AllowRegVarAddr    = INTSTACK(0);  /* Allow taking addresses of register vars */
 IntStack RegVarsToCallStack = INTSTACK(0);  /* Save reg variables on call stack */
+IntStack StaticFrames       = INTSTACK(0);  /* Use static stack frames where possible */
 IntStack StaticLocals       = INTSTACK(0);  /* Make local variables static */
 IntStack SignedChars        = INTSTACK(0);  /* Make characters signed by default */
 IntStack CheckStack         = INTSTACK(0);  /* Generate stack overflow checks */
@@ -60,6 +60,7 @@ extern unsigned char    DumpUserMacros;         /* Output user macros */
 extern unsigned char    PreprocessOnly;         /* Just preprocess the input */
 extern unsigned char    DebugOptOutput;         /* Output debug stuff */
 extern unsigned         RegisterSpace;          /* Space available for register vars */
+extern unsigned         OptimizerJobs;          /* Threads for the optimizer, 0 = CPU cores */
 
 /* Stackable options */
 extern IntStack         WritableStrings;        /* Literal strings are r/w */
@@ -67,8 +68,10 @@ extern IntStack         LocalStrings;           /* Emit string literals immediat
 extern IntStack         InlineStdFuncs;         /* Inline some standard functions */
 extern IntStack         EagerlyInlineFuncs;     /* Eagerly inline some known functions */
 extern IntStack         EnableRegVars;          /* Enable register variables */
+extern IntStack         AutoRegVars;            /* Move hot locals into the register bank */
 extern IntStack         AllowRegVarAddr;        /* Allow taking addresses of register vars */
 extern IntStack         RegVarsToCallStack;     /* Save reg variables on call stack */
+extern IntStack         StaticFrames;           /* Use static stack frames where possible */
 extern IntStack         StaticLocals;           /* Make local variables static */
 extern IntStack         SignedChars;            /* Use 'signed char' as the underlying type of 'char' */
 extern IntStack         CheckStack;             /* Generate stack overflow checks */
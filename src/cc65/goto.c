@@ -85,6 +85,12 @@ int GotoStatement (void)
 
         ED_Init (&desc);
 
+        /* The stack frame of the function must stay on the stack, since
+        ** the jumps through the label table can't be analyzed.
+        */
+        CS->Code->StaticFrame = 0;
+        CS->Code->AutoRegVars = 0;
+
         NextToken ();
 
         /* arr[foo], we only support simple foo for now */
@@ -52,3 +52,25 @@ int IsIdent (char c)
 {
     return (IsAlpha (c) || c == '_');
 }
+
+
+
+const char* NextIdent (const char* Text, StrBuf* Ident)
+/* Search for the next identifier in the assembler text Text and copy it into
+** Ident. Return a pointer behind the identifier or NULL if there is none.
+** Numbers are returned as well, since they are harmless for the callers.
+*/
+{
+    while (*Text != '\0' && !IsAlNum (*Text) && *Text != '_') {
+        ++Text;
+    }
+    if (*Text == '\0') {
+        return 0;
+    }
+    SB_Clear (Ident);
+    while (IsAlNum (*Text) || *Text == '_') {
+        SB_AppendChar (Ident, *Text++);
+    }
+    SB_Terminate (Ident);
+    return Text;
+}
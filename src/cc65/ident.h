@@ -38,6 +38,11 @@
 
 
 
+/* common */
+#include "strbuf.h"
+
+
+
 /*****************************************************************************/
 /*                                   Data                                    */
 /*****************************************************************************/
@@ -62,6 +67,12 @@ typedef char ident [IDENTSIZE];
 int IsIdent (char c);
 /* Return true if the given char may start an identifier */
 
+const char* NextIdent (const char* Text, StrBuf* Ident);
+/* Search for the next identifier in the assembler text Text and copy it into
+** Ident. Return a pointer behind the identifier or NULL if there is none.
+** Numbers are returned as well, since they are harmless for the callers.
+*/
+
 
 
 /* End of ident.h */
@@ -38,6 +38,7 @@
 /* common */
 #include "chartype.h"
 #include "check.h"
+#include "thread.h"
 #include "xmalloc.h"
 
 /* cc65 */
@@ -131,7 +132,13 @@ LineInfo* UseLineInfo (LineInfo* LI)
 /* Increase the reference count of the given line info and return it. */
 {
     CHECK (LI != 0);
+
+    /* Code entries of several functions may share line infos, and the
+    ** optimizer works on functions in parallel.
+    */
+    ThreadLock ();
     ++LI->RefCount;
+    ThreadUnlock ();
     return LI;
 }
 
@@ -142,8 +149,17 @@ void ReleaseLineInfo (LineInfo* LI)
 ** reference count drops to zero.
 */
 {
-    CHECK (LI && LI->RefCount > 0);
-    if (--LI->RefCount == 0) {
+    unsigned RefCount;
+
+    CHECK (LI != 0);
+
+    /* See UseLineInfo */
+    ThreadLock ();
+    CHECK (LI->RefCount > 0);
+    RefCount = --LI->RefCount;
+    ThreadUnlock ();
+
+    if (RefCount == 0) {
         /* No more references, free it */
         FreeLineInfo (LI);
     }
@@ -39,7 +39,9 @@
 
 /* cc65 */
 #include "anonname.h"
+#include "asmcode.h"
 #include "asmlabel.h"
+#include "codeent.h"
 #include "codegen.h"
 #include "declare.h"
 #include "error.h"
@@ -281,6 +283,7 @@ static void ParseAutoDecl (Declarator* Decl)
             } else {
 
                 ExprDesc Expr;
+                CodeMark Start;
                 ED_Init (&Expr);
 
                 /* Allocate previously reserved local space */
@@ -306,7 +309,9 @@ static void ParseAutoDecl (Declarator* Decl)
                 }
 
                 /* Push the value */
+                GetCodePos (&Start);
                 g_push (Flags | CG_TypeOf (Sym->Type), Expr.IVal);
+                MarkFrameCode (&Start, CEF_FRAME_PUSH, StackPtr);
 
                 /* This has to be done at sequence point */
                 DoDeferred (SQP_KEEP_NONE, &Expr);
@@ -57,6 +57,7 @@
 /* cc65 */
 #include "asmcode.h"
 #include "compile.h"
+#include "codearg.h"
 #include "codeopt.h"
 #include "error.h"
 #include "global.h"
@@ -107,6 +108,7 @@ static void Usage (void)
             "Long options:\n"
             "  --add-source\t\t\tInclude source as comment\n"
             "  --all-cdecl\t\t\tMake functions default to __cdecl__\n"
+            "  --auto-register-vars\t\tMove hot locals into the register bank\n"
             "  --bss-name seg\t\tSet the name of the BSS segment\n"
             "  --check-stack\t\t\tGenerate stack overflow checks\n"
             "  --code-name seg\t\tSet the name of the CODE segment\n"
@@ -127,6 +129,7 @@ static void Usage (void)
             "  --help\t\t\tHelp (this text)\n"
             "  --include-dir dir\t\tSet an include directory search path\n"
             "  --inline-stdfuncs\t\tInline some standard functions\n"
+            "  --jobs n\t\t\tOptimize functions on n threads\n"
             "  --list-opt-steps\t\tList all optimizer steps and exit\n"
             "  --list-warnings\t\tList available warning types for -W\n"
             "  --local-strings\t\tEmit string literals immediately\n"
@@ -136,6 +139,7 @@ static void Usage (void)
             "  --rodata-name seg\t\tSet the name of the RODATA segment\n"
             "  --signed-chars\t\tDefault characters are signed\n"
             "  --standard std\t\tLanguage standard (c89, c99, cc65)\n"
+            "  --static-frames\t\tUse static stack frames where possible\n"
             "  --static-locals\t\tMake local variables static\n"
             "  --target sys\t\t\tSet the target system\n"
             "  --verbose\t\t\tIncrease verbosity\n"
@@ -517,6 +521,15 @@ static void OptAllCDecl (const char* Opt attribute ((unused)),
 
 
 
+static void OptAutoRegisterVars (const char* Opt attribute ((unused)),
+                                 const char* Arg attribute ((unused)))
+/* Handle the --auto-register-vars option */
+{
+    IS_Set (&AutoRegVars, 1);
+}
+
+
+
 static void OptBssName (const char* Opt attribute ((unused)), const char* Arg)
 /* Handle the --bss-name option */
 {
@@ -771,6 +784,17 @@ static void OptInlineStdFuncs (const char* Opt attribute((unused)),
 
 
 
+static void OptJobs (const char* Opt, const char* Arg)
+/* Handle the --jobs option */
+{
+    /* Numeric argument expected */
+    if (sscanf (Arg, "%u", &OptimizerJobs) != 1 || OptimizerJobs > 256) {
+        AbEnd ("Argument for option %s is invalid", Opt);
+    }
+}
+
+
+
 static void OptListOptSteps (const char* Opt attribute ((unused)),
                              const char* Arg attribute ((unused)))
 /* List all optimizer steps */
@@ -887,6 +911,15 @@ static void OptStandard (const char* Opt, const char* Arg)
 
 
 
+static void OptStaticFrames (const char* Opt attribute ((unused)),
+                             const char* Arg attribute ((unused)))
+/* Place the stack frames of non recursive functions in static storage */
+{
+    IS_Set (&StaticFrames, 1);
+}
+
+
+
 static void OptStaticLocals (const char* Opt attribute ((unused)),
                              const char* Arg attribute ((unused)))
 /* Place local variables in static storage */
@@ -993,6 +1026,7 @@ int main (int argc, char* argv[])
     static const LongOpt OptTab[] = {
         { "--add-source",           0,      OptAddSource            },
         { "--all-cdecl",            0,      OptAllCDecl             },
+        { "--auto-register-vars",   0,      OptAutoRegisterVars     },
         { "--bss-name",             1,      OptBssName              },
         { "--check-stack",          0,      OptCheckStack           },
         { "--code-name",            1,      OptCodeName             },
@@ -1013,6 +1047,7 @@ int main (int argc, char* argv[])
         { "--help",                 0,      OptHelp                 },
         { "--include-dir",          1,      OptIncludeDir           },
         { "--inline-stdfuncs",      0,      OptInlineStdFuncs       },
+        { "--jobs",                 1,      OptJobs                 },
         { "--list-opt-steps",       0,      OptListOptSteps         },
         { "--list-warnings",        0,      OptListWarnings         },
         { "--local-strings",        0,      OptLocalStrings         },
@@ -1022,6 +1057,7 @@ int main (int argc, char* argv[])
         { "--rodata-name",          1,      OptRodataName           },
         { "--signed-chars",         0,      OptSignedChars          },
         { "--standard",             1,      OptStandard             },
+        { "--static-frames",        0,      OptStaticFrames         },
         { "--static-locals",        0,      OptStaticLocals         },
         { "--target",               1,      OptTarget               },
         { "--verbose",              0,      OptVerbose              },
@@ -1047,6 +1083,9 @@ int main (int argc, char* argv[])
     /* Initialize the include search paths */
     InitIncludePaths ();
 
+    /* Create the predefined arguments of code entries */
+    InitCodeArgs ();
+
     /* Parse the command line */
     I = 1;
     while (I < ArgCount) {
@@ -1248,6 +1287,7 @@ int main (int argc, char* argv[])
 
         /* Emit literals, do cleanup and optimizations */
         FinishCompile ();
+        WriteOptReport (InputFile);
 
         /* Open the file */
         OpenOutputFile ();
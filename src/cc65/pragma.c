@@ -68,6 +68,7 @@ typedef enum {
     PRAGMA_ILLEGAL = -1,
     PRAGMA_ALIGN,
     PRAGMA_ALLOW_EAGER_INLINE,
+    PRAGMA_AUTO_REGISTER_VARS,
     PRAGMA_BSS_NAME,
     PRAGMA_CHARMAP,
     PRAGMA_CHECK_STACK,
@@ -82,6 +83,7 @@ typedef enum {
     PRAGMA_REGVARADDR,
     PRAGMA_RODATA_NAME,
     PRAGMA_SIGNED_CHARS,
+    PRAGMA_STATIC_FRAMES,
     PRAGMA_STATIC_LOCALS,
     PRAGMA_WARN,
     PRAGMA_WRAPPED_CALL,
@@ -99,6 +101,8 @@ static const struct Pragma {
     { "align",                  PRAGMA_ALIGN              },
     { "allow-eager-inline",     PRAGMA_ALLOW_EAGER_INLINE },
     { "allow_eager_inline",     PRAGMA_ALLOW_EAGER_INLINE },
+    { "auto-register-vars",     PRAGMA_AUTO_REGISTER_VARS },
+    { "auto_register_vars",     PRAGMA_AUTO_REGISTER_VARS },
     { "bss-name",               PRAGMA_BSS_NAME           },
     { "bss_name",               PRAGMA_BSS_NAME           },
     { "charmap",                PRAGMA_CHARMAP            },
@@ -122,7 +126,9 @@ static const struct Pragma {
     { "rodata_name",            PRAGMA_RODATA_NAME        },
     { "signed-chars",           PRAGMA_SIGNED_CHARS       },
     { "signed_chars",           PRAGMA_SIGNED_CHARS       },
+    { "static-frames",          PRAGMA_STATIC_FRAMES      },
     { "static-locals",          PRAGMA_STATIC_LOCALS      },
+    { "static_frames",          PRAGMA_STATIC_FRAMES      },
     { "static_locals",          PRAGMA_STATIC_LOCALS      },
     { "warn",                   PRAGMA_WARN               },
     { "wrapped-call",           PRAGMA_WRAPPED_CALL       },
@@ -919,6 +925,10 @@ static void ParsePragmaString (StrBuf* B)
             FlagPragma (PES_STMT, Pragma, B, &EagerlyInlineFuncs);
             break;
 
+        case PRAGMA_AUTO_REGISTER_VARS:
+            FlagPragma (PES_FUNC, Pragma, B, &AutoRegVars);
+            break;
+
         case PRAGMA_BSS_NAME:
             /* TODO: PES_STMT or even PES_EXPR (PES_DECL) maybe? */
             SegNamePragma (PES_FUNC, PRAGMA_BSS_NAME, B);
@@ -988,6 +998,10 @@ static void ParsePragmaString (StrBuf* B)
             FlagPragma (PES_FUNC, Pragma, B, &SignedChars);
             break;
 
+        case PRAGMA_STATIC_FRAMES:
+            FlagPragma (PES_FUNC, Pragma, B, &StaticFrames);
+            break;
+
         case PRAGMA_STATIC_LOCALS:
             /* TODO: PES_STMT or even PES_EXPR (PES_DECL) maybe? */
             FlagPragma (PES_FUNC, Pragma, B, &StaticLocals);
@@ -0,0 +1,844 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                regalloc.c                                 */
+/*                                                                           */
+/*            Automatic allocation of locals in the register bank            */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <string.h>
+
+/* common */
+#include "check.h"
+#include "coll.h"
+#include "xmalloc.h"
+#include "xsprintf.h"
+
+/* cc65 */
+#include "codeent.h"
+#include "codeinfo.h"
+#include "codeseg.h"
+#include "datatype.h"
+#include "error.h"
+#include "funcdesc.h"
+#include "regalloc.h"
+#include "reginfo.h"
+#include "segments.h"
+#include "symentry.h"
+#include "symtab.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* The weight of an access is multiplied by this for each enclosing loop */
+#define LOOP_WEIGHT     8UL
+
+/* Deeper loops don't increase the weight any further */
+#define MAX_LOOP_DEPTH  4U
+
+/* A variable that may be moved into the register bank */
+typedef struct RegCand RegCand;
+struct RegCand {
+    SymEntry*       Sym;                /* The variable */
+    int             Offs;               /* Offset in the stack frame */
+    unsigned        Size;               /* Size of the variable */
+    unsigned long   Weight;             /* Accesses weighted by loop depth */
+    unsigned        First;              /* First insn of the live range */
+    unsigned        Last;               /* Last insn of the live range */
+    unsigned char   Init;               /* Has a value when the body starts */
+    unsigned char   Bad;                /* Cannot be moved */
+    int             Reg;                /* Offset in the register bank or -1 */
+    RegCand*        Owner;              /* Candidate owning the register */
+};
+
+/* A loop, or anything else that a backward jump may repeat */
+typedef struct RegLoop RegLoop;
+struct RegLoop {
+    unsigned        Start;              /* Index of the jump target */
+    unsigned        End;                /* Index of the jump */
+};
+
+/* Inserts new code */
+typedef struct RegEmitter RegEmitter;
+struct RegEmitter {
+    CodeSeg*        S;                  /* The code */
+    unsigned        Pos;                /* Insert position */
+    LineInfo*       LI;                 /* Line info for the new code */
+    unsigned        Flags;              /* CEF_FRAME_* flags for the new code */
+    int             FrameSP;            /* Stack pointer for the new code */
+};
+
+
+
+/*****************************************************************************/
+/*                                  Helpers                                  */
+/*****************************************************************************/
+
+
+
+static int CanReplaceHelper (const StackFuncInfo* H)
+/* Return true if EmitRegAccess can replace a call to the runtime function */
+{
+    switch (H->Kind) {
+        case SFK_ADDEQ:
+        case SFK_LDAX:
+        case SFK_STAX:
+        case SFK_SUBEQ:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+
+
+static int GetAccess (const CodeEntry* E, int* Lo, unsigned* Size)
+/* Check an instruction that is tagged as a frame access. Return 1 and the
+** range of the frame in Lo/Size if it accesses a known part of the frame,
+** 0 if it accesses no variable, and -1 if it may access any variable.
+*/
+{
+    if (E->OPC == OP65_JSR) {
+
+        const StackFuncInfo* H = GetStackFuncInfo (E->Arg);
+        int Y;
+        if (H == 0) {
+            return -1;
+        }
+        if (H->Kind == SFK_LEAA || H->Kind == SFK_LEAAX) {
+            /* Variables whose address is used are no candidates */
+            return 0;
+        }
+        Y = H->Y >= 0? H->Y : E->RI->In.RegY;
+        if (Y < 0) {
+            return -1;
+        }
+        *Lo   = E->FrameSP + Y + H->Lo;
+        *Size = H->Size;
+        return 1;
+
+    } else if (E->AM == AM65_ZP_INDY && CE_IsArg (E, ARG_C_SP)) {
+
+        if (!RegValIsKnown (E->RI->In.RegY)) {
+            return -1;
+        }
+        *Lo   = E->FrameSP + E->RI->In.RegY;
+        *Size = 1;
+        return 1;
+
+    } else {
+
+        /* Loads of offsets or of the stack pointer */
+        return 0;
+
+    }
+}
+
+
+
+static int Overlaps (const RegCand* C, int Lo, unsigned Size)
+/* Return true if the variable overlaps the given range of the frame */
+{
+    return C->Offs < Lo + (int) Size && Lo < C->Offs + (int) C->Size;
+}
+
+
+
+static unsigned long GetWeight (unsigned Depth)
+/* Return the weight of an access in the given loop depth */
+{
+    unsigned long Weight = 1;
+    if (Depth > MAX_LOOP_DEPTH) {
+        Depth = MAX_LOOP_DEPTH;
+    }
+    while (Depth--) {
+        Weight *= LOOP_WEIGHT;
+    }
+    return Weight;
+}
+
+
+
+static void CollectCands (const Function* F, Collection* Cands)
+/* Collect the parameters and top level locals that may be moved */
+{
+    SymEntry* Sym = F->Desc->SymTab->SymHead;
+    while (Sym) {
+        if ((Sym->Flags & (SC_STORAGEMASK | SC_TYPEMASK)) == (SC_AUTO | SC_NONE) &&
+            (Sym->Flags & (SC_ADDRTAKEN | SC_FICTITIOUS)) == 0                   &&
+            (IsClassInt (Sym->Type) || IsClassPtr (Sym->Type))                   &&
+            !IsQualVolatile (Sym->Type)                                          &&
+            Sym->V.Offs >= F->TopLevelSP) {
+
+            unsigned Size = SizeOf (Sym->Type);
+            if ((Size == 1 || Size == 2) &&
+                Sym->V.Offs - F->TopLevelSP + Size <= 0x100) {
+                RegCand* C = xmalloc (sizeof (RegCand));
+                C->Sym    = Sym;
+                C->Offs   = Sym->V.Offs;
+                C->Size   = Size;
+                C->Weight = 0;
+                C->First  = 0;
+                C->Last   = 0;
+                C->Init   = (Sym->Flags & SC_PARAM) != 0;
+                C->Bad    = 0;
+                C->Reg    = -1;
+                C->Owner  = 0;
+                CollAppend (Cands, C);
+            }
+        }
+        Sym = Sym->NextSym;
+    }
+}
+
+
+
+static void AddLoop (Collection* Loops, unsigned* Depth, unsigned Start, unsigned End)
+/* Remember a backward jump from End to Start */
+{
+    RegLoop* L = xmalloc (sizeof (RegLoop));
+    L->Start = Start;
+    L->End   = End;
+    CollAppend (Loops, L);
+    ++Depth[Start];
+    --Depth[End+1];
+}
+
+
+
+static int FindLoops (CodeSeg* S, unsigned Body, unsigned Exit,
+                      Collection* Loops, unsigned* Depth)
+/* Find all backward jumps in the body and set the loop depth of the body
+** insns. Return false if the control flow cannot be analyzed.
+*/
+{
+    unsigned I;
+    unsigned Count = 0;
+
+    /* Nobody may jump to the start of the body from outside */
+    if (Body < Exit) {
+        CodeEntry* E = CS_GetEntry (S, Body);
+        for (I = 0; I < CE_GetLabelCount (E); ++I) {
+            const CodeLabel* L = CE_GetLabel (E, I);
+            unsigned J;
+            for (J = 0; J < CollCount (&L->JumpFrom); ++J) {
+                CodeEntry* From = CollAtUnchecked (&L->JumpFrom, J);
+                if (CS_GetEntryIndex (S, From) < Body) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    for (I = Body; I < Exit; ++I) {
+        CodeEntry* E = CS_GetEntry (S, I);
+        if ((E->Flags & CEF_JUMPTABLE) != 0) {
+            const JumpTable* T = CS_GetJumpTable (E);
+            unsigned J;
+            for (J = 0; J < CollCount (&T->Labels); ++J) {
+                const CodeLabel* L = CollConstAt (&T->Labels, J);
+                unsigned Target;
+                if (L->Owner == 0) {
+                    return 0;
+                }
+                Target = CS_GetEntryIndex (S, L->Owner);
+                if (Target < Body) {
+                    return 0;
+                } else if (Target <= I) {
+                    AddLoop (Loops, Depth, Target, I);
+                }
+            }
+        } else if (E->JumpTo != 0) {
+            unsigned Target;
+            if (E->JumpTo->Owner == 0) {
+                return 0;
+            }
+            Target = CS_GetEntryIndex (S, E->JumpTo->Owner);
+            if (Target < Body) {
+                return 0;
+            } else if (Target <= I) {
+                AddLoop (Loops, Depth, Target, I);
+            }
+        } else if ((E->Info & OF_BRA) != 0) {
+            /* Jump to an unknown location */
+            return 0;
+        }
+    }
+
+    /* Turn the differences into depths */
+    for (I = Body; I < Exit; ++I) {
+        Count += Depth[I];
+        Depth[I] = Count;
+    }
+    return 1;
+}
+
+
+
+static int ScanCode (CodeSeg* S, unsigned Body, unsigned Exit,
+                     const unsigned* Depth, Collection* Cands)
+/* Count the weighted accesses of the candidates in the body and find the
+** ones that have a value when the body starts. Return false if the code
+** may access the variables in an unknown way.
+*/
+{
+    unsigned I, J;
+
+    for (I = 0; I < Exit; ++I) {
+
+        const CodeEntry* E = CS_GetEntry (S, I);
+        int Lo;
+        unsigned Size;
+        int Res;
+
+        if (I < Body && (E->Flags & CEF_FRAME_PUSH) != 0) {
+            /* Initialization of a local by pushing it */
+            for (J = 0; J < CollCount (Cands); ++J) {
+                RegCand* C = CollAtUnchecked (Cands, J);
+                if (Overlaps (C, E->FrameSP, 4)) {
+                    C->Init = 1;
+                }
+            }
+            continue;
+        }
+        if ((E->Flags & CEF_FRAME_ACCESS) == 0) {
+            continue;
+        }
+
+        Res = GetAccess (E, &Lo, &Size);
+        if (Res < 0) {
+            if (I >= Body) {
+                return 0;
+            }
+            for (J = 0; J < CollCount (Cands); ++J) {
+                ((RegCand*) CollAtUnchecked (Cands, J))->Init = 1;
+            }
+            continue;
+        } else if (Res == 0) {
+            continue;
+        }
+
+        for (J = 0; J < CollCount (Cands); ++J) {
+            RegCand* C = CollAtUnchecked (Cands, J);
+            if (!Overlaps (C, Lo, Size)) {
+                continue;
+            }
+            if (I < Body) {
+                C->Init = 1;
+                continue;
+            }
+            if (E->OPC == OP65_JSR) {
+                /* Runtime functions must access the whole variable */
+                if (!CanReplaceHelper (GetStackFuncInfo (E->Arg)) ||
+                    C->Offs != Lo || C->Size != Size) {
+                    C->Bad = 1;
+                    continue;
+                }
+            }
+            if (C->Weight == 0) {
+                C->First = I;
+            }
+            C->Weight += GetWeight (Depth[I]);
+            C->Last = I;
+        }
+    }
+    return 1;
+}
+
+
+
+static void ExtendLiveRanges (Collection* Cands, unsigned Body, const Collection* Loops)
+/* Set the live ranges of the candidates. A variable that is used in a loop
+** may carry its value around the loop, so it is live in all of it.
+*/
+{
+    unsigned I, J;
+
+    for (I = 0; I < CollCount (Cands); ++I) {
+        RegCand* C = CollAtUnchecked (Cands, I);
+        int Changed;
+        if (C->Init) {
+            C->First = Body;
+        }
+        do {
+            Changed = 0;
+            for (J = 0; J < CollCount (Loops); ++J) {
+                const RegLoop* L = CollConstAt (Loops, J);
+                if (L->Start <= C->Last && C->First <= L->End &&
+                    (L->Start < C->First || C->Last < L->End)) {
+                    if (L->Start < C->First) {
+                        C->First = L->Start;
+                    }
+                    if (C->Last < L->End) {
+                        C->Last = L->End;
+                    }
+                    Changed = 1;
+                }
+            }
+        } while (Changed);
+    }
+}
+
+
+
+static int CmpCand (void* Data attribute ((unused)),
+                    const void* Left, const void* Right)
+/* Compare function for CollSort: Sort by the weight per byte */
+{
+    const RegCand* L = Left;
+    const RegCand* R = Right;
+    unsigned long LW = L->Weight * R->Size;
+    unsigned long RW = R->Weight * L->Size;
+    if (LW != RW) {
+        return LW < RW? 1 : -1;
+    }
+    return R->Offs - L->Offs;
+}
+
+
+
+static int CanShare (const Collection* Cands, const RegCand* C, const RegCand* Owner)
+/* Return true if C may use the register of Owner */
+{
+    unsigned I;
+
+    /* C must not have a value before it is used first. The swap code at
+    ** the start only saves the variable of the owner.
+    */
+    if (C->Init || C->Size > Owner->Size) {
+        return 0;
+    }
+
+    /* The live ranges of all users of the register must be disjoint */
+    for (I = 0; I < CollCount (Cands); ++I) {
+        const RegCand* D = CollConstAt (Cands, I);
+        if ((D == Owner || D->Owner == Owner) &&
+            D->First <= C->Last && C->First <= D->Last) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+
+static int SelectCands (Function* F, const CodeSeg* S, Collection* Cands)
+/* Assign registers to the candidates that are used often enough. Return
+** the number of registers that have been assigned.
+*/
+{
+    unsigned I, J;
+    unsigned long Limit;
+    unsigned      Factor = S->CodeSizeFactor > 0? S->CodeSizeFactor : 1;
+    int           Count = 0;
+
+    /* Saving and restoring the register bank costs about as much as eight
+    ** stack accesses, less if larger code is acceptable.
+    */
+    Limit = LOOP_WEIGHT * 100 / Factor;
+    if (Limit == 0) {
+        Limit = 1;
+    }
+
+    CollSort (Cands, CmpCand, 0);
+    for (I = 0; I < CollCount (Cands); ++I) {
+
+        RegCand* C = CollAtUnchecked (Cands, I);
+        if (C->Bad || C->Weight < Limit) {
+            continue;
+        }
+
+        /* Try to share the register of a variable with a disjoint live range */
+        for (J = 0; J < I; ++J) {
+            RegCand* Owner = CollAtUnchecked (Cands, J);
+            if (Owner->Reg >= 0 && Owner->Owner == 0 && CanShare (Cands, C, Owner)) {
+                C->Reg   = Owner->Reg;
+                C->Owner = Owner;
+                break;
+            }
+        }
+
+        /* Otherwise take a free register */
+        if (C->Reg < 0 && F->RegOffs >= C->Size) {
+            F->RegOffs -= C->Size;
+            C->Reg = F->RegOffs;
+            ++Count;
+        }
+    }
+    return Count;
+}
+
+
+
+static const RegCand* FindCand (const Collection* Cands, int Lo, unsigned Size)
+/* Return the candidate with a register that overlaps the given range */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (Cands); ++I) {
+        const RegCand* C = CollConstAt (Cands, I);
+        if (C->Reg >= 0 && Overlaps (C, Lo, Size)) {
+            return C;
+        }
+    }
+    return 0;
+}
+
+
+
+static CodeEntry* Emit (RegEmitter* C, opc_t OPC, am_t AM, const char* Arg)
+/* Insert a new instruction */
+{
+    CodeEntry* X = NewCodeEntry (OPC, AM, Arg, 0, C->LI);
+    X->Flags   |= C->Flags;
+    X->FrameSP  = C->FrameSP;
+    CS_InsertEntry (C->S, X, C->Pos++);
+    return X;
+}
+
+
+
+static void EmitImpl (RegEmitter* C, opc_t OPC)
+/* Insert an instruction without an argument */
+{
+    Emit (C, OPC, AM65_IMP, 0);
+}
+
+
+
+static void EmitImm (RegEmitter* C, opc_t OPC, unsigned Val)
+/* Insert an instruction with an immediate argument */
+{
+    char Buf[16];
+    xsprintf (Buf, sizeof (Buf), "$%02X", Val & 0xFF);
+    Emit (C, OPC, AM65_IMM, Buf);
+}
+
+
+
+static void EmitReg (RegEmitter* C, opc_t OPC, int Reg)
+/* Insert an instruction that accesses the register bank */
+{
+    char Buf[32];
+    xsprintf (Buf, sizeof (Buf), "regbank%+d", Reg);
+    Emit (C, OPC, AM65_ZP, Buf);
+}
+
+
+
+static void EmitStack (RegEmitter* C, opc_t OPC)
+/* Insert an instruction that accesses the stack at offset Y */
+{
+    Emit (C, OPC, AM65_ZP_INDY, "c_sp");
+}
+
+
+
+static void EmitAccess (RegEmitter* C, const CodeEntry* E, int Reg)
+/* Insert the replacement for an access of a variable that has been moved
+** into the register bank at Reg.
+*/
+{
+    const StackFuncInfo* H;
+    int Y;
+
+    if (E->OPC != OP65_JSR) {
+        EmitReg (C, E->OPC, Reg);
+        return;
+    }
+
+    /* The runtime functions leave Y pointing to the last byte accessed */
+    H = GetStackFuncInfo (E->Arg);
+    Y = H->Y >= 0? H->Y : E->RI->In.RegY;
+    switch (H->Kind) {
+
+        case SFK_LDAX:
+            EmitImm (C, OP65_LDY, Y - 1);
+            EmitReg (C, OP65_LDX, Reg + 1);
+            EmitReg (C, OP65_LDA, Reg);
+            break;
+
+        case SFK_STAX:
+            EmitImm (C, OP65_LDY, Y + 1);
+            EmitReg (C, OP65_STA, Reg);
+            EmitReg (C, OP65_STX, Reg + 1);
+            break;
+
+        case SFK_ADDEQ:
+        case SFK_SUBEQ:
+            EmitImm (C, OP65_LDY, Y + 1);
+            if (H->Kind == SFK_ADDEQ) {
+                EmitImpl (C, OP65_CLC);
+            } else {
+                EmitImpl (C, OP65_SEC);
+                EmitImm (C, OP65_EOR, 0xFF);
+            }
+            EmitReg (C, OP65_ADC, Reg);
+            EmitReg (C, OP65_STA, Reg);
+            EmitImpl (C, OP65_PHA);
+            EmitImpl (C, OP65_TXA);
+            if (H->Kind == SFK_SUBEQ) {
+                EmitImm (C, OP65_EOR, 0xFF);
+            }
+            EmitReg (C, OP65_ADC, Reg + 1);
+            EmitReg (C, OP65_STA, Reg + 1);
+            EmitImpl (C, OP65_TAX);
+            EmitImpl (C, OP65_PLA);
+            break;
+
+        default:
+            Internal ("Unexpected runtime function '%s'", E->Arg);
+
+    }
+}
+
+
+
+static unsigned RewriteBody (CodeSeg* S, unsigned Body, unsigned Exit,
+                             const Collection* Cands)
+/* Replace the accesses of the variables that have been moved into the
+** register bank. Return the new index of the exit code.
+*/
+{
+    RegEmitter C;
+    unsigned   I = Exit;
+
+    C.S       = S;
+    C.Flags   = 0;
+    C.FrameSP = 0;
+
+    while (I-- > Body) {
+
+        CodeEntry*      E = CS_GetEntry (S, I);
+        const RegCand*  Cand;
+        int             Lo;
+        unsigned        Size;
+        unsigned        Count;
+
+        if ((E->Flags & CEF_FRAME_ACCESS) == 0 || GetAccess (E, &Lo, &Size) <= 0) {
+            continue;
+        }
+        Cand = FindCand (Cands, Lo, Size);
+        if (Cand == 0) {
+            continue;
+        }
+
+        /* Insert the new code behind the old one, then remove the old one */
+        Count = CS_GetEntryCount (S);
+        C.Pos = I + 1;
+        C.LI  = E->LI;
+        EmitAccess (&C, E, Cand->Reg + (Lo - Cand->Offs));
+        CS_DelEntry (S, I);
+        Exit += CS_GetEntryCount (S) - Count;
+    }
+
+    return Exit;
+}
+
+
+
+static void InsertSwap (CodeSeg* S, unsigned Pos, int SP,
+                        const Collection* Cands)
+/* Insert the code that swaps the variables with the register bank. The old
+** contents of the registers are saved in the stack locations of the
+** variables.
+*/
+{
+    RegEmitter C;
+    unsigned   I;
+
+    C.S       = S;
+    C.Pos     = Pos;
+    C.LI      = CS_GetEntry (S, Pos)->LI;
+    C.Flags   = CEF_FRAME_ACCESS;
+    C.FrameSP = SP;
+
+    for (I = 0; I < CollCount (Cands); ++I) {
+        const RegCand* Cand = CollConstAt (Cands, I);
+        if (Cand->Reg < 0 || Cand->Owner != 0) {
+            continue;
+        }
+        EmitImm (&C, OP65_LDY, Cand->Offs - SP);
+        if (Cand->Size == 1 && S->CodeSizeFactor >= 165) {
+            EmitStack (&C, OP65_LDA);
+            EmitReg (&C, OP65_LDX, Cand->Reg);
+            EmitReg (&C, OP65_STA, Cand->Reg);
+            EmitImpl (&C, OP65_TXA);
+            EmitStack (&C, OP65_STA);
+        } else {
+            EmitImm (&C, OP65_LDX, Cand->Reg);
+            Emit (&C, OP65_JSR, AM65_ABS, Cand->Size == 1? "regswap1" : "regswap2");
+        }
+    }
+}
+
+
+
+static void InsertRestore (CodeSeg* S, unsigned Pos, int SP, int SaveA,
+                           const Collection* Cands)
+/* Insert the code that restores the register bank at the function exit.
+** A and X are preserved.
+*/
+{
+    RegEmitter  C;
+    CodeEntry*  Exit = CS_GetEntry (S, Pos);
+    unsigned    I;
+
+    C.S       = S;
+    C.Pos     = Pos;
+    C.LI      = Exit->LI;
+    C.Flags   = CEF_FRAME_ACCESS;
+    C.FrameSP = SP;
+
+    if (SaveA) {
+        EmitImpl (&C, OP65_PHA);
+    }
+    for (I = 0; I < CollCount (Cands); ++I) {
+        const RegCand* Cand = CollConstAt (Cands, I);
+        if (Cand->Reg < 0 || Cand->Owner != 0) {
+            continue;
+        }
+        EmitImm (&C, OP65_LDY, Cand->Offs - SP);
+        EmitStack (&C, OP65_LDA);
+        EmitReg (&C, OP65_STA, Cand->Reg);
+        if (Cand->Size == 2) {
+            EmitImpl (&C, OP65_INY);
+            EmitStack (&C, OP65_LDA);
+            EmitReg (&C, OP65_STA, Cand->Reg + 1);
+        }
+    }
+    if (SaveA) {
+        EmitImpl (&C, OP65_PLA);
+    }
+
+    /* Jumps to the exit code must execute the new code */
+    CS_MoveLabels (S, Exit, CS_GetEntry (S, Pos));
+}
+
+
+
+static void AddNotes (CodeSeg* S, const Collection* Cands)
+/* Record the decisions for the candidates in the function header */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (Cands); ++I) {
+        const RegCand* C = CollConstAt (Cands, I);
+        if (C->Weight == 0) {
+            continue;
+        }
+        if (C->Reg < 0) {
+            CS_AddNote (S, "%s: stack, weight %lu", C->Sym->Name, C->Weight);
+        } else if (C->Owner == 0) {
+            CS_AddNote (S, "%s: regbank%+d, weight %lu",
+                        C->Sym->Name, C->Reg, C->Weight);
+        } else {
+            CS_AddNote (S, "%s: regbank%+d, weight %lu, shared with %s",
+                        C->Sym->Name, C->Reg, C->Weight, C->Owner->Sym->Name);
+        }
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void AllocAutoRegVars (Function* F, const CodeMark* Body, const CodeMark* Exit,
+                       int RestoreOnExit)
+/* Move the most used parameters and top level locals of F into the part of
+** the register bank that is still free. Body marks the first instruction of
+** the function body, Exit the first instruction behind the return label.
+** Accesses are weighted by the loop depth, and variables whose live ranges
+** don't overlap share a register. If RestoreOnExit is false, the old
+** contents of the register bank aren't restored (see main). The decisions
+** are output as comments in the function header.
+*/
+{
+    CodeSeg*    S = CS->Code;
+    Collection  Cands = AUTO_COLLECTION_INITIALIZER;
+    Collection  Loops = AUTO_COLLECTION_INITIALIZER;
+    unsigned*   Depth;
+    unsigned    ExitPos;
+    unsigned    I;
+
+    /* Check if the function qualifies */
+    if (!S->AutoRegVars || ErrorCount > 0 || F_IsVariadic (F) ||
+        F->RegOffs == 0 || Exit->Pos >= CS_GetEntryCount (S)) {
+        return;
+    }
+    CHECK (Body->Pos <= Exit->Pos);
+
+    /* Get the variables that may be moved */
+    CollectCands (F, &Cands);
+    if (CollCount (&Cands) == 0) {
+        DoneCollection (&Cands);
+        return;
+    }
+
+    /* Analyze the control flow. The labels are merged first, as it is done
+    ** before the optimizer runs, so each label is referenced.
+    */
+    CS_MergeLabels (S);
+    Depth = xmalloc ((Exit->Pos + 1) * sizeof (Depth[0]));
+    memset (Depth, 0, (Exit->Pos + 1) * sizeof (Depth[0]));
+    if (FindLoops (S, Body->Pos, Exit->Pos, &Loops, Depth)) {
+
+        /* Analyze the accesses */
+        CS_GenRegInfo (S);
+        if (ScanCode (S, Body->Pos, Exit->Pos, Depth, &Cands)) {
+
+            ExtendLiveRanges (&Cands, Body->Pos, &Loops);
+            if (SelectCands (F, S, &Cands) > 0) {
+
+                /* Change the code, starting at the end */
+                ExitPos = RewriteBody (S, Body->Pos, Exit->Pos, &Cands);
+                if (RestoreOnExit) {
+                    InsertRestore (S, ExitPos, Exit->SP,
+                                   !F_HasVoidReturn (F), &Cands);
+                }
+                InsertSwap (S, Body->Pos, Body->SP, &Cands);
+            }
+            AddNotes (S, &Cands);
+        }
+        CS_FreeRegInfo (S);
+    }
+
+    /* Free the data */
+    xfree (Depth);
+    for (I = 0; I < CollCount (&Loops); ++I) {
+        xfree (CollAtUnchecked (&Loops, I));
+    }
+    DoneCollection (&Loops);
+    for (I = 0; I < CollCount (&Cands); ++I) {
+        xfree (CollAtUnchecked (&Cands, I));
+    }
+    DoneCollection (&Cands);
+}
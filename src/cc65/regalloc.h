@@ -0,0 +1,62 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                regalloc.h                                 */
+/*                                                                           */
+/*            Automatic allocation of locals in the register bank            */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+
+
+/* cc65 */
+#include "asmcode.h"
+#include "function.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void AllocAutoRegVars (Function* F, const CodeMark* Body, const CodeMark* Exit,
+                       int RestoreOnExit);
+/* Move the most used parameters and top level locals of F into the part of
+** the register bank that is still free. Body marks the first instruction of
+** the function body, Exit the first instruction behind the return label.
+** Accesses are weighted by the loop depth, and variables whose live ranges
+** don't overlap share a register. If RestoreOnExit is false, the old
+** contents of the register bank aren't restored (see main). The decisions
+** are output as comments in the function header.
+*/
+
+
+
+/* End of regalloc.h */
+
+#endif
@@ -83,6 +83,23 @@ void RC_InvalidatePS (RegContents* C)
 
 
 
+int RC_IsEqual (const RegContents* A, const RegContents* B)
+/* Return true if both register contents are identical */
+{
+    return A->RegA   == B->RegA   &&
+           A->RegX   == B->RegX   &&
+           A->RegY   == B->RegY   &&
+           A->SRegLo == B->SRegLo &&
+           A->SRegHi == B->SRegHi &&
+           A->Ptr1Lo == B->Ptr1Lo &&
+           A->Ptr1Hi == B->Ptr1Hi &&
+           A->Tmp1   == B->Tmp1   &&
+           A->PFlags == B->PFlags &&
+           A->ZNRegs == B->ZNRegs;
+}
+
+
+
 static void RC_Dump1 (FILE* F, const char* Desc, short Val)
 /* Dump one register value */
 {
@@ -134,6 +151,10 @@ RegInfo* NewRegInfo (const RegContents* RC)
         RC_InvalidatePS (&RI->Out2);
     }
 
+    /* The info is not yet bound to an instruction */
+    RI->Run = 0;
+    RI->Arg = 0;
+
     /* Return the new struct */
     return RI;
 }
@@ -42,6 +42,16 @@
 
 
 
+/*****************************************************************************/
+/*                                 Forwards                                  */
+/*****************************************************************************/
+
+
+
+struct CodeArg;
+
+
+
 /*****************************************************************************/
 /*                                   Data                                    */
 /*****************************************************************************/
@@ -135,6 +145,25 @@ struct RegInfo {
     RegContents In;             /* Incoming register values */
     RegContents Out;            /* Outgoing register values */
     RegContents Out2;           /* Alternative outgoing reg values for branches */
+
+    /* The instruction the info was generated for. CS_GenRegInfo keeps the
+    ** info of an instruction as long as neither the instruction nor its
+    ** incoming register values change.
+    */
+    unsigned long   Run;        /* Last run of CS_GenRegInfo that visited it */
+    const struct CodeArg* Arg;  /* Argument, NULL if the info is not valid */
+    unsigned long   Num;        /* Numeric argument */
+    unsigned        Use;        /* Registers used */
+    unsigned        Chg;        /* Registers changed */
+    unsigned short  Info;       /* Opcode info */
+    unsigned char   OPC;        /* Opcode */
+    unsigned char   AM;         /* Addressing mode */
+    unsigned char   NumArg;     /* True if the argument is numeric */
+    unsigned char   Labels;     /* True if the instruction has labels */
+    unsigned char   PrevOPC;    /* Previous insn, for branches on zero flag */
+    unsigned char   PrevAM;
+    unsigned char   PrevNumArg;
+    unsigned long   PrevNum;
 };
 
 
@@ -154,6 +183,9 @@ void RC_InvalidateZP (RegContents* C);
 void RC_InvalidatePS (RegContents* C);
 /* Invalidate processor status */
 
+int RC_IsEqual (const RegContents* A, const RegContents* B);
+/* Return true if both register contents are identical */
+
 void RC_Dump (FILE* F, const RegContents* RC);
 /* Dump the contents of the given RegContents struct */
 
@@ -43,6 +43,7 @@
 /* cc65 */
 #include "asmcode.h"
 #include "asmlabel.h"
+#include "codeent.h"
 #include "codegen.h"
 #include "error.h"
 #include "funcdesc.h"
@@ -225,6 +226,7 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
     unsigned ParamSize = 0;
     unsigned Label;
     int      Offs;
+    CodeMark Start;
 
     /* Argument #1 */
     ParseArg (&Arg1, Arg1Type, Expr);
@@ -360,6 +362,7 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code */
             RemoveCode (&Arg1.Expr.Start);
+            GetCodePos (&Start);
 
             /* We need a label */
             Label = GetLocalLabel ();
@@ -409,6 +412,9 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             }
 
+            /* The code accesses the stack frame */
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
+
             /* memcpy returns the address, so the result is actually identical
             ** to the first argument.
             */
@@ -438,6 +444,7 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code */
             RemoveCode (&Arg1.Expr.Start);
+            GetCodePos (&Start);
 
             /* We need a label */
             Label = GetLocalLabel ();
@@ -487,6 +494,9 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             }
 
+            /* The code accesses the stack frame */
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
+
             /* memcpy returns the address, so the result is actually identical
             ** to the first argument.
             */
@@ -502,6 +512,7 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code but leave the load of the first argument*/
             RemoveCode (&Arg1.Push);
+            GetCodePos (&Start);
 
             /* We need a label */
             Label = GetLocalLabel ();
@@ -526,6 +537,9 @@ static void StdFunc_memcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
                 AddCodeLine ("bne %s", LocalLabelName (Label));
             }
 
+            /* The code accesses the stack frame */
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
+
             /* Reload result - X hasn't changed by the code above */
             AddCodeLine ("lda ptr1");
 
@@ -567,6 +581,7 @@ static void StdFunc_memset (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
     int      MemSet    = 1;             /* Use real memset if true */
     unsigned ParamSize = 0;
     unsigned Label;
+    CodeMark Start;
 
     /* Argument #1 */
     ParseArg (&Arg1, Arg1Type, Expr);
@@ -695,6 +710,7 @@ static void StdFunc_memset (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code */
             RemoveCode (&Arg1.Expr.Start);
+            GetCodePos (&Start);
 
             /* We need a label */
             Label = GetLocalLabel ();
@@ -707,6 +723,7 @@ static void StdFunc_memset (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
             AddCodeLine ("iny");
             AddCmpCodeIfSizeNot256 ("cpy #$%02X", Offs + Arg3.Expr.IVal);
             AddCodeLine ("bne %s", LocalLabelName (Label));
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
 
             /* memset returns the address, so the result is actually identical
             ** to the first argument.
@@ -793,6 +810,7 @@ static void StdFunc_strcmp (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
     long     ECount2;
     int      IsArray;
     int      Offs;
+    CodeMark Start;
 
     /* Argument #1 */
     ParseArg (&Arg1, Arg1Type, Expr);
@@ -853,11 +871,13 @@ static void StdFunc_strcmp (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
                 (Offs = ED_GetStackOffs (&Arg1.Expr, 0) < 256)) {
                 /* Drop the generated code */
                 RemoveCode (&Arg1.Load);
+                GetCodePos (&Start);
 
                 /* Generate code */
                 AddCodeLine ("ldy #$%02X", Offs);
                 AddCodeLine ("ldx #$00");
                 AddCodeLine ("lda (c_sp),y");
+                MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
             } else if (IsArray && ED_IsLocConst (&Arg1.Expr)) {
                 /* Drop the generated code */
                 RemoveCode (&Arg1.Load);
@@ -989,6 +1009,7 @@ static void StdFunc_strcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
     unsigned ParamSize = 0;
     long     ECount;
     unsigned L1;
+    CodeMark Start;
 
     /* Argument #1 */
     ParseArg (&Arg1, Arg1Type, Expr);
@@ -1081,6 +1102,7 @@ static void StdFunc_strcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code */
             RemoveCode (&Arg1.Expr.Start);
+            GetCodePos (&Start);
 
             /* We need labels */
             L1 = GetLocalLabel ();
@@ -1101,6 +1123,7 @@ static void StdFunc_strcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
                 AddCodeLine ("sta %s,x", ED_GetLabelName (&Arg1.Expr, 0));
             }
             AddCodeLine ("bne %s", LocalLabelName (L1));
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
 
             /* strcpy returns argument #1 */
             *Expr = Arg1.Expr;
@@ -1128,6 +1151,7 @@ static void StdFunc_strcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
 
             /* Drop the generated code */
             RemoveCode (&Arg1.Expr.Start);
+            GetCodePos (&Start);
 
             /* We need labels */
             L1 = GetLocalLabel ();
@@ -1148,6 +1172,7 @@ static void StdFunc_strcpy (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
                 AddCodeLine ("sta (c_sp),y");
             }
             AddCodeLine ("bne %s", LocalLabelName (L1));
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
 
             /* strcpy returns argument #1 */
             *Expr = Arg1.Expr;
@@ -1184,6 +1209,7 @@ static void StdFunc_strlen (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
     int         IsByteIndex;
     long        ECount;
     unsigned    L;
+    CodeMark    Start;
 
     ED_Init (&Arg);
     Arg.Flags |= Expr->Flags & E_MASK_KEEP_SUBEXPR;
@@ -1279,6 +1305,7 @@ static void StdFunc_strlen (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
             int Offs = ED_GetStackOffs (&Arg, 0);
 
             /* Generate the strlen code */
+            GetCodePos (&Start);
             L = GetLocalLabel ();
             AddCodeLine ("ldx #$FF");
             AddCodeLine ("ldy #$%02X", (unsigned char) (Offs-1));
@@ -1289,6 +1316,7 @@ static void StdFunc_strlen (FuncDesc* F attribute ((unused)), ExprDesc* Expr)
             AddCodeLine ("bne %s", LocalLabelName (L));
             AddCodeLine ("txa");
             AddCodeLine ("ldx #$00");
+            MarkFrameCode (&Start, CEF_FRAME_ACCESS, StackPtr);
 
             /* The function result is an rvalue in the primary register */
             ED_FinalizeRValLoad (Expr);
@@ -43,6 +43,7 @@
 /* cc65 */
 #include "asmcode.h"
 #include "asmlabel.h"
+#include "codeent.h"
 #include "codegen.h"
 #include "datatype.h"
 #include "error.h"
@@ -143,6 +144,17 @@ static void SkipPending (int PendingToken)
 
 
 
+static void DropLocals (int SP)
+/* Drop the local variables below the stack pointer SP from the stack */
+{
+    CodeMark Start;
+    GetCodePos (&Start);
+    g_space (StackPtr - SP);
+    MarkFrameCode (&Start, CEF_FRAME_ADJUST, StackPtr);
+}
+
+
+
 /*****************************************************************************/
 /*                                   Code                                    */
 /*****************************************************************************/
@@ -454,7 +466,7 @@ static int ReturnStatement (void)
     F_ReturnFound (CurrentFunc);
 
     /* Cleanup the stack in case we're inside a block with locals */
-    g_space (StackPtr - F_GetTopLevelSP (CurrentFunc));
+    DropLocals (F_GetTopLevelSP (CurrentFunc));
 
     /* Output a jump to the function exit code */
     g_jump (F_GetRetLab (CurrentFunc));
@@ -484,7 +496,7 @@ static int BreakStatement (void)
     }
 
     /* Correct the stack pointer if needed */
-    g_space (StackPtr - L->StackPtr);
+    DropLocals (L->StackPtr);
 
     /* Jump to the exit label of the loop */
     g_jump (L->BreakLabel);
@@ -522,7 +534,7 @@ static int ContinueStatement (void)
     }
 
     /* Correct the stackpointer if needed */
-    g_space (StackPtr - L->StackPtr);
+    DropLocals (L->StackPtr);
 
     /* Jump to next loop iteration */
     g_jump (L->ContinueLabel);
@@ -700,7 +712,7 @@ static int CompoundStatement (int* PendingToken, struct SwitchCtrl* Switch)
 
     /* Clean up the stack if the codeflow may reach the end */
     if ((StmtFlags & SF_MASK_UNREACH) == SF_NONE) {
-        g_space (StackPtr - OldStack);
+        DropLocals (OldStack);
     }
 
     /* If the segment had autoinited variables, let's pop it of a stack
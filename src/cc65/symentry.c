@@ -152,6 +152,8 @@ void DumpSymEntry (FILE* F, const SymEntry* E)
         { "SC_GOTO_IND",    SC_GOTO_IND         },
         { "SC_LOCALSCOPE",  SC_LOCALSCOPE       },
         { "SC_NOINLINEDEF", SC_NOINLINEDEF      },
+        { "SC_INLINED",     SC_INLINED          },
+        { "SC_ADDRTAKEN",   SC_ADDRTAKEN        },
     };
 
     unsigned I;
@@ -223,10 +225,12 @@ int SymIsOutputFunc (const SymEntry* Sym)
 /* Return true if this is a function that must be output */
 {
     /* Symbol must be a function which is defined and either extern or
-    ** static and referenced.
+    ** static and referenced. Functions that were inlined into all callers
+    ** are not needed.
     */
     return IsTypeFunc (Sym->Type)                       &&
            SymIsDef (Sym)                               &&
+           (Sym->Flags & SC_INLINED) == 0               &&
            ((Sym->Flags & SC_REF) ||
             (Sym->Flags & SC_STORAGEMASK) != SC_STATIC);
 }
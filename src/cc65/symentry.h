@@ -154,6 +154,12 @@ struct CodeEntry;
 #define SC_INLINE       0x10000000U     /* Inline function */
 #define SC_NORETURN     0x20000000U     /* Noreturn function */
 
+/* Function status set by the optimizer */
+#define SC_INLINED      0x40000000U     /* Code was copied into all callers */
+
+/* Local variable status set by the parser */
+#define SC_ADDRTAKEN    0x80000000U     /* Address of the variable is used */
+
 
 
 /* Label definition or reference */
@@ -303,6 +309,16 @@ static inline int SymIsRegVar (const SymEntry* Sym)
     return ((Sym->Flags & (SC_STORAGEMASK | SC_TYPEMASK)) == (SC_REGISTER | SC_NONE));
 }
 
+static inline int SymIsLocalFunc (const SymEntry* Sym)
+/* Return true if the given entry is a function that is not visible outside
+** of the translation unit. An inline definition is handled like a static
+** function.
+*/
+{
+    return ((Sym->Flags & SC_STORAGEMASK) == SC_STATIC ||
+            (Sym->Flags & (SC_INLINE | SC_NOINLINEDEF)) == SC_INLINE);
+}
+
 static inline int SymHasFlexibleArrayMember (const SymEntry* Sym)
 /* Return true if the given entry has a flexible array member */
 {
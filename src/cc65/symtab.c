@@ -49,6 +49,7 @@
 #include "anonname.h"
 #include "asmcode.h"
 #include "asmlabel.h"
+#include "codeent.h"
 #include "codegen.h"
 #include "datatype.h"
 #include "declare.h"
@@ -1146,7 +1147,11 @@ SymEntry* AddLabelSym (const char* Name, unsigned Flags)
                 ** so we simply emit the SP adjustment code.
                 */
                 if (StackPtr != DOR->StackPtr) {
+                    CodeMark Start;
+                    GetCodePos (&Start);
                     g_space (StackPtr - DOR->StackPtr);
+                    MarkFrameCode (&Start, CEF_FRAME_ADJUST,
+                                   StackPtr < DOR->StackPtr? StackPtr : DOR->StackPtr);
                 }
 
                 /* Are we jumping into a block with initalization of an object that
@@ -1218,7 +1223,10 @@ SymEntry* AddLabelSym (const char* Name, unsigned Flags)
 
     /* We are processing a goto, but the label has not yet been defined */
     if (!SymIsDef (Entry) && (Flags & SC_REF) && (Flags & SC_GOTO)) {
+        CodeMark Start;
+        GetCodePos (&Start);
         g_lateadjustSP (NewDOR->LateSP_Label);
+        MarkFrameCode (&Start, CEF_FRAME_ADJUST, StackPtr);
     }
 
     /* Return the entry */
@@ -850,6 +850,7 @@ static void Usage (void)
             "  --asm-args options\t\tPass options to the assembler\n"
             "  --asm-define sym[=v]\t\tDefine an assembler symbol\n"
             "  --asm-include-dir dir\t\tSet an assembler include directory\n"
+            "  --auto-register-vars\t\tMove hot locals into the register bank\n"
             "  --bin-include-dir dir\t\tSet an assembler binary include directory\n"
             "  --bss-label name\t\tDefine and export a BSS segment label\n"
             "  --bss-name seg\t\tSet the name of the BSS segment\n"
@@ -872,6 +873,7 @@ static void Usage (void)
             "  --force-import sym\t\tForce an import of symbol 'sym'\n"
             "  --help\t\t\tHelp (this text)\n"
             "  --include-dir dir\t\tSet a compiler include directory path\n"
+            "  --jobs n\t\t\tOptimize functions on n threads\n"
             "  --ld-args options\t\tPass options to the linker\n"
             "  --lib-path path\t\tSpecify a library search path\n"
             "  --list-targets\t\tList all available targets\n"
@@ -893,6 +895,7 @@ static void Usage (void)
             "  --signed-chars\t\tDefault characters are signed\n"
             "  --standard std\t\tLanguage standard (c89, c99, cc65)\n"
             "  --start-addr addr\t\tSet the default start address\n"
+            "  --static-frames\t\tUse static stack frames where possible\n"
             "  --static-locals\t\tMake local variables static\n"
             "  --target sys\t\t\tSet the target system\n"
             "  --version\t\t\tPrint the version number\n"
@@ -947,6 +950,15 @@ static void OptAsmIncludeDir (const char* Opt attribute ((unused)), const char*
 
 
 
+static void OptAutoRegisterVars (const char* Opt attribute ((unused)),
+                                 const char* Arg attribute ((unused)))
+/* Move hot locals into the register bank */
+{
+    CmdAddArg (&CC65, "--auto-register-vars");
+}
+
+
+
 static void OptBinIncludeDir (const char* Opt attribute ((unused)), const char* Arg)
 /* Binary include directory (assembler) */
 {
@@ -1153,6 +1165,14 @@ static void OptIncludeDir (const char* Opt attribute ((unused)), const char* Arg
 
 
 
+static void OptJobs (const char* Opt attribute ((unused)), const char* Arg)
+/* Handle the --jobs option */
+{
+    CmdAddArg2 (&CC65, "--jobs", Arg);
+}
+
+
+
 static void OptLdArgs (const char* Opt attribute ((unused)), const char* Arg)
 /* Pass arguments to the linker */
 {
@@ -1374,6 +1394,15 @@ static void OptStartAddr (const char* Opt attribute ((unused)), const char* Arg)
 
 
 
+static void OptStaticFrames (const char* Opt attribute ((unused)),
+                             const char* Arg attribute ((unused)))
+/* Use static stack frames where possible */
+{
+    CmdAddArg (&CC65, "--static-frames");
+}
+
+
+
 static void OptStaticLocals (const char* Opt attribute ((unused)),
                              const char* Arg attribute ((unused)))
 /* Place local variables in static storage */
@@ -1468,6 +1497,7 @@ int main (int argc, char* argv [])
         { "--asm-args",            1, OptAsmArgs            },
         { "--asm-define",          1, OptAsmDefine          },
         { "--asm-include-dir",     1, OptAsmIncludeDir      },
+        { "--auto-register-vars",  0, OptAutoRegisterVars   },
         { "--bin-include-dir",     1, OptBinIncludeDir      },
         { "--bss-label",           1, OptBssLabel           },
         { "--bss-name",            1, OptBssName            },
@@ -1490,6 +1520,7 @@ int main (int argc, char* argv [])
         { "--force-import",        1, OptForceImport        },
         { "--help",                0, OptHelp               },
         { "--include-dir",         1, OptIncludeDir         },
+        { "--jobs",                1, OptJobs               },
         { "--ld-args",             1, OptLdArgs             },
         { "--lib-path",            1, OptLibPath            },
         { "--list-targets",        0, OptListTargets        },
@@ -1511,6 +1542,7 @@ int main (int argc, char* argv [])
         { "--signed-chars",        0, OptSignedChars        },
         { "--standard",            1, OptStandard           },
         { "--start-addr",          1, OptStartAddr          },
+        { "--static-frames",       0, OptStaticFrames       },
         { "--static-locals",       0, OptStaticLocals       },
         { "--target",              1, OptTarget             },
         { "--verbose",             0, OptVerbose            },
@@ -0,0 +1,190 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  thread.c                                 */
+/*                                                                           */
+/*                          Minimal thread support                           */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <process.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+/* common */
+#include "abend.h"
+#include "thread.h"
+#include "xmalloc.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+struct Thread {
+#if defined(_WIN32)
+    HANDLE              Handle;
+#else
+    pthread_t           Handle;
+#endif
+    ThreadFunc          Func;
+    void*               Data;
+};
+
+/* The global lock and the condition used by ThreadWait/ThreadNotify */
+#if defined(_WIN32)
+static SRWLOCK            Lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE Cond = CONDITION_VARIABLE_INIT;
+#else
+static pthread_mutex_t    Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t     Cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+#if defined(_WIN32)
+static unsigned __stdcall ThreadMain (void* Arg)
+#else
+static void* ThreadMain (void* Arg)
+#endif
+/* Entry point for all threads */
+{
+    Thread* T = Arg;
+    T->Func (T->Data);
+    return 0;
+}
+
+
+
+Thread* ThreadStart (ThreadFunc Func, void* Data)
+/* Start a new thread that calls Func with Data */
+{
+    Thread* T = xmalloc (sizeof (Thread));
+    T->Func = Func;
+    T->Data = Data;
+#if defined(_WIN32)
+    T->Handle = (HANDLE) _beginthreadex (0, 0, ThreadMain, T, 0, 0);
+    if (T->Handle == 0) {
+        AbEnd ("Cannot create thread");
+    }
+#else
+    if (pthread_create (&T->Handle, 0, ThreadMain, T) != 0) {
+        AbEnd ("Cannot create thread");
+    }
+#endif
+    return T;
+}
+
+
+
+void ThreadJoin (Thread* T)
+/* Wait until a thread has finished and free it */
+{
+#if defined(_WIN32)
+    WaitForSingleObject (T->Handle, INFINITE);
+    CloseHandle (T->Handle);
+#else
+    pthread_join (T->Handle, 0);
+#endif
+    xfree (T);
+}
+
+
+
+void ThreadLock (void)
+/* Acquire the global lock */
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive (&Lock);
+#else
+    pthread_mutex_lock (&Lock);
+#endif
+}
+
+
+
+void ThreadUnlock (void)
+/* Release the global lock */
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive (&Lock);
+#else
+    pthread_mutex_unlock (&Lock);
+#endif
+}
+
+
+
+void ThreadWait (void)
+/* Release the global lock, wait until another thread calls ThreadNotify,
+** then acquire the lock again. The caller must hold the lock.
+*/
+{
+#if defined(_WIN32)
+    SleepConditionVariableSRW (&Cond, &Lock, INFINITE, 0);
+#else
+    pthread_cond_wait (&Cond, &Lock);
+#endif
+}
+
+
+
+void ThreadNotify (void)
+/* Wake up all threads waiting in ThreadWait */
+{
+#if defined(_WIN32)
+    WakeAllConditionVariable (&Cond);
+#else
+    pthread_cond_broadcast (&Cond);
+#endif
+}
+
+
+
+unsigned ThreadCPUCount (void)
+/* Return the number of CPU cores of the host */
+{
+#if defined(_WIN32)
+    SYSTEM_INFO Info;
+    GetSystemInfo (&Info);
+    return Info.dwNumberOfProcessors;
+#else
+    long Count = sysconf (_SC_NPROCESSORS_ONLN);
+    return Count > 0 ? (unsigned) Count : 1;
+#endif
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  thread.h                                 */
+/*                                                                           */
+/*                          Minimal thread support                           */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+#ifndef THREAD_H
+#define THREAD_H
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Storage class for variables of which each thread has its own copy */
+#if defined(_MSC_VER)
+#  define THREAD_LOCAL  __declspec(thread)
+#else
+#  define THREAD_LOCAL  __thread
+#endif
+
+/* A running thread */
+typedef struct Thread Thread;
+
+/* Thread function */
+typedef void (*ThreadFunc) (void* Data);
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+Thread* ThreadStart (ThreadFunc Func, void* Data);
+/* Start a new thread that calls Func with Data */
+
+void ThreadJoin (Thread* T);
+/* Wait until a thread has finished and free it */
+
+void ThreadLock (void);
+/* Acquire the global lock */
+
+void ThreadUnlock (void);
+/* Release the global lock */
+
+void ThreadWait (void);
+/* Release the global lock, wait until another thread calls ThreadNotify,
+** then acquire the lock again. The caller must hold the lock.
+*/
+
+void ThreadNotify (void);
+/* Wake up all threads waiting in ThreadWait */
+
+unsigned ThreadCPUCount (void);
+/* Return the number of CPU cores of the host */
+
+
+
+/* End of thread.h */
+
+#endif
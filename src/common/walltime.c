@@ -0,0 +1,63 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 walltime.c                                */
+/*                                                                           */
+/*                  Wall clock time for measuring durations                  */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+/* common */
+#include "walltime.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+double WallTime (void)
+/* Return the wall clock time in seconds, counted from some arbitrary point
+** in the past. Only the difference of two values is meaningful.
+*/
+{
+#if defined(_WIN32)
+    LARGE_INTEGER Count;
+    LARGE_INTEGER Freq;
+    QueryPerformanceCounter (&Count);
+    QueryPerformanceFrequency (&Freq);
+    return (double) Count.QuadPart / (double) Freq.QuadPart;
+#else
+    struct timespec TS;
+    clock_gettime (CLOCK_MONOTONIC, &TS);
+    return (double) TS.tv_sec + (double) TS.tv_nsec * 1e-9;
+#endif
+}
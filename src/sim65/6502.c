@@ -44,14 +44,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
+#include "coverage.h"
+#include "heatmap.h"
+#include "loops.h"
 #include "memory.h"
 #include "peripherals.h"
 #include "error.h"
 #include "paravirt.h"
+#include "profile.h"
 #include "trace.h"
 
 #include "6502.h"
+#include "65816.h"
 
 /*
 
@@ -391,22 +397,41 @@ SBC #imm     |   EBh  |  2     |
 
 
 /* Current CPU */
-CPUType CPU;
+THREAD_LOCAL CPUType CPU;
 
 /* Type of an opcode handler function */
 typedef void (*OPFunc) (void);
 
 /* The CPU registers */
-CPURegs Regs;
+THREAD_LOCAL CPURegs Regs;
 
 /* Cycles for the current insn */
-static unsigned Cycles;
+static THREAD_LOCAL unsigned Cycles;
+
+/* Number of page crossing penalties taken so far */
+THREAD_LOCAL unsigned PageCrossings;
 
 /* NMI request active */
-static bool HaveNMIRequest;
+static THREAD_LOCAL bool HaveNMIRequest;
 
 /* IRQ request active */
-static bool HaveIRQRequest;
+static THREAD_LOCAL bool HaveIRQRequest;
+
+/* ExecuteUntil should return after the current instruction */
+static THREAD_LOCAL bool HaveBreakRequest;
+
+/* Decoded code cache. For every address that was executed (or decoded ahead
+** as part of a basic block), this holds the opcode handler for the current
+** CPU, so the dispatcher doesn't have to fetch the opcode and index the
+** handler tables. DecodeOperand holds the operand bytes of the insn, so the
+** handlers don't have to go through the memory map for them. An entry is
+** valid as long as the handler in DecodeCache is set, which means that a
+** write must invalidate the insns that may use the written byte as operand.
+** The addressing mode isn't cached, since every handler implements exactly
+** one mode.
+*/
+static THREAD_LOCAL OPFunc DecodeCache[0x10000];
+static THREAD_LOCAL uint16_t DecodeOperand[0x10000];
 
 
 
@@ -451,83 +476,92 @@ static bool HaveIRQRequest;
 /* Test for page cross */
 #define PAGE_CROSS(addr,offs)   ((((addr) & 0xFF) + offs) >= 0x100)
 
+/* Operands of the insn at PC. The handler for the insn is called only after
+** DecodeBlock has stored them.
+*/
+#define OPERAND_BYTE()  ((uint8_t) DecodeOperand[Regs.PC])
+#define OPERAND_WORD()  (DecodeOperand[Regs.PC])
+
 /* Address operators */
 
 /* zp */
 #define ADR_ZP(ad)                                              \
-    ad = MemReadByte (Regs.PC+1);                               \
+    ad = OPERAND_BYTE ();                                       \
     Regs.PC += 2
 
 /* zp,x */
 #define ADR_ZPX(ad)                                             \
-    ad = (MemReadByte (Regs.PC+1) + Regs.XR) & 0xFF;            \
+    ad = (OPERAND_BYTE () + Regs.XR) & 0xFF;                    \
     Regs.PC += 2
 
 /* zp,y */
 #define ADR_ZPY(ad)                                             \
-    ad = (MemReadByte (Regs.PC+1) + Regs.YR) & 0xFF;            \
+    ad = (OPERAND_BYTE () + Regs.YR) & 0xFF;                    \
     Regs.PC += 2
 
 /* abs */
 #define ADR_ABS(ad)                                             \
-    ad = MemReadWord (Regs.PC+1);                               \
+    ad = OPERAND_WORD ();                                       \
     Regs.PC += 3
 
 /* abs,x */
 #define ADR_ABSX(ad)                                            \
-    ad = MemReadWord (Regs.PC+1);                               \
+    ad = OPERAND_WORD ();                                       \
     if (PAGE_CROSS (ad, Regs.XR)) {                             \
         ++Cycles;                                               \
+        ++PageCrossings;                                        \
     }                                                           \
     ad += Regs.XR;                                              \
     Regs.PC += 3
 
 /* abs,y */
 #define ADR_ABSY(ad)                                            \
-    ad = MemReadWord (Regs.PC+1);                               \
+    ad = OPERAND_WORD ();                                       \
     if (PAGE_CROSS (ad, Regs.YR)) {                             \
         ++Cycles;                                               \
+        ++PageCrossings;                                        \
     }                                                           \
     ad += Regs.YR;                                              \
     Regs.PC += 3
 
 /* (zp,x) */
 #define ADR_ZPXIND(ad)                                          \
-    ad = (MemReadByte (Regs.PC+1) + Regs.XR) & 0xFF;            \
+    ad = (OPERAND_BYTE () + Regs.XR) & 0xFF;                    \
     ad = MemReadZPWord (ad);                                    \
     Regs.PC += 2
 
 /* (zp),y */
 #define ADR_ZPINDY(ad)                                          \
-    ad = MemReadZPWord (MemReadByte (Regs.PC+1));               \
+    ad = MemReadZPWord (OPERAND_BYTE ());                       \
     if (PAGE_CROSS (ad, Regs.YR)) {                             \
         ++Cycles;                                               \
+        ++PageCrossings;                                        \
     }                                                           \
     ad += Regs.YR;                                              \
     Regs.PC += 2
 
 /* (zp) */
 #define ADR_ZPIND(ad)                                           \
-    ad = MemReadZPWord (MemReadByte (Regs.PC+1));               \
+    ad = MemReadZPWord (OPERAND_BYTE ());                       \
     Regs.PC += 2
 
 /* Address operators (no penalty on page cross) */
 
 /* abs,x - no penalty */
 #define ADR_ABSX_NP(ad)                                         \
-    ad = MemReadWord (Regs.PC+1);                               \
+    ad = OPERAND_WORD ();                                       \
     ad += Regs.XR;                                              \
     Regs.PC += 3
 
 /* abs,y - no penalty */
 #define ADR_ABSY_NP(ad)                                         \
-    ad = MemReadWord (Regs.PC+1);                               \
+    ad = OPERAND_WORD ();                                       \
     ad += Regs.YR;                                              \
     Regs.PC += 3
 
 /* (zp),y - no penalty */
 #define ADR_ZPINDY_NP(ad)                                       \
-    ad = MemReadZPWord (MemReadByte (Regs.PC+1));               \
+    ad = MemReadZPWord (OPERAND_BYTE ());                       \
     ad += Regs.YR;                                              \
     Regs.PC += 2
 
@@ -537,7 +571,7 @@ static bool HaveIRQRequest;
 
 /* #imm */
 #define MEM_AD_OP_IMM(op)                                       \
-    op = MemReadByte (Regs.PC+1);                               \
+    op = OPERAND_BYTE ();                                       \
     Regs.PC += 2
 
 /* zp / zp,x / zp,y / abs / abs,x / abs,y / (zp,x) / (zp),y / (zp) */
@@ -755,12 +789,13 @@ static bool HaveIRQRequest;
             int8_t Offs;                                        \
             uint8_t OldPCH;                                     \
             ++Cycles;                                           \
-            Offs = MemReadByte (Regs.PC+1);                     \
+            Offs = OPERAND_BYTE ();                             \
             Regs.PC += 2;                                       \
             OldPCH = PCH;                                       \
             Regs.PC = (Regs.PC + (int) Offs) & 0xFFFF;          \
             if (PCH != OldPCH) {                                \
                 ++Cycles;                                       \
+                ++PageCrossings;                                \
             }                                                   \
         } else {                                                \
             Regs.PC += 2;                                       \
@@ -1121,7 +1156,7 @@ static bool HaveIRQRequest;
  */
 #define ZP_BITOP(bitnr, bitval)                                 \
     do {                                                        \
-        const uint8_t zp_address = MemReadByte (Regs.PC + 1);   \
+        const uint8_t zp_address = OPERAND_BYTE ();             \
         uint8_t zp_value = MemReadByte (zp_address);            \
         if (bitval) {                                           \
             zp_value |= (1 << bitnr);                           \
@@ -1139,9 +1174,9 @@ static bool HaveIRQRequest;
  */
 #define ZP_BIT_BRANCH(bitnr, bitval)                            \
     do {                                                        \
-        const uint8_t zp_address = MemReadByte (Regs.PC + 1);   \
+        const uint8_t zp_address = OPERAND_BYTE ();             \
         const uint8_t zp_value = MemReadByte (zp_address);      \
-        const int8_t displacement = MemReadByte (Regs.PC + 2);  \
+        const int8_t displacement = OPERAND_WORD () >> 8;       \
         if (((zp_value & (1 << bitnr)) != 0) == bitval) {       \
             Regs.PC += 3;                                       \
             uint8_t OldPCH = PCH;                               \
@@ -1149,6 +1184,7 @@ static bool HaveIRQRequest;
             Cycles = 6;                                         \
             if (PCH != OldPCH) {                                \
                 Cycles += 1;                                    \
+                ++PageCrossings;                                \
             }                                                   \
         } else {                                                \
             Regs.PC += 3;                                       \
@@ -1563,7 +1599,7 @@ static void OPC_6502_20 (void)
 
     Regs.PC = AddrLo + (AddrHi << 8);
 
-    ParaVirtHooks (&Regs);
+    Cycles += ParaVirtHooks (&Regs);
 }
 
 
@@ -1953,9 +1989,9 @@ static void OPC_6502_4C (void)
 /* Opcode $4C: JMP abs */
 {
     Cycles = 3;
-    Regs.PC = MemReadWord (Regs.PC+1);
+    Regs.PC = OPERAND_WORD ();
 
-    ParaVirtHooks (&Regs);
+    Cycles += ParaVirtHooks (&Regs);
 }
 
 
@@ -2299,7 +2335,7 @@ static void OPC_6502_6C (void)
                     PC, Lo);
     }
 
-    ParaVirtHooks (&Regs);
+    Cycles += ParaVirtHooks (&Regs);
 }
 
 
@@ -2311,7 +2347,7 @@ static void OPC_65C02_6C (void)
     Cycles = 6;
     Regs.PC = MemReadWord (MemReadWord (Regs.PC+1));
 
-    ParaVirtHooks (&Regs);
+    Cycles += ParaVirtHooks (&Regs);
 }
 
 
@@ -2499,7 +2535,7 @@ static void OPC_65C02_7C (void)
     Adr = MemReadWord (PC+1);
     Regs.PC = MemReadWord(Adr+Regs.XR);
 
-    ParaVirtHooks (&Regs);
+    Cycles += ParaVirtHooks (&Regs);
 }
 
 
@@ -4688,6 +4724,167 @@ static const OPFunc* Handlers[3] = {
 
 
 
+/*****************************************************************************/
+/*                            Decoded code cache                             */
+/*****************************************************************************/
+
+
+
+static bool EndsBlock (uint8_t OPC)
+/* Return true if the given opcode may transfer control and does therefore
+** end a basic block.
+*/
+{
+    switch (OPC) {
+        case 0x00:      /* BRK */
+        case 0x20:      /* JSR */
+        case 0x40:      /* RTI */
+        case 0x4C:      /* JMP abs */
+        case 0x60:      /* RTS */
+        case 0x6C:      /* JMP (ind) */
+        case 0x7C:      /* JMP (ind,x) */
+        case 0x80:      /* BRA */
+            return true;
+        default:
+            /* Conditional branches, and BBRx/BBSx on the 65C02 */
+            return (OPC & 0x1F) == 0x10 ||
+                   (CPU == CPU_65C02 && (OPC & 0x0F) == 0x0F);
+    }
+}
+
+
+
+static void OPC_CoverageBranch (void)
+/* Execute a conditional branch and record in the coverage map whether it
+** was taken. Used instead of the handlers for branches when collecting
+** coverage.
+*/
+{
+    uint16_t PC  = Regs.PC;
+    uint8_t  OPC = MemReadByte (PC);
+
+    Handlers[CPU][OPC] ();
+    if (Regs.PC == (uint16_t) (PC + CoverageBranchLen[OPC])) {
+        CoverageMap[PC] |= COV_NOT_TAKEN;
+    } else {
+        CoverageMap[PC] |= COV_TAKEN;
+    }
+}
+
+
+
+static OPFunc GetHandler (const OPFunc* Table, uint8_t OPC)
+/* Return the handler for an opcode */
+{
+    if (CoverageMap && CoverageBranchLen[OPC]) {
+        return OPC_CoverageBranch;
+    }
+    return Table[OPC];
+}
+
+
+
+static OPFunc DecodeBlock (uint16_t Addr)
+/* Decode the basic block starting at Addr into the code cache and return the
+** handler for the instruction at Addr. Decoding stops at the first insn that
+** may transfer control, at the end of the page, or when reaching code that
+** is already in the cache.
+*/
+{
+    const OPFunc* Table = Handlers[CPU];
+    unsigned PC = Addr;
+
+    /* Don't cache code in pages with a read handler (like the one with the
+    ** peripherals aperture), since reads may return a different value each
+    ** time. The operand of the insn may be in the following page. Read only
+    ** the bytes that belong to the insn, since reads may have side effects.
+    */
+    if (MemHasReadHandler (Addr >> 8) ||
+        MemHasReadHandler ((uint16_t) (Addr + 2) >> 8)) {
+        uint8_t  OPC = MemReadByte (Addr);
+        unsigned Len = GetInstructionLength (OPC);
+        DecodeOperand[Addr] = (Len > 1)? MemReadByte (Addr + 1) : 0;
+        if (Len > 2) {
+            DecodeOperand[Addr] |= MemReadByte (Addr + 2) << 8;
+        }
+        return GetHandler (Table, OPC);
+    }
+
+    /* Make sure we notice writes to this page */
+    MemSetPageFlags (Addr >> 8, MEM_PAGE_CODE);
+
+    /* Without a read handler, the page is plain RAM. Reading Mem directly
+    ** keeps the decoder out of the heatmap.
+    */
+    do {
+        uint8_t  OPC = Mem[PC];
+        unsigned Len = GetInstructionLength (OPC);
+
+        /* An insn at the end of the page may have its operand in the next
+        ** page, so writes to that page must be noticed, too.
+        */
+        if (((PC + Len - 1) >> 8) != (PC >> 8)) {
+            uint8_t Next = (uint8_t) ((PC >> 8) + 1);
+            if (MemHasReadHandler (Next)) {
+                break;
+            }
+            MemSetPageFlags (Next, MEM_PAGE_CODE);
+        }
+
+        DecodeCache[PC]   = GetHandler (Table, OPC);
+        DecodeOperand[PC] = Mem[(uint16_t) (PC + 1)] |
+                            (Mem[(uint16_t) (PC + 2)] << 8);
+        if (EndsBlock (OPC)) {
+            break;
+        }
+        PC += Len;
+    } while ((PC >> 8) == (Addr >> 8) && DecodeCache[PC] == 0);
+
+    return DecodeCache[Addr];
+}
+
+
+
+static void OPC_65816 (void)
+/* Execute one 65816 instruction. Used by ExecuteInsn, since the 65816 has
+** its own interpreter and doesn't use the code cache.
+*/
+{
+    Cycles = Step65816 ();
+}
+
+
+
+void InvalidateDecodedInsn (uint16_t Addr)
+/* Remove the decoded instructions that use the byte at Addr from the code
+** cache. Called when the memory at Addr is written to, and the page has the
+** MEM_PAGE_CODE flag set. Self modifying code usually changes operands, so
+** the byte may belong to an insn starting up to two bytes before.
+*/
+{
+    DecodeCache[Addr] = 0;
+    DecodeCache[(uint16_t) (Addr - 1)] = 0;
+    DecodeCache[(uint16_t) (Addr - 2)] = 0;
+}
+
+
+
+void InvalidateCodeCache (void)
+/* Drop all decoded instructions, for example because the CPU type changed */
+{
+    unsigned Page;
+
+    /* Only pages with the MEM_PAGE_CODE flag have decoded instructions */
+    for (Page = 0; Page < 0x100; ++Page) {
+        if (MemGetPageFlags (Page) & MEM_PAGE_CODE) {
+            memset (DecodeCache + (Page << 8), 0, 0x100 * sizeof (DecodeCache[0]));
+            MemClearPageFlags (Page, MEM_PAGE_CODE);
+        }
+    }
+}
+
+
+
 /*****************************************************************************/
 /*                                   Code                                    */
 /*****************************************************************************/
@@ -4699,6 +4896,9 @@ void IRQRequest (void)
 {
     /* Remember the request */
     HaveIRQRequest = true;
+
+    /* Leave the fast execution loop, so the IRQ can be handled */
+    HaveBreakRequest = true;
 }
 
 
@@ -4708,6 +4908,35 @@ void NMIRequest (void)
 {
     /* Remember the request */
     HaveNMIRequest = true;
+
+    /* Leave the fast execution loop, so the NMI can be handled */
+    HaveBreakRequest = true;
+}
+
+
+
+unsigned GetPendingInterrupts (void)
+/* Return the pending interrupt requests as a set of PENDING_xxx flags */
+{
+    return (HaveIRQRequest ? PENDING_IRQ : 0) | (HaveNMIRequest ? PENDING_NMI : 0);
+}
+
+
+
+void SetPendingInterrupts (unsigned Pending)
+/* Replace the pending interrupt requests by a set of PENDING_xxx flags */
+{
+    HaveIRQRequest = (Pending & PENDING_IRQ) != 0;
+    HaveNMIRequest = (Pending & PENDING_NMI) != 0;
+    HaveBreakRequest = true;
+}
+
+
+
+void ExecuteBreak (void)
+/* Make ExecuteUntil return after the current instruction */
+{
+    HaveBreakRequest = true;
 }
 
 
@@ -4722,6 +4951,16 @@ void Reset (void)
     /* Bits 5 and 4 aren't used, and always are 1! */
     Regs.SR = 0x30;
     Regs.PC = MemReadWord (0xFFFC);
+
+    /* The 65816 starts in emulation mode with everything in bank zero */
+    Regs.AH  = 0;
+    Regs.XH  = 0;
+    Regs.YH  = 0;
+    Regs.SPH = 1;
+    Regs.DP  = 0;
+    Regs.DBR = 0;
+    Regs.PBR = 0;
+    Regs.E   = 1;
 }
 
 
@@ -4729,6 +4968,13 @@ void Reset (void)
 unsigned ExecuteInsn (void)
 /* Execute one CPU instruction */
 {
+    /* Address and opcode of the instruction for the profiler, and the page
+    ** crossing counter before the instruction for the loop statistics.
+    */
+    uint16_t PC        = Regs.PC;
+    int      OPC       = -1;
+    unsigned Crossings = PageCrossings;
+
     /* If we have an NMI request, handle it */
     if (HaveNMIRequest) {
 
@@ -4739,16 +4985,20 @@ unsigned ExecuteInsn (void)
         HaveNMIRequest = false;
         Peripherals.Counter.NmiEvents += 1;
 
-        PUSH (PCH);
-        PUSH (PCL);
-        PUSH (Regs.SR & ~BF);
-        SET_IF (1);
-        if (CPU == CPU_65C02)
-        {
-            SET_DF (0);
+        if (CPU == CPU_65816) {
+            Cycles = Interrupt65816 (true);
+        } else {
+            PUSH (PCH);
+            PUSH (PCL);
+            PUSH (Regs.SR & ~BF);
+            SET_IF (1);
+            if (CPU == CPU_65C02)
+            {
+                SET_DF (0);
+            }
+            Regs.PC = MemReadWord (0xFFFA);
+            Cycles = 7;
         }
-        Regs.PC = MemReadWord (0xFFFA);
-        Cycles = 7;
 
     } else if (HaveIRQRequest && GET_IF () == 0) {
 
@@ -4759,21 +5009,41 @@ unsigned ExecuteInsn (void)
         HaveIRQRequest = false;
         Peripherals.Counter.IrqEvents += 1;
 
-        PUSH (PCH);
-        PUSH (PCL);
-        PUSH (Regs.SR & ~BF);
-        SET_IF (1);
-        if (CPU == CPU_65C02)
-        {
-            SET_DF (0);
+        if (CPU == CPU_65816) {
+            Cycles = Interrupt65816 (false);
+        } else {
+            PUSH (PCH);
+            PUSH (PCL);
+            PUSH (Regs.SR & ~BF);
+            SET_IF (1);
+            if (CPU == CPU_65C02)
+            {
+                SET_DF (0);
+            }
+            Regs.PC = MemReadWord (0xFFFE);
+            Cycles = 7;
         }
-        Regs.PC = MemReadWord (0xFFFE);
-        Cycles = 7;
 
     } else {
 
-        /* Normal instruction - read the next opcode */
-        uint8_t OPC = MemReadByte (Regs.PC);
+        /* Normal instruction - get the handler from the code cache. The
+        ** 65816 doesn't use the cache, and is profiled in bank zero only.
+        */
+        OPFunc Handler;
+        bool   Bank0 = (Regs.PBR == 0);
+        if (CPU == CPU_65816) {
+            Handler = OPC_65816;
+        } else {
+            Handler = DecodeCache[Regs.PC];
+            if (Handler == 0) {
+                Handler = DecodeBlock (Regs.PC);
+            }
+        }
+
+        /* Fetches of the instruction bytes don't count as data reads */
+        if (HeatmapEnabled) {
+            HeatmapInsn (PC);
+        }
 
         /* Print a trace line, if trace mode is enabled. */
         if (TraceMode != TRACE_DISABLED) {
@@ -4783,13 +5053,150 @@ unsigned ExecuteInsn (void)
         /* Increment the instruction counter by one. */
         Peripherals.Counter.CpuInstructions += 1;
 
+        /* Remember the opcode, the handler may change the memory */
+        if ((ProfileEnabled || LoopsEnabled) && Bank0) {
+            OPC = MemReadByte (PC);
+        }
+
         /* Execute the instruction. The handler sets the 'Cycles' variable. */
-        Handlers[CPU][OPC] ();
+        Handler ();
+
+        /* Mark it in the coverage map */
+        if (CoverageMap && Bank0) {
+            CoverageInsn (PC);
+        }
     }
 
     /* Increment the 64-bit clock cycle counter with the cycle count for the instruction that we just executed. */
     Peripherals.Counter.ClockCycles += Cycles;
 
+    /* Account for the instruction in the profile */
+    if (OPC >= 0) {
+        if (ProfileEnabled) {
+            ProfileInsn (PC, (uint8_t) OPC, Cycles);
+        }
+        if (LoopsEnabled) {
+            LoopsInsn (PC, (uint8_t) OPC, Cycles, PageCrossings - Crossings);
+        }
+    }
+
     /* Return the number of clock cycles needed by this instruction */
     return Cycles;
 }
+
+
+
+unsigned long long ExecuteUntil (unsigned long long Budget)
+/* Execute CPU instructions until at least Budget clock cycles have been
+** used, or until ExecuteBreak is called. Return the number of clock cycles
+** actually executed.
+*/
+{
+    unsigned long long Total = 0;
+
+    HaveBreakRequest = false;
+    while (Total < Budget && !HaveBreakRequest) {
+
+        /* Pending interrupts and tracing are handled by ExecuteInsn. Since
+        ** they cannot become active without a break request, checking for
+        ** them once before entering the inner loop is sufficient.
+        */
+        if (HaveNMIRequest || HaveIRQRequest || TraceMode != TRACE_DISABLED) {
+            Total += ExecuteInsn ();
+            continue;
+        }
+
+        /* The 65816 has its own interpreter without a decode cache */
+        if (CPU == CPU_65816) {
+            do {
+                uint16_t PC    = Regs.PC;
+                bool     Bank0 = (Regs.PBR == 0);
+                uint8_t  OPC;
+                unsigned Crossings = PageCrossings;
+                if (HeatmapEnabled) {
+                    HeatmapInsn (PC);
+                }
+                OPC = MemReadByte (PC);
+                Peripherals.Counter.CpuInstructions += 1;
+                Cycles = Step65816 ();
+                Peripherals.Counter.ClockCycles += Cycles;
+                Total += Cycles;
+                if (Bank0) {
+                    if (ProfileEnabled) {
+                        ProfileInsn (PC, OPC, Cycles);
+                    }
+                    if (LoopsEnabled) {
+                        LoopsInsn (PC, OPC, Cycles, PageCrossings - Crossings);
+                    }
+                    if (CoverageMap) {
+                        CoverageInsn (PC);
+                    }
+                }
+            } while (Total < Budget && !HaveBreakRequest);
+            continue;
+        }
+
+        /* Use a separate loop when collecting coverage only, and another
+        ** one for the profiler, the loop statistics and the heatmap, so the
+        ** common case doesn't pay for it.
+        */
+        if (CoverageMap && !ProfileEnabled && !LoopsEnabled && !HeatmapEnabled) {
+            do {
+                uint16_t PC  = Regs.PC;
+                OPFunc Handler = DecodeCache[PC];
+                if (Handler == 0) {
+                    Handler = DecodeBlock (PC);
+                }
+                Peripherals.Counter.CpuInstructions += 1;
+                Handler ();
+                Peripherals.Counter.ClockCycles += Cycles;
+                Total += Cycles;
+                CoverageInsn (PC);
+            } while (Total < Budget && !HaveBreakRequest);
+            continue;
+        }
+        if (ProfileEnabled || LoopsEnabled || HeatmapEnabled) {
+            do {
+                uint16_t PC        = Regs.PC;
+                uint8_t  OPC;
+                unsigned Crossings = PageCrossings;
+                OPFunc Handler;
+                if (HeatmapEnabled) {
+                    HeatmapInsn (PC);
+                }
+                OPC     = MemReadByte (PC);
+                Handler = DecodeCache[PC];
+                if (Handler == 0) {
+                    Handler = DecodeBlock (PC);
+                }
+                Peripherals.Counter.CpuInstructions += 1;
+                Handler ();
+                Peripherals.Counter.ClockCycles += Cycles;
+                Total += Cycles;
+                if (ProfileEnabled) {
+                    ProfileInsn (PC, OPC, Cycles);
+                }
+                if (LoopsEnabled) {
+                    LoopsInsn (PC, OPC, Cycles, PageCrossings - Crossings);
+                }
+                if (CoverageMap) {
+                    CoverageInsn (PC);
+                }
+            } while (Total < Budget && !HaveBreakRequest);
+            continue;
+        }
+
+        do {
+            OPFunc Handler = DecodeCache[Regs.PC];
+            if (Handler == 0) {
+                Handler = DecodeBlock (Regs.PC);
+            }
+            Peripherals.Counter.CpuInstructions += 1;
+            Handler ();
+            Peripherals.Counter.ClockCycles += Cycles;
+            Total += Cycles;
+        } while (Total < Budget && !HaveBreakRequest);
+    }
+
+    return Total;
+}
@@ -39,6 +39,9 @@
 
 #include <stdint.h>
 
+/* common */
+#include "thread.h"
+
 
 /*****************************************************************************/
 /*                                   Data                                    */
@@ -50,13 +53,16 @@
 typedef enum CPUType {
     CPU_6502  = 0,
     CPU_65C02 = 1,
-    CPU_6502X = 2
+    CPU_6502X = 2,
+    CPU_65816 = 3
 } CPUType;
 
 /* Current CPU */
-extern CPUType CPU;
+extern THREAD_LOCAL CPUType CPU;
 
-/* 6502 CPU registers */
+/* 6502 CPU registers. The 65816 core keeps the low bytes of its registers
+** in the 6502 registers, so the paravirtualization hooks work for both.
+*/
 typedef struct CPURegs CPURegs;
 struct CPURegs {
     uint8_t     AC;             /* Accumulator */
@@ -65,10 +71,25 @@ struct CPURegs {
     uint8_t     SR;             /* Status register */
     uint8_t     SP;             /* Stackpointer */
     uint16_t    PC;             /* Program counter */
+
+    /* 65816 only */
+    uint8_t     AH;             /* High byte of the accumulator */
+    uint8_t     XH;             /* High byte of the X register */
+    uint8_t     YH;             /* High byte of the Y register */
+    uint8_t     SPH;            /* High byte of the stackpointer */
+    uint16_t    DP;             /* Direct page register */
+    uint8_t     DBR;            /* Data bank register */
+    uint8_t     PBR;            /* Program bank register */
+    uint8_t     E;              /* Emulation mode flag */
 };
 
 /* Current CPU registers */
-extern CPURegs Regs;
+extern THREAD_LOCAL CPURegs Regs;
+
+/* Number of page crossing penalties taken so far. This counter wraps, only
+** differences are meaningful.
+*/
+extern THREAD_LOCAL unsigned PageCrossings;
 
 /* Status register bits */
 #define CF      0x01            /* Carry flag */
@@ -79,6 +100,10 @@ extern CPURegs Regs;
 #define OF      0x40            /* Overflow flag */
 #define SF      0x80            /* Sign flag */
 
+/* Flags for pending interrupt requests */
+#define PENDING_IRQ     0x01U
+#define PENDING_NMI     0x02U
+
 
 
 /*****************************************************************************/
@@ -96,11 +121,35 @@ void IRQRequest (void);
 void NMIRequest (void);
 /* Generate an NMI */
 
+unsigned GetPendingInterrupts (void);
+/* Return the pending interrupt requests as a set of PENDING_xxx flags */
+
+void SetPendingInterrupts (unsigned Pending);
+/* Replace the pending interrupt requests by a set of PENDING_xxx flags */
+
+void InvalidateDecodedInsn (uint16_t Addr);
+/* Remove a decoded instruction from the code cache. Called when the memory
+** at Addr is written to, and the page has the MEM_PAGE_CODE flag set.
+*/
+
+void InvalidateCodeCache (void);
+/* Drop all decoded instructions, for example because the CPU type changed */
+
 unsigned ExecuteInsn (void);
 /* Execute one CPU instruction. Return the number of clock cycles for the
 ** executed instruction.
 */
 
+void ExecuteBreak (void);
+/* Make ExecuteUntil return after the current instruction */
+
+unsigned long long ExecuteUntil (unsigned long long Budget);
+/* Execute CPU instructions until at least Budget clock cycles have been
+** used, or until ExecuteBreak is called. Return the number of clock cycles
+** actually executed. ExecuteBreak is called for IRQ and NMI requests, for
+** writes to the trace mode register, and by the paravirtualization hooks.
+*/
+
 
 /* End of 6502.h */
 
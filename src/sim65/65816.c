@@ -0,0 +1,1188 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  65816.c                                  */
+/*                                                                           */
+/*                           CPU core for the 65816                          */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+/* The core runs 65816 code in emulation and native mode, with 8 and 16 bit
+** registers and 24 bit addresses. Some details are simplified:
+**  - Reads of 16 bit values from the direct page or the stack at $FFFF
+**    continue in bank 1 instead of wrapping to $0000.
+**  - In emulation mode, all stack accesses wrap within page one, including
+**    those of the new instructions like PEA and JSL.
+**  - WAI waits by executing itself again until an interrupt is pending.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "6502.h"
+#include "65816.h"
+#include "coverage.h"
+#include "error.h"
+#include "memory.h"
+#include "paravirt.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Status register bits with a different meaning in native mode */
+#define MF      0x20            /* Accumulator and memory are 8 bits */
+#define XF      0x10            /* Index registers are 8 bits */
+
+/* Register width */
+#define ACC8    ((Regs.SR & MF) != 0)
+#define IDX8    ((Regs.SR & XF) != 0)
+
+/* 16 bit registers */
+#define GET_A   ((unsigned) Regs.AC | ((unsigned) Regs.AH << 8))
+#define GET_X   ((unsigned) Regs.XR | ((unsigned) Regs.XH << 8))
+#define GET_Y   ((unsigned) Regs.YR | ((unsigned) Regs.YH << 8))
+#define GET_S   ((unsigned) Regs.SP | ((unsigned) Regs.SPH << 8))
+
+/* Bank addresses */
+#define DATA_BANK       ((uint32_t) Regs.DBR << 16)
+#define PROGRAM_BANK    ((uint32_t) Regs.PBR << 16)
+
+/* Clock cycles for each opcode with 8 bit registers, a page aligned direct
+** page, and without page crossings. The penalties are added by the
+** functions that access memory.
+*/
+static const uint8_t BaseCycles[256] = {
+    7, 6, 7, 4, 5, 3, 5, 6, 3, 2, 2, 4, 6, 4, 6, 5,     /* $00 */
+    2, 5, 5, 7, 5, 4, 6, 6, 2, 4, 2, 2, 6, 4, 7, 5,     /* $10 */
+    6, 6, 8, 4, 3, 3, 5, 6, 4, 2, 2, 5, 4, 4, 6, 5,     /* $20 */
+    2, 5, 5, 7, 4, 4, 6, 6, 2, 4, 2, 2, 4, 4, 7, 5,     /* $30 */
+    6, 6, 2, 4, 7, 3, 5, 6, 3, 2, 2, 3, 3, 4, 6, 5,     /* $40 */
+    2, 5, 5, 7, 7, 4, 6, 6, 2, 4, 3, 2, 4, 4, 7, 5,     /* $50 */
+    6, 6, 6, 4, 3, 3, 5, 6, 4, 2, 2, 6, 5, 4, 6, 5,     /* $60 */
+    2, 5, 5, 7, 4, 4, 6, 6, 2, 4, 4, 2, 6, 4, 7, 5,     /* $70 */
+    2, 6, 4, 4, 3, 3, 3, 6, 2, 2, 2, 3, 4, 4, 4, 5,     /* $80 */
+    2, 6, 5, 7, 4, 4, 4, 6, 2, 5, 2, 2, 4, 5, 5, 5,     /* $90 */
+    2, 6, 2, 4, 3, 3, 3, 6, 2, 2, 2, 4, 4, 4, 4, 5,     /* $A0 */
+    2, 5, 5, 7, 4, 4, 4, 6, 2, 4, 2, 2, 4, 4, 4, 5,     /* $B0 */
+    2, 6, 3, 4, 3, 3, 5, 6, 2, 2, 2, 3, 4, 4, 6, 5,     /* $C0 */
+    2, 5, 5, 7, 6, 4, 6, 6, 2, 4, 3, 3, 6, 4, 7, 5,     /* $D0 */
+    2, 6, 3, 4, 3, 3, 5, 6, 2, 2, 2, 3, 4, 4, 6, 5,     /* $E0 */
+    2, 5, 5, 7, 5, 4, 6, 6, 2, 4, 4, 2, 8, 4, 7, 5,     /* $F0 */
+};
+
+/* Clock cycles of the current instruction */
+static THREAD_LOCAL unsigned Cycles;
+
+
+
+/*****************************************************************************/
+/*                             Registers and flags                           */
+/*****************************************************************************/
+
+
+
+static void SetFlag (uint8_t Flag, bool On)
+/* Set or clear a flag in the status register */
+{
+    if (On) {
+        Regs.SR |= Flag;
+    } else {
+        Regs.SR &= ~Flag;
+    }
+}
+
+
+
+static void TestNZ (unsigned Val, bool Wide)
+/* Set the N and Z flags for an 8 or 16 bit value */
+{
+    if (Wide) {
+        SetFlag (ZF, (Val & 0xFFFF) == 0);
+        SetFlag (SF, (Val & 0x8000) != 0);
+    } else {
+        SetFlag (ZF, (Val & 0xFF) == 0);
+        SetFlag (SF, (Val & 0x80) != 0);
+    }
+}
+
+
+
+static void SetA16 (unsigned Val)
+/* Set the full accumulator */
+{
+    Regs.AC = (uint8_t) Val;
+    Regs.AH = (uint8_t) (Val >> 8);
+}
+
+
+
+static unsigned GetAM (void)
+/* Return the accumulator with its current width */
+{
+    return ACC8? Regs.AC : GET_A;
+}
+
+
+
+static void SetAM (unsigned Val)
+/* Set the accumulator with its current width, and the N and Z flags */
+{
+    if (ACC8) {
+        Regs.AC = (uint8_t) Val;
+    } else {
+        SetA16 (Val);
+    }
+    TestNZ (Val, !ACC8);
+}
+
+
+
+static void SetX (unsigned Val)
+/* Set the X register with its current width, and the N and Z flags */
+{
+    Regs.XR = (uint8_t) Val;
+    Regs.XH = IDX8? 0 : (uint8_t) (Val >> 8);
+    TestNZ (Val, !IDX8);
+}
+
+
+
+static void SetY (unsigned Val)
+/* Set the Y register with its current width, and the N and Z flags */
+{
+    Regs.YR = (uint8_t) Val;
+    Regs.YH = IDX8? 0 : (uint8_t) (Val >> 8);
+    TestNZ (Val, !IDX8);
+}
+
+
+
+static void SetS (unsigned Val)
+/* Set the stack pointer. It stays in page one in emulation mode. */
+{
+    Regs.SP  = (uint8_t) Val;
+    Regs.SPH = Regs.E? 0x01 : (uint8_t) (Val >> 8);
+}
+
+
+
+static void UpdateMode (void)
+/* Enforce the register widths after the status register or the emulation
+** flag was changed.
+*/
+{
+    if (Regs.E) {
+        Regs.SR |= MF | XF;
+        Regs.SPH = 0x01;
+    }
+    if (IDX8) {
+        Regs.XH = 0;
+        Regs.YH = 0;
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                               Memory access                               */
+/*****************************************************************************/
+
+
+
+static uint8_t Read8 (uint32_t Addr)
+/* Read a byte */
+{
+    return MemReadLong (Addr & 0xFFFFFF);
+}
+
+
+
+static unsigned Read16 (uint32_t Addr)
+/* Read a word */
+{
+    return Read8 (Addr) | (Read8 (Addr + 1) << 8);
+}
+
+
+
+static void Write8 (uint32_t Addr, uint8_t Val)
+/* Write a byte */
+{
+    MemWriteLong (Addr & 0xFFFFFF, Val);
+}
+
+
+
+static void Write16 (uint32_t Addr, unsigned Val)
+/* Write a word */
+{
+    Write8 (Addr, (uint8_t) Val);
+    Write8 (Addr + 1, (uint8_t) (Val >> 8));
+}
+
+
+
+static unsigned ReadM (uint32_t Addr)
+/* Read a value with the width of the accumulator */
+{
+    if (ACC8) {
+        return Read8 (Addr);
+    }
+    ++Cycles;
+    return Read16 (Addr);
+}
+
+
+
+static void WriteM (uint32_t Addr, unsigned Val)
+/* Write a value with the width of the accumulator */
+{
+    if (ACC8) {
+        Write8 (Addr, (uint8_t) Val);
+    } else {
+        ++Cycles;
+        Write16 (Addr, Val);
+    }
+}
+
+
+
+static unsigned ReadX (uint32_t Addr)
+/* Read a value with the width of the index registers */
+{
+    if (IDX8) {
+        return Read8 (Addr);
+    }
+    ++Cycles;
+    return Read16 (Addr);
+}
+
+
+
+static void WriteX (uint32_t Addr, unsigned Val)
+/* Write a value with the width of the index registers */
+{
+    if (IDX8) {
+        Write8 (Addr, (uint8_t) Val);
+    } else {
+        ++Cycles;
+        Write16 (Addr, Val);
+    }
+}
+
+
+
+static uint8_t Fetch8 (void)
+/* Fetch the next byte of the instruction */
+{
+    uint8_t Val = Read8 (PROGRAM_BANK | Regs.PC);
+    ++Regs.PC;
+    return Val;
+}
+
+
+
+static unsigned Fetch16 (void)
+/* Fetch the next word of the instruction */
+{
+    unsigned Lo = Fetch8 ();
+    return Lo | (Fetch8 () << 8);
+}
+
+
+
+static uint32_t Fetch24 (void)
+/* Fetch a 24 bit address from the instruction */
+{
+    uint32_t Lo = Fetch16 ();
+    return Lo | ((uint32_t) Fetch8 () << 16);
+}
+
+
+
+static unsigned FetchM (void)
+/* Fetch an immediate operand with the width of the accumulator */
+{
+    if (ACC8) {
+        return Fetch8 ();
+    }
+    ++Cycles;
+    return Fetch16 ();
+}
+
+
+
+static unsigned FetchX (void)
+/* Fetch an immediate operand with the width of the index registers */
+{
+    if (IDX8) {
+        return Fetch8 ();
+    }
+    ++Cycles;
+    return Fetch16 ();
+}
+
+
+
+static void Push8 (uint8_t Val)
+/* Push a byte onto the stack */
+{
+    Write8 (GET_S, Val);
+    SetS (GET_S - 1);
+}
+
+
+
+static void Push16 (unsigned Val)
+/* Push a word onto the stack */
+{
+    Push8 ((uint8_t) (Val >> 8));
+    Push8 ((uint8_t) Val);
+}
+
+
+
+static uint8_t Pull8 (void)
+/* Pull a byte from the stack */
+{
+    SetS (GET_S + 1);
+    return Read8 (GET_S);
+}
+
+
+
+static unsigned Pull16 (void)
+/* Pull a word from the stack */
+{
+    unsigned Lo = Pull8 ();
+    return Lo | (Pull8 () << 8);
+}
+
+
+
+/*****************************************************************************/
+/*                             Addressing modes                              */
+/*****************************************************************************/
+
+
+
+static uint16_t DirectAddr (unsigned Offs)
+/* Return an address in the direct page. In emulation mode, with the direct
+** page at a page boundary, it wraps around like the 6502 zero page.
+*/
+{
+    if (Regs.E && (Regs.DP & 0xFF) == 0) {
+        return Regs.DP | (Offs & 0xFF);
+    }
+    return (Regs.DP + Offs) & 0xFFFF;
+}
+
+
+
+static unsigned FetchDirect (void)
+/* Fetch the offset of a direct page operand */
+{
+    /* Accesses take one cycle more if the direct page isn't aligned */
+    if (Regs.DP & 0xFF) {
+        ++Cycles;
+    }
+    return Fetch8 ();
+}
+
+
+
+static unsigned DirectPtr (unsigned Offs)
+/* Read a 16 bit pointer from the direct page */
+{
+    return Read8 (DirectAddr (Offs)) | (Read8 (DirectAddr (Offs + 1)) << 8);
+}
+
+
+
+static uint32_t Indexed (uint32_t Base, unsigned Index, bool Read)
+/* Add an index register to a base address. Reads take one cycle more if
+** a page boundary is crossed, or the index registers are 16 bits.
+*/
+{
+    uint32_t Addr = (Base + Index) & 0xFFFFFF;
+    if (Read && (!IDX8 || (Addr >> 8) != (Base >> 8))) {
+        ++Cycles;
+        if (IDX8) {
+            ++PageCrossings;
+        }
+    }
+    return Addr;
+}
+
+
+
+static uint32_t EA_Dir (void)
+/* d */
+{
+    return DirectAddr (FetchDirect ());
+}
+
+
+
+static uint32_t EA_DirX (void)
+/* d,x */
+{
+    return DirectAddr (FetchDirect () + GET_X);
+}
+
+
+
+static uint32_t EA_DirY (void)
+/* d,y */
+{
+    return DirectAddr (FetchDirect () + GET_Y);
+}
+
+
+
+static uint32_t EA_DirInd (void)
+/* (d) */
+{
+    return DATA_BANK | DirectPtr (FetchDirect ());
+}
+
+
+
+static uint32_t EA_DirXInd (void)
+/* (d,x) */
+{
+    return DATA_BANK | DirectPtr (FetchDirect () + GET_X);
+}
+
+
+
+static uint32_t EA_DirIndY (bool Read)
+/* (d),y */
+{
+    return Indexed (DATA_BANK | DirectPtr (FetchDirect ()), GET_Y, Read);
+}
+
+
+
+static uint32_t EA_DirIndLong (void)
+/* [d] */
+{
+    unsigned Offs = FetchDirect ();
+    return DirectPtr (Offs) | ((uint32_t) Read8 (DirectAddr (Offs + 2)) << 16);
+}
+
+
+
+static uint32_t EA_DirIndLongY (void)
+/* [d],y */
+{
+    return (EA_DirIndLong () + GET_Y) & 0xFFFFFF;
+}
+
+
+
+static uint32_t EA_Abs (void)
+/* a */
+{
+    return DATA_BANK | Fetch16 ();
+}
+
+
+
+static uint32_t EA_AbsX (bool Read)
+/* a,x */
+{
+    return Indexed (EA_Abs (), GET_X, Read);
+}
+
+
+
+static uint32_t EA_AbsY (bool Read)
+/* a,y */
+{
+    return Indexed (EA_Abs (), GET_Y, Read);
+}
+
+
+
+static uint32_t EA_Long (void)
+/* al */
+{
+    return Fetch24 ();
+}
+
+
+
+static uint32_t EA_LongX (void)
+/* al,x */
+{
+    return (Fetch24 () + GET_X) & 0xFFFFFF;
+}
+
+
+
+static uint32_t EA_Stack (void)
+/* d,s */
+{
+    return (GET_S + Fetch8 ()) & 0xFFFF;
+}
+
+
+
+static uint32_t EA_StackIndY (void)
+/* (d,s),y */
+{
+    return (DATA_BANK + Read16 (EA_Stack ()) + GET_Y) & 0xFFFFFF;
+}
+
+
+
+static uint32_t EA_Alu (uint8_t OPC, bool Read)
+/* Return the effective address for one of the eight ALU instructions. The
+** addressing mode is in the low five bits of the opcode.
+*/
+{
+    switch (OPC & 0x1F) {
+        case 0x01:      return EA_DirXInd ();
+        case 0x03:      return EA_Stack ();
+        case 0x05:      return EA_Dir ();
+        case 0x07:      return EA_DirIndLong ();
+        case 0x0D:      return EA_Abs ();
+        case 0x0F:      return EA_Long ();
+        case 0x11:      return EA_DirIndY (Read);
+        case 0x12:      return EA_DirInd ();
+        case 0x13:      return EA_StackIndY ();
+        case 0x15:      return EA_DirX ();
+        case 0x17:      return EA_DirIndLongY ();
+        case 0x19:      return EA_AbsY (Read);
+        case 0x1D:      return EA_AbsX (Read);
+        case 0x1F:      return EA_LongX ();
+        default:
+            Internal ("Invalid ALU opcode $%02X", OPC);
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                Operations                                 */
+/*****************************************************************************/
+
+
+
+static void OpADC (unsigned Val)
+/* Add with carry, in binary or decimal mode */
+{
+    unsigned Bits = ACC8? 8 : 16;
+    unsigned Mask = (1U << Bits) - 1;
+    unsigned Sign = 1U << (Bits - 1);
+    unsigned A    = GetAM ();
+    int      Res;
+
+    if (Regs.SR & DF) {
+        /* Add digit by digit. The top digit is adjusted after computing
+        ** the overflow flag.
+        */
+        unsigned Carry = Regs.SR & CF;
+        unsigned Shift;
+        Res = 0;
+        for (Shift = 0; Shift < Bits; Shift += 4) {
+            unsigned Digit = 0x0FU << Shift;
+            unsigned Low   = (1U << Shift) - 1;
+            Res = (A & Digit) + (Val & Digit) + (Carry << Shift) + (Res & Low);
+            if (Shift + 4 < Bits) {
+                if ((unsigned) Res > (0x0AU << Shift) - 1) {
+                    Res += 0x06 << Shift;
+                }
+                Carry = (unsigned) Res > (Digit | Low);
+            }
+        }
+    } else {
+        Res = A + Val + (Regs.SR & CF);
+    }
+    SetFlag (OF, (~(A ^ Val) & (A ^ Res) & Sign) != 0);
+    if ((Regs.SR & DF) && (unsigned) Res > (0xA0U << (Bits - 8)) - 1) {
+        Res += 0x60 << (Bits - 8);
+    }
+    SetFlag (CF, (unsigned) Res > Mask);
+    SetAM (Res & Mask);
+}
+
+
+
+static void OpSBC (unsigned Val)
+/* Subtract with borrow, in binary or decimal mode */
+{
+    unsigned Bits = ACC8? 8 : 16;
+    unsigned Mask = (1U << Bits) - 1;
+    unsigned Sign = 1U << (Bits - 1);
+    unsigned A    = GetAM ();
+    int      Res;
+
+    Val ^= Mask;
+    if (Regs.SR & DF) {
+        unsigned Carry = Regs.SR & CF;
+        unsigned Shift;
+        Res = 0;
+        for (Shift = 0; Shift < Bits; Shift += 4) {
+            unsigned Digit = 0x0FU << Shift;
+            unsigned Low   = (1U << Shift) - 1;
+            Res = (A & Digit) + (Val & Digit) + (Carry << Shift) + (Res & Low);
+            if (Shift + 4 < Bits) {
+                if (Res <= (int) (Digit | Low)) {
+                    Res -= 0x06 << Shift;
+                }
+                Carry = Res > (int) (Digit | Low);
+            }
+        }
+    } else {
+        Res = A + Val + (Regs.SR & CF);
+    }
+    SetFlag (OF, (~(A ^ Val) & (A ^ Res) & Sign) != 0);
+    if ((Regs.SR & DF) && Res <= (int) Mask) {
+        Res -= 0x60 << (Bits - 8);
+    }
+    SetFlag (CF, Res > (int) Mask);
+    SetAM (Res & Mask);
+}
+
+
+
+static void OpCompare (unsigned Reg, unsigned Val, bool Wide)
+/* Compare a register with a value */
+{
+    unsigned Res = Reg - Val;
+    SetFlag (CF, Reg >= Val);
+    TestNZ (Res, Wide);
+}
+
+
+
+static void OpBIT (unsigned Val)
+/* Test bits in memory against the accumulator */
+{
+    unsigned Sign = ACC8? 0x80 : 0x8000;
+    SetFlag (ZF, (GetAM () & Val) == 0);
+    SetFlag (SF, (Val & Sign) != 0);
+    SetFlag (OF, (Val & (Sign >> 1)) != 0);
+}
+
+
+
+static unsigned OpShift (uint8_t OPC, unsigned Val)
+/* Shift or rotate a value with the width of the accumulator. The operation
+** is taken from bits 5 and 6 of the opcode: ASL, ROL, LSR or ROR.
+*/
+{
+    unsigned Sign  = ACC8? 0x80 : 0x8000;
+    unsigned Carry = Regs.SR & CF;
+    unsigned Res;
+
+    switch ((OPC >> 5) & 0x03) {
+        case 0:         /* ASL */
+            Carry = 0;
+            /* FALLTHROUGH */
+        case 1:         /* ROL */
+            Res = (Val << 1) | Carry;
+            SetFlag (CF, (Val & Sign) != 0);
+            break;
+        case 2:         /* LSR */
+            Carry = 0;
+            /* FALLTHROUGH */
+        default:        /* ROR */
+            Res = (Val >> 1) | (Carry? Sign : 0);
+            SetFlag (CF, (Val & 0x01) != 0);
+            break;
+    }
+    Res &= (Sign << 1) - 1;
+    TestNZ (Res, !ACC8);
+    return Res;
+}
+
+
+
+static void OpShiftMem (uint8_t OPC, uint32_t Addr)
+/* Shift or rotate memory */
+{
+    WriteM (Addr, OpShift (OPC, ReadM (Addr)));
+}
+
+
+
+static void OpIncMem (uint32_t Addr, int Delta)
+/* Increment or decrement memory */
+{
+    unsigned Val = (ReadM (Addr) + Delta) & (ACC8? 0xFF : 0xFFFF);
+    TestNZ (Val, !ACC8);
+    WriteM (Addr, Val);
+}
+
+
+
+static void OpTestBits (uint32_t Addr, bool Set)
+/* TSB and TRB */
+{
+    unsigned Val = ReadM (Addr);
+    SetFlag (ZF, (Val & GetAM ()) == 0);
+    WriteM (Addr, Set? (Val | GetAM ()) : (Val & ~GetAM ()));
+}
+
+
+
+static void OpBranch (bool Cond)
+/* Conditional and unconditional short branches */
+{
+    uint16_t PC   = Regs.PC - 1;
+    int8_t   Offs = (int8_t) Fetch8 ();
+
+    if (Cond) {
+        uint16_t Target = Regs.PC + Offs;
+        ++Cycles;
+        if (Regs.E && (Target >> 8) != (Regs.PC >> 8)) {
+            ++Cycles;
+            ++PageCrossings;
+        }
+        Regs.PC = Target;
+    }
+
+    /* Coverage is recorded for bank 0 only */
+    if (CoverageMap && Regs.PBR == 0) {
+        CoverageMap[PC] |= Cond? COV_TAKEN : COV_NOT_TAKEN;
+    }
+}
+
+
+
+static void OpBlockMove (int Delta)
+/* MVN and MVP. One byte is moved per execution; the instruction is repeated
+** until the accumulator wraps to $FFFF.
+*/
+{
+    uint8_t  Dst  = Fetch8 ();
+    uint8_t  Src  = Fetch8 ();
+    unsigned Mask = IDX8? 0xFF : 0xFFFF;
+    unsigned X    = GET_X;
+    unsigned Y    = GET_Y;
+    unsigned Count;
+
+    Regs.DBR = Dst;
+    Write8 (((uint32_t) Dst << 16) | Y, Read8 (((uint32_t) Src << 16) | X));
+    X = (X + Delta) & Mask;
+    Y = (Y + Delta) & Mask;
+    Regs.XR = (uint8_t) X;
+    Regs.XH = (uint8_t) (X >> 8);
+    Regs.YR = (uint8_t) Y;
+    Regs.YH = (uint8_t) (Y >> 8);
+    Count = (GET_A - 1) & 0xFFFF;
+    SetA16 (Count);
+    if (Count != 0xFFFF) {
+        Regs.PC -= 3;
+    }
+}
+
+
+
+static void CheckHooks (void)
+/* Run a paravirtualization hook after a jump or call into bank zero */
+{
+    if (Regs.PBR == 0) {
+        Cycles += ParaVirtHooks (&Regs);
+    }
+}
+
+
+
+static void EnterInterrupt (uint16_t EmuVector, uint16_t NativeVector, bool Break)
+/* Push the return address and the status, and jump through a vector. BRK and
+** COP push the status with the B flag set in emulation mode.
+*/
+{
+    if (Regs.E) {
+        Push16 (Regs.PC);
+        Push8 (Break? (Regs.SR | BF) : (Regs.SR & ~BF));
+    } else {
+        Push8 (Regs.PBR);
+        Push16 (Regs.PC);
+        Push8 (Regs.SR);
+        ++Cycles;
+    }
+    Regs.SR |= IF;
+    Regs.SR &= ~DF;
+    Regs.PBR = 0;
+    Regs.PC  = Read16 (Regs.E? EmuVector : NativeVector);
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+unsigned Interrupt65816 (bool NMI)
+/* Enter an interrupt handler for an NMI or IRQ. Return the number of clock
+** cycles used.
+*/
+{
+    Cycles = 7;
+    if (NMI) {
+        EnterInterrupt (0xFFFA, 0xFFEA, false);
+    } else {
+        EnterInterrupt (0xFFFE, 0xFFEE, false);
+    }
+    return Cycles;
+}
+
+
+
+unsigned Step65816 (void)
+/* Execute one 65816 instruction and return the number of clock cycles it
+** took. The registers are kept in Regs, with the high bytes in the fields
+** for the 65816.
+*/
+{
+    uint8_t  OPC = Fetch8 ();
+    uint32_t Addr;
+    unsigned Val;
+
+    Cycles = BaseCycles[OPC];
+
+    switch (OPC) {
+
+        /* Interrupts and returns */
+        case 0x00:      /* BRK */
+            Fetch8 ();
+            EnterInterrupt (0xFFFE, 0xFFE6, true);
+            break;
+        case 0x02:      /* COP */
+            Fetch8 ();
+            EnterInterrupt (0xFFF4, 0xFFE4, true);
+            break;
+        case 0x40:      /* RTI */
+            Regs.SR = Pull8 ();
+            UpdateMode ();
+            Regs.PC = Pull16 ();
+            if (!Regs.E) {
+                Regs.PBR = Pull8 ();
+                ++Cycles;
+            }
+            break;
+        case 0x60:      /* RTS */
+            Regs.PC = Pull16 () + 1;
+            break;
+        case 0x6B:      /* RTL */
+            Regs.PC  = Pull16 () + 1;
+            Regs.PBR = Pull8 ();
+            break;
+
+        /* Jumps and calls */
+        case 0x4C:      /* JMP a */
+            Regs.PC = Fetch16 ();
+            CheckHooks ();
+            break;
+        case 0x5C:      /* JML al */
+            Addr = Fetch24 ();
+            Regs.PC  = (uint16_t) Addr;
+            Regs.PBR = (uint8_t) (Addr >> 16);
+            break;
+        case 0x6C:      /* JMP (a) */
+            Regs.PC = Read16 (Fetch16 ());
+            CheckHooks ();
+            break;
+        case 0x7C:      /* JMP (a,x) */
+            Regs.PC = Read16 (PROGRAM_BANK | ((Fetch16 () + GET_X) & 0xFFFF));
+            CheckHooks ();
+            break;
+        case 0xDC:      /* JML [a] */
+            Addr = Fetch16 ();
+            Regs.PC  = Read16 (Addr);
+            Regs.PBR = Read8 (Addr + 2);
+            break;
+        case 0x20:      /* JSR a */
+            Val = Fetch16 ();
+            Push16 (Regs.PC - 1);
+            Regs.PC = Val;
+            CheckHooks ();
+            break;
+        case 0x22:      /* JSL al */
+            Addr = Fetch24 ();
+            Push8 (Regs.PBR);
+            Push16 (Regs.PC - 1);
+            Regs.PC  = (uint16_t) Addr;
+            Regs.PBR = (uint8_t) (Addr >> 16);
+            break;
+        case 0xFC:      /* JSR (a,x) */
+            Val = Fetch16 ();
+            Push16 (Regs.PC - 1);
+            Regs.PC = Read16 (PROGRAM_BANK | ((Val + GET_X) & 0xFFFF));
+            CheckHooks ();
+            break;
+
+        /* Branches */
+        case 0x10:      OpBranch ((Regs.SR & SF) == 0);         break;
+        case 0x30:      OpBranch ((Regs.SR & SF) != 0);         break;
+        case 0x50:      OpBranch ((Regs.SR & OF) == 0);         break;
+        case 0x70:      OpBranch ((Regs.SR & OF) != 0);         break;
+        case 0x80:      OpBranch (true);                        break;
+        case 0x90:      OpBranch ((Regs.SR & CF) == 0);         break;
+        case 0xB0:      OpBranch ((Regs.SR & CF) != 0);         break;
+        case 0xD0:      OpBranch ((Regs.SR & ZF) == 0);         break;
+        case 0xF0:      OpBranch ((Regs.SR & ZF) != 0);         break;
+        case 0x82:      /* BRL */
+            Val = Fetch16 ();
+            Regs.PC += Val;
+            break;
+
+        /* Flags and modes */
+        case 0x18:      Regs.SR &= ~CF;                         break;
+        case 0x38:      Regs.SR |= CF;                          break;
+        case 0x58:      Regs.SR &= ~IF;                         break;
+        case 0x78:      Regs.SR |= IF;                          break;
+        case 0xB8:      Regs.SR &= ~OF;                         break;
+        case 0xD8:      Regs.SR &= ~DF;                         break;
+        case 0xF8:      Regs.SR |= DF;                          break;
+        case 0xC2:      /* REP */
+            Regs.SR &= ~Fetch8 ();
+            UpdateMode ();
+            break;
+        case 0xE2:      /* SEP */
+            Regs.SR |= Fetch8 ();
+            UpdateMode ();
+            break;
+        case 0xFB:      /* XCE */
+            Val = Regs.E;
+            Regs.E = (Regs.SR & CF) != 0;
+            SetFlag (CF, Val != 0);
+            UpdateMode ();
+            break;
+
+        /* Transfers */
+        case 0xAA:      SetX (ACC8 && IDX8? Regs.AC : GET_A);   break;  /* TAX */
+        case 0xA8:      SetY (ACC8 && IDX8? Regs.AC : GET_A);   break;  /* TAY */
+        case 0x8A:      SetAM (GET_X);                          break;  /* TXA */
+        case 0x98:      SetAM (GET_Y);                          break;  /* TYA */
+        case 0x9B:      SetY (GET_X);                           break;  /* TXY */
+        case 0xBB:      SetX (GET_Y);                           break;  /* TYX */
+        case 0xBA:      SetX (GET_S);                           break;  /* TSX */
+        case 0x9A:      SetS (GET_X);                           break;  /* TXS */
+        case 0x1B:      SetS (GET_A);                           break;  /* TCS */
+        case 0x3B:      SetA16 (GET_S); TestNZ (GET_A, true);   break;  /* TSC */
+        case 0x5B:      Regs.DP = GET_A; TestNZ (GET_A, true);  break;  /* TCD */
+        case 0x7B:      SetA16 (Regs.DP); TestNZ (GET_A, true); break;  /* TDC */
+        case 0xEB:      /* XBA */
+            Val = Regs.AC;
+            Regs.AC = Regs.AH;
+            Regs.AH = (uint8_t) Val;
+            TestNZ (Regs.AC, false);
+            break;
+
+        /* Stack */
+        case 0x48:      /* PHA */
+            if (ACC8) {
+                Push8 (Regs.AC);
+            } else {
+                Push16 (GET_A);
+                ++Cycles;
+            }
+            break;
+        case 0x68:      /* PLA */
+            if (ACC8) {
+                SetAM (Pull8 ());
+            } else {
+                SetAM (Pull16 ());
+                ++Cycles;
+            }
+            break;
+        case 0xDA:      /* PHX */
+        case 0x5A:      /* PHY */
+            Val = (OPC == 0xDA)? GET_X : GET_Y;
+            if (IDX8) {
+                Push8 ((uint8_t) Val);
+            } else {
+                Push16 (Val);
+                ++Cycles;
+            }
+            break;
+        case 0xFA:      /* PLX */
+        case 0x7A:      /* PLY */
+            if (IDX8) {
+                Val = Pull8 ();
+            } else {
+                Val = Pull16 ();
+                ++Cycles;
+            }
+            if (OPC == 0xFA) {
+                SetX (Val);
+            } else {
+                SetY (Val);
+            }
+            break;
+        case 0x08:      Push8 (Regs.SR);                        break;  /* PHP */
+        case 0x28:      Regs.SR = Pull8 (); UpdateMode ();      break;  /* PLP */
+        case 0x8B:      Push8 (Regs.DBR);                       break;  /* PHB */
+        case 0xAB:      /* PLB */
+            Regs.DBR = Pull8 ();
+            TestNZ (Regs.DBR, false);
+            break;
+        case 0x0B:      Push16 (Regs.DP);                       break;  /* PHD */
+        case 0x2B:      /* PLD */
+            Regs.DP = Pull16 ();
+            TestNZ (Regs.DP, true);
+            break;
+        case 0x4B:      Push8 (Regs.PBR);                       break;  /* PHK */
+        case 0xF4:      Push16 (Fetch16 ());                    break;  /* PEA */
+        case 0xD4:      Push16 (DirectPtr (FetchDirect ()));    break;  /* PEI */
+        case 0x62:      /* PER */
+            Val = Fetch16 ();
+            Push16 (Regs.PC + Val);
+            break;
+
+        /* Index registers */
+        case 0xA2:      SetX (FetchX ());                       break;  /* LDX # */
+        case 0xA6:      SetX (ReadX (EA_Dir ()));               break;  /* LDX d */
+        case 0xB6:      SetX (ReadX (EA_DirY ()));              break;  /* LDX d,y */
+        case 0xAE:      SetX (ReadX (EA_Abs ()));               break;  /* LDX a */
+        case 0xBE:      SetX (ReadX (EA_AbsY (true)));          break;  /* LDX a,y */
+        case 0xA0:      SetY (FetchX ());                       break;  /* LDY # */
+        case 0xA4:      SetY (ReadX (EA_Dir ()));               break;  /* LDY d */
+        case 0xB4:      SetY (ReadX (EA_DirX ()));              break;  /* LDY d,x */
+        case 0xAC:      SetY (ReadX (EA_Abs ()));               break;  /* LDY a */
+        case 0xBC:      SetY (ReadX (EA_AbsX (true)));          break;  /* LDY a,x */
+        case 0x86:      WriteX (EA_Dir (), GET_X);              break;  /* STX d */
+        case 0x96:      WriteX (EA_DirY (), GET_X);             break;  /* STX d,y */
+        case 0x8E:      WriteX (EA_Abs (), GET_X);              break;  /* STX a */
+        case 0x84:      WriteX (EA_Dir (), GET_Y);              break;  /* STY d */
+        case 0x94:      WriteX (EA_DirX (), GET_Y);             break;  /* STY d,x */
+        case 0x8C:      WriteX (EA_Abs (), GET_Y);              break;  /* STY a */
+        case 0xE0:      OpCompare (GET_X, FetchX (), !IDX8);    break;  /* CPX # */
+        case 0xE4:      OpCompare (GET_X, ReadX (EA_Dir ()), !IDX8); break;
+        case 0xEC:      OpCompare (GET_X, ReadX (EA_Abs ()), !IDX8); break;
+        case 0xC0:      OpCompare (GET_Y, FetchX (), !IDX8);    break;  /* CPY # */
+        case 0xC4:      OpCompare (GET_Y, ReadX (EA_Dir ()), !IDX8); break;
+        case 0xCC:      OpCompare (GET_Y, ReadX (EA_Abs ()), !IDX8); break;
+        case 0xE8:      SetX (GET_X + 1);                       break;  /* INX */
+        case 0xC8:      SetY (GET_Y + 1);                       break;  /* INY */
+        case 0xCA:      SetX (GET_X - 1);                       break;  /* DEX */
+        case 0x88:      SetY (GET_Y - 1);                       break;  /* DEY */
+
+        /* Read-modify-write */
+        case 0x0A:      /* ASL A */
+        case 0x2A:      /* ROL A */
+        case 0x4A:      /* LSR A */
+        case 0x6A:      /* ROR A */
+            SetAM (OpShift (OPC, GetAM ()));
+            break;
+        case 0x06: case 0x26: case 0x46: case 0x66:
+            OpShiftMem (OPC, EA_Dir ());
+            break;
+        case 0x0E: case 0x2E: case 0x4E: case 0x6E:
+            OpShiftMem (OPC, EA_Abs ());
+            break;
+        case 0x16: case 0x36: case 0x56: case 0x76:
+            OpShiftMem (OPC, EA_DirX ());
+            break;
+        case 0x1E: case 0x3E: case 0x5E: case 0x7E:
+            OpShiftMem (OPC, EA_AbsX (false));
+            break;
+        case 0x1A:      SetAM (GetAM () + 1);                   break;  /* INC A */
+        case 0x3A:      SetAM (GetAM () - 1);                   break;  /* DEC A */
+        case 0xE6:      OpIncMem (EA_Dir (), 1);                break;
+        case 0xF6:      OpIncMem (EA_DirX (), 1);               break;
+        case 0xEE:      OpIncMem (EA_Abs (), 1);                break;
+        case 0xFE:      OpIncMem (EA_AbsX (false), 1);          break;
+        case 0xC6:      OpIncMem (EA_Dir (), -1);               break;
+        case 0xD6:      OpIncMem (EA_DirX (), -1);              break;
+        case 0xCE:      OpIncMem (EA_Abs (), -1);               break;
+        case 0xDE:      OpIncMem (EA_AbsX (false), -1);         break;
+        case 0x04:      OpTestBits (EA_Dir (), true);           break;  /* TSB */
+        case 0x0C:      OpTestBits (EA_Abs (), true);           break;
+        case 0x14:      OpTestBits (EA_Dir (), false);          break;  /* TRB */
+        case 0x1C:      OpTestBits (EA_Abs (), false);          break;
+
+        /* Accumulator and memory */
+        case 0x89:      /* BIT # only changes the Z flag */
+            SetFlag (ZF, (GetAM () & FetchM ()) == 0);
+            break;
+        case 0x24:      OpBIT (ReadM (EA_Dir ()));              break;
+        case 0x34:      OpBIT (ReadM (EA_DirX ()));             break;
+        case 0x2C:      OpBIT (ReadM (EA_Abs ()));              break;
+        case 0x3C:      OpBIT (ReadM (EA_AbsX (true)));         break;
+        case 0x64:      WriteM (EA_Dir (), 0);                  break;  /* STZ */
+        case 0x74:      WriteM (EA_DirX (), 0);                 break;
+        case 0x9C:      WriteM (EA_Abs (), 0);                  break;
+        case 0x9E:      WriteM (EA_AbsX (false), 0);            break;
+
+        /* Block moves */
+        case 0x54:      OpBlockMove (1);                        break;  /* MVN */
+        case 0x44:      OpBlockMove (-1);                       break;  /* MVP */
+
+        /* Others */
+        case 0xEA:      /* NOP */
+            break;
+        case 0x42:      /* WDM */
+            Fetch8 ();
+            break;
+        case 0xCB:      /* WAI */
+            if (GetPendingInterrupts () == 0) {
+                Regs.PC -= 1;
+            }
+            break;
+        case 0xDB:      /* STP */
+            Error ("STP instruction at address $%02X:%04X",
+                   Regs.PBR, (uint16_t) (Regs.PC - 1));
+
+        /* The eight ALU instructions, with the addressing mode in the low
+        ** five bits of the opcode.
+        */
+        default:
+            if ((OPC & 0x1F) == 0x09) {
+                Val = FetchM ();
+            } else if ((OPC & 0xE0) == 0x80) {
+                WriteM (EA_Alu (OPC, false), GetAM ());         /* STA */
+                break;
+            } else {
+                Val = ReadM (EA_Alu (OPC, true));
+            }
+            switch (OPC >> 5) {
+                case 0:         SetAM (GetAM () | Val);                 break;  /* ORA */
+                case 1:         SetAM (GetAM () & Val);                 break;  /* AND */
+                case 2:         SetAM (GetAM () ^ Val);                 break;  /* EOR */
+                case 3:         OpADC (Val);                            break;  /* ADC */
+                case 5:         SetAM (Val);                            break;  /* LDA */
+                case 6:         OpCompare (GetAM (), Val, !ACC8);       break;  /* CMP */
+                default:        OpSBC (Val);                            break;  /* SBC */
+            }
+            break;
+    }
+
+    return Cycles;
+}
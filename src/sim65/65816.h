@@ -0,0 +1,62 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  65816.h                                  */
+/*                                                                           */
+/*                           CPU core for the 65816                          */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#ifndef _65816_H
+#define _65816_H
+
+
+#include <stdbool.h>
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+unsigned Step65816 (void);
+/* Execute one 65816 instruction and return the number of clock cycles it
+** took. The registers are kept in Regs, with the high bytes in the fields
+** for the 65816.
+*/
+
+unsigned Interrupt65816 (bool NMI);
+/* Enter an interrupt handler for an NMI or IRQ. Return the number of clock
+** cycles used.
+*/
+
+
+
+/* End of 65816.h */
+
+#endif
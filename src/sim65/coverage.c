@@ -0,0 +1,576 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coverage.c                                */
+/*                                                                           */
+/*                 Code coverage for the sim65 6502 simulator                */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* common */
+#include "coll.h"
+#include "strbuf.h"
+#include "strpool.h"
+#include "xmalloc.h"
+
+/* dbginfo */
+#include "../dbginfo/dbginfo.h"
+
+/* sim65 */
+#include "6502.h"
+#include "coverage.h"
+#include "error.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Coverage files start with this signature, followed by a version byte */
+static const unsigned char CoverageSignature[] = {
+    's', 'i', 'm', '6', '5', 'C'
+};
+#define COVERAGE_VERSION        1
+
+/* Flag used by the report for lines that have addresses assigned */
+#define COV_OWNED       0x80
+
+/* Coverage map with one byte of flags per address */
+uint8_t* CoverageMap = 0;
+
+/* Length of each opcode if it is a conditional branch, zero otherwise */
+uint8_t CoverageBranchLen[256];
+
+/* Output file and debug info file names */
+static const char* OutputName;
+static const char* DbgName;
+
+/* An entry in the report. Entries with Site == 0 describe a source line,
+** the other ones a branch in that line. Site is the offset of the branch
+** from the start of the line plus one, so branches in library code match
+** even if the code was linked to different addresses.
+*/
+typedef struct CovEntry CovEntry;
+struct CovEntry {
+    unsigned    Source;                 /* Index of source name in the pool */
+    unsigned    Line;                   /* Line number */
+    unsigned    Site;                   /* Branch site, zero for the line */
+    uint8_t     Flags;                  /* Set of COV_xxx flags */
+};
+
+/* A source line of one program */
+typedef struct CovLine CovLine;
+struct CovLine {
+    unsigned    Source;                 /* Index of source name in the pool */
+    unsigned    Line;                   /* Line number */
+    unsigned    Start;                  /* Lowest address of the line */
+    int         Ext;                    /* Line info is from a C file */
+};
+
+
+
+/*****************************************************************************/
+/*                                Collecting                                 */
+/*****************************************************************************/
+
+
+
+void CoverageInit (const char* aOutputName, const char* aDbgName)
+/* Enable coverage collection. The coverage map is written to OutputName
+** when the simulation ends. DbgName is the name of the debug info file for
+** the program or NULL. It is stored in the output file, so the report can
+** map addresses to source lines. Must be called after the CPU type is
+** known.
+*/
+{
+    unsigned OPC;
+
+    OutputName = aOutputName;
+    DbgName    = aDbgName;
+
+    /* Conditional branches, and BBRx/BBSx on the 65C02 */
+    for (OPC = 0; OPC < 0x100; ++OPC) {
+        if ((OPC & 0x1F) == 0x10) {
+            CoverageBranchLen[OPC] = 2;
+        } else if (CPU == CPU_65C02 && (OPC & 0x0F) == 0x0F) {
+            CoverageBranchLen[OPC] = 3;
+        } else {
+            CoverageBranchLen[OPC] = 0;
+        }
+    }
+
+    CoverageMap = xmalloc (0x10000);
+    memset (CoverageMap, 0, 0x10000);
+
+    /* Decode the code again with the handlers for coverage */
+    InvalidateCodeCache ();
+}
+
+
+
+void CoverageWrite (void)
+/* Write the coverage map to the output file */
+{
+    size_t Len = DbgName? strlen (DbgName) : 0;
+    unsigned char Buf[3];
+    FILE* F;
+
+    if (CoverageMap == 0) {
+        return;
+    }
+
+    F = fopen (OutputName, "wb");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", OutputName, strerror (errno));
+    }
+
+    /* Header, name of the debug info file and the map itself */
+    Buf[0] = COVERAGE_VERSION;
+    Buf[1] = (unsigned char) Len;
+    Buf[2] = (unsigned char) (Len >> 8);
+    if (fwrite (CoverageSignature, 1, sizeof (CoverageSignature), F) != sizeof (CoverageSignature) ||
+        fwrite (Buf, 1, sizeof (Buf), F) != sizeof (Buf)                                          ||
+        fwrite (DbgName, 1, Len, F) != Len                                                        ||
+        fwrite (CoverageMap, 1, 0x10000, F) != 0x10000) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+    if (fclose (F) != 0) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+
+    xfree (CoverageMap);
+    CoverageMap = 0;
+}
+
+
+
+/*****************************************************************************/
+/*                                 Reporting                                 */
+/*****************************************************************************/
+
+
+
+static void DbgError (const cc65_parseerror* E)
+/* Report an error or warning from reading the debug info */
+{
+    if (E->type == CC65_WARNING) {
+        Warning ("%s:%u: %s", E->name, E->line, E->errormsg);
+    } else {
+        Error ("%s:%u: %s", E->name, E->line, E->errormsg);
+    }
+}
+
+
+
+static int IsCodeSegment (const char* Name)
+/* Return true if the segment with the given name contains code. The debug
+** info doesn't have the segment type, so go by the names used by the cc65
+** runtime and the compiler.
+*/
+{
+    size_t Len = strlen (Name);
+    return (Len >= 4 && strcmp (Name + Len - 4, "CODE") == 0) ||
+           strcmp (Name, "STARTUP") == 0                      ||
+           strcmp (Name, "ONCE") == 0;
+}
+
+
+
+static int CmpEntry (const void* A, const void* B)
+/* Compare two report entries by source, line and site */
+{
+    const CovEntry* L = A;
+    const CovEntry* R = B;
+    if (L->Source != R->Source) {
+        return L->Source < R->Source? -1 : 1;
+    }
+    if (L->Line != R->Line) {
+        return L->Line < R->Line? -1 : 1;
+    }
+    if (L->Site != R->Site) {
+        return L->Site < R->Site? -1 : 1;
+    }
+    return 0;
+}
+
+
+
+static char* ReadCoverageFile (const char* Name, uint8_t* Map)
+/* Read a coverage file into Map and return the name of the debug info file
+** stored in it, or NULL if there is none. The name must be freed by the
+** caller.
+*/
+{
+    unsigned char Sig[sizeof (CoverageSignature)];
+    unsigned char Buf[3];
+    unsigned      Len;
+    char*         DbgFile = 0;
+
+    FILE* F = fopen (Name, "rb");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+    if (fread (Sig, 1, sizeof (Sig), F) != sizeof (Sig) ||
+        memcmp (Sig, CoverageSignature, sizeof (Sig)) != 0 ||
+        fread (Buf, 1, sizeof (Buf), F) != sizeof (Buf)) {
+        Error ("'%s' is not a sim65 coverage file", Name);
+    }
+    if (Buf[0] != COVERAGE_VERSION) {
+        Error ("'%s': Unsupported coverage file version %u", Name, Buf[0]);
+    }
+    Len = Buf[1] | (Buf[2] << 8);
+    if (Len > 0) {
+        DbgFile = xmalloc (Len + 1);
+        if (fread (DbgFile, 1, Len, F) != Len) {
+            Error ("'%s': Unexpected end of file", Name);
+        }
+        DbgFile[Len] = '\0';
+    }
+    if (fread (Map, 1, 0x10000, F) != 0x10000) {
+        Error ("'%s': Unexpected end of file", Name);
+    }
+    fclose (F);
+
+    return DbgFile;
+}
+
+
+
+static void AssignLines (cc65_dbginfo Info, CovLine* Lines, unsigned* Count,
+                         unsigned* LineOf, StringPool* Sources)
+/* Assign a source line to every address with code. LineOf is indexed by
+** address and receives the index of the line in Lines plus one, or zero if
+** there's no line. C source lines are preferred over assembler lines.
+*/
+{
+    const cc65_spaninfo* Spans = cc65_get_spanlist (Info);
+    unsigned I, J;
+
+    if (Spans == 0) {
+        return;
+    }
+
+    for (I = 0; I < Spans->count; ++I) {
+        const cc65_spandata*    Span = Spans->data + I;
+        const cc65_segmentinfo* Seg;
+        const cc65_lineinfo*    L;
+        const cc65_linedata*    Best = 0;
+        const cc65_sourceinfo*  S;
+        CovLine*                Line;
+        unsigned                Addr;
+        int                     Code;
+
+        if (Span->span_start > 0xFFFF || Span->span_end > 0xFFFF) {
+            continue;
+        }
+
+        /* Ignore data */
+        Seg = cc65_segment_byid (Info, Span->segment_id);
+        Code = Seg && IsCodeSegment (Seg->data[0].segment_name);
+        cc65_free_segmentinfo (Info, Seg);
+        if (!Code) {
+            continue;
+        }
+
+        /* Find the line for this span */
+        L = cc65_line_byspan (Info, Span->span_id);
+        if (L == 0) {
+            continue;
+        }
+        for (J = 0; J < L->count; ++J) {
+            const cc65_linedata* D = L->data + J;
+            if (D->line_type == CC65_LINE_EXT ||
+                (Best == 0 && D->line_type == CC65_LINE_ASM)) {
+                Best = D;
+            }
+        }
+        if (Best == 0) {
+            cc65_free_lineinfo (Info, L);
+            continue;
+        }
+
+        /* Add the line. Spans for one line are usually next to each other
+        ** in the list, so checking the last one avoids most duplicates.
+        */
+        S = cc65_source_byid (Info, Best->source_id);
+        Line = Lines + *Count;
+        Line->Source = SP_AddStr (Sources, S? S->data[0].source_name : "?");
+        Line->Line   = Best->source_line;
+        Line->Start  = Span->span_start;
+        Line->Ext    = Best->line_type == CC65_LINE_EXT;
+        cc65_free_sourceinfo (Info, S);
+        cc65_free_lineinfo (Info, L);
+        if (*Count > 0 && Line[-1].Source == Line->Source && Line[-1].Line == Line->Line) {
+            --Line;
+            if (Line->Start > Span->span_start) {
+                Line->Start = Span->span_start;
+            }
+        } else {
+            ++*Count;
+        }
+
+        /* Assign the addresses */
+        for (Addr = Span->span_start; Addr <= Span->span_end; ++Addr) {
+            if (LineOf[Addr] == 0 || (Line->Ext && !Lines[LineOf[Addr] - 1].Ext)) {
+                LineOf[Addr] = (Line - Lines) + 1;
+            }
+        }
+    }
+
+    cc65_free_spaninfo (Info, Spans);
+}
+
+
+
+static CovEntry* CollectEntries (const char* Name, StringPool* Sources, unsigned* Count)
+/* Read one coverage file and return its entries sorted by source, line and
+** site. Entries for the same line are merged.
+*/
+{
+    uint8_t*     Map    = xmalloc (0x10000);
+    unsigned*    LineOf = xmalloc (0x10000 * sizeof (unsigned));
+    CovLine*     Lines  = xmalloc (0x10000 * sizeof (CovLine));
+    unsigned     LineCount = 0;
+    CovEntry*    Entries;
+    cc65_dbginfo Info;
+    char*        DbgFile;
+    unsigned     Addr, I, J;
+
+    DbgFile = ReadCoverageFile (Name, Map);
+    if (DbgFile == 0) {
+        Error ("'%s' was written without debug info (use --dbgfile)", Name);
+    }
+    Info = cc65_read_dbginfo (DbgFile, DbgError);
+    if (Info == 0) {
+        Error ("Cannot read debug info from '%s'", DbgFile);
+    }
+
+    memset (LineOf, 0, 0x10000 * sizeof (unsigned));
+    AssignLines (Info, Lines, &LineCount, LineOf, Sources);
+
+    /* One entry per line, and one per branch that was executed */
+    Entries = xmalloc ((LineCount + 0x10000) * sizeof (CovEntry));
+    for (I = 0; I < LineCount; ++I) {
+        Entries[I].Source = Lines[I].Source;
+        Entries[I].Line   = Lines[I].Line;
+        Entries[I].Site   = 0;
+        Entries[I].Flags  = 0;
+    }
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        if (LineOf[Addr] == 0) {
+            continue;
+        }
+        J = LineOf[Addr] - 1;
+        Entries[J].Flags |= COV_OWNED;
+        if (Map[Addr] == 0) {
+            continue;
+        }
+        Entries[J].Flags |= COV_EXEC;
+        if (Map[Addr] & (COV_TAKEN | COV_NOT_TAKEN)) {
+            CovEntry* E = Entries + I++;
+            E->Source = Lines[J].Source;
+            E->Line   = Lines[J].Line;
+            E->Site   = Addr - Lines[J].Start + 1;
+            E->Flags  = Map[Addr];
+        }
+    }
+
+    /* Sort and merge. Lines that lost all their addresses to C source lines
+    ** are dropped.
+    */
+    qsort (Entries, I, sizeof (CovEntry), CmpEntry);
+    for (J = 0, *Count = 0; J < I; ++J) {
+        if (Entries[J].Site == 0) {
+            if ((Entries[J].Flags & COV_OWNED) == 0) {
+                continue;
+            }
+            Entries[J].Flags &= ~COV_OWNED;
+        }
+        if (*Count > 0 && CmpEntry (Entries + *Count - 1, Entries + J) == 0) {
+            Entries[*Count - 1].Flags |= Entries[J].Flags;
+        } else {
+            Entries[(*Count)++] = Entries[J];
+        }
+    }
+
+    cc65_free_dbginfo (Info);
+    xfree (DbgFile);
+    xfree (Lines);
+    xfree (LineOf);
+    xfree (Map);
+    return Entries;
+}
+
+
+
+static CovEntry* MergeEntries (CovEntry* A, unsigned ACount,
+                               CovEntry* B, unsigned BCount, unsigned* Count)
+/* Merge two sorted lists of entries into a new one. The input lists are
+** freed.
+*/
+{
+    CovEntry* Result = xmalloc ((ACount + BCount + 1) * sizeof (CovEntry));
+    unsigned  I = 0, J = 0;
+
+    *Count = 0;
+    while (I < ACount || J < BCount) {
+        int Cmp = (I == ACount)? 1 : (J == BCount)? -1 : CmpEntry (A + I, B + J);
+        if (Cmp < 0) {
+            Result[(*Count)++] = A[I++];
+        } else if (Cmp > 0) {
+            Result[(*Count)++] = B[J++];
+        } else {
+            Result[*Count] = A[I++];
+            Result[(*Count)++].Flags |= B[J++].Flags;
+        }
+    }
+
+    xfree (A);
+    xfree (B);
+    return Result;
+}
+
+
+
+static int CmpSourceName (void* Data, const void* A, const void* B)
+/* Compare two groups of entries by the name of their source file */
+{
+    const StringPool* Sources = Data;
+    const CovEntry*   L = A;
+    const CovEntry*   R = B;
+    return strcmp (SB_GetConstBuf (SP_Get (Sources, L->Source)),
+                   SB_GetConstBuf (SP_Get (Sources, R->Source)));
+}
+
+
+
+static double Percent (unsigned Part, unsigned Total)
+/* Return Part as a percentage of Total */
+{
+    return Total? (100.0 * Part) / Total : 100.0;
+}
+
+
+
+void CoverageReport (const char* OutputName, unsigned Count, char* const* Files)
+/* Read Count coverage files written by CoverageWrite, merge them by source
+** line and write a report to OutputName.
+*/
+{
+    StringPool* Sources = NewStringPool (1103);
+    Collection  Groups = STATIC_COLLECTION_INITIALIZER;
+    CovEntry*   Entries = 0;
+    unsigned    EntryCount = 0;
+    unsigned    I;
+    FILE*       F;
+
+    if (Count == 0) {
+        Error ("No coverage files");
+    }
+
+    /* Read and merge all files */
+    for (I = 0; I < Count; ++I) {
+        unsigned  NewCount;
+        CovEntry* New = CollectEntries (Files[I], Sources, &NewCount);
+        Entries = MergeEntries (Entries, EntryCount, New, NewCount, &EntryCount);
+    }
+
+    F = fopen (OutputName, "w");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", OutputName, strerror (errno));
+    }
+
+    /* Sort the source files by name. The entries are sorted by the index of
+    ** the name in the pool, so the first entry of each file stands for the
+    ** file.
+    */
+    for (I = 0; I < EntryCount; ++I) {
+        if (I == 0 || Entries[I].Source != Entries[I - 1].Source) {
+            CollAppend (&Groups, Entries + I);
+        }
+    }
+    CollSort (&Groups, CmpSourceName, Sources);
+
+    /* Summary per source file */
+    fprintf (F,
+             "Coverage summary:\n\n"
+             "   Lines     Hit       %%  Branches   Taken  NotTkn  Source\n");
+    for (I = 0; I < CollCount (&Groups); ++I) {
+        const CovEntry* First = CollConstAt (&Groups, I);
+        const CovEntry* E;
+        unsigned Lines = 0, Hit = 0, Branches = 0, Taken = 0, NotTaken = 0;
+        for (E = First; E < Entries + EntryCount && E->Source == First->Source; ++E) {
+            if (E->Site == 0) {
+                ++Lines;
+                Hit += (E->Flags & COV_EXEC) != 0;
+            } else {
+                ++Branches;
+                Taken    += (E->Flags & COV_TAKEN) != 0;
+                NotTaken += (E->Flags & COV_NOT_TAKEN) != 0;
+            }
+        }
+        fprintf (F, "%8u%8u  %6.2f  %8u%8u%8u  %s\n",
+                 Lines, Hit, Percent (Hit, Lines), Branches, Taken, NotTaken,
+                 SB_GetConstBuf (SP_Get (Sources, First->Source)));
+    }
+
+    /* Details for lines that were not executed and branches that went only
+    ** one way.
+    */
+    fprintf (F, "\nUncovered lines and branches:\n\n");
+    for (I = 0; I < CollCount (&Groups); ++I) {
+        const CovEntry* First = CollConstAt (&Groups, I);
+        const CovEntry* E;
+        const char*     Name = SB_GetConstBuf (SP_Get (Sources, First->Source));
+        for (E = First; E < Entries + EntryCount && E->Source == First->Source; ++E) {
+            if (E->Site == 0) {
+                if ((E->Flags & COV_EXEC) == 0) {
+                    fprintf (F, "%s:%u: not executed\n", Name, E->Line);
+                }
+            } else if ((E->Flags & COV_TAKEN) == 0) {
+                fprintf (F, "%s:%u: branch at +%u never taken\n", Name, E->Line, E->Site - 1);
+            } else if ((E->Flags & COV_NOT_TAKEN) == 0) {
+                fprintf (F, "%s:%u: branch at +%u always taken\n", Name, E->Line, E->Site - 1);
+            }
+        }
+    }
+
+    if (fclose (F) != 0) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+
+    DoneCollection (&Groups);
+    xfree (Entries);
+    FreeStringPool (Sources);
+}
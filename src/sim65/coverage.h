@@ -0,0 +1,100 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 coverage.h                                */
+/*                                                                           */
+/*                 Code coverage for the sim65 6502 simulator                */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+
+#include <stdint.h>
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Flags in the coverage map */
+#define COV_EXEC        0x01            /* Instruction was executed */
+#define COV_TAKEN       0x02            /* Branch was taken */
+#define COV_NOT_TAKEN   0x04            /* Branch was not taken */
+
+/* Coverage map with one byte of flags per address, NULL if coverage is not
+** collected.
+*/
+extern uint8_t* CoverageMap;
+
+/* Length of each opcode if it is a conditional branch, zero otherwise. The
+** CPU uses a handler for these opcodes that records whether the branch was
+** taken. A branch to the next instruction cannot be told apart from one
+** that is not taken, but that doesn't make a difference for the program.
+*/
+extern uint8_t CoverageBranchLen[256];
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void CoverageInit (const char* OutputName, const char* DbgName);
+/* Enable coverage collection. The coverage map is written to OutputName
+** when the simulation ends. DbgName is the name of the debug info file for
+** the program or NULL. It is stored in the output file, so the report can
+** map addresses to source lines. Must be called after the CPU type is
+** known.
+*/
+
+static inline void CoverageInsn (uint16_t PC)
+/* Mark the instruction at PC as executed. The outcome of conditional
+** branches is recorded by the CPU, see CoverageBranchLen.
+*/
+{
+    CoverageMap[PC] |= COV_EXEC;
+}
+
+void CoverageWrite (void);
+/* Write the coverage map to the output file */
+
+void CoverageReport (const char* OutputName, unsigned Count, char* const* Files);
+/* Read Count coverage files written by CoverageWrite, merge them by source
+** line and write a report to OutputName.
+*/
+
+
+
+/* End of coverage.h */
+
+#endif
@@ -36,10 +36,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <setjmp.h>
 #include <inttypes.h>
 
+#include "coverage.h"
 #include "error.h"
+#include "heatmap.h"
+#include "loops.h"
 #include "peripherals.h"
+#include "profile.h"
 
 
 /*****************************************************************************/
@@ -51,6 +56,12 @@
 /* flag to print cycles at program termination */
 int PrintCycles = 0;
 
+/* If not NULL, the simulation ends with a longjmp here instead of exiting */
+THREAD_LOCAL jmp_buf* SimExitJump = 0;
+
+/* Exit code of the simulation after a longjmp to SimExitJump */
+THREAD_LOCAL int SimExitCode;
+
 
 
 /*****************************************************************************/
@@ -59,6 +70,19 @@ int PrintCycles = 0;
 
 
 
+static void Terminate (int Code) attribute ((noreturn));
+static void Terminate (int Code)
+/* End the simulation with the given exit code */
+{
+    if (SimExitJump) {
+        SimExitCode = Code;
+        longjmp (*SimExitJump, 1);
+    }
+    exit (Code);
+}
+
+
+
 void Warning (const char* Format, ...)
 /* Print a warning message */
 {
@@ -81,7 +105,7 @@ void Error (const char* Format, ...)
     vfprintf (stderr, Format, ap);
     putc ('\n', stderr);
     va_end (ap);
-    exit (SIM65_ERROR);
+    Terminate (SIM65_ERROR);
 }
 
 
@@ -95,7 +119,7 @@ void ErrorCode (int Code, const char* Format, ...)
     vfprintf (stderr, Format, ap);
     putc ('\n', stderr);
     va_end (ap);
-    exit (Code);
+    Terminate (Code);
 }
 
 
@@ -109,7 +133,7 @@ void Internal (const char* Format, ...)
     vfprintf (stderr, Format, ap);
     putc ('\n', stderr);
     va_end (ap);
-    exit (SIM65_ERROR);
+    Terminate (SIM65_ERROR);
 }
 
 
@@ -120,5 +144,9 @@ void SimExit (int Code)
     if (PrintCycles) {
         fprintf (stdout, "%" PRIu64 " cycles\n", Peripherals.Counter.ClockCycles);
     }
-    exit (Code);
+    ProfileWrite ();
+    LoopsWrite ();
+    HeatmapWrite ();
+    CoverageWrite ();
+    Terminate (Code);
 }
@@ -38,8 +38,11 @@
 
 
 
+#include <setjmp.h>
+
 /* common */
 #include "attrib.h"
+#include "thread.h"
 
 
 
@@ -60,6 +63,15 @@
 extern int PrintCycles;
 /* flag to print cycles at program termination */
 
+extern THREAD_LOCAL jmp_buf* SimExitJump;
+/* If not NULL, SimExit and the error functions don't exit the program, but
+** store the exit code in SimExitCode and do a longjmp to SimExitJump. This
+** allows running several programs in one process.
+*/
+
+extern THREAD_LOCAL int SimExitCode;
+/* Exit code of the simulation after a longjmp to SimExitJump */
+
 
 
 /*****************************************************************************/
@@ -0,0 +1,226 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  event.c                                  */
+/*                                                                           */
+/*                   Cycle based event scheduler for sim65                   */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#include <stdint.h>
+
+/* common */
+#include "xmalloc.h"
+
+/* sim65 */
+#include "6502.h"
+#include "event.h"
+#include "peripherals.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* A scheduled event */
+typedef struct Event Event;
+struct Event {
+    uint64_t    Deadline;       /* Clock cycle when the event is due */
+    uint64_t    Seq;            /* Keeps events with equal deadlines in order */
+    EventFunc   Func;
+    void*       Data;
+};
+
+/* The scheduled events, as a binary min-heap ordered by deadline */
+static THREAD_LOCAL Event*   Events;
+static THREAD_LOCAL unsigned EventCount;
+static THREAD_LOCAL unsigned EventSize;
+static THREAD_LOCAL uint64_t EventSeq;
+
+
+
+/*****************************************************************************/
+/*                              Helper functions                             */
+/*****************************************************************************/
+
+
+
+static int Before (const Event* A, const Event* B)
+/* Return true if event A is due before event B */
+{
+    return A->Deadline < B->Deadline ||
+           (A->Deadline == B->Deadline && A->Seq < B->Seq);
+}
+
+
+
+static void SiftUp (unsigned I)
+/* Move the event at index I up until the heap order is restored */
+{
+    Event E = Events[I];
+    while (I > 0) {
+        unsigned Parent = (I - 1) / 2;
+        if (!Before (&E, &Events[Parent])) {
+            break;
+        }
+        Events[I] = Events[Parent];
+        I = Parent;
+    }
+    Events[I] = E;
+}
+
+
+
+static void SiftDown (unsigned I)
+/* Move the event at index I down until the heap order is restored */
+{
+    Event E = Events[I];
+    while (1) {
+        unsigned Child = 2 * I + 1;
+        if (Child >= EventCount) {
+            break;
+        }
+        if (Child + 1 < EventCount && Before (&Events[Child + 1], &Events[Child])) {
+            ++Child;
+        }
+        if (!Before (&Events[Child], &E)) {
+            break;
+        }
+        Events[I] = Events[Child];
+        I = Child;
+    }
+    Events[I] = E;
+}
+
+
+
+static void RemoveAt (unsigned I)
+/* Remove the event at index I from the heap */
+{
+    --EventCount;
+    if (I < EventCount) {
+        Events[I] = Events[EventCount];
+        SiftDown (I);
+        SiftUp (I);
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void EventSchedule (uint64_t Deadline, EventFunc Func, void* Data)
+/* Schedule a call to Func when the clock cycle counter reaches Deadline.
+** Events with the same deadline are run in the order they were scheduled.
+*/
+{
+    Event* E;
+
+    if (EventCount == EventSize) {
+        EventSize = EventSize? EventSize * 2 : 8;
+        Events = xrealloc (Events, EventSize * sizeof (Event));
+    }
+    E = &Events[EventCount++];
+    E->Deadline = Deadline;
+    E->Seq      = EventSeq++;
+    E->Func     = Func;
+    E->Data     = Data;
+    SiftUp (EventCount - 1);
+
+    /* The budget of a running ExecuteUntil doesn't know about the event */
+    ExecuteBreak ();
+}
+
+
+
+void EventCancel (EventFunc Func, void* Data)
+/* Remove all scheduled events with the given function and data */
+{
+    unsigned I = 0;
+    while (I < EventCount) {
+        if (Events[I].Func == Func && Events[I].Data == Data) {
+            RemoveAt (I);
+            /* Check the event moved to this index, and possibly others, again */
+            I = 0;
+        } else {
+            ++I;
+        }
+    }
+}
+
+
+
+uint64_t EventNextDeadline (void)
+/* Return the deadline of the next event, or EVENT_NEVER */
+{
+    return EventCount? Events[0].Deadline : EVENT_NEVER;
+}
+
+
+
+unsigned long long EventLimitBudget (unsigned long long Budget)
+/* Return the number of cycles ExecuteUntil may run before the next event is
+** due, but not more than Budget.
+*/
+{
+    uint64_t Now = Peripherals.Counter.ClockCycles;
+
+    if (EventCount == 0) {
+        return Budget;
+    }
+    if (Events[0].Deadline <= Now) {
+        return 0;
+    }
+    return (Events[0].Deadline - Now < Budget)? Events[0].Deadline - Now : Budget;
+}
+
+
+
+void EventRun (void)
+/* Run all events that are due */
+{
+    while (EventCount > 0 && Events[0].Deadline <= Peripherals.Counter.ClockCycles) {
+        Event E = Events[0];
+        RemoveAt (0);
+        E.Func (E.Data);
+    }
+}
+
+
+
+void EventReset (void)
+/* Remove all scheduled events */
+{
+    EventCount = 0;
+    EventSeq   = 0;
+}
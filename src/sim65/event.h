@@ -0,0 +1,90 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  event.h                                  */
+/*                                                                           */
+/*                   Cycle based event scheduler for sim65                   */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#ifndef EVENT_H
+#define EVENT_H
+
+
+
+#include <stdint.h>
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Function called when an event is due. Data is the value passed to
+** EventSchedule.
+*/
+typedef void (*EventFunc) (void* Data);
+
+/* Deadline returned by EventNextDeadline if no event is scheduled */
+#define EVENT_NEVER     UINT64_MAX
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void EventSchedule (uint64_t Deadline, EventFunc Func, void* Data);
+/* Schedule a call to Func when the clock cycle counter reaches Deadline.
+** Events with the same deadline are run in the order they were scheduled.
+*/
+
+void EventCancel (EventFunc Func, void* Data);
+/* Remove all scheduled events with the given function and data */
+
+uint64_t EventNextDeadline (void);
+/* Return the deadline of the next event, or EVENT_NEVER */
+
+unsigned long long EventLimitBudget (unsigned long long Budget);
+/* Return the number of cycles ExecuteUntil may run before the next event is
+** due, but not more than Budget.
+*/
+
+void EventRun (void);
+/* Run all events that are due */
+
+void EventReset (void);
+/* Remove all scheduled events */
+
+
+
+/* End of event.h */
+
+#endif
@@ -0,0 +1,565 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 heatmap.c                                 */
+/*                                                                           */
+/*             Memory access heatmap for the sim65 6502 simulator            */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+/* common */
+#include "xmalloc.h"
+
+/* dbginfo */
+#include "../dbginfo/dbginfo.h"
+
+/* sim65 */
+#include "6502.h"
+#include "error.h"
+#include "heatmap.h"
+#include "memory.h"
+#include "peripherals.h"
+#include "trace.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Raw data collected while the program runs. All arrays are indexed by
+** address.
+*/
+typedef struct HeatData HeatData;
+struct HeatData {
+    uint64_t            Reads[0x10000];         /* Data reads */
+    uint64_t            Writes[0x10000];        /* Data writes */
+    uint64_t            Uninit[0x10000];        /* Reads before first write */
+    uint16_t            FirstPC[0x10000];       /* First uninitialized read */
+    uint8_t             Written[0x10000];       /* Memory was initialized */
+};
+
+/* A group of addresses in the report. With debug info, this is the memory
+** from one label to the next, otherwise a single address.
+*/
+typedef struct HeatGroup HeatGroup;
+struct HeatGroup {
+    unsigned            Start;          /* First address */
+    unsigned            End;            /* Last address */
+    uint64_t            Reads;
+    uint64_t            Writes;
+    uint64_t            Uninit;
+};
+
+/* True if memory accesses are counted */
+bool HeatmapEnabled = false;
+
+/* Collected data, allocated when the heatmap is enabled */
+static HeatData* Heat;
+
+/* True until HeatmapStart is called */
+static bool Loading;
+
+/* The bytes of the instruction being executed */
+static uint16_t FetchPC;
+static unsigned FetchLen;
+
+/* Output file and debug info file names */
+static const char* OutputName;
+static const char* DbgName;
+
+/* The debug info, if any */
+static cc65_dbginfo DbgInfo;
+
+/* Labels from the debug info, and the label for each address */
+static const cc65_symbolinfo* Labels;
+static const cc65_symboldata** AddrToLabel;
+
+/* Characters used for the page map, from cold to hot */
+static const char HeatChars[] = " .:-=+*#%@";
+
+
+
+/*****************************************************************************/
+/*                                Collecting                                 */
+/*****************************************************************************/
+
+
+
+static void DbgError (const cc65_parseerror* E)
+/* Report an error or warning from reading the debug info */
+{
+    if (E->type == CC65_WARNING) {
+        Warning ("%s:%u: %s", E->name, E->line, E->errormsg);
+    } else {
+        Error ("%s:%u: %s", E->name, E->line, E->errormsg);
+    }
+}
+
+
+
+void HeatmapInit (const char* aOutputName, const char* aDbgName)
+/* Enable the heatmap. The report is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to name the accessed memory. Must be
+** called after MemInit and PeripheralsInit, but before the program is
+** loaded, so the loaded bytes count as initialized memory.
+*/
+{
+    unsigned Page;
+
+    OutputName = aOutputName;
+    DbgName    = aDbgName;
+
+    /* Read the debug info now, so errors show up before the simulation */
+    if (DbgName) {
+        DbgInfo = cc65_read_dbginfo (DbgName, DbgError);
+        if (DbgInfo == 0) {
+            Error ("Cannot read debug info from '%s'", DbgName);
+        }
+    }
+
+    Heat = xmalloc (sizeof (HeatData));
+    memset (Heat, 0, sizeof (HeatData));
+    Loading  = true;
+    FetchLen = 0;
+
+    /* Send all accesses through the slow path of the memory subsystem */
+    for (Page = 0; Page < 0x100; ++Page) {
+        MemSetPageFlags (Page, MEM_PAGE_WATCH);
+    }
+    HeatmapEnabled = true;
+}
+
+
+
+void HeatmapStart (bool Restored)
+/* Start counting accesses. Writes before this call mark memory as
+** initialized, but are not counted. If Restored is true, the memory was
+** restored from a saved state, and all of it counts as initialized.
+*/
+{
+    if (Restored) {
+        memset (Heat->Written, 1, sizeof (Heat->Written));
+    }
+    Loading = false;
+}
+
+
+
+void HeatmapInsn (uint16_t PC)
+/* Tell the heatmap that the instruction at PC is about to be executed.
+** Reads of the instruction bytes are fetches and not counted.
+*/
+{
+    FetchPC  = PC;
+    FetchLen = 4;               /* Longest 65816 instruction */
+    if (CPU != CPU_65816) {
+        FetchLen = GetInstructionLength (MemReadByte (PC));
+    }
+}
+
+
+
+void HeatmapCountRead (uint16_t Addr)
+/* Count a read from RAM */
+{
+    if ((uint16_t) (Addr - FetchPC) < FetchLen) {
+        return;
+    }
+    ++Heat->Reads[Addr];
+    if (!Heat->Written[Addr] && Heat->Uninit[Addr]++ == 0) {
+        Heat->FirstPC[Addr] = FetchPC;
+    }
+}
+
+
+
+void HeatmapCountWrite (uint16_t Addr)
+/* Count a write to RAM */
+{
+    Heat->Written[Addr] = 1;
+    if (!Loading) {
+        ++Heat->Writes[Addr];
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                Evaluation                                 */
+/*****************************************************************************/
+
+
+
+static int CmpLabel (const void* A, const void* B)
+/* Compare labels by address, then by name */
+{
+    const cc65_symboldata* S1 = *(const cc65_symboldata**) A;
+    const cc65_symboldata* S2 = *(const cc65_symboldata**) B;
+    if (S1->symbol_value != S2->symbol_value) {
+        return S1->symbol_value < S2->symbol_value ? -1 : 1;
+    }
+    return strcmp (S1->symbol_name, S2->symbol_name);
+}
+
+
+
+static void MapLabels (void)
+/* Map each address to the label it belongs to. An address belongs to the
+** closest label below it, unless the label has a size that ends before the
+** address. If there are several labels for one address, the first one in
+** alphabetical order wins.
+*/
+{
+    const cc65_symboldata** Sorted;
+    unsigned Count = 0;
+    unsigned I;
+
+    AddrToLabel = xmalloc (0x10000 * sizeof (AddrToLabel[0]));
+    memset (AddrToLabel, 0, 0x10000 * sizeof (AddrToLabel[0]));
+
+    if (DbgInfo == 0 || (Labels = cc65_symbol_inrange (DbgInfo, 0, 0xFFFF)) == 0) {
+        return;
+    }
+    Sorted = xmalloc (Labels->count * sizeof (Sorted[0]));
+    for (I = 0; I < Labels->count; ++I) {
+        const cc65_symboldata* S = Labels->data + I;
+        if (S->symbol_type == CC65_SYM_LABEL && S->parent_id == CC65_INV_ID) {
+            Sorted[Count++] = S;
+        }
+    }
+    qsort (Sorted, Count, sizeof (Sorted[0]), CmpLabel);
+
+    for (I = 0; I < Count; ++I) {
+        const cc65_symboldata* S = Sorted[I];
+        unsigned Addr = S->symbol_value & 0xFFFF;
+        unsigned End  = 0x10000;
+        while (I + 1 < Count && Sorted[I+1]->symbol_value == S->symbol_value) {
+            ++I;
+        }
+        if (I + 1 < Count) {
+            End = Sorted[I+1]->symbol_value & 0xFFFF;
+        }
+        if (S->symbol_size > 0 && Addr + S->symbol_size < End) {
+            End = Addr + S->symbol_size;
+        }
+        while (Addr < End) {
+            AddrToLabel[Addr++] = S;
+        }
+    }
+    xfree (Sorted);
+}
+
+
+
+static const char* AddrName (unsigned Addr, char* Buf)
+/* Return the label for an address with an offset, or an empty string. Buf
+** must have room for the name of the label and eight more characters.
+*/
+{
+    const cc65_symboldata* S = AddrToLabel[Addr];
+    if (S == 0) {
+        Buf[0] = '\0';
+    } else if ((unsigned long) S->symbol_value == Addr) {
+        strcpy (Buf, S->symbol_name);
+    } else {
+        sprintf (Buf, "%s+%lu", S->symbol_name,
+                 (unsigned long) Addr - (unsigned long) S->symbol_value);
+    }
+    return Buf;
+}
+
+
+
+static void AddGroup (HeatGroup* G, unsigned Addr)
+/* Add the counters for one address to a group */
+{
+    G->Reads  += Heat->Reads[Addr];
+    G->Writes += Heat->Writes[Addr];
+    G->Uninit += Heat->Uninit[Addr];
+}
+
+
+
+static int CmpGroupAccesses (const void* A, const void* B)
+/* Compare groups by the number of accesses, descending */
+{
+    const HeatGroup* G1 = A;
+    const HeatGroup* G2 = B;
+    uint64_t C1 = G1->Reads + G1->Writes;
+    uint64_t C2 = G2->Reads + G2->Writes;
+    if (C1 != C2) {
+        return C1 > C2 ? -1 : 1;
+    }
+    return (G1->Start > G2->Start) - (G1->Start < G2->Start);
+}
+
+
+
+static void WriteSegments (FILE* F)
+/* Write the accesses per segment, so they can be compared to the map file
+** written by ld65.
+*/
+{
+    unsigned I;
+    const cc65_segmentinfo* Segs = cc65_get_segmentlist (DbgInfo);
+
+    if (Segs == 0) {
+        return;
+    }
+    fprintf (F,
+             "\nSegments:\n\n"
+             "           Reads          Writes      Uninit  Start  End    Segment\n");
+    for (I = 0; I < Segs->count; ++I) {
+        const cc65_segmentdata* S = Segs->data + I;
+        HeatGroup G;
+        unsigned  Addr;
+        if (S->segment_size == 0 || S->segment_start + S->segment_size > 0x10000) {
+            continue;
+        }
+        memset (&G, 0, sizeof (G));
+        for (Addr = S->segment_start; Addr < S->segment_start + S->segment_size; ++Addr) {
+            AddGroup (&G, Addr);
+        }
+        fprintf (F, "%16" PRIu64 "  %14" PRIu64 "  %10" PRIu64 "  $%04X  $%04X  %s\n",
+                 G.Reads, G.Writes, G.Uninit, (unsigned) S->segment_start,
+                 (unsigned) (S->segment_start + S->segment_size - 1),
+                 S->segment_name);
+    }
+    cc65_free_segmentinfo (DbgInfo, Segs);
+}
+
+
+
+static void WriteZeroPage (FILE* F)
+/* Write the accesses for each zero page location */
+{
+    unsigned Addr;
+    char     Buf[256];
+
+    fprintf (F,
+             "\nZero page:\n\n"
+             "  Addr           Reads          Writes      Uninit  Label\n");
+    for (Addr = 0; Addr < 0x100; ++Addr) {
+        if (Heat->Reads[Addr] == 0 && Heat->Writes[Addr] == 0) {
+            continue;
+        }
+        AddrName (Addr, Buf);
+        fprintf (F, "  $%02X  %14" PRIu64 "  %14" PRIu64 "  %10" PRIu64 "%s%s\n",
+                 Addr, Heat->Reads[Addr], Heat->Writes[Addr], Heat->Uninit[Addr],
+                 Buf[0]? "  " : "", Buf);
+    }
+}
+
+
+
+static void WriteHotData (FILE* F)
+/* Write the memory outside the zero page, sorted by the number of accesses.
+** With debug info, the addresses are grouped by label.
+*/
+{
+    HeatGroup* Groups = xmalloc (0x10000 * sizeof (HeatGroup));
+    unsigned   Count  = 0;
+    unsigned   Addr   = 0x100;
+    unsigned   I;
+    char       Buf[256];
+
+    while (Addr < 0x10000) {
+        HeatGroup* G = Groups + Count;
+        const cc65_symboldata* S = AddrToLabel[Addr];
+        memset (G, 0, sizeof (HeatGroup));
+        G->Start = Addr;
+        do {
+            AddGroup (G, Addr++);
+        } while (S && Addr < 0x10000 && AddrToLabel[Addr] == S);
+        G->End = Addr - 1;
+        if (G->Reads || G->Writes) {
+            ++Count;
+        }
+    }
+    qsort (Groups, Count, sizeof (HeatGroup), CmpGroupAccesses);
+
+    fprintf (F,
+             "\nData outside the zero page:\n\n"
+             "        Accesses           Reads          Writes      Uninit  Address      Label\n");
+    for (I = 0; I < Count; ++I) {
+        const HeatGroup* G = Groups + I;
+        char Range[16];
+        if (G->Start == G->End) {
+            sprintf (Range, "$%04X", G->Start);
+        } else {
+            sprintf (Range, "$%04X-$%04X", G->Start, G->End);
+        }
+        AddrName (G->Start, Buf);
+        fprintf (F, "%16" PRIu64 "  %14" PRIu64 "  %14" PRIu64 "  %10" PRIu64 "  %-*s%s%s\n",
+                 G->Reads + G->Writes, G->Reads, G->Writes, G->Uninit,
+                 Buf[0]? 11 : 0, Range, Buf[0]? "  " : "", Buf);
+    }
+
+    xfree (Groups);
+}
+
+
+
+static void WriteUninit (FILE* F)
+/* Write the addresses that were read before they were written */
+{
+    unsigned Addr;
+    char     Buf1[256];
+    char     Buf2[256];
+
+    fprintf (F,
+             "\nReads of uninitialized memory:\n\n"
+             "  Address           Reads  First PC  Label\n");
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        if (Heat->Uninit[Addr] == 0) {
+            continue;
+        }
+        AddrName (Addr, Buf1);
+        AddrName (Heat->FirstPC[Addr], Buf2);
+        fprintf (F, "  $%04X    %14" PRIu64 "  $%04X     %s%s%s%s\n",
+                 Addr, Heat->Uninit[Addr], Heat->FirstPC[Addr],
+                 Buf1[0]? Buf1 : "-", Buf2[0]? " (read by " : "", Buf2,
+                 Buf2[0]? ")" : "");
+    }
+}
+
+
+
+static void WritePages (FILE* F)
+/* Write a map of the accesses per page. Each page is shown as a character,
+** on a logarithmic scale relative to the busiest page.
+*/
+{
+    uint64_t Pages[0x100];
+    uint64_t Max = 0;
+    unsigned Page;
+    unsigned Addr;
+    unsigned MaxBits = 0;
+
+    memset (Pages, 0, sizeof (Pages));
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        Pages[Addr >> 8] += Heat->Reads[Addr] + Heat->Writes[Addr];
+    }
+    for (Page = 0; Page < 0x100; ++Page) {
+        if (Pages[Page] > Max) {
+            Max = Pages[Page];
+        }
+    }
+    while ((Max >> MaxBits) > 0) {
+        ++MaxBits;
+    }
+
+    fprintf (F,
+             "\nAccesses per page (\"%s\" from none to most):\n\n"
+             "         0123456789ABCDEF\n",
+             HeatChars);
+    for (Page = 0; Page < 0x100; ++Page) {
+        unsigned C = 0;
+        if (Page % 16 == 0) {
+            fprintf (F, "  $%04X  ", Page << 8);
+        }
+        if (Pages[Page] > 0) {
+            /* Bit length of the count, scaled to the characters 1..9 */
+            unsigned Bits = 0;
+            while ((Pages[Page] >> Bits) > 0) {
+                ++Bits;
+            }
+            C = 1 + (Bits - 1) * (sizeof (HeatChars) - 3) / (MaxBits > 1? MaxBits - 1 : 1);
+        }
+        fputc (HeatChars[C], F);
+        if (Page % 16 == 15) {
+            fputc ('\n', F);
+        }
+    }
+}
+
+
+
+void HeatmapWrite (void)
+/* Write the heatmap to the output file */
+{
+    uint64_t Reads  = 0;
+    uint64_t Writes = 0;
+    unsigned Addr;
+    FILE*    F;
+
+    if (!HeatmapEnabled) {
+        return;
+    }
+
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        Reads  += Heat->Reads[Addr];
+        Writes += Heat->Writes[Addr];
+    }
+    MapLabels ();
+
+    F = fopen (OutputName, "w");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", OutputName, strerror (errno));
+    }
+
+    fprintf (F, "Total: %" PRIu64 " reads and %" PRIu64 " writes in %"
+             PRIu64 " cycles\n", Reads, Writes, Peripherals.Counter.ClockCycles);
+    if (DbgInfo) {
+        WriteSegments (F);
+    }
+    WriteZeroPage (F);
+    WriteHotData (F);
+    WriteUninit (F);
+    WritePages (F);
+
+    if (fclose (F) != 0) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+
+    /* Clean up */
+    for (Addr = 0; Addr < 0x100; ++Addr) {
+        MemClearPageFlags (Addr, MEM_PAGE_WATCH);
+    }
+    if (DbgInfo) {
+        if (Labels) {
+            cc65_free_symbolinfo (DbgInfo, Labels);
+            Labels = 0;
+        }
+        cc65_free_dbginfo (DbgInfo);
+        DbgInfo = 0;
+    }
+    xfree (AddrToLabel);
+    AddrToLabel = 0;
+    xfree (Heat);
+    Heat = 0;
+    HeatmapEnabled = false;
+}
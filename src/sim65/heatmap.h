@@ -0,0 +1,91 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 heatmap.h                                 */
+/*                                                                           */
+/*             Memory access heatmap for the sim65 6502 simulator            */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* True if memory accesses are counted */
+extern bool HeatmapEnabled;
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void HeatmapInit (const char* OutputName, const char* DbgName);
+/* Enable the heatmap. The report is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to name the accessed memory. Must be
+** called after MemInit and PeripheralsInit, but before the program is
+** loaded, so the loaded bytes count as initialized memory.
+*/
+
+void HeatmapStart (bool Restored);
+/* Start counting accesses. Writes before this call mark memory as
+** initialized, but are not counted. If Restored is true, the memory was
+** restored from a saved state, and all of it counts as initialized.
+*/
+
+void HeatmapInsn (uint16_t PC);
+/* Tell the heatmap that the instruction at PC is about to be executed.
+** Reads of the instruction bytes are fetches and not counted.
+*/
+
+void HeatmapCountRead (uint16_t Addr);
+/* Count a read from RAM */
+
+void HeatmapCountWrite (uint16_t Addr);
+/* Count a write to RAM */
+
+void HeatmapWrite (void);
+/* Write the heatmap to the output file */
+
+
+
+/* End of heatmap.h */
+
+#endif
@@ -0,0 +1,537 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  loops.c                                  */
+/*                                                                           */
+/*              Hot loop detection for the sim65 6502 simulator              */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+/* common */
+#include "coll.h"
+#include "xmalloc.h"
+
+/* dbginfo */
+#include "../dbginfo/dbginfo.h"
+
+/* sim65 */
+#include "6502.h"
+#include "error.h"
+#include "loops.h"
+#include "memory.h"
+#include "peripherals.h"
+#include "trace.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Number of buckets in the histograms. Bucket n counts values in the range
+** 2^n .. 2^(n+1)-1.
+*/
+#define HIST_BUCKETS    64
+
+/* How a jump or branch opcode is treated */
+#define JUMP_NONE       0               /* Not a jump */
+#define JUMP_BRANCH     1               /* Relative branch */
+#define JUMP_ABS        2               /* Jump to an absolute address */
+
+/* Back edge check results for JMP sites */
+#define EDGE_UNKNOWN    0
+#define EDGE_LOOP       1               /* Jump back to a loop head */
+#define EDGE_NONE       2               /* Jump into another function */
+
+/* A loop, identified by its head */
+typedef struct LoopInfo LoopInfo;
+struct LoopInfo {
+    unsigned            Head;           /* Address of the loop head */
+    unsigned            End;            /* Address of the last back edge */
+    unsigned            BackEdge;       /* Arrived at the head via back edge */
+    uint64_t            Trips;          /* Trips in the current activation */
+    uint64_t            LastEdge;       /* Clock cycles at last iteration end */
+    uint64_t            Entries;        /* Number of activations */
+    uint64_t            Iterations;     /* Number of timed iterations */
+    uint64_t            Cycles;         /* Cycles of the timed iterations */
+    uint64_t            MinCycles;      /* Fastest iteration */
+    uint64_t            MaxCycles;      /* Slowest iteration */
+    uint64_t            Penalties;      /* Page crossing penalties in loop */
+    uint64_t            TripHist[HIST_BUCKETS];
+    uint64_t            CycleHist[HIST_BUCKETS];
+};
+
+/* Raw data collected while the program runs. All arrays are indexed by
+** address.
+*/
+typedef struct LoopData LoopData;
+struct LoopData {
+    LoopInfo*           Heads[0x10000];         /* Loop per head address */
+    uint64_t            Insns[0x10000];         /* Executions per insn */
+    uint64_t            Crossings[0x10000];     /* Penalties per insn */
+    uint8_t             Edge[0x10000];          /* EDGE_xxx per JMP site */
+    uint8_t             IsEntry[0x10000];       /* JSR targets seen so far */
+};
+
+/* True if loop statistics are collected */
+bool LoopsEnabled = false;
+
+/* Collected data, allocated when loop statistics are enabled */
+static LoopData* Data;
+
+/* All loops in the order they were found */
+static Collection Loops = STATIC_COLLECTION_INITIALIZER;
+
+/* Jump type per opcode. All CPUs are handled with one table: Where an
+** opcode is a jump on one CPU but not on another, it is an instruction that
+** never moves the PC backwards on the other CPUs.
+*/
+static uint8_t JumpType[256];
+
+/* Output file and debug info file names */
+static const char* OutputName;
+static const char* DbgName;
+
+/* The debug info, if any */
+static cc65_dbginfo DbgInfo;
+
+
+
+/*****************************************************************************/
+/*                                Collecting                                 */
+/*****************************************************************************/
+
+
+
+static void DbgError (const cc65_parseerror* E)
+/* Report an error or warning from reading the debug info */
+{
+    if (E->type == CC65_WARNING) {
+        Warning ("%s:%u: %s", E->name, E->line, E->errormsg);
+    } else {
+        Error ("%s:%u: %s", E->name, E->line, E->errormsg);
+    }
+}
+
+
+
+void LoopsInit (const char* aOutputName, const char* aDbgName)
+/* Enable the loop statistics. The report is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to map loops to source lines.
+*/
+{
+    unsigned OPC;
+
+    OutputName = aOutputName;
+    DbgName    = aDbgName;
+
+    /* Read the debug info now, so errors show up before the simulation */
+    if (DbgName) {
+        DbgInfo = cc65_read_dbginfo (DbgName, DbgError);
+        if (DbgInfo == 0) {
+            Error ("Cannot read debug info from '%s'", DbgName);
+        }
+    }
+
+    /* Conditional branches, BRA and BRL, BBR and BBS, JMP and JML. Indirect
+    ** jumps are left out, since they are used for calls through pointers
+    ** and jump tables, not for loops.
+    */
+    for (OPC = 0; OPC < 256; ++OPC) {
+        if ((OPC & 0x1F) == 0x10 || (OPC & 0x0F) == 0x0F ||
+            OPC == 0x80 || OPC == 0x82) {
+            JumpType[OPC] = JUMP_BRANCH;
+        }
+    }
+    JumpType[0x4C] = JUMP_ABS;
+    JumpType[0x5C] = JUMP_ABS;
+
+    Data = xmalloc (sizeof (LoopData));
+    memset (Data, 0, sizeof (LoopData));
+    LoopsEnabled = true;
+}
+
+
+
+static unsigned Bucket (uint64_t Val)
+/* Return the histogram bucket for a value */
+{
+    unsigned B = 0;
+    while (Val > 1) {
+        Val >>= 1;
+        ++B;
+    }
+    return B;
+}
+
+
+
+static void EndActivation (LoopInfo* L)
+/* Account for the trip count of the current activation of a loop */
+{
+    if (L->Trips > 0) {
+        ++L->TripHist[Bucket (L->Trips)];
+        L->Trips = 0;
+    }
+}
+
+
+
+static int IsBackEdge (uint16_t PC, uint16_t Target)
+/* Check if a JMP from PC to a lower address Target is a back edge. cc65
+** uses JMP for tail calls, so a jump that crosses the entry of a function
+** called before is not considered a loop. The result is cached per site.
+*/
+{
+    if (Data->Edge[PC] == EDGE_UNKNOWN) {
+        unsigned Addr;
+        Data->Edge[PC] = EDGE_LOOP;
+        for (Addr = Target + 1; Addr <= PC; ++Addr) {
+            if (Data->IsEntry[Addr]) {
+                Data->Edge[PC] = EDGE_NONE;
+                break;
+            }
+        }
+    }
+    return Data->Edge[PC] == EDGE_LOOP;
+}
+
+
+
+void LoopsInsn (uint16_t PC, uint8_t OPC, unsigned Cycles, unsigned Crossings)
+/* Account for an instruction that was just executed. PC and OPC are the
+** address and opcode of the instruction, Cycles the number of clock cycles
+** it took, and Crossings the number of page crossing penalties included in
+** Cycles.
+*/
+{
+    uint64_t  Now = Peripherals.Counter.ClockCycles;
+    LoopInfo* L   = Data->Heads[PC];
+
+    ++Data->Insns[PC];
+    Data->Crossings[PC] += Crossings;
+
+    /* Arriving at a loop head other than through a back edge starts a new
+    ** activation of the loop.
+    */
+    if (L) {
+        if (L->BackEdge) {
+            L->BackEdge = 0;
+        } else {
+            EndActivation (L);
+            ++L->Entries;
+            L->LastEdge = Now - Cycles;
+        }
+        ++L->Trips;
+    }
+
+    /* Remember function entry points */
+    if (OPC == 0x20 && Regs.PC == MemReadWord (PC + 1)) {
+        Data->IsEntry[Regs.PC] = 1;
+        return;
+    }
+
+    /* A taken jump to a lower address closes an iteration of a loop */
+    if (JumpType[OPC] == JUMP_NONE || Regs.PC > PC) {
+        return;
+    }
+    if (JumpType[OPC] == JUMP_ABS && !IsBackEdge (PC, Regs.PC)) {
+        return;
+    }
+    L = Data->Heads[Regs.PC];
+    if (L == 0) {
+        /* A new loop. We're in its first activation, and the head was
+        ** executed once, but the iteration wasn't timed.
+        */
+        L = xmalloc (sizeof (LoopInfo));
+        memset (L, 0, sizeof (LoopInfo));
+        L->Head      = Regs.PC;
+        L->End       = PC;
+        L->Entries   = 1;
+        L->Trips     = 1;
+        L->MinCycles = UINT64_MAX;
+        Data->Heads[Regs.PC] = L;
+        CollAppend (&Loops, L);
+    } else {
+        uint64_t C = Now - L->LastEdge;
+        ++L->Iterations;
+        L->Cycles += C;
+        if (C < L->MinCycles) {
+            L->MinCycles = C;
+        }
+        if (C > L->MaxCycles) {
+            L->MaxCycles = C;
+        }
+        ++L->CycleHist[Bucket (C)];
+        if (PC > L->End) {
+            L->End = PC;
+        }
+    }
+    L->LastEdge = Now;
+    L->BackEdge = 1;
+}
+
+
+
+/*****************************************************************************/
+/*                                Evaluation                                 */
+/*****************************************************************************/
+
+
+
+static int CmpLoopCycles (void* Unused attribute ((unused)),
+                          const void* A, const void* B)
+/* Compare loops by cycles, descending */
+{
+    const LoopInfo* L1 = A;
+    const LoopInfo* L2 = B;
+    if (L1->Cycles != L2->Cycles) {
+        return L1->Cycles > L2->Cycles ? -1 : 1;
+    }
+    return (L1->Head > L2->Head) - (L1->Head < L2->Head);
+}
+
+
+
+static int CmpSiteCrossings (const void* A, const void* B)
+/* Compare instruction addresses by page crossing penalties, descending */
+{
+    uint64_t C1 = Data->Crossings[*(const unsigned*) A];
+    uint64_t C2 = Data->Crossings[*(const unsigned*) B];
+    if (C1 != C2) {
+        return C1 > C2 ? -1 : 1;
+    }
+    return (*(const unsigned*) A > *(const unsigned*) B) -
+           (*(const unsigned*) A < *(const unsigned*) B);
+}
+
+
+
+static const char* LineName (unsigned Addr, char* Buf, size_t Size)
+/* Return the source line for an address as "file:line". C source lines are
+** preferred over assembler lines. Return an empty string if there's no
+** line info.
+*/
+{
+    unsigned I, J;
+    int Found = 0;
+    const cc65_spaninfo* Spans;
+
+    Buf[0] = '\0';
+    if (DbgInfo == 0 || (Spans = cc65_span_byaddr (DbgInfo, Addr)) == 0) {
+        return Buf;
+    }
+    for (I = 0; I < Spans->count && Found < 2; ++I) {
+        const cc65_lineinfo* Lines = cc65_line_byspan (DbgInfo, Spans->data[I].span_id);
+        if (Lines == 0) {
+            continue;
+        }
+        for (J = 0; J < Lines->count; ++J) {
+            const cc65_linedata* L = Lines->data + J;
+            if (L->line_type == CC65_LINE_EXT || (!Found && L->line_type == CC65_LINE_ASM)) {
+                const cc65_sourceinfo* S = cc65_source_byid (DbgInfo, L->source_id);
+                snprintf (Buf, Size, "%s:%u",
+                          S? S->data[0].source_name : "?", L->source_line);
+                cc65_free_sourceinfo (DbgInfo, S);
+                Found = 1 + (L->line_type == CC65_LINE_EXT);
+            }
+        }
+        cc65_free_lineinfo (DbgInfo, Lines);
+    }
+    cc65_free_spaninfo (DbgInfo, Spans);
+    return Buf;
+}
+
+
+
+static void WriteHist (FILE* F, const char* Title, const uint64_t* Hist)
+/* Write the non empty buckets of a histogram on one line */
+{
+    unsigned B;
+    fprintf (F, "      %-22s", Title);
+    for (B = 0; B < HIST_BUCKETS; ++B) {
+        if (Hist[B] == 0) {
+            continue;
+        }
+        if (B == 0) {
+            fprintf (F, "  1: %" PRIu64, Hist[B]);
+        } else {
+            fprintf (F, "  %" PRIu64 "-%" PRIu64 ": %" PRIu64,
+                     (uint64_t) 1 << B, ((uint64_t) 2 << B) - 1, Hist[B]);
+        }
+    }
+    fputc ('\n', F);
+}
+
+
+
+static const LoopInfo* InnermostLoop (unsigned Addr)
+/* Return the innermost loop that contains Addr, or NULL */
+{
+    const LoopInfo* Best = 0;
+    unsigned I;
+    for (I = 0; I < CollCount (&Loops); ++I) {
+        const LoopInfo* L = CollConstAt (&Loops, I);
+        if (L->Head <= Addr && Addr <= L->End &&
+            (Best == 0 || L->End - L->Head < Best->End - Best->Head)) {
+            Best = L;
+        }
+    }
+    return Best;
+}
+
+
+
+static void WriteLoops (FILE* F, uint64_t Total)
+/* Write the loops, sorted by the cycles spent in them */
+{
+    unsigned I;
+    char     Buf[256];
+
+    fprintf (F,
+             "Loops:\n\n"
+             "          Cycles       %%     Entries     Iterations"
+             "  Cycles/iter       Min       Max   Penalty  Loop\n");
+    for (I = 0; I < CollCount (&Loops); ++I) {
+        const LoopInfo* L = CollConstAt (&Loops, I);
+        LineName (L->Head, Buf, sizeof (Buf));
+        fprintf (F, "%16" PRIu64 "  %6.2f  %10" PRIu64 "  %13" PRIu64
+                 "  %11.1f  %8" PRIu64 "  %8" PRIu64 "  %8" PRIu64
+                 "  $%04X-$%04X%s%s\n",
+                 L->Cycles,
+                 Total? 100.0 * (double) L->Cycles / (double) Total : 0.0,
+                 L->Entries, L->Iterations,
+                 L->Iterations? (double) L->Cycles / (double) L->Iterations : 0.0,
+                 L->Iterations? L->MinCycles : 0, L->MaxCycles,
+                 L->Penalties, L->Head, L->End, Buf[0]? "  " : "", Buf);
+        WriteHist (F, "Trips per entry:", L->TripHist);
+        if (L->Iterations) {
+            WriteHist (F, "Cycles per iteration:", L->CycleHist);
+        }
+    }
+}
+
+
+
+static void WriteCrossings (FILE* F)
+/* Write the instructions that took page crossing penalties */
+{
+    unsigned* Sites = xmalloc (0x10000 * sizeof (unsigned));
+    unsigned  Count = 0;
+    unsigned  I;
+    char      Insn[32];
+    char      Line[256];
+
+    for (I = 0; I < 0x10000; ++I) {
+        if (Data->Crossings[I]) {
+            Sites[Count++] = I;
+        }
+    }
+    qsort (Sites, Count, sizeof (unsigned), CmpSiteCrossings);
+
+    fprintf (F,
+             "\nPage crossing penalties:\n\n"
+             "         Penalty          Insns       %%  Address  Loop"
+             "         Instruction       Source:Line\n");
+    for (I = 0; I < Count; ++I) {
+        unsigned        Addr = Sites[I];
+        const LoopInfo* L    = InnermostLoop (Addr);
+        char            LoopName[16] = "-";
+        if (L) {
+            sprintf (LoopName, "$%04X-$%04X", L->Head, L->End);
+        }
+        DisassembleInstruction (Insn, (uint16_t) Addr);
+        LineName (Addr, Line, sizeof (Line));
+        fprintf (F, "%16" PRIu64 "  %13" PRIu64 "  %6.2f  $%04X    %-11s  %-*s%s%s\n",
+                 Data->Crossings[Addr], Data->Insns[Addr],
+                 100.0 * (double) Data->Crossings[Addr] / (double) Data->Insns[Addr],
+                 Addr, LoopName, Line[0]? 16 : 0, Insn,
+                 Line[0]? "  " : "", Line);
+    }
+
+    xfree (Sites);
+}
+
+
+
+void LoopsWrite (void)
+/* Write the loop report to the output file */
+{
+    unsigned I;
+    unsigned Addr;
+    FILE*    F;
+
+    if (!LoopsEnabled) {
+        return;
+    }
+
+    /* Finish the running activations and sum up the page crossing penalties
+    ** per loop.
+    */
+    for (I = 0; I < CollCount (&Loops); ++I) {
+        LoopInfo* L = CollAtUnchecked (&Loops, I);
+        EndActivation (L);
+        for (Addr = L->Head; Addr <= L->End; ++Addr) {
+            L->Penalties += Data->Crossings[Addr];
+        }
+    }
+    CollSort (&Loops, CmpLoopCycles, 0);
+
+    F = fopen (OutputName, "w");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", OutputName, strerror (errno));
+    }
+
+    fprintf (F, "Total: %" PRIu64 " cycles\n\n", Peripherals.Counter.ClockCycles);
+    WriteLoops (F, Peripherals.Counter.ClockCycles);
+    WriteCrossings (F);
+
+    if (fclose (F) != 0) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+
+    /* Clean up */
+    for (I = 0; I < CollCount (&Loops); ++I) {
+        xfree (CollAtUnchecked (&Loops, I));
+    }
+    DoneCollection (&Loops);
+    if (DbgInfo) {
+        cc65_free_dbginfo (DbgInfo);
+        DbgInfo = 0;
+    }
+    xfree (Data);
+    Data = 0;
+    LoopsEnabled = false;
+}
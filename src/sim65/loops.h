@@ -0,0 +1,76 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                  loops.h                                  */
+/*                                                                           */
+/*              Hot loop detection for the sim65 6502 simulator              */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef LOOPS_H
+#define LOOPS_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* True if loop statistics are collected */
+extern bool LoopsEnabled;
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void LoopsInit (const char* OutputName, const char* DbgName);
+/* Enable the loop statistics. The report is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to map loops to source lines.
+*/
+
+void LoopsInsn (uint16_t PC, uint8_t OPC, unsigned Cycles, unsigned Crossings);
+/* Account for an instruction that was just executed. PC and OPC are the
+** address and opcode of the instruction, Cycles the number of clock cycles
+** it took, and Crossings the number of page crossing penalties included in
+** Cycles.
+*/
+
+void LoopsWrite (void);
+/* Write the loop report to the output file */
+
+
+
+/* End of loops.h */
+
+#endif
@@ -35,21 +35,33 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <inttypes.h>
 
 /* common */
 #include "abend.h"
 #include "cmdline.h"
+#include "coll.h"
 #include "print.h"
+#include "thread.h"
 #include "version.h"
+#include "xmalloc.h"
 
 /* sim65 */
 #include "6502.h"
+#include "coverage.h"
 #include "error.h"
+#include "event.h"
+#include "heatmap.h"
+#include "loops.h"
 #include "memory.h"
 #include "peripherals.h"
 #include "paravirt.h"
+#include "profile.h"
+#include "snapshot.h"
 #include "trace.h"
 
 
@@ -61,16 +73,67 @@
 
 
 /* Name of program file */
-const char* ProgramFile;
+static THREAD_LOCAL const char* ProgramFile;
 
 /* Set to True if CPU mode override is in effect. If set, the CPU is not read from the program file. */
 static bool CPUOverrideActive = false;
 
+/* The CPU type given on the command line. Needed since CPU is thread local */
+static CPUType CPUOverride = CPU_6502;
+
 /* exit simulator after MaxCycles Cccles */
 unsigned long long MaxCycles = 0;
 
 /* countdown from MaxCycles */
-unsigned long long RemainCycles;
+static THREAD_LOCAL unsigned long long RemainCycles;
+
+/* Snapshot files and the address where the snapshot is taken */
+static const char* SaveStateFile = 0;
+static const char* LoadStateFile = 0;
+static long SaveStateAddr = -1;
+
+/* Binary trace output file */
+static const char* TraceFileName = 0;
+
+/* Trace mode set on the command line */
+static uint8_t OptTraceMode;
+
+/* Manifest for batch mode */
+static const char* BatchFile = 0;
+
+/* Number of threads for batch mode, 0 for one per CPU core */
+static unsigned BatchJobs = 0;
+
+/* A program in the batch manifest */
+typedef struct BatchEntry BatchEntry;
+struct BatchEntry {
+    int                 Expected;       /* Expected exit code */
+    unsigned            ArgCount;       /* Number of arguments */
+    char**              ArgVec;         /* Program file and arguments */
+    int                 Result;         /* Actual exit code */
+    uint64_t            Cycles;         /* Clock cycles used */
+    bool                Done;           /* Result is valid */
+};
+
+/* The programs in batch mode, and the index of the next one to run. Done
+** in the entries and NextEntry are protected by the global thread lock.
+*/
+static Collection* BatchEntries;
+static unsigned NextEntry;
+
+/* Profile output file and debug info file */
+static const char* ProfileFile = 0;
+static const char* DbgFile = 0;
+
+/* Loop report file */
+static const char* LoopsFile = 0;
+
+/* Memory access heatmap file */
+static const char* HeatmapFile = 0;
+
+/* Coverage output file, and the report file for --coverage-report */
+static const char* CoverageFile = 0;
+static const char* CoverageReportFile = 0;
 
 /* Header signature 'sim65' */
 static const unsigned char HeaderSignature[] = {
@@ -90,6 +153,7 @@ static const unsigned char HeaderVersion = 2;
 static void Usage (void)
 {
     printf ("Usage: %s [options] file [arguments]\n"
+            "       %s [options] --load-state file [arguments]\n"
             "Short options:\n"
             "  -h\t\t\tHelp (this text)\n"
             "  -c\t\t\tPrint amount of executed CPU cycles\n"
@@ -100,11 +164,25 @@ static void Usage (void)
             "Long options:\n"
             "  --help\t\tHelp (this text)\n"
             "  --cycles\t\tPrint amount of executed CPU cycles\n"
-            "  --cpu <type>\t\tOverride CPU type (6502, 65C02, 6502X)\n"
+            "  --batch <file>\t\tRun the programs listed in <file>\n"
+            "  --coverage <file>\tWrite a code coverage map to <file>\n"
+            "  --coverage-report <file> <maps...>\tMerge coverage maps into a report\n"
+            "  --cpu <type>\t\tOverride CPU type (6502, 65C02, 6502X, 65816)\n"
+            "  --dbgfile <file>\tRead debug info for the reports or coverage from <file>\n"
+            "  --heatmap <file>\tWrite memory access counts to <file>\n"
+            "  --jobs <num>\t\tUse <num> threads for --batch (default: CPU cores)\n"
+            "  --load-state <file>\tStart from the machine state in <file>\n"
+            "  --loops <file>\t\tWrite a report of hot loops to <file>\n"
+            "  --profile <file>\tWrite a cycle profile to <file>\n"
+            "  --pvmem <mode>\t\tRun memcpy and friends natively or emulated\n"
+            "  --save-at <addr>\tSave the state when the PC reaches <addr>\n"
+            "  --save-state <file>\tSave the machine state to <file>\n"
             "  --trace\t\tEnable CPU trace\n"
+            "  --trace-decode <file>\tPrint a binary trace file and exit\n"
+            "  --trace-file <file>\tEnable CPU trace, write it to <file> in binary form\n"
             "  --verbose\t\tIncrease verbosity\n"
             "  --version\t\tPrint the simulator version number\n",
-            ProgName);
+            ProgName, ProgName);
 }
 
 
@@ -119,18 +197,29 @@ static void OptHelp (const char* Opt attribute ((unused)),
 
 
 
+static void OptBatch (const char* Opt attribute ((unused)), const char* Arg)
+/* Run the programs from a manifest */
+{
+    BatchFile = Arg;
+}
+
+
+
 static void OptCPU (const char* Opt, const char* Arg)
 /* Set CPU type */
 {
     /* Don't use FindCPU here. Enum constants would clash. */
     if (strcmp(Arg, "6502") == 0) {
-        CPU = CPU_6502;
+        CPU = CPUOverride = CPU_6502;
         CPUOverrideActive = true;
     } else if (strcmp(Arg, "65C02") == 0 || strcmp(Arg, "65c02") == 0) {
-        CPU = CPU_65C02;
+        CPU = CPUOverride = CPU_65C02;
         CPUOverrideActive = true;
     } else if (strcmp(Arg, "6502X") == 0 || strcmp(Arg, "6502x") == 0) {
-        CPU = CPU_6502X;
+        CPU = CPUOverride = CPU_6502X;
+        CPUOverrideActive = true;
+    } else if (strcmp(Arg, "65816") == 0) {
+        CPU = CPUOverride = CPU_65816;
         CPUOverrideActive = true;
     } else {
         AbEnd ("Invalid argument for %s: '%s'", Opt, Arg);
@@ -139,6 +228,115 @@ static void OptCPU (const char* Opt, const char* Arg)
 
 
 
+static void OptCoverage (const char* Opt attribute ((unused)), const char* Arg)
+/* Enable coverage collection */
+{
+    CoverageFile = Arg;
+}
+
+
+
+static void OptCoverageReport (const char* Opt attribute ((unused)), const char* Arg)
+/* Write a report for the coverage files given instead of a program */
+{
+    CoverageReportFile = Arg;
+}
+
+
+
+static void OptDbgFile (const char* Opt attribute ((unused)), const char* Arg)
+/* Set the debug info file for the profiler and coverage */
+{
+    DbgFile = Arg;
+}
+
+
+
+static void OptHeatmap (const char* Opt attribute ((unused)), const char* Arg)
+/* Count memory accesses */
+{
+    HeatmapFile = Arg;
+}
+
+
+
+static void OptJobs (const char* Opt, const char* Arg)
+/* Set the number of threads for batch mode */
+{
+    char* End;
+    unsigned long Jobs = strtoul (Arg, &End, 10);
+    if (*Arg == '\0' || *End != '\0' || Jobs == 0 || Jobs > 1024) {
+        AbEnd ("Invalid argument for %s: '%s'", Opt, Arg);
+    }
+    BatchJobs = (unsigned) Jobs;
+}
+
+
+
+static void OptLoadState (const char* Opt attribute ((unused)), const char* Arg)
+/* Start from a saved machine state instead of a program file */
+{
+    LoadStateFile = Arg;
+}
+
+
+
+static void OptSaveAt (const char* Opt, const char* Arg)
+/* Set the address where the machine state is saved */
+{
+    char* End;
+    unsigned long Addr;
+    if (*Arg == '$') {
+        Addr = strtoul (Arg + 1, &End, 16);
+    } else {
+        Addr = strtoul (Arg, &End, 0);
+    }
+    if (*Arg == '\0' || *End != '\0' || Addr > 0xFFFF) {
+        AbEnd ("Invalid argument for %s: '%s'", Opt, Arg);
+    }
+    SaveStateAddr = (long) Addr;
+}
+
+
+
+static void OptPVMem (const char* Opt, const char* Arg)
+/* Select how the paravirtualized memory functions are run */
+{
+    if (strcmp (Arg, "native") == 0) {
+        ParaVirtMemNative = true;
+    } else if (strcmp (Arg, "emulated") == 0) {
+        ParaVirtMemNative = false;
+    } else {
+        AbEnd ("Invalid argument for %s: '%s'", Opt, Arg);
+    }
+}
+
+
+
+static void OptSaveState (const char* Opt attribute ((unused)), const char* Arg)
+/* Save the machine state to a file */
+{
+    SaveStateFile = Arg;
+}
+
+
+
+static void OptLoops (const char* Opt attribute ((unused)), const char* Arg)
+/* Enable the loop statistics */
+{
+    LoopsFile = Arg;
+}
+
+
+
+static void OptProfile (const char* Opt attribute ((unused)), const char* Arg)
+/* Enable the profiler */
+{
+    ProfileFile = Arg;
+}
+
+
+
 static void OptTrace (const char* Opt attribute ((unused)),
                       const char* Arg attribute ((unused)))
 /* Enable trace mode */
@@ -148,6 +346,24 @@ static void OptTrace (const char* Opt attribute ((unused)),
 
 
 
+static void OptTraceDecode (const char* Opt attribute ((unused)), const char* Arg)
+/* Print a binary trace file and exit */
+{
+    TraceDecodeFile (Arg);
+    exit (EXIT_SUCCESS);
+}
+
+
+
+static void OptTraceFile (const char* Opt attribute ((unused)), const char* Arg)
+/* Enable trace mode and write the trace to a binary file */
+{
+    TraceFileName = Arg;
+    TraceMode = TRACE_ENABLE_FULL;
+}
+
+
+
 static void OptVerbose (const char* Opt attribute ((unused)),
                         const char* Arg attribute ((unused)))
 /* Increase verbosity */
@@ -185,6 +401,25 @@ static void OptQuitXIns (const char* Opt attribute ((unused)),
 
 
 
+static void CountCycles (unsigned long long Cycles)
+/* Count executed cycles against the limit set with -x, and exit if it was
+** exceeded.
+*/
+{
+    if (MaxCycles) {
+        if (Cycles > RemainCycles) {
+            ProfileWrite ();
+            LoopsWrite ();
+            HeatmapWrite ();
+            CoverageWrite ();
+            ErrorCode (SIM65_ERROR_TIMEOUT, "Maximum number of cycles reached.");
+        }
+        RemainCycles -= Cycles;
+    }
+}
+
+
+
 static unsigned char ReadProgramFile (void)
 /* Load program into memory */
 {
@@ -222,6 +457,7 @@ static unsigned char ReadProgramFile (void)
             case CPU_6502:
             case CPU_65C02:
             case CPU_6502X:
+            case CPU_65816:
                 CPU = Val;
                 break;
             default:
@@ -277,21 +513,278 @@ static unsigned char ReadProgramFile (void)
 
 
 
+static void Run (void) attribute ((noreturn));
+static void Run (void)
+/* Run the program until it exits */
+{
+    while (1) {
+        /* Stop at the next event, so it runs on time */
+        if (MaxCycles) {
+            /* Allow one cycle more than remaining, so that we notice if the
+            ** last instruction exceeds the limit.
+            */
+            CountCycles (ExecuteUntil (EventLimitBudget (RemainCycles < ULLONG_MAX ? RemainCycles + 1 : ULLONG_MAX)));
+        } else {
+            ExecuteUntil (EventLimitBudget (ULLONG_MAX));
+        }
+        EventRun ();
+    }
+}
+
+
+
+static Collection* ReadManifest (const char* Name)
+/* Read the batch manifest. Each line contains the expected exit code, the
+** program file and its arguments, separated by white space. Empty lines
+** and lines starting with '#' are ignored.
+*/
+{
+    Collection* Entries = NewCollection ();
+    Collection  Args = STATIC_COLLECTION_INITIALIZER;
+    char        Line[4096];
+    unsigned    LineNum = 0;
+
+    FILE* F = fopen (Name, "r");
+    if (F == 0) {
+        AbEnd ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+
+    while (fgets (Line, sizeof (Line), F)) {
+
+        BatchEntry* E;
+        char*       P = Line;
+        char*       End;
+        long        Expected;
+
+        ++LineNum;
+
+        /* Skip white space, empty lines and comments */
+        while (isspace ((unsigned char) *P)) {
+            ++P;
+        }
+        if (*P == '\0' || *P == '#') {
+            continue;
+        }
+
+        /* Expected exit code */
+        Expected = strtol (P, &End, 0);
+        if (End == P || !isspace ((unsigned char) *End)) {
+            AbEnd ("%s:%u: Expected exit code", Name, LineNum);
+        }
+        P = End;
+
+        /* Program file and arguments */
+        while (1) {
+            while (isspace ((unsigned char) *P)) {
+                ++P;
+            }
+            if (*P == '\0') {
+                break;
+            }
+            End = P;
+            while (*End != '\0' && !isspace ((unsigned char) *End)) {
+                ++End;
+            }
+            if (*End != '\0') {
+                *End++ = '\0';
+            }
+            CollAppend (&Args, xstrdup (P));
+            P = End;
+        }
+        if (CollCount (&Args) == 0) {
+            AbEnd ("%s:%u: Program file missing", Name, LineNum);
+        }
+
+        E = xmalloc (sizeof (BatchEntry));
+        E->Expected = (int) Expected;
+        E->ArgCount = CollCount (&Args);
+        E->ArgVec   = xmalloc (E->ArgCount * sizeof (char*));
+        memcpy (E->ArgVec, Args.Items, E->ArgCount * sizeof (char*));
+        E->Result   = SIM65_ERROR;
+        E->Cycles   = 0;
+        E->Done     = false;
+        CollAppend (Entries, E);
+        CollDeleteAll (&Args);
+    }
+
+    if (ferror (F)) {
+        AbEnd ("Error reading from '%s': %s", Name, strerror (errno));
+    }
+    fclose (F);
+    DoneCollection (&Args);
+
+    return Entries;
+}
+
+
+
+static void RunBatchEntry (BatchEntry* E)
+/* Run one program from the batch manifest. The machine is reset first, and
+** only the memory pages written by the previous program are cleared.
+*/
+{
+    jmp_buf       ExitJump;
+    unsigned char SPAddr;
+
+    /* Reset the machine */
+    MemReset ();
+    InvalidateCodeCache ();
+    EventReset ();
+    PeripheralsInit ();
+    ParaVirtReset ();
+    memset (&Regs, 0, sizeof (Regs));
+    TraceMode = OptTraceMode;
+    RemainCycles = MaxCycles;
+    CPU = CPUOverrideActive? CPUOverride : CPU_6502;
+
+    /* SimExit and the error functions come back here */
+    if (setjmp (ExitJump) == 0) {
+        SimExitJump = &ExitJump;
+
+        ProgramFile = E->ArgVec[0];
+        SPAddr = ReadProgramFile ();
+        TraceInit (SPAddr);
+        ParaVirtInit (E->ArgCount, E->ArgVec, SPAddr);
+        Reset ();
+        Run ();
+    }
+    SimExitJump = 0;
+
+    E->Result = SimExitCode;
+    E->Cycles = Peripherals.Counter.ClockCycles;
+}
+
+
+
+static void BatchWorker (void* Data attribute ((unused)))
+/* Thread function for batch mode. Each thread has its own machine, and runs
+** the next program from the manifest until all programs are done.
+*/
+{
+    MemInit ();
+    PeripheralsInit ();
+
+    while (1) {
+
+        BatchEntry* E;
+
+        ThreadLock ();
+        if (NextEntry >= CollCount (BatchEntries)) {
+            ThreadUnlock ();
+            break;
+        }
+        E = CollAtUnchecked (BatchEntries, NextEntry++);
+        ThreadUnlock ();
+
+        RunBatchEntry (E);
+
+        ThreadLock ();
+        E->Done = true;
+        ThreadNotify ();
+        ThreadUnlock ();
+    }
+}
+
+
+
+static int RunBatch (const char* Name)
+/* Run all programs from the batch manifest on BatchJobs threads and report
+** the results in the order of the manifest. Return the exit code for sim65.
+*/
+{
+    Thread** Threads;
+    unsigned    Failed = 0;
+    unsigned    Jobs;
+    unsigned    I;
+
+    BatchEntries = ReadManifest (Name);
+    NextEntry = 0;
+
+    /* Start the workers */
+    Jobs = BatchJobs ? BatchJobs : ThreadCPUCount ();
+    if (Jobs > CollCount (BatchEntries)) {
+        Jobs = CollCount (BatchEntries);
+    }
+    Threads = xmalloc ((Jobs + 1) * sizeof (Thread*));
+    for (I = 0; I < Jobs; ++I) {
+        Threads[I] = ThreadStart (BatchWorker, 0);
+    }
+
+    /* Report the results in order, as they become available */
+    for (I = 0; I < CollCount (BatchEntries); ++I) {
+        BatchEntry* E = CollAtUnchecked (BatchEntries, I);
+
+        ThreadLock ();
+        while (!E->Done) {
+            ThreadWait ();
+        }
+        ThreadUnlock ();
+
+        /* The output of the programs goes directly to the file descriptor,
+        ** so flush our own output to keep the order.
+        */
+        if (E->Result == E->Expected) {
+            printf ("PASS  %s: exit code %d, %" PRIu64 " cycles\n",
+                    E->ArgVec[0], E->Result, E->Cycles);
+        } else {
+            printf ("FAIL  %s: exit code %d, expected %d, %" PRIu64 " cycles\n",
+                    E->ArgVec[0], E->Result, E->Expected, E->Cycles);
+            ++Failed;
+        }
+        fflush (stdout);
+    }
+
+    printf ("%u of %u programs passed\n", CollCount (BatchEntries) - Failed, CollCount (BatchEntries));
+
+    for (I = 0; I < Jobs; ++I) {
+        ThreadJoin (Threads[I]);
+    }
+    xfree (Threads);
+
+    for (I = 0; I < CollCount (BatchEntries); ++I) {
+        BatchEntry* E = CollAtUnchecked (BatchEntries, I);
+        unsigned J;
+        for (J = 0; J < E->ArgCount; ++J) {
+            xfree (E->ArgVec[J]);
+        }
+        xfree (E->ArgVec);
+        xfree (E);
+    }
+    FreeCollection (BatchEntries);
+
+    return Failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
 int main (int argc, char* argv[])
 {
     /* Program long options */
     static const LongOpt OptTab[] = {
         { "--help",             0,      OptHelp      },
+        { "--batch",            1,      OptBatch     },
+        { "--coverage",         1,      OptCoverage  },
+        { "--coverage-report",  1,      OptCoverageReport },
         { "--cycles",           0,      OptCycles    },
         { "--cpu",              1,      OptCPU       },
+        { "--dbgfile",          1,      OptDbgFile   },
+        { "--heatmap",          1,      OptHeatmap   },
+        { "--jobs",             1,      OptJobs      },
+        { "--load-state",       1,      OptLoadState },
+        { "--loops",            1,      OptLoops     },
+        { "--profile",          1,      OptProfile   },
+        { "--pvmem",            1,      OptPVMem     },
+        { "--save-at",          1,      OptSaveAt    },
+        { "--save-state",       1,      OptSaveState },
         { "--trace",            0,      OptTrace     },
+        { "--trace-decode",     1,      OptTraceDecode },
+        { "--trace-file",       1,      OptTraceFile },
         { "--verbose",          0,      OptVerbose   },
         { "--version",          0,      OptVersion   },
     };
 
     unsigned I;
     unsigned char SPAddr;
-    unsigned int Cycles;
 
     /* Set reasonable defaults. */
     CPU = CPU_6502;
@@ -342,7 +835,12 @@ int main (int argc, char* argv[])
                     break;
             }
         } else {
-            ProgramFile = Arg;
+            /* When starting from a saved state, all remaining arguments
+            ** are passed to the program.
+            */
+            if (LoadStateFile == NULL) {
+                ProgramFile = Arg;
+            }
             break;
         }
 
@@ -350,43 +848,130 @@ int main (int argc, char* argv[])
         ++I;
     }
 
+    /* Merge coverage files instead of running a program */
+    if (CoverageReportFile) {
+        CoverageReport (CoverageReportFile, ArgCount - I, ArgVec + I);
+        return EXIT_SUCCESS;
+    }
+
+    /* Remember the trace mode for batch mode */
+    OptTraceMode = TraceMode;
+
+    /* In batch mode, the programs come from the manifest */
+    if (BatchFile) {
+        if (ProgramFile || LoadStateFile || SaveStateFile || ProfileFile ||
+            LoopsFile || HeatmapFile || CoverageFile) {
+            AbEnd ("--batch cannot be used with a program file, --load-state, "
+                   "--save-state, --profile, --loops, --heatmap or --coverage");
+        }
+        if (TraceFileName && BatchJobs != 1) {
+            AbEnd ("--trace-file with --batch requires --jobs 1");
+        }
+        if (TraceFileName) {
+            TraceOpenFile (TraceFileName);
+        }
+        return RunBatch (BatchFile);
+    }
+
     /* Do we have a program file? */
-    if (ProgramFile == NULL) {
+    if (ProgramFile == NULL && LoadStateFile == NULL) {
         AbEnd ("No program file");
     }
 
+    /* Saving the state needs both the file and the address */
+    if ((SaveStateFile == NULL) != (SaveStateAddr < 0)) {
+        AbEnd ("--save-state and --save-at must be used together");
+    }
+
+    /* Debug info is only used by the reports and for coverage */
+    if (DbgFile != NULL && ProfileFile == NULL && LoopsFile == NULL &&
+        HeatmapFile == NULL && CoverageFile == NULL) {
+        AbEnd ("--dbgfile requires --profile, --loops, --heatmap or --coverage");
+    }
+
     /* Reset memory */
     MemInit ();
 
     /* Reset peripherals. */
     PeripheralsInit ();
 
-    /* Read program file into memory.
-     * This also sets the CPU type, unless a CPU override is in effect.
-     */
-    SPAddr = ReadProgramFile ();
+    /* Count memory accesses if requested. This is done before loading the
+    ** program, so the loaded bytes count as initialized memory.
+    */
+    if (HeatmapFile) {
+        HeatmapInit (HeatmapFile, DbgFile);
+    }
+
+    if (LoadStateFile) {
+        /* Restore the machine state. Options given on the command line
+         * override the CPU type and trace mode from the state.
+         */
+        CPUType  OptCPU = CPU;
+        uint8_t  OptTraceMode = TraceMode;
+        SPAddr = SnapshotLoad (LoadStateFile);
+        if (CPUOverrideActive) {
+            CPU = OptCPU;
+        }
+        if (OptTraceMode != TRACE_DISABLED) {
+            TraceMode = OptTraceMode;
+        }
+    } else {
+        /* Read program file into memory.
+         * This also sets the CPU type, unless a CPU override is in effect.
+         */
+        SPAddr = ReadProgramFile ();
+    }
 
     /* Initialize the paravirtualization subsystem. It requires the stack pointer address, to be able to
      * simulate 6502 subroutine calls.
      */
 
     TraceInit(SPAddr);
-    ParaVirtInit (I, SPAddr);
+    if (TraceFileName) {
+        TraceOpenFile (TraceFileName);
+    }
+    ParaVirtInit (ArgCount - I, ArgVec + I, SPAddr);
 
-    /* Reset the CPU */
-    Reset ();
+    /* Enable the profiler if requested */
+    if (ProfileFile) {
+        ProfileInit (ProfileFile, DbgFile);
+    }
+
+    /* Collect loop statistics if requested */
+    if (LoopsFile) {
+        LoopsInit (LoopsFile, DbgFile);
+    }
+
+    /* Collect coverage if requested */
+    if (CoverageFile) {
+        CoverageInit (CoverageFile, DbgFile);
+    }
+
+    /* Reset the CPU, unless it continues from a saved state */
+    if (LoadStateFile == NULL) {
+        Reset ();
+    }
+
+    /* Count the memory accesses of the program from here on */
+    if (HeatmapFile) {
+        HeatmapStart (LoadStateFile != NULL);
+    }
 
     RemainCycles = MaxCycles;
-    while (1) {
-        Cycles = ExecuteInsn ();
-        if (MaxCycles) {
-            if (Cycles > RemainCycles) {
-                ErrorCode (SIM65_ERROR_TIMEOUT, "Maximum number of cycles reached.");
-            }
-            RemainCycles -= Cycles;
+
+    /* If the state should be saved, run up to the given address one
+    ** instruction at a time.
+    */
+    if (SaveStateFile) {
+        while (Regs.PC != SaveStateAddr) {
+            CountCycles (ExecuteInsn ());
+            EventRun ();
         }
+        SnapshotSave (SaveStateFile, SPAddr);
     }
 
+    Run ();
+
     /* Unreachable. sim65 program must exit through paravirtual PVExit
     ** or timeout from MaxCycles producing an error.
     */
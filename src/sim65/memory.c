@@ -35,8 +35,13 @@
 
 #include <string.h>
 
+/* common */
+#include "xmalloc.h"
+
+/* sim65 */
+#include "6502.h"
+#include "heatmap.h"
 #include "memory.h"
-#include "peripherals.h"
 
 
 /*****************************************************************************/
@@ -46,7 +51,26 @@
 
 
 /* The memory */
-uint8_t Mem[0x10000];
+THREAD_LOCAL uint8_t Mem[0x10000];
+
+/* The page table used by the inline access functions */
+THREAD_LOCAL uint8_t* MemReadMap[0x100];
+THREAD_LOCAL uint8_t* MemWriteMap[0x100];
+
+/* Everything we know about a page */
+typedef struct MemPage MemPage;
+struct MemPage {
+    MemReadFunc         Read;           /* Read handler or NULL for RAM */
+    MemWriteFunc        Write;          /* Write handler or NULL for RAM */
+    unsigned            Flags;          /* MEM_PAGE_xxx */
+};
+
+static THREAD_LOCAL MemPage Pages[0x100];
+
+/* Memory of the banks above bank 0, used by the 65816. Banks are allocated
+** when they are written to for the first time.
+*/
+static THREAD_LOCAL uint8_t* Banks[0x100];
 
 
 
@@ -56,21 +80,111 @@ uint8_t Mem[0x10000];
 
 
 
-void MemWriteByte (uint16_t Addr, uint8_t Val)
-/* Write a byte to a memory location */
+static void UpdatePage (uint8_t Page)
+/* Recalculate the page table entries for a page */
 {
-    if ((PERIPHERALS_APERTURE_BASE_ADDRESS <= Addr) && (Addr <= PERIPHERALS_APERTURE_LAST_ADDRESS))
-    {
-        /* Defer the the memory-mapped peripherals handler for this write. */
-        PeripheralsWriteByte (Addr - PERIPHERALS_APERTURE_BASE_ADDRESS, Val);
+    const MemPage* P = Pages + Page;
+
+    /* Reads may use the fast path if there's no read handler, and they're
+    ** not counted.
+    */
+    if (P->Read == 0 && (P->Flags & MEM_PAGE_WATCH) == 0) {
+        MemReadMap[Page] = Mem + (Page << 8);
+    } else {
+        MemReadMap[Page] = 0;
+    }
+
+    /* Writes may use the fast path if there's no write handler and nothing
+    ** else to check.
+    */
+    if (P->Write == 0 && P->Flags == 0) {
+        MemWriteMap[Page] = Mem + (Page << 8);
     } else {
+        MemWriteMap[Page] = 0;
+    }
+}
+
+
+
+uint8_t MemReadByteSlow (uint16_t Addr)
+/* Read a byte from a page that isn't mapped as plain RAM */
+{
+    const MemPage* P = Pages + (Addr >> 8);
+    if (P->Read) {
+        return P->Read (Addr);
+    }
+    if (P->Flags & MEM_PAGE_WATCH) {
+        HeatmapCountRead (Addr);
+    }
+    return Mem[Addr];
+}
+
+
+
+void MemWriteByteSlow (uint16_t Addr, uint8_t Val)
+/* Write a byte to a page that isn't mapped as plain RAM */
+{
+    const MemPage* P = Pages + (Addr >> 8);
+
+    /* Remember that the page must be cleared by MemReset */
+    if (P->Flags & MEM_PAGE_CLEAN) {
+        MemClearPageFlags (Addr >> 8, MEM_PAGE_CLEAN);
+    }
+
+    /* If there's code in this page, the decoded insn may be stale now */
+    if (P->Flags & MEM_PAGE_CODE) {
+        InvalidateDecodedInsn (Addr);
+    }
+
+    if (P->Write) {
+        /* Defer to the handler for this page */
+        P->Write (Addr, Val);
+    } else if ((P->Flags & MEM_PAGE_READONLY) == 0) {
         /* Write to the Mem array. */
+        if (P->Flags & MEM_PAGE_WATCH) {
+            HeatmapCountWrite (Addr);
+        }
         Mem[Addr] = Val;
     }
 }
 
 
 
+uint8_t MemReadLongSlow (uint32_t Addr)
+/* Read a byte from a bank other than bank 0 */
+{
+    const uint8_t* Bank = Banks[(Addr >> 16) & 0xFF];
+    return Bank? Bank[Addr & 0xFFFF] : 0xFF;
+}
+
+
+
+void MemWriteLongSlow (uint32_t Addr, uint8_t Val)
+/* Write a byte to a bank other than bank 0 */
+{
+    uint8_t** Bank = Banks + ((Addr >> 16) & 0xFF);
+    if (*Bank == 0) {
+        /* Unused memory reads as the illegal opcode, like in bank 0 */
+        *Bank = xmalloc (0x10000);
+        memset (*Bank, 0xFF, 0x10000);
+    }
+    (*Bank)[Addr & 0xFFFF] = Val;
+}
+
+
+
+static void FreeBanks (void)
+/* Release the memory of all banks above bank 0 */
+{
+    unsigned I;
+    for (I = 1; I < 0x100; ++I) {
+        xfree (Banks[I]);
+        Banks[I] = 0;
+    }
+}
+
+
+
 void MemWriteWord (uint16_t Addr, uint16_t Val)
 /* Write a word to a memory location */
 {
@@ -80,38 +194,52 @@ void MemWriteWord (uint16_t Addr, uint16_t Val)
 
 
 
-uint8_t MemReadByte (uint16_t Addr)
-/* Read a byte from a memory location */
+void MemMapHandler (uint8_t Page, MemReadFunc Read, MemWriteFunc Write)
+/* Install handlers for reads and/or writes for a page. A NULL handler means
+** that the corresponding accesses go to the Mem array.
+*/
 {
-    if ((PERIPHERALS_APERTURE_BASE_ADDRESS <= Addr) && (Addr <= PERIPHERALS_APERTURE_LAST_ADDRESS))
-    {
-        /* Defer the the memory-mapped peripherals handler for this read. */
-        return PeripheralsReadByte (Addr - PERIPHERALS_APERTURE_BASE_ADDRESS);
-    } else {
-        /* Read from the Mem array. */
-        return Mem[Addr];
+    Pages[Page].Read  = Read;
+    Pages[Page].Write = Write;
+    UpdatePage (Page);
+}
+
+
+
+int MemHasReadHandler (uint8_t Page)
+/* Return true if reads from the page go to a handler instead of Mem */
+{
+    return Pages[Page].Read != 0;
+}
+
+
+
+void MemSetPageFlags (uint8_t Page, unsigned Flags)
+/* Set flags for a page */
+{
+    if ((Pages[Page].Flags & Flags) != Flags) {
+        Pages[Page].Flags |= Flags;
+        UpdatePage (Page);
     }
 }
 
 
 
-uint16_t MemReadWord (uint16_t Addr)
-/* Read a word from a memory location */
+void MemClearPageFlags (uint8_t Page, unsigned Flags)
+/* Clear flags for a page */
 {
-    uint8_t W = MemReadByte (Addr++);
-    return (W | (MemReadByte (Addr) << 8));
+    if ((Pages[Page].Flags & Flags) != 0) {
+        Pages[Page].Flags &= ~Flags;
+        UpdatePage (Page);
+    }
 }
 
 
 
-uint16_t MemReadZPWord (uint8_t Addr)
-/* Read a word from the zero page. This function differs from MemReadWord in that
-** the read will always be in the zero page, even in case of an address
-** overflow.
-*/
+unsigned MemGetPageFlags (uint8_t Page)
+/* Return the flags for a page */
 {
-    uint8_t W = MemReadByte (Addr++);
-    return (W | (MemReadByte (Addr) << 8));
+    return Pages[Page].Flags;
 }
 
 
@@ -119,6 +247,38 @@ uint16_t MemReadZPWord (uint8_t Addr)
 void MemInit (void)
 /* Initialize the memory subsystem */
 {
+    unsigned I;
+
     /* Fill memory with illegal opcode */
     memset (Mem, 0xFF, sizeof (Mem));
+
+    /* Map all pages as plain RAM */
+    for (I = 0; I < 0x100; ++I) {
+        Pages[I].Read  = 0;
+        Pages[I].Write = 0;
+        Pages[I].Flags = MEM_PAGE_CLEAN;
+        UpdatePage (I);
+    }
+
+    /* Banks above bank 0 are allocated when needed */
+    FreeBanks ();
+}
+
+
+
+void MemReset (void)
+/* Restore the contents of all pages written to since MemInit or the last
+** call to MemReset, and release the banks above bank 0. The handlers and
+** other flags are not changed.
+*/
+{
+    unsigned I;
+
+    for (I = 0; I < 0x100; ++I) {
+        if ((Pages[I].Flags & MEM_PAGE_CLEAN) == 0) {
+            memset (Mem + (I << 8), 0xFF, 0x100);
+            MemSetPageFlags (I, MEM_PAGE_CLEAN);
+        }
+    }
+    FreeBanks ();
 }
@@ -38,7 +38,39 @@
 
 #include <stdint.h>
 
-extern uint8_t Mem[0x10000];
+/* common */
+#include "thread.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* The memory */
+extern THREAD_LOCAL uint8_t Mem[0x10000];
+
+/* Handlers for pages that are not plain RAM */
+typedef uint8_t (*MemReadFunc) (uint16_t Addr);
+typedef void (*MemWriteFunc) (uint16_t Addr, uint8_t Val);
+
+/* Page flags */
+#define MEM_PAGE_READONLY   0x01U       /* Writes to Mem are ignored */
+#define MEM_PAGE_CODE       0x02U       /* Page contains decoded code */
+#define MEM_PAGE_CLEAN      0x04U       /* Page wasn't written to yet */
+#define MEM_PAGE_WATCH      0x08U       /* Accesses are counted by heatmap */
+
+/* The page table. For each of the 256 pages, these point to the memory that
+** is accessed by reads and writes. If the pointer is NULL, the access goes
+** through the slow path, which calls the handlers installed for the page,
+** or checks the page flags.
+*/
+extern THREAD_LOCAL uint8_t* MemReadMap[0x100];
+extern THREAD_LOCAL uint8_t* MemWriteMap[0x100];
+
+
 
 /*****************************************************************************/
 /*                                   Code                                    */
@@ -46,27 +78,106 @@ extern uint8_t Mem[0x10000];
 
 
 
-void MemWriteByte (uint16_t Addr, uint8_t Val);
+uint8_t MemReadByteSlow (uint16_t Addr);
+/* Read a byte from a page that isn't mapped as plain RAM */
+
+void MemWriteByteSlow (uint16_t Addr, uint8_t Val);
+/* Write a byte to a page that isn't mapped as plain RAM */
+
+static inline void MemWriteByte (uint16_t Addr, uint8_t Val)
 /* Write a byte to a memory location */
+{
+    uint8_t* Page = MemWriteMap[Addr >> 8];
+    if (Page) {
+        Page[Addr & 0xFF] = Val;
+    } else {
+        MemWriteByteSlow (Addr, Val);
+    }
+}
 
 void MemWriteWord (uint16_t Addr, uint16_t Val);
 /* Write a word to a memory location */
 
-uint8_t MemReadByte (uint16_t Addr);
+static inline uint8_t MemReadByte (uint16_t Addr)
 /* Read a byte from a memory location */
+{
+    const uint8_t* Page = MemReadMap[Addr >> 8];
+    return Page ? Page[Addr & 0xFF] : MemReadByteSlow (Addr);
+}
 
-uint16_t MemReadWord (uint16_t Addr);
+static inline uint16_t MemReadWord (uint16_t Addr)
 /* Read a word from a memory location */
-
-uint16_t MemReadZPWord (uint8_t Addr);
+{
+    const uint8_t* Page = MemReadMap[Addr >> 8];
+    if (Page && (Addr & 0xFF) != 0xFF) {
+        /* Both bytes are in the same RAM page */
+        return Page[Addr & 0xFF] | (Page[(Addr & 0xFF) + 1] << 8);
+    } else {
+        uint8_t W = MemReadByte (Addr++);
+        return (W | (MemReadByte (Addr) << 8));
+    }
+}
+
+uint8_t MemReadLongSlow (uint32_t Addr);
+/* Read a byte from a bank other than bank 0 */
+
+void MemWriteLongSlow (uint32_t Addr, uint8_t Val);
+/* Write a byte to a bank other than bank 0 */
+
+static inline uint8_t MemReadLong (uint32_t Addr)
+/* Read a byte from a 24 bit address, as used by the 65816. Bank 0 is the
+** memory used by the 6502.
+*/
+{
+    return (Addr & 0xFF0000)? MemReadLongSlow (Addr) : MemReadByte ((uint16_t) Addr);
+}
+
+static inline void MemWriteLong (uint32_t Addr, uint8_t Val)
+/* Write a byte to a 24 bit address, as used by the 65816 */
+{
+    if (Addr & 0xFF0000) {
+        MemWriteLongSlow (Addr, Val);
+    } else {
+        MemWriteByte ((uint16_t) Addr, Val);
+    }
+}
+
+static inline uint16_t MemReadZPWord (uint8_t Addr)
 /* Read a word from the zero page. This function differs from MemReadWord in that
 ** the read will always be in the zero page, even in case of an address
 ** overflow.
 */
+{
+    uint8_t W = MemReadByte (Addr++);
+    return (W | (MemReadByte (Addr) << 8));
+}
+
+void MemMapHandler (uint8_t Page, MemReadFunc Read, MemWriteFunc Write);
+/* Install handlers for reads and/or writes for a page. A NULL handler means
+** that the corresponding accesses go to the Mem array.
+*/
+
+int MemHasReadHandler (uint8_t Page);
+/* Return true if reads from the page go to a handler instead of Mem */
+
+void MemSetPageFlags (uint8_t Page, unsigned Flags);
+/* Set flags for a page */
+
+void MemClearPageFlags (uint8_t Page, unsigned Flags);
+/* Clear flags for a page */
+
+unsigned MemGetPageFlags (uint8_t Page);
+/* Return the flags for a page */
 
 void MemInit (void);
 /* Initialize the memory subsystem */
 
+void MemReset (void);
+/* Restore the contents of all pages written to since MemInit or the last
+** call to MemReset, and release the banks above bank 0. The handlers and
+** other flags are not changed.
+*/
+
 
 
 /* End of memory.h */
@@ -35,6 +35,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #if defined(_WIN32)
@@ -57,7 +58,7 @@
 #endif
 
 /* common */
-#include "cmdline.h"
+#include "coll.h"
 #include "print.h"
 #include "xmalloc.h"
 
@@ -77,8 +78,46 @@
 
 typedef void (*PVFunc) (CPURegs* Regs);
 
-static unsigned ArgStart;
-static unsigned char SPAddr;
+/* Cost of a memory function run natively, in the clock cycles the version
+** from the library would have used in addition to those of the wrapper in
+** pvmem.s: Base + PerPage * (n / 256) + PerByte * (n % 256), where n is the
+** number of bytes processed. The values were measured with sim65.
+*/
+typedef struct PVCost PVCost;
+struct PVCost {
+    unsigned    Base;
+    unsigned    PerPage;
+    unsigned    PerByte;
+};
+
+static const PVCost MemcpyCost  = { 122, 3798, 18 };
+static const PVCost MemmoveCost = { 142, 3849, 18 };
+static const PVCost MemsetCost  = { 175, 1995,  9 };
+static const PVCost BzeroCost   = { 136, 1995,  9 };
+static const PVCost StrcmpCost  = {  56, 5605, 22 };
+static const PVCost StrlenCost  = {   0, 3226, 13 };
+
+/* True if the memory functions run natively */
+bool ParaVirtMemNative = true;
+
+/* Clock cycles used by the last hook, in addition to the JSR */
+static THREAD_LOCAL unsigned HookCycles;
+
+static THREAD_LOCAL unsigned ArgStart;
+static THREAD_LOCAL unsigned ProgArgCount;
+static THREAD_LOCAL char* const* ProgArgVec;
+static THREAD_LOCAL unsigned char SPAddr;
+
+/* A file opened by the simulated program */
+typedef struct PVFile PVFile;
+struct PVFile {
+    int         FD;             /* Host file descriptor */
+    unsigned    Flags;          /* cc65 open flags */
+    char*       Path;           /* Name of the file */
+};
+
+/* All files currently opened by the simulated program */
+static THREAD_LOCAL Collection Files = STATIC_COLLECTION_INITIALIZER;
 
 
 
@@ -131,7 +170,7 @@ static void PVExit (CPURegs* Regs)
 
 static void PVArgs (CPURegs* Regs)
 {
-    unsigned ArgC = ArgCount - ArgStart;
+    unsigned ArgC = ProgArgCount - ArgStart;
     unsigned ArgV = GetAX (Regs);
     unsigned SP   = MemReadZPWord (SPAddr);
     unsigned Args = SP - (ArgC + 1) * 2;
@@ -141,9 +180,9 @@ static void PVArgs (CPURegs* Regs)
     MemWriteWord (ArgV, Args);
 
     SP = Args;
-    while (ArgStart < ArgCount) {
+    while (ArgStart < ProgArgCount) {
         unsigned I = 0;
-        const char* Arg = ArgVec[ArgStart++];
+        const char* Arg = ProgArgVec[ArgStart++];
         SP -= strlen (Arg) + 1;
         do {
             MemWriteByte (SP + I, Arg[I]);
@@ -185,10 +224,73 @@ static void PVLseek (CPURegs* Regs)
 
 
 
+static int MapOpenFlags (unsigned Flags)
+/* Map cc65 open flags to the flags of the host */
+{
+    int OFlag = O_INITIAL;
+
+    switch (Flags & 0x03) {
+        case 0x01:
+            OFlag |= O_RDONLY;
+            break;
+        case 0x02:
+            OFlag |= O_WRONLY;
+            break;
+        case 0x03:
+            OFlag |= O_RDWR;
+            break;
+    }
+    if (Flags & 0x10) {
+        OFlag |= O_CREAT;
+    }
+    if (Flags & 0x20) {
+        OFlag |= O_TRUNC;
+    }
+    if (Flags & 0x40) {
+        OFlag |= O_APPEND;
+    }
+    if (Flags & 0x80) {
+        OFlag |= O_EXCL;
+    }
+
+    return OFlag;
+}
+
+
+
+static void AddFile (int FD, unsigned Flags, const char* Path)
+/* Remember a file opened by the simulated program */
+{
+    PVFile* F = xmalloc (sizeof (PVFile));
+    F->FD    = FD;
+    F->Flags = Flags;
+    F->Path  = xstrdup (Path);
+    CollAppend (&Files, F);
+}
+
+
+
+static void RemoveFile (int FD)
+/* Forget a file closed by the simulated program */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (&Files); ++I) {
+        PVFile* F = CollAtUnchecked (&Files, I);
+        if (F->FD == FD) {
+            CollDelete (&Files, I);
+            xfree (F->Path);
+            xfree (F);
+            return;
+        }
+    }
+}
+
+
+
 static void PVOpen (CPURegs* Regs)
 {
     char Path[PV_PATH_SIZE];
-    int OFlag = O_INITIAL;
+    int OFlag;
     int OMode = 0;
     unsigned RetVal, I = 0;
 
@@ -216,29 +318,7 @@ static void PVOpen (CPURegs* Regs)
 
     Print (stderr, 2, "PVOpen (\"%s\", $%04X)\n", Path, Flags);
 
-    switch (Flags & 0x03) {
-        case 0x01:
-            OFlag |= O_RDONLY;
-            break;
-        case 0x02:
-            OFlag |= O_WRONLY;
-            break;
-        case 0x03:
-            OFlag |= O_RDWR;
-            break;
-    }
-    if (Flags & 0x10) {
-        OFlag |= O_CREAT;
-    }
-    if (Flags & 0x20) {
-        OFlag |= O_TRUNC;
-    }
-    if (Flags & 0x40) {
-        OFlag |= O_APPEND;
-    }
-    if (Flags & 0x80) {
-        OFlag |= O_EXCL;
-    }
+    OFlag = MapOpenFlags (Flags);
 
     if (Mode & 0x01) {
         OMode |= S_IREAD;
@@ -248,6 +328,9 @@ static void PVOpen (CPURegs* Regs)
     }
 
     RetVal = open (Path, OFlag, OMode);
+    if (RetVal != (unsigned) -1) {
+        AddFile (RetVal, Flags, Path);
+    }
 
     SetAX (Regs, RetVal);
 }
@@ -264,6 +347,9 @@ static void PVClose (CPURegs* Regs)
 
     if (FD != 0xFFFF) {
         RetVal = close (FD);
+        if (RetVal == 0) {
+            RemoveFile (FD);
+        }
     } else {
         /* test/val/constexpr.c "abuses" close, expecting close(-1) to return -1.
         ** This behaviour is not the same on all target platforms.
@@ -366,7 +452,148 @@ static void PVOSMapErrno (CPURegs* Regs)
 
 
 
+static bool MemFunc (CPURegs* Regs, const PVCost* Cost, unsigned Count)
+/* Common code for the memory functions. If they run natively, account for
+** the cycles they would have taken, and return true. Otherwise set the carry
+** flag to tell the 6502 code to do the work, and return false.
+*/
+{
+    if (!ParaVirtMemNative) {
+        Regs->SR |= CF;
+        return false;
+    }
+    HookCycles = Cost->Base + Cost->PerPage * (Count >> 8) +
+                 Cost->PerByte * (Count & 0xFF);
+    Regs->SR &= ~CF;
+    return true;
+}
+
+
+
+static void PVMemcpy (CPURegs* Regs)
+{
+    unsigned Count = GetAX (Regs);
+
+    if (MemFunc (Regs, &MemcpyCost, Count)) {
+        unsigned Src  = PopParam (2);
+        unsigned Dest = PopParam (2);
+
+        /* Copy upwards like the library does, even if the blocks overlap */
+        SetAX (Regs, Dest);
+        while (Count--) {
+            MemWriteByte (Dest++, MemReadByte (Src++));
+        }
+    }
+}
+
+
+
+static void PVMemmove (CPURegs* Regs)
+{
+    unsigned Count = GetAX (Regs);
+
+    if (MemFunc (Regs, &MemmoveCost, Count)) {
+        unsigned Src  = PopParam (2);
+        unsigned Dest = PopParam (2);
+
+        SetAX (Regs, Dest);
+        if (Dest < Src) {
+            while (Count--) {
+                MemWriteByte (Dest++, MemReadByte (Src++));
+            }
+        } else {
+            while (Count--) {
+                MemWriteByte (Dest + Count, MemReadByte (Src + Count));
+            }
+        }
+    }
+}
+
+
+
+static void Fill (CPURegs* Regs, unsigned Ptr, unsigned char Val, unsigned Count)
+/* Fill memory for PVMemset and PVBzero */
+{
+    SetAX (Regs, Ptr);
+    while (Count--) {
+        MemWriteByte (Ptr++, Val);
+    }
+}
+
+
+
+static void PVMemset (CPURegs* Regs)
+{
+    unsigned Count = GetAX (Regs);
+
+    if (MemFunc (Regs, &MemsetCost, Count)) {
+        unsigned char Val = (unsigned char) PopParam (2);
+        Fill (Regs, PopParam (2), Val, Count);
+    }
+}
+
+
+
+static void PVBzero (CPURegs* Regs)
+{
+    unsigned Count = GetAX (Regs);
+
+    if (MemFunc (Regs, &BzeroCost, Count)) {
+        Fill (Regs, PopParam (2), 0, Count);
+    }
+}
+
+
+
+static void PVStrcmp (CPURegs* Regs)
+{
+    unsigned S2 = GetAX (Regs);
+    unsigned S1 = MemReadWord (MemReadZPWord (SPAddr));
+    unsigned I  = 0;
+    unsigned char C1, C2;
+
+    /* The cost depends on the number of characters compared */
+    while ((C1 = MemReadByte (S1 + I)) == (C2 = MemReadByte (S2 + I)) &&
+           C1 != 0 && I < 0xFFFF) {
+        ++I;
+    }
+    if (MemFunc (Regs, &StrcmpCost, I)) {
+        PopParam (2);
+
+        /* Same result as the library: The character from s1 in A, and the
+        ** sign of the difference in X.
+        */
+        Regs->AC = C1;
+        Regs->XR = (C1 == C2)? 0x00 : (C1 < C2)? 0xFF : 0x01;
+    }
+}
+
+
+
+static void PVStrlen (CPURegs* Regs)
+{
+    unsigned S = GetAX (Regs);
+    unsigned I = 0;
+
+    while (MemReadByte (S + I) != 0 && I < 0xFFFF) {
+        ++I;
+    }
+    if (MemFunc (Regs, &StrlenCost, I)) {
+        /* strspn and strcspn expect the low byte of the length in Y */
+        SetAX (Regs, I);
+        Regs->YR = I & 0xFF;
+    }
+}
+
+
+
 static const PVFunc Hooks[] = {
+    PVStrlen,
+    PVStrcmp,
+    PVBzero,
+    PVMemset,
+    PVMemmove,
+    PVMemcpy,
     PVLseek,
     PVSysRemove,
     PVOSMapErrno,
@@ -380,30 +607,100 @@ static const PVFunc Hooks[] = {
 
 
 
-void ParaVirtInit (unsigned aArgStart, unsigned char aSPAddr)
-/* Initialize the paravirtualization subsystem */
+void ParaVirtInit (unsigned aArgCount, char* const* aArgVec, unsigned char aSPAddr)
+/* Initialize the paravirtualization subsystem. The arguments for the program
+** start with the program name.
+*/
 {
-    ArgStart = aArgStart;
+    ArgStart = 0;
+    ProgArgCount = aArgCount;
+    ProgArgVec = aArgVec;
     SPAddr = aSPAddr;
 };
 
 
 
-void ParaVirtHooks (CPURegs* Regs)
-/* Potentially execute paravirtualization hooks */
+void ParaVirtReset (void)
+/* Close all files left open by the simulated program */
+{
+    while (CollCount (&Files) > 0) {
+        const PVFile* F = CollLast (&Files);
+        close (F->FD);
+        RemoveFile (F->FD);
+    }
+}
+
+
+
+unsigned ParaVirtFileCount (void)
+/* Return the number of files currently opened by the simulated program */
+{
+    return CollCount (&Files);
+}
+
+
+
+const char* ParaVirtGetFile (unsigned Index, int* FD, unsigned* Flags, long* Offset)
+/* Return the name of an open file, and its file descriptor, cc65 open flags
+** and current position.
+*/
+{
+    const PVFile* F = CollConstAt (&Files, Index);
+    *FD     = F->FD;
+    *Flags  = F->Flags;
+    *Offset = (long) lseek (F->FD, 0, SEEK_CUR);
+    return F->Path;
+}
+
+
+
+void ParaVirtReopenFile (int FD, unsigned Flags, const char* Path, long Offset)
+/* Open a file again under the same file descriptor and at the same position
+** as before. Flags that would create or truncate the file are ignored.
+*/
+{
+    int NewFD = open (Path, MapOpenFlags (Flags & ~(0x10 | 0x20 | 0x80)));
+    if (NewFD < 0) {
+        Error ("Cannot reopen '%s': %s", Path, strerror (errno));
+    }
+    if (NewFD != FD) {
+        if (dup2 (NewFD, FD) < 0) {
+            Error ("Cannot reopen '%s': %s", Path, strerror (errno));
+        }
+        close (NewFD);
+    }
+    if (lseek (FD, (off_t) Offset, SEEK_SET) < 0) {
+        Error ("Cannot seek in '%s': %s", Path, strerror (errno));
+    }
+    RemoveFile (FD);
+    AddFile (FD, Flags, Path);
+}
+
+
+
+unsigned ParaVirtHooks (CPURegs* Regs)
+/* Potentially execute paravirtualization hooks. Return the number of clock
+** cycles used by the hook, in addition to those of the JSR or JMP.
+*/
 {
     unsigned lo;
 
     /* Check for paravirtualization address range */
     if (Regs->PC <  PARAVIRT_BASE ||
         Regs->PC >= PARAVIRT_BASE + sizeof (Hooks) / sizeof (Hooks[0])) {
-        return;
+        return 0;
     }
 
     /* Call paravirtualization hook */
+    HookCycles = 0;
     Hooks[Regs->PC - PARAVIRT_BASE] (Regs);
 
+    /* Give the caller of ExecuteUntil a chance to look at the results */
+    ExecuteBreak ();
+
     /* Simulate RTS */
     lo = Pop (Regs);
     Regs->PC = lo + (Pop (Regs) << 8) + 1;
+
+    return HookCycles;
 }
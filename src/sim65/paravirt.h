@@ -36,6 +36,8 @@
 #define PARAVIRT_H
 
 
+#include <stdbool.h>
+
 #include "6502.h"
 
 
@@ -45,12 +47,17 @@
 
 
 
-#define PARAVIRT_BASE        0xFFF1
+#define PARAVIRT_BASE        0xFFEB
 /* Lowest address used by a paravirtualization hook */
 
 #define PV_PATH_SIZE         1024
 /* Maximum path size supported by PVOpen/PVSysRemove */
 
+extern bool ParaVirtMemNative;
+/* True if the hooks for memcpy, memset and friends do the work natively.
+** Otherwise the 6502 code from the library is used.
+*/
+
 
 
 /*****************************************************************************/
@@ -59,11 +66,31 @@
 
 
 
-void ParaVirtInit (unsigned aArgStart, unsigned char aSPAddr);
-/* Initialize the paravirtualization subsystem */
+void ParaVirtInit (unsigned aArgCount, char* const* aArgVec, unsigned char aSPAddr);
+/* Initialize the paravirtualization subsystem. The arguments for the program
+** start with the program name.
+*/
+
+void ParaVirtReset (void);
+/* Close all files left open by the simulated program */
+
+unsigned ParaVirtHooks (CPURegs* Regs);
+/* Potentially execute paravirtualization hooks. Return the number of clock
+** cycles used by the hook, in addition to those of the JSR or JMP.
+*/
+
+unsigned ParaVirtFileCount (void);
+/* Return the number of files currently opened by the simulated program */
+
+const char* ParaVirtGetFile (unsigned Index, int* FD, unsigned* Flags, long* Offset);
+/* Return the name of an open file, and its file descriptor, cc65 open flags
+** and current position.
+*/
 
-void ParaVirtHooks (CPURegs* Regs);
-/* Potentially execute paravirtualization hooks */
+void ParaVirtReopenFile (int FD, unsigned Flags, const char* Path, long Offset);
+/* Open a file again under the same file descriptor and at the same position
+** as before. Flags that would create or truncate the file are ignored.
+*/
 
 
 
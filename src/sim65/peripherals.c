@@ -36,7 +36,11 @@
 #endif
 
 
+#include "attrib.h"
+
 #include "peripherals.h"
+#include "event.h"
+#include "memory.h"
 #include "trace.h"
 #include "6502.h"
 
@@ -48,7 +52,7 @@
 
 
 /* The system-wide state of the peripherals */
-Sim65Peripherals Peripherals;
+THREAD_LOCAL Sim65Peripherals Peripherals;
 
 
 
@@ -107,6 +111,45 @@ static bool GetWallclockTime (struct timespec * ts)
 
 
 
+static void TimerExpired (void* Data attribute ((unused)))
+/* Event function for the timer */
+{
+    TimerPeripheral* T = &Peripherals.Timer;
+
+    T->Status |= PERIPHERALS_TIMER_STATUS_EXPIRED;
+    if (T->Control & PERIPHERALS_TIMER_CONTROL_NMI) {
+        NMIRequest ();
+    } else {
+        IRQRequest ();
+    }
+
+    /* Keep the period exact, even if the event ran a few cycles late */
+    if (T->Control & PERIPHERALS_TIMER_CONTROL_PERIODIC) {
+        T->Deadline += T->Period;
+        EventSchedule (T->Deadline, TimerExpired, 0);
+    } else {
+        T->Control &= ~PERIPHERALS_TIMER_CONTROL_ENABLE;
+    }
+}
+
+
+
+static void TimerStart (void)
+/* Start or stop the timer after a write to the control register */
+{
+    TimerPeripheral* T = &Peripherals.Timer;
+
+    EventCancel (TimerExpired, 0);
+    if ((T->Control & PERIPHERALS_TIMER_CONTROL_ENABLE) && T->Period > 0) {
+        T->Deadline = Peripherals.Counter.ClockCycles + T->Period;
+        EventSchedule (T->Deadline, TimerExpired, 0);
+    } else {
+        T->Control &= ~PERIPHERALS_TIMER_CONTROL_ENABLE;
+    }
+}
+
+
+
 void PeripheralsWriteByte (uint8_t Addr, uint8_t Val)
 /* Write a byte to a memory location in the peripherals address aperture. */
 {
@@ -151,14 +194,46 @@ void PeripheralsWriteByte (uint8_t Addr, uint8_t Val)
         /* Handle writes to the SimControl peripheral. */
 
         case PERIPHERALS_SIMCONTROL_ADDRESS_OFFSET_CPUMODE: {
-            if (Val == CPU_6502 || Val == CPU_65C02 || Val == CPU_6502X) {
+            if ((Val == CPU_6502 || Val == CPU_65C02 || Val == CPU_6502X || Val == CPU_65816) &&
+                Val != CPU) {
                 CPU = Val;
+                /* Decoded instructions are only valid for one CPU type */
+                InvalidateCodeCache ();
             }
             break;
         }
 
         case PERIPHERALS_SIMCONTROL_ADDRESS_OFFSET_TRACEMODE: {
             TraceMode = Val;
+            /* Tracing is done outside of the fast execution loop */
+            ExecuteBreak ();
+            break;
+        }
+
+        /* Handle writes to the Timer peripheral. */
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 0:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 1:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 2:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 3: {
+            /* Set one byte of the period. It is used when the timer is started
+             * the next time, or restarts in periodic mode.
+             */
+            unsigned Shift = (Addr - PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD) * 8;
+            Peripherals.Timer.Period &= ~((uint32_t) 0xFF << Shift);
+            Peripherals.Timer.Period |= (uint32_t) Val << Shift;
+            break;
+        }
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_CONTROL: {
+            Peripherals.Timer.Control = Val;
+            TimerStart ();
+            break;
+        }
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_STATUS: {
+            /* Acknowledge the expiration */
+            Peripherals.Timer.Status &= ~(Val & PERIPHERALS_TIMER_STATUS_EXPIRED);
             break;
         }
 
@@ -218,6 +293,24 @@ uint8_t PeripheralsReadByte (uint8_t Addr)
             return TraceMode;
         }
 
+        /* Handle reads from the Timer peripheral. */
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 0:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 1:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 2:
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD + 3: {
+            unsigned Shift = (Addr - PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD) * 8;
+            return (uint8_t) (Peripherals.Timer.Period >> Shift);
+        }
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_CONTROL: {
+            return Peripherals.Timer.Control;
+        }
+
+        case PERIPHERALS_TIMER_ADDRESS_OFFSET_STATUS: {
+            return Peripherals.Timer.Status;
+        }
+
         /* Handle reads from unused peripheral and write-only addresses. */
 
         default: {
@@ -229,9 +322,44 @@ uint8_t PeripheralsReadByte (uint8_t Addr)
 
 
 
+static uint8_t PeripheralsPageRead (uint16_t Addr)
+/* Read handler for the memory page that contains the peripherals aperture. */
+{
+    if ((PERIPHERALS_APERTURE_BASE_ADDRESS <= Addr) && (Addr <= PERIPHERALS_APERTURE_LAST_ADDRESS)) {
+        /* Defer to the memory-mapped peripherals handler for this read. */
+        return PeripheralsReadByte (Addr - PERIPHERALS_APERTURE_BASE_ADDRESS);
+    } else {
+        /* Read from the Mem array. */
+        return Mem[Addr];
+    }
+}
+
+
+
+static void PeripheralsPageWrite (uint16_t Addr, uint8_t Val)
+/* Write handler for the memory page that contains the peripherals aperture. */
+{
+    if ((PERIPHERALS_APERTURE_BASE_ADDRESS <= Addr) && (Addr <= PERIPHERALS_APERTURE_LAST_ADDRESS)) {
+        /* Defer to the memory-mapped peripherals handler for this write. */
+        PeripheralsWriteByte (Addr - PERIPHERALS_APERTURE_BASE_ADDRESS, Val);
+    } else {
+        /* Write to the Mem array. */
+        Mem[Addr] = Val;
+    }
+}
+
+
+
 void PeripheralsInit (void)
 /* Initialize the peripherals. */
 {
+    /* Route accesses to the page with the peripherals through our handlers.
+    ** All other pages remain plain RAM.
+    */
+    MemMapHandler (PERIPHERALS_APERTURE_BASE_ADDRESS >> 8,
+                   PeripheralsPageRead,
+                   PeripheralsPageWrite);
+
     /* Initialize the Counter peripheral */
 
     Peripherals.Counter.ClockCycles = 0;
@@ -247,4 +375,25 @@ void PeripheralsInit (void)
     Peripherals.Counter.LatchedWallclockTimeSplit = 0;
 
     Peripherals.Counter.LatchedValueSelected = 0;
+
+    /* Initialize the Timer peripheral. It is stopped. */
+
+    EventCancel (TimerExpired, 0);
+    Peripherals.Timer.Period = 0;
+    Peripherals.Timer.Control = 0;
+    Peripherals.Timer.Status = 0;
+    Peripherals.Timer.Deadline = 0;
+}
+
+
+
+void PeripheralsRestore (void)
+/* Schedule the events of the peripherals again after their state was
+** restored from a snapshot.
+*/
+{
+    EventCancel (TimerExpired, 0);
+    if (Peripherals.Timer.Control & PERIPHERALS_TIMER_CONTROL_ENABLE) {
+        EventSchedule (Peripherals.Timer.Deadline, TimerExpired, 0);
+    }
 }
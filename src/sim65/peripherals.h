@@ -35,10 +35,13 @@
 
 #include <stdint.h>
 
+/* common */
+#include "thread.h"
+
 /* The memory range where the memory-mapped peripherals can be accessed. */
 
 #define PERIPHERALS_APERTURE_BASE_ADDRESS  0xffc0
-#define PERIPHERALS_APERTURE_LAST_ADDRESS  0xffcb
+#define PERIPHERALS_APERTURE_LAST_ADDRESS  0xffd1
 
 /* Declarations for the COUNTER peripheral */
 
@@ -92,14 +95,46 @@ typedef struct {
 #define PERIPHERALS_SIMCONTROL_CPUMODE   (PERIPHERALS_APERTURE_BASE_ADDRESS + PERIPHERALS_SIMCONTROL_ADDRESS_OFFSET_CPUMODE)
 #define PERIPHERALS_SIMCONTROL_TRACEMODE (PERIPHERALS_APERTURE_BASE_ADDRESS + PERIPHERALS_SIMCONTROL_ADDRESS_OFFSET_TRACEMODE)
 
+/* Declarations for the TIMER peripheral. */
+
+#define PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD   0x0C
+#define PERIPHERALS_TIMER_ADDRESS_OFFSET_CONTROL  0x10
+#define PERIPHERALS_TIMER_ADDRESS_OFFSET_STATUS   0x11
+
+#define PERIPHERALS_TIMER_PERIOD   (PERIPHERALS_APERTURE_BASE_ADDRESS + PERIPHERALS_TIMER_ADDRESS_OFFSET_PERIOD)
+#define PERIPHERALS_TIMER_CONTROL  (PERIPHERALS_APERTURE_BASE_ADDRESS + PERIPHERALS_TIMER_ADDRESS_OFFSET_CONTROL)
+#define PERIPHERALS_TIMER_STATUS   (PERIPHERALS_APERTURE_BASE_ADDRESS + PERIPHERALS_TIMER_ADDRESS_OFFSET_STATUS)
+
+#define PERIPHERALS_TIMER_CONTROL_ENABLE    0x01    /* Timer is running */
+#define PERIPHERALS_TIMER_CONTROL_PERIODIC  0x02    /* Restart when it expires */
+#define PERIPHERALS_TIMER_CONTROL_NMI       0x04    /* Raise an NMI instead of an IRQ */
+
+#define PERIPHERALS_TIMER_STATUS_EXPIRED    0x01    /* Expired, not yet acknowledged */
+
+typedef struct {
+    /* Number of clock cycles until the timer expires. A 32 bit, read/write
+     * register with the LSB at PERIPHERALS_TIMER_PERIOD.
+     */
+    uint32_t Period;
+    /* Read/write control register. Each write restarts the timer if the
+     * ENABLE bit is set, and stops it otherwise.
+     */
+    uint8_t Control;
+    /* Status register. Writing a value with the EXPIRED bit set clears it. */
+    uint8_t Status;
+    /* Clock cycle count when the running timer expires. */
+    uint64_t Deadline;
+} TimerPeripheral;
+
 /* Declare the 'Sim65Peripherals' type and its single instance 'Peripherals'. */
 
 typedef struct {
     /* State of the peripherals available in sim65. */
     CounterPeripheral Counter;
+    TimerPeripheral   Timer;
 } Sim65Peripherals;
 
-extern Sim65Peripherals Peripherals;
+extern THREAD_LOCAL Sim65Peripherals Peripherals;
 
 /*****************************************************************************/
 /*                                   Code                                    */
@@ -116,7 +151,15 @@ uint8_t PeripheralsReadByte (uint8_t Addr);
 
 
 void PeripheralsInit (void);
-/* Initialize the peripherals. */
+/* Initialize the peripherals. Must be called after MemInit, since it
+** installs the handlers for the memory page with the peripherals aperture.
+*/
+
+
+void PeripheralsRestore (void);
+/* Schedule the events of the peripherals again after their state was
+** restored from a snapshot.
+*/
 
 
 
@@ -0,0 +1,711 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 profile.c                                 */
+/*                                                                           */
+/*                   Cycle profiler for the sim65 6502 simulator             */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+/* common */
+#include "coll.h"
+#include "xmalloc.h"
+
+/* dbginfo */
+#include "../dbginfo/dbginfo.h"
+
+/* sim65 */
+#include "6502.h"
+#include "error.h"
+#include "memory.h"
+#include "paravirt.h"
+#include "peripherals.h"
+#include "profile.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Maximum depth of the shadow call stack. JSR pushes two bytes, so the 6502
+** stack cannot hold more than 128 return addresses.
+*/
+#define MAX_CALL_DEPTH  128
+
+/* A frame on the shadow call stack */
+typedef struct CallFrame CallFrame;
+struct CallFrame {
+    uint16_t            Site;           /* Address of the JSR */
+    uint8_t             SP;             /* Stack pointer before the JSR */
+    uint64_t            Start;          /* Clock cycles when JSR started */
+};
+
+/* Raw data collected while the program runs. All arrays are indexed by
+** address.
+*/
+typedef struct ProfileData ProfileData;
+struct ProfileData {
+    uint64_t            Cycles[0x10000];        /* Cycles spent per insn */
+    uint64_t            Insns[0x10000];         /* Executions per insn */
+    uint64_t            Calls[0x10000];         /* Calls per JSR site */
+    uint64_t            CallCycles[0x10000];    /* Inclusive cycles per site */
+    uint16_t            CallTarget[0x10000];    /* Target per JSR site */
+    CallFrame           Stack[MAX_CALL_DEPTH];  /* Shadow call stack */
+    unsigned            Depth;                  /* Depth of call stack */
+};
+
+/* A function in the profile */
+typedef struct ProfileFunc ProfileFunc;
+struct ProfileFunc {
+    unsigned            Addr;           /* Entry point */
+    const char*         Name;           /* Name from the debug info or NULL */
+    uint64_t            Cycles;         /* Cycles spent in the function */
+    uint64_t            Insns;          /* Instructions executed */
+    uint64_t            Calls;          /* Number of calls */
+    uint64_t            CallCycles;     /* Inclusive cycles of all calls */
+};
+
+/* An edge in the call graph */
+typedef struct ProfileEdge ProfileEdge;
+struct ProfileEdge {
+    ProfileFunc*        Caller;
+    ProfileFunc*        Callee;         /* NULL for paravirtualization hooks */
+    unsigned            Target;         /* Call target address */
+    uint64_t            Calls;
+    uint64_t            CallCycles;
+};
+
+/* A source line in the profile */
+typedef struct ProfileLine ProfileLine;
+struct ProfileLine {
+    unsigned            SourceId;       /* Id of the source file */
+    unsigned            Line;           /* Line number */
+    uint64_t            Cycles;
+    uint64_t            Insns;
+};
+
+/* True if the profiler collects data */
+bool ProfileEnabled = false;
+
+/* Collected data, allocated when the profiler is enabled */
+static ProfileData* Prof;
+
+/* Output file and debug info file names */
+static const char* OutputName;
+static const char* DbgName;
+
+/* The debug info, if any */
+static cc65_dbginfo DbgInfo;
+
+/* Total number of clock cycles in the profile */
+static uint64_t TotalCycles;
+
+
+
+/*****************************************************************************/
+/*                                Collecting                                 */
+/*****************************************************************************/
+
+
+
+static void DbgError (const cc65_parseerror* E)
+/* Report an error or warning from reading the debug info */
+{
+    if (E->type == CC65_WARNING) {
+        Warning ("%s:%u: %s", E->name, E->line, E->errormsg);
+    } else {
+        Error ("%s:%u: %s", E->name, E->line, E->errormsg);
+    }
+}
+
+
+
+void ProfileInit (const char* aOutputName, const char* aDbgName)
+/* Enable the profiler. The profile is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to attribute cycles to functions and
+** source lines. Without it, functions are inferred from JSR targets.
+*/
+{
+    OutputName = aOutputName;
+    DbgName    = aDbgName;
+
+    /* Read the debug info now, so errors show up before the simulation */
+    if (DbgName) {
+        DbgInfo = cc65_read_dbginfo (DbgName, DbgError);
+        if (DbgInfo == 0) {
+            Error ("Cannot read debug info from '%s'", DbgName);
+        }
+    }
+
+    Prof = xmalloc (sizeof (ProfileData));
+    memset (Prof, 0, sizeof (ProfileData));
+    ProfileEnabled = true;
+}
+
+
+
+void ProfileInsn (uint16_t PC, uint8_t OPC, unsigned Cycles)
+/* Account for an instruction that was just executed. PC and OPC are the
+** address and opcode of the instruction, Cycles the number of clock cycles
+** it took.
+*/
+{
+    Prof->Cycles[PC] += Cycles;
+    ++Prof->Insns[PC];
+
+    if (OPC == 0x20) {
+
+        /* JSR. If we're at the target, it's a real call. Otherwise it was
+        ** a paravirtualization hook, which has returned already.
+        */
+        uint16_t Target = MemReadWord (PC + 1);
+        Prof->CallTarget[PC] = Target;
+        ++Prof->Calls[PC];
+        if (Regs.PC == Target) {
+            if (Prof->Depth < MAX_CALL_DEPTH) {
+                CallFrame* F = Prof->Stack + Prof->Depth++;
+                F->Site  = PC;
+                F->SP    = Regs.SP + 2;
+                F->Start = Peripherals.Counter.ClockCycles - Cycles;
+            }
+        } else {
+            Prof->CallCycles[PC] += Cycles;
+        }
+
+    } else if (OPC == 0x60) {
+
+        /* RTS. Pop all frames that are no longer on the 6502 stack. This
+        ** will also remove frames left over by code that manipulates the
+        ** stack directly.
+        */
+        while (Prof->Depth > 0 && Prof->Stack[Prof->Depth-1].SP <= Regs.SP) {
+            const CallFrame* F = Prof->Stack + --Prof->Depth;
+            Prof->CallCycles[F->Site] += Peripherals.Counter.ClockCycles - F->Start;
+        }
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                Evaluation                                 */
+/*****************************************************************************/
+
+
+
+static ProfileFunc* NewFunc (unsigned Addr, const char* Name)
+/* Create a new function entry */
+{
+    ProfileFunc* F = xmalloc (sizeof (ProfileFunc));
+    memset (F, 0, sizeof (ProfileFunc));
+    F->Addr = Addr;
+    F->Name = Name;
+    return F;
+}
+
+
+
+static void MarkSymbol (unsigned char** Marks, unsigned* Count, unsigned Id)
+/* Mark a symbol id in a dynamically grown array */
+{
+    if (Id == CC65_INV_ID) {
+        return;
+    }
+    if (Id >= *Count) {
+        unsigned NewCount = (Id + 1) * 2;
+        *Marks = xrealloc (*Marks, NewCount);
+        memset (*Marks + *Count, 0, NewCount - *Count);
+        *Count = NewCount;
+    }
+    (*Marks)[Id] = 1;
+}
+
+
+
+static void AddDbgFuncs (Collection* Funcs, const uint8_t* IsTarget)
+/* Add function entry points from the debug info. A label is considered to
+** be a function if it names a .proc scope, if it is exported, or if it was
+** the target of a JSR.
+*/
+{
+    unsigned I, J;
+    unsigned char* Marks = 0;
+    unsigned Count = 0;
+    const cc65_scopeinfo* Scopes;
+    const cc65_symbolinfo* Syms;
+
+    /* Mark scope labels and exports */
+    Scopes = cc65_get_scopelist (DbgInfo);
+    if (Scopes) {
+        for (I = 0; I < Scopes->count; ++I) {
+            const cc65_scopedata* Scope = Scopes->data + I;
+            if (Scope->scope_type == CC65_SCOPE_SCOPE) {
+                MarkSymbol (&Marks, &Count, Scope->symbol_id);
+            }
+            Syms = cc65_symbol_byscope (DbgInfo, Scope->scope_id);
+            if (Syms == 0) {
+                continue;
+            }
+            for (J = 0; J < Syms->count; ++J) {
+                if (Syms->data[J].symbol_type == CC65_SYM_IMPORT) {
+                    MarkSymbol (&Marks, &Count, Syms->data[J].export_id);
+                }
+            }
+            cc65_free_symbolinfo (DbgInfo, Syms);
+        }
+        cc65_free_scopeinfo (DbgInfo, Scopes);
+    }
+
+    /* Add the marked labels and those at call targets */
+    Syms = cc65_symbol_inrange (DbgInfo, 0, PARAVIRT_BASE - 1);
+    if (Syms) {
+        for (I = 0; I < Syms->count; ++I) {
+            const cc65_symboldata* S = Syms->data + I;
+            if (S->symbol_type != CC65_SYM_LABEL || S->parent_id != CC65_INV_ID) {
+                continue;
+            }
+            if ((S->symbol_id < Count && Marks[S->symbol_id]) ||
+                IsTarget[S->symbol_value & 0xFFFF]) {
+                CollAppend (Funcs, NewFunc (S->symbol_value, S->symbol_name));
+            }
+        }
+        cc65_free_symbolinfo (DbgInfo, Syms);
+    }
+
+    xfree (Marks);
+}
+
+
+
+static void AddCallTargets (Collection* Funcs, const uint8_t* IsTarget)
+/* Add all call targets as function entry points */
+{
+    unsigned Addr;
+    for (Addr = 0; Addr < PARAVIRT_BASE; ++Addr) {
+        if (IsTarget[Addr]) {
+            CollAppend (Funcs, NewFunc (Addr, 0));
+        }
+    }
+}
+
+
+
+static int CmpFuncAddr (void* Data attribute ((unused)),
+                        const void* A, const void* B)
+/* Compare functions by address, then by name */
+{
+    const ProfileFunc* F1 = A;
+    const ProfileFunc* F2 = B;
+    if (F1->Addr != F2->Addr) {
+        return F1->Addr < F2->Addr ? -1 : 1;
+    }
+    if (F1->Name == 0 || F2->Name == 0) {
+        return (F1->Name == 0) - (F2->Name == 0);
+    }
+    return strcmp (F1->Name, F2->Name);
+}
+
+
+
+static int CmpFuncCycles (void* Data attribute ((unused)),
+                          const void* A, const void* B)
+/* Compare functions by cycles spent, descending */
+{
+    const ProfileFunc* F1 = A;
+    const ProfileFunc* F2 = B;
+    if (F1->Cycles != F2->Cycles) {
+        return F1->Cycles > F2->Cycles ? -1 : 1;
+    }
+    return (F1->Addr > F2->Addr) - (F1->Addr < F2->Addr);
+}
+
+
+
+static int CmpEdgeCycles (void* Data attribute ((unused)),
+                          const void* A, const void* B)
+/* Compare call graph edges by inclusive cycles, descending */
+{
+    const ProfileEdge* E1 = A;
+    const ProfileEdge* E2 = B;
+    if (E1->CallCycles != E2->CallCycles) {
+        return E1->CallCycles > E2->CallCycles ? -1 : 1;
+    }
+    if (E1->Caller->Addr != E2->Caller->Addr) {
+        return E1->Caller->Addr < E2->Caller->Addr ? -1 : 1;
+    }
+    return (E1->Target > E2->Target) - (E1->Target < E2->Target);
+}
+
+
+
+static int CmpLine (const void* A, const void* B)
+/* Compare lines by source and line number */
+{
+    const ProfileLine* L1 = A;
+    const ProfileLine* L2 = B;
+    if (L1->SourceId != L2->SourceId) {
+        return L1->SourceId < L2->SourceId ? -1 : 1;
+    }
+    return (L1->Line > L2->Line) - (L1->Line < L2->Line);
+}
+
+
+
+static int CmpLineCycles (const void* A, const void* B)
+/* Compare lines by cycles, descending */
+{
+    const ProfileLine* L1 = A;
+    const ProfileLine* L2 = B;
+    if (L1->Cycles != L2->Cycles) {
+        return L1->Cycles > L2->Cycles ? -1 : 1;
+    }
+    return CmpLine (A, B);
+}
+
+
+
+static const char* FuncName (const ProfileFunc* F, char* Buf)
+/* Return a printable name for a function. Buf must have room for at least
+** six characters.
+*/
+{
+    if (F->Name) {
+        return F->Name;
+    }
+    sprintf (Buf, "$%04X", F->Addr);
+    return Buf;
+}
+
+
+
+static double Percent (uint64_t Cycles)
+/* Return Cycles as percentage of the total */
+{
+    return TotalCycles? 100.0 * (double) Cycles / (double) TotalCycles : 0.0;
+}
+
+
+
+static void WriteFuncs (FILE* F, Collection* Funcs, ProfileFunc** AddrToFunc)
+/* Aggregate the data per function and write the flat profile */
+{
+    unsigned I;
+    unsigned Addr;
+    char     Buf[16];
+
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        ProfileFunc* Func = AddrToFunc[Addr];
+        if (Func) {
+            Func->Cycles += Prof->Cycles[Addr];
+            Func->Insns  += Prof->Insns[Addr];
+        }
+        if (Prof->Calls[Addr] && Prof->CallTarget[Addr] < PARAVIRT_BASE) {
+            Func = AddrToFunc[Prof->CallTarget[Addr]];
+            if (Func) {
+                Func->Calls      += Prof->Calls[Addr];
+                Func->CallCycles += Prof->CallCycles[Addr];
+            }
+        }
+    }
+
+    CollSort (Funcs, CmpFuncCycles, 0);
+
+    fprintf (F,
+             "Flat profile:\n\n"
+             "          Cycles       %%          Insns       Calls"
+             "       Inclusive  Function\n");
+    for (I = 0; I < CollCount (Funcs); ++I) {
+        const ProfileFunc* Func = CollConstAt (Funcs, I);
+        if (Func->Insns == 0 && Func->Calls == 0) {
+            continue;
+        }
+        fprintf (F, "%16" PRIu64 "  %6.2f  %13" PRIu64 "  %10" PRIu64 "  %14" PRIu64 "  %s\n",
+                 Func->Cycles, Percent (Func->Cycles), Func->Insns,
+                 Func->Calls, Func->CallCycles, FuncName (Func, Buf));
+    }
+}
+
+
+
+static void WriteCallGraph (FILE* F, ProfileFunc** AddrToFunc)
+/* Aggregate the JSR sites per caller/callee pair and write the call graph */
+{
+    Collection Edges = STATIC_COLLECTION_INITIALIZER;
+    unsigned   Addr;
+    unsigned   I;
+    char       Buf1[16];
+    char       Buf2[16];
+
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+
+        ProfileFunc* Caller;
+        ProfileFunc* Callee;
+        unsigned     Target;
+        ProfileEdge* E = 0;
+
+        if (Prof->Calls[Addr] == 0 || (Caller = AddrToFunc[Addr]) == 0) {
+            continue;
+        }
+        Target = Prof->CallTarget[Addr];
+        Callee = Target < PARAVIRT_BASE? AddrToFunc[Target] : 0;
+
+        /* Search for an existing edge */
+        for (I = 0; I < CollCount (&Edges); ++I) {
+            ProfileEdge* X = CollAtUnchecked (&Edges, I);
+            if (X->Caller == Caller && X->Callee == Callee &&
+                (Callee != 0 || X->Target == Target)) {
+                E = X;
+                break;
+            }
+        }
+        if (E == 0) {
+            E = xmalloc (sizeof (ProfileEdge));
+            E->Caller     = Caller;
+            E->Callee     = Callee;
+            E->Target     = Callee? Callee->Addr : Target;
+            E->Calls      = 0;
+            E->CallCycles = 0;
+            CollAppend (&Edges, E);
+        }
+        E->Calls      += Prof->Calls[Addr];
+        E->CallCycles += Prof->CallCycles[Addr];
+    }
+
+    CollSort (&Edges, CmpEdgeCycles, 0);
+
+    fprintf (F,
+             "\nCall graph:\n\n"
+             "       Calls       Inclusive  Caller -> Callee\n");
+    for (I = 0; I < CollCount (&Edges); ++I) {
+        const ProfileEdge* E = CollConstAt (&Edges, I);
+        const char* CalleeName;
+        if (E->Callee) {
+            CalleeName = FuncName (E->Callee, Buf2);
+        } else {
+            sprintf (Buf2, "$%04X", E->Target);
+            CalleeName = Buf2;
+        }
+        fprintf (F, "%12" PRIu64 "  %14" PRIu64 "  %s -> %s\n",
+                 E->Calls, E->CallCycles, FuncName (E->Caller, Buf1),
+                 CalleeName);
+        xfree (CollAtUnchecked (&Edges, I));
+    }
+    DoneCollection (&Edges);
+}
+
+
+
+static int GetLine (unsigned Addr, unsigned* SourceId, unsigned* Line)
+/* Find the source line for an address. C source lines are preferred over
+** assembler lines. Return false if there's no line info.
+*/
+{
+    unsigned I, J;
+    int Found = 0;
+    const cc65_spaninfo* Spans = cc65_span_byaddr (DbgInfo, Addr);
+    if (Spans == 0) {
+        return 0;
+    }
+    for (I = 0; I < Spans->count; ++I) {
+        const cc65_lineinfo* Lines = cc65_line_byspan (DbgInfo, Spans->data[I].span_id);
+        if (Lines == 0) {
+            continue;
+        }
+        for (J = 0; J < Lines->count; ++J) {
+            const cc65_linedata* L = Lines->data + J;
+            if (L->line_type == CC65_LINE_EXT || (!Found && L->line_type == CC65_LINE_ASM)) {
+                *SourceId = L->source_id;
+                *Line     = L->source_line;
+                Found = 1 + (L->line_type == CC65_LINE_EXT);
+            }
+        }
+        cc65_free_lineinfo (DbgInfo, Lines);
+        if (Found > 1) {
+            break;
+        }
+    }
+    cc65_free_spaninfo (DbgInfo, Spans);
+    return Found;
+}
+
+
+
+static void WriteLines (FILE* F)
+/* Aggregate the data per source line and write the line profile */
+{
+    ProfileLine* Lines = xmalloc (0x10000 * sizeof (ProfileLine));
+    unsigned     Count = 0;
+    unsigned     Addr;
+    unsigned     I;
+
+    /* Collect the lines for all executed addresses */
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        ProfileLine* L;
+        if (Prof->Insns[Addr] == 0) {
+            continue;
+        }
+        L = Lines + Count;
+        if (GetLine (Addr, &L->SourceId, &L->Line)) {
+            L->Cycles = Prof->Cycles[Addr];
+            L->Insns  = Prof->Insns[Addr];
+            ++Count;
+        }
+    }
+
+    /* Merge entries for the same line */
+    qsort (Lines, Count, sizeof (ProfileLine), CmpLine);
+    for (I = 1, Addr = 0; I < Count; ++I) {
+        if (CmpLine (Lines + Addr, Lines + I) == 0) {
+            Lines[Addr].Cycles += Lines[I].Cycles;
+            Lines[Addr].Insns  += Lines[I].Insns;
+        } else {
+            Lines[++Addr] = Lines[I];
+        }
+    }
+    if (Count > 0) {
+        Count = Addr + 1;
+    }
+    qsort (Lines, Count, sizeof (ProfileLine), CmpLineCycles);
+
+    fprintf (F,
+             "\nLine profile:\n\n"
+             "          Cycles       %%          Insns  Source:Line\n");
+    for (I = 0; I < Count; ++I) {
+        const cc65_sourceinfo* S = cc65_source_byid (DbgInfo, Lines[I].SourceId);
+        fprintf (F, "%16" PRIu64 "  %6.2f  %13" PRIu64 "  %s:%u\n",
+                 Lines[I].Cycles, Percent (Lines[I].Cycles), Lines[I].Insns,
+                 S? S->data[0].source_name : "?", Lines[I].Line);
+        cc65_free_sourceinfo (DbgInfo, S);
+    }
+
+    xfree (Lines);
+}
+
+
+
+void ProfileWrite (void)
+/* Write the profile to the output file */
+{
+    Collection    Funcs = STATIC_COLLECTION_INITIALIZER;
+    ProfileFunc** AddrToFunc;
+    uint8_t*      IsTarget;
+    unsigned      Addr;
+    unsigned      I;
+    FILE*         F;
+
+    if (!ProfileEnabled) {
+        return;
+    }
+
+    /* Pop remaining frames, so the inclusive cycles of main and friends are
+    ** accounted for.
+    */
+    while (Prof->Depth > 0) {
+        const CallFrame* Frame = Prof->Stack + --Prof->Depth;
+        Prof->CallCycles[Frame->Site] += Peripherals.Counter.ClockCycles - Frame->Start;
+    }
+
+    /* Determine the function entry points. The reset vector counts as call
+    ** target.
+    */
+    IsTarget = xmalloc (0x10000);
+    memset (IsTarget, 0, 0x10000);
+    IsTarget[MemReadWord (0xFFFC)] = 1;
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        if (Prof->Calls[Addr]) {
+            IsTarget[Prof->CallTarget[Addr]] = 1;
+        }
+    }
+    if (DbgInfo) {
+        AddDbgFuncs (&Funcs, IsTarget);
+    }
+    if (CollCount (&Funcs) == 0) {
+        AddCallTargets (&Funcs, IsTarget);
+    }
+    xfree (IsTarget);
+    CollSort (&Funcs, CmpFuncAddr, 0);
+
+    /* Map each address to the function it belongs to. If there are several
+    ** labels for one address, the first one wins.
+    */
+    AddrToFunc = xmalloc (0x10000 * sizeof (ProfileFunc*));
+    memset (AddrToFunc, 0, 0x10000 * sizeof (ProfileFunc*));
+    for (I = 0; I < CollCount (&Funcs); ++I) {
+        ProfileFunc* Func = CollAtUnchecked (&Funcs, I);
+        unsigned     End  = PARAVIRT_BASE;
+        for (++I; I < CollCount (&Funcs); ++I) {
+            const ProfileFunc* Next = CollConstAt (&Funcs, I);
+            if (Next->Addr != Func->Addr) {
+                End = Next->Addr;
+                break;
+            }
+        }
+        --I;
+        for (Addr = Func->Addr; Addr < End; ++Addr) {
+            AddrToFunc[Addr] = Func;
+        }
+    }
+
+    /* Get the total */
+    TotalCycles = 0;
+    for (Addr = 0; Addr < 0x10000; ++Addr) {
+        TotalCycles += Prof->Cycles[Addr];
+    }
+
+    F = fopen (OutputName, "w");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", OutputName, strerror (errno));
+    }
+
+    fprintf (F, "Total: %" PRIu64 " cycles\n\n", TotalCycles);
+    WriteFuncs (F, &Funcs, AddrToFunc);
+    WriteCallGraph (F, AddrToFunc);
+    if (DbgInfo) {
+        WriteLines (F);
+    }
+
+    if (fclose (F) != 0) {
+        Error ("Error writing '%s': %s", OutputName, strerror (errno));
+    }
+
+    for (I = 0; I < CollCount (&Funcs); ++I) {
+        xfree (CollAtUnchecked (&Funcs, I));
+    }
+    DoneCollection (&Funcs);
+    xfree (AddrToFunc);
+    if (DbgInfo) {
+        cc65_free_dbginfo (DbgInfo);
+        DbgInfo = 0;
+    }
+    ProfileEnabled = false;
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 profile.h                                 */
+/*                                                                           */
+/*                   Cycle profiler for the sim65 6502 simulator             */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* True if the profiler collects data */
+extern bool ProfileEnabled;
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void ProfileInit (const char* OutputName, const char* DbgName);
+/* Enable the profiler. The profile is written to OutputName when the
+** simulation ends. If DbgName is not NULL, it is the name of a debug info
+** file written by ld65, which is used to attribute cycles to functions and
+** source lines. Without it, functions are inferred from JSR targets.
+*/
+
+void ProfileInsn (uint16_t PC, uint8_t OPC, unsigned Cycles);
+/* Account for an instruction that was just executed. PC and OPC are the
+** address and opcode of the instruction, Cycles the number of clock cycles
+** it took.
+*/
+
+void ProfileWrite (void);
+/* Write the profile to the output file */
+
+
+
+/* End of profile.h */
+
+#endif
@@ -0,0 +1,367 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 snapshot.c                                */
+/*                                                                           */
+/*                  Save and restore the sim65 machine state                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+/* common */
+#include "xmalloc.h"
+
+/* sim65 */
+#include "6502.h"
+#include "error.h"
+#include "memory.h"
+#include "paravirt.h"
+#include "peripherals.h"
+#include "snapshot.h"
+#include "trace.h"
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Snapshot files start with this signature, followed by a version byte */
+static const unsigned char SnapshotSignature[] = {
+    's', 'i', 'm', '6', '5', 'S'
+};
+#define SNAPSHOT_VERSION        2
+
+/* An open file of the simulated program */
+typedef struct SnapshotFile SnapshotFile;
+struct SnapshotFile {
+    int         FD;
+    unsigned    Flags;
+    long        Offset;
+    char*       Path;
+};
+
+/* File and name of the snapshot file being processed */
+static FILE*       F;
+static const char* FileName;
+
+
+
+/*****************************************************************************/
+/*                              Helper functions                             */
+/*****************************************************************************/
+
+
+
+static void WriteData (const void* Data, size_t Size)
+/* Write data to the snapshot file */
+{
+    if (fwrite (Data, 1, Size, F) != Size) {
+        Error ("Error writing '%s': %s", FileName, strerror (errno));
+    }
+}
+
+
+
+static void Write8 (uint8_t Val)
+/* Write a byte to the snapshot file */
+{
+    WriteData (&Val, 1);
+}
+
+
+
+static void Write64 (uint64_t Val)
+/* Write a 64 bit value in little endian byte order */
+{
+    unsigned char Buf[8];
+    unsigned I;
+    for (I = 0; I < 8; ++I) {
+        Buf[I] = (unsigned char) (Val >> (8 * I));
+    }
+    WriteData (Buf, sizeof (Buf));
+}
+
+
+
+static void WriteStr (const char* S)
+/* Write a string with its length */
+{
+    size_t Len = strlen (S);
+    Write64 (Len);
+    WriteData (S, Len);
+}
+
+
+
+static void ReadData (void* Data, size_t Size)
+/* Read data from the snapshot file */
+{
+    if (fread (Data, 1, Size, F) != Size) {
+        if (ferror (F)) {
+            Error ("Error reading from '%s': %s", FileName, strerror (errno));
+        } else {
+            Error ("'%s': Unexpected end of file", FileName);
+        }
+    }
+}
+
+
+
+static uint8_t Read8 (void)
+/* Read a byte from the snapshot file */
+{
+    uint8_t Val;
+    ReadData (&Val, 1);
+    return Val;
+}
+
+
+
+static uint64_t Read64 (void)
+/* Read a 64 bit value in little endian byte order */
+{
+    unsigned char Buf[8];
+    uint64_t Val = 0;
+    unsigned I;
+    ReadData (Buf, sizeof (Buf));
+    for (I = 0; I < 8; ++I) {
+        Val |= (uint64_t) Buf[I] << (8 * I);
+    }
+    return Val;
+}
+
+
+
+static char* ReadStr (void)
+/* Read a string written by WriteStr. The result must be freed. */
+{
+    uint64_t Len = Read64 ();
+    char*    S;
+    if (Len >= PV_PATH_SIZE) {
+        Error ("'%s': Invalid string length", FileName);
+    }
+    S = xmalloc (Len + 1);
+    ReadData (S, Len);
+    S[Len] = '\0';
+    return S;
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void SnapshotSave (const char* Name, uint8_t SPAddr)
+/* Save the complete machine state to a file. This includes the memory, the
+** CPU registers and pending interrupts, the peripherals, the trace mode and
+** the files opened by the simulated program. SPAddr is the zero page
+** address of the cc65 stack pointer.
+*/
+{
+    const CounterPeripheral* C = &Peripherals.Counter;
+    const TimerPeripheral*   T = &Peripherals.Timer;
+    unsigned I;
+
+    /* Only the 6502 registers and the 64K address space are saved */
+    if (CPU == CPU_65816) {
+        Error ("Snapshots are not supported for the 65816");
+    }
+
+    F = fopen (Name, "wb");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+    FileName = Name;
+
+    /* Header */
+    WriteData (SnapshotSignature, sizeof (SnapshotSignature));
+    Write8 (SNAPSHOT_VERSION);
+
+    /* CPU */
+    Write8 (CPU);
+    Write8 (Regs.AC);
+    Write8 (Regs.XR);
+    Write8 (Regs.YR);
+    Write8 (Regs.SR);
+    Write8 (Regs.SP);
+    Write8 (Regs.PC & 0xFF);
+    Write8 (Regs.PC >> 8);
+    Write8 (GetPendingInterrupts ());
+
+    /* Peripherals and simulator settings */
+    Write64 (C->ClockCycles);
+    Write64 (C->CpuInstructions);
+    Write64 (C->IrqEvents);
+    Write64 (C->NmiEvents);
+    Write64 (C->LatchedClockCycles);
+    Write64 (C->LatchedCpuInstructions);
+    Write64 (C->LatchedIrqEvents);
+    Write64 (C->LatchedNmiEvents);
+    Write64 (C->LatchedWallclockTime);
+    Write64 (C->LatchedWallclockTimeSplit);
+    Write8 (C->LatchedValueSelected);
+    Write64 (T->Period);
+    Write8 (T->Control);
+    Write8 (T->Status);
+    Write64 (T->Deadline);
+    Write8 (TraceMode);
+    Write8 (SPAddr);
+
+    /* Memory */
+    WriteData (Mem, sizeof (Mem));
+
+    /* Open files */
+    Write64 (ParaVirtFileCount ());
+    for (I = 0; I < ParaVirtFileCount (); ++I) {
+        int         FD;
+        unsigned    Flags;
+        long        Offset;
+        const char* Path = ParaVirtGetFile (I, &FD, &Flags, &Offset);
+        if (Offset < 0) {
+            Error ("Cannot get the position in '%s': %s", Path, strerror (errno));
+        }
+        Write64 (FD);
+        Write64 (Flags);
+        Write64 (Offset);
+        WriteStr (Path);
+    }
+
+    if (fclose (F) != 0) {
+        Error ("Error closing '%s': %s", Name, strerror (errno));
+    }
+    F = 0;
+}
+
+
+
+uint8_t SnapshotLoad (const char* Name)
+/* Restore the machine state from a file written by SnapshotSave. Must be
+** called after MemInit and PeripheralsInit. Returns the zero page address
+** of the cc65 stack pointer.
+*/
+{
+    CounterPeripheral* C = &Peripherals.Counter;
+    TimerPeripheral*   T = &Peripherals.Timer;
+    unsigned char      Sig[sizeof (SnapshotSignature)];
+    uint8_t            SPAddr;
+    uint8_t            CPUVal;
+    uint64_t           Count;
+    uint64_t           I;
+    SnapshotFile*      Files;
+
+    F = fopen (Name, "rb");
+    if (F == 0) {
+        Error ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+    FileName = Name;
+
+    /* Header */
+    ReadData (Sig, sizeof (Sig));
+    if (memcmp (Sig, SnapshotSignature, sizeof (Sig)) != 0) {
+        Error ("'%s': Invalid snapshot signature", Name);
+    }
+    if (Read8 () != SNAPSHOT_VERSION) {
+        Error ("'%s': Invalid snapshot version", Name);
+    }
+
+    /* CPU */
+    CPUVal = Read8 ();
+    if (CPUVal != CPU_6502 && CPUVal != CPU_65C02 && CPUVal != CPU_6502X) {
+        Error ("'%s': Invalid CPU type", Name);
+    }
+    CPU     = CPUVal;
+    Regs.AC = Read8 ();
+    Regs.XR = Read8 ();
+    Regs.YR = Read8 ();
+    Regs.SR = Read8 ();
+    Regs.SP = Read8 ();
+    Regs.PC = Read8 ();
+    Regs.PC |= Read8 () << 8;
+    SetPendingInterrupts (Read8 ());
+
+    /* Peripherals and simulator settings */
+    C->ClockCycles               = Read64 ();
+    C->CpuInstructions           = Read64 ();
+    C->IrqEvents                 = Read64 ();
+    C->NmiEvents                 = Read64 ();
+    C->LatchedClockCycles        = Read64 ();
+    C->LatchedCpuInstructions    = Read64 ();
+    C->LatchedIrqEvents          = Read64 ();
+    C->LatchedNmiEvents          = Read64 ();
+    C->LatchedWallclockTime      = Read64 ();
+    C->LatchedWallclockTimeSplit = Read64 ();
+    C->LatchedValueSelected      = Read8 ();
+    T->Period                    = (uint32_t) Read64 ();
+    T->Control                   = Read8 ();
+    T->Status                    = Read8 ();
+    T->Deadline                  = Read64 ();
+    TraceMode                    = Read8 ();
+    PeripheralsRestore ();
+    SPAddr                       = Read8 ();
+
+    /* Memory. Anything decoded before is stale now, and all pages must be
+    ** cleared by MemReset.
+    */
+    ReadData (Mem, sizeof (Mem));
+    InvalidateCodeCache ();
+    for (I = 0; I < 0x100; ++I) {
+        MemClearPageFlags ((uint8_t) I, MEM_PAGE_CLEAN);
+    }
+
+    /* Open files. Read the list completely before reopening them, since
+    ** the snapshot file itself may use one of the file descriptors.
+    */
+    Count = Read64 ();
+    if (Count > 0xFFFF) {
+        Error ("'%s': Invalid number of open files", Name);
+    }
+    Files = xmalloc (Count * sizeof (SnapshotFile) + 1);
+    for (I = 0; I < Count; ++I) {
+        Files[I].FD     = (int) Read64 ();
+        Files[I].Flags  = (unsigned) Read64 ();
+        Files[I].Offset = (long) Read64 ();
+        Files[I].Path   = ReadStr ();
+    }
+
+    fclose (F);
+    F = 0;
+
+    for (I = 0; I < Count; ++I) {
+        ParaVirtReopenFile (Files[I].FD, Files[I].Flags, Files[I].Path, Files[I].Offset);
+        xfree (Files[I].Path);
+    }
+    xfree (Files);
+
+    return SPAddr;
+}
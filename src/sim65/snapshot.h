@@ -0,0 +1,63 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 snapshot.h                                */
+/*                                                                           */
+/*                  Save and restore the sim65 machine state                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+
+#include <stdint.h>
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+void SnapshotSave (const char* Name, uint8_t SPAddr);
+/* Save the complete machine state to a file. This includes the memory, the
+** CPU registers and pending interrupts, the peripherals, the trace mode and
+** the files opened by the simulated program. SPAddr is the zero page
+** address of the cc65 stack pointer.
+*/
+
+uint8_t SnapshotLoad (const char* Name);
+/* Restore the machine state from a file written by SnapshotSave. Must be
+** called after MemInit and PeripheralsInit. Returns the zero page address
+** of the cc65 stack pointer.
+*/
+
+
+
+/* End of snapshot.h */
+
+#endif
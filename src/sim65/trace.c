@@ -31,18 +31,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
 #include <inttypes.h>
 
 #include "6502.h"
+#include "error.h"
 #include "memory.h"
 #include "trace.h"
 #include "peripherals.h"
 
 /* Current Trace Mode. Tracing is off by default, and needs to be explicitly enabled. */
-uint8_t TraceMode = TRACE_DISABLED;
+THREAD_LOCAL uint8_t TraceMode = TRACE_DISABLED;
 
 /* CC65 stack pointer */
-uint8_t StackPointerZPageAddress;
+static THREAD_LOCAL uint8_t StackPointerZPageAddress;
 
 /* 6502, 65C02 addressing modes. */
 typedef enum {
@@ -898,10 +901,56 @@ static InstructionInfo II_6502X[256] = {
 
 static InstructionInfo * II[3] = { II_6502, II_65C02, II_6502X };
 
-static unsigned GetInstructionLength (uint8_t opcode)
-/* Get the number of bytes in the full instruction. Depends on the addressing mode. */
+/* Everything needed to render one trace line. The counters and registers
+ * are the values before the instruction or interrupt is executed.
+ */
+typedef struct {
+    uint8_t     Type;           /* TRACE_REC_xxx */
+    uint8_t     Mode;           /* Trace mode at the time of the record */
+    uint8_t     CPU;            /* CPU type */
+    uint8_t     Length;         /* Number of valid instruction bytes */
+    uint16_t    PC;             /* Program counter */
+    uint8_t     Bytes[3];       /* Instruction bytes */
+    uint8_t     AC, XR, YR;     /* Registers */
+    uint8_t     SP, SR;
+    uint16_t    CC65SP;         /* CC65 stack pointer */
+    uint64_t    Insns;          /* Instruction counter */
+    uint64_t    Cycles;         /* Clock cycle counter */
+} TraceRecord;
+
+/* Record types. In the binary trace file, the low two bits of the first
+ * byte of each record hold the type.
+ */
+#define TRACE_REC_INSN      0
+#define TRACE_REC_NMI       1
+#define TRACE_REC_IRQ       2
+#define TRACE_REC_SYNC      3
+
+/* Binary trace files start with this header. The last two bytes are the
+ * format version and the record size.
+ */
+static const uint8_t TraceFileHeader[8] = {
+    's', 'i', 'm', '6', '5', 'T', 1, 16
+};
+#define TRACE_RECORD_SIZE   16
+
+/* Output file for binary traces, NULL if the trace is printed */
+static FILE * TraceFile = NULL;
+static const char * TraceFileName;
+
+/* Output buffer for the binary trace */
+static uint8_t TraceBuf[0x10000];
+static unsigned TraceBufPos;
+
+/* Counters of the last record written to the binary trace */
+static bool TraceSynced;
+static uint64_t LastInsns;
+static uint64_t LastCycles;
+
+static unsigned InstructionLength (uint8_t cpu, uint8_t opcode)
+/* Get the number of bytes in the full instruction for the given CPU. */
 {
-    switch (II[CPU][opcode].adrmode) {
+    switch (II[cpu][opcode].adrmode) {
         case ILLEGAL:
         case IMPLIED:
         case ACCUMULATOR:
@@ -930,18 +979,23 @@ static unsigned GetInstructionLength (uint8_t opcode)
 
 
 
-static char * PrintAssemblyInstruction (char * ptr)
-/* Print assembly instruction: mnemonic and addres-mode specific operand(s). */
+unsigned GetInstructionLength (uint8_t opcode)
+/* Get the number of bytes in the full instruction. Depends on the addressing mode. */
 {
-    uint8_t opcode;
+    return InstructionLength (CPU, opcode);
+}
 
-    /* Print the instruction starting at the current program counter. */
 
-    opcode = MemReadByte (Regs.PC);
 
-    ptr += sprintf (ptr, "%-4s ", II[CPU][opcode].mnemonic);
+static char * PrintAssemblyInstruction (char * ptr, const TraceRecord * rec)
+/* Print assembly instruction: mnemonic and addres-mode specific operand(s). */
+{
+    uint8_t opcode = rec->Bytes[0];
+    uint16_t word = rec->Bytes[1] | (rec->Bytes[2] << 8);
 
-    switch (II[CPU][opcode].adrmode) {
+    ptr += sprintf (ptr, "%-4s ", II[rec->CPU][opcode].mnemonic);
+
+    switch (II[rec->CPU][opcode].adrmode) {
         case IMPLIED:
         case ILLEGAL:
             break;
@@ -949,46 +1003,46 @@ static char * PrintAssemblyInstruction (char * ptr)
             ptr += sprintf (ptr, "A");
             break;
         case IMMEDIATE:
-            ptr += sprintf (ptr, "#$%02X", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "#$%02X", rec->Bytes[1]);
             break;
         case REL:
-            ptr += sprintf (ptr, "$%04X", Regs.PC + 2 + (int8_t)MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%04X", rec->PC + 2 + (int8_t)rec->Bytes[1]);
             break;
         case ZP:
-            ptr += sprintf (ptr, "$%02X", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%02X", rec->Bytes[1]);
             break;
         case ZP_X:
-            ptr += sprintf (ptr, "$%02X,X", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%02X,X", rec->Bytes[1]);
             break;
         case ZP_Y:
-            ptr += sprintf (ptr, "$%02X,Y", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%02X,Y", rec->Bytes[1]);
             break;
         case ZP_IND:
-            ptr += sprintf (ptr, "($%02X)", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "($%02X)", rec->Bytes[1]);
             break;
         case ZP_X_IND:
-            ptr += sprintf (ptr, "($%02X,X)", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "($%02X,X)", rec->Bytes[1]);
             break;
         case ZP_IND_Y:
-            ptr += sprintf (ptr, "($%02X),Y", MemReadByte (Regs.PC + 1));
+            ptr += sprintf (ptr, "($%02X),Y", rec->Bytes[1]);
             break;
         case ZP_REL:
-            ptr += sprintf (ptr, "$%02X,$%04X", MemReadByte (Regs.PC + 1), Regs.PC + 3 + (int8_t)MemReadByte (Regs.PC + 2));
+            ptr += sprintf (ptr, "$%02X,$%04X", rec->Bytes[1], rec->PC + 3 + (int8_t)rec->Bytes[2]);
             break;
         case ABS:
-            ptr += sprintf (ptr, "$%04X", MemReadWord (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%04X", word);
             break;
         case ABS_IND:
-            ptr += sprintf (ptr, "($%04X)", MemReadWord (Regs.PC + 1));
+            ptr += sprintf (ptr, "($%04X)", word);
             break;
         case ABS_X:
-            ptr += sprintf (ptr, "$%04X,X", MemReadWord (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%04X,X", word);
             break;
         case ABS_X_IND:
-            ptr += sprintf (ptr, "($%04X,X)", MemReadWord (Regs.PC + 1));
+            ptr += sprintf (ptr, "($%04X,X)", word);
             break;
         case ABS_Y:
-            ptr += sprintf (ptr, "$%04X,Y", MemReadWord (Regs.PC + 1));
+            ptr += sprintf (ptr, "$%04X,Y", word);
             break;
     }
 
@@ -997,75 +1051,84 @@ static char * PrintAssemblyInstruction (char * ptr)
 
 
 
-static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
+void DisassembleInstruction (char * buf, uint16_t pc)
+/* Write the assembly text of the instruction at pc to buf, which must have
+ * room for at least 32 characters. The 65816 is disassembled as a 65C02.
+ */
+{
+    TraceRecord rec;
+
+    rec.CPU      = CPU == CPU_65816 ? CPU_65C02 : CPU;
+    rec.PC       = pc;
+    rec.Bytes[0] = MemReadByte (pc);
+    rec.Bytes[1] = MemReadByte ((uint16_t) (pc + 1));
+    rec.Bytes[2] = MemReadByte ((uint16_t) (pc + 2));
+    PrintAssemblyInstruction (buf, &rec);
+}
+
+
+
+static void PrintTraceRecord (const TraceRecord * rec)
+/* Print the trace line for a record to stdout. */
 {
     char traceline[200];
     char * traceline_ptr = traceline;
-    uint8_t opcode;
     unsigned k, num_bytes;
 
-    if (TraceMode & TRACE_FIELD_INSTR_COUNTER) {
+    if (rec->Mode & TRACE_FIELD_INSTR_COUNTER) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
             traceline_ptr += sprintf (traceline_ptr, "  ");
         }
 
-        traceline_ptr += sprintf (traceline_ptr, "%12" PRIu64, Peripherals.Counter.CpuInstructions);
+        traceline_ptr += sprintf (traceline_ptr, "%12" PRIu64, rec->Insns);
     }
 
-    if (TraceMode & TRACE_FIELD_CLOCK_COUNTER) {
+    if (rec->Mode & TRACE_FIELD_CLOCK_COUNTER) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
             traceline_ptr += sprintf (traceline_ptr, "  ");
         }
 
-        traceline_ptr += sprintf (traceline_ptr, "%12" PRIu64, Peripherals.Counter.ClockCycles);
+        traceline_ptr += sprintf (traceline_ptr, "%12" PRIu64, rec->Cycles);
     }
 
-    if (TraceMode & TRACE_FIELD_PC) {
+    if (rec->Mode & TRACE_FIELD_PC) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
             traceline_ptr += sprintf (traceline_ptr, "  ");
         }
 
-        traceline_ptr += sprintf (traceline_ptr, "%04X", Regs.PC);
+        traceline_ptr += sprintf (traceline_ptr, "%04X", rec->PC);
     }
 
-    if (TraceMode & TRACE_FIELD_INSTR_BYTES) {
+    if (rec->Mode & TRACE_FIELD_INSTR_BYTES) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
             traceline_ptr += sprintf (traceline_ptr, "  ");
         }
 
-        if (InterruptType == NULL)
-        {
-            /* Get the opcode */
-            opcode = MemReadByte (Regs.PC);
-
-            /* How many bytes are in the full instruction? 1, 2 or 3. */
-            num_bytes = GetInstructionLength (opcode);
-        } else {
-            num_bytes = 0; /* Consider interrupts as instructions that are inserted into the instruction stream. */
-        }
-
-        /* Print 0 to 3 bytes for the interrupt/instruction. */
+        /* Print 0 to 3 bytes for the interrupt/instruction. Interrupts
+         * have no bytes, they are considered as instructions that are
+         * inserted into the instruction stream.
+         */
         for (k = 0; k < 3; ++k) {
             if (k != 0) {
                 *traceline_ptr++ = ' ';
             }
-            if (k < num_bytes) {
-                traceline_ptr += sprintf (traceline_ptr, "%02X", MemReadByte (Regs.PC + k));
+            if (k < rec->Length) {
+                traceline_ptr += sprintf (traceline_ptr, "%02X", rec->Bytes[k]);
             } else {
                 traceline_ptr += sprintf (traceline_ptr, "  ");
             }
         }
     }
 
-    if (TraceMode & TRACE_FIELD_INSTR_ASSEMBLY) {
+    if (rec->Mode & TRACE_FIELD_INSTR_ASSEMBLY) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
@@ -1074,11 +1137,11 @@ static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
 
         char * save_ptr = traceline_ptr;
 
-        if (InterruptType == NULL) {
-            traceline_ptr = PrintAssemblyInstruction (traceline_ptr);
+        if (rec->Type == TRACE_REC_INSN) {
+            traceline_ptr = PrintAssemblyInstruction (traceline_ptr, rec);
         } else {
             /* Print interrupt message. */
-            traceline_ptr += sprintf (traceline_ptr, "*** %s ***", InterruptType);
+            traceline_ptr += sprintf (traceline_ptr, "*** %s ***", rec->Type == TRACE_REC_NMI ? "NMI" : "IRQ");
         }
 
         /* Fill out the field to 16 characters */
@@ -1088,7 +1151,7 @@ static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
         }
     }
 
-    if (TraceMode & TRACE_FIELD_CPU_REGISTERS) {
+    if (rec->Mode & TRACE_FIELD_CPU_REGISTERS) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
@@ -1097,20 +1160,20 @@ static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
 
         traceline_ptr += sprintf (traceline_ptr,
             "A=%02X X=%02X Y=%02X S=%02X Flags=%c%c%c%c%c%c",
-            Regs.AC,
-            Regs.XR,
-            Regs.YR,
-            Regs.SP,
-            (Regs.SR & SF) ? 'N' : 'n',
-            (Regs.SR & OF) ? 'V' : 'v',
-            (Regs.SR & DF) ? 'D' : 'd',
-            (Regs.SR & IF) ? 'I' : 'i',
-            (Regs.SR & ZF) ? 'Z' : 'z',
-            (Regs.SR & CF) ? 'C' : 'c'
+            rec->AC,
+            rec->XR,
+            rec->YR,
+            rec->SP,
+            (rec->SR & SF) ? 'N' : 'n',
+            (rec->SR & OF) ? 'V' : 'v',
+            (rec->SR & DF) ? 'D' : 'd',
+            (rec->SR & IF) ? 'I' : 'i',
+            (rec->SR & ZF) ? 'Z' : 'z',
+            (rec->SR & CF) ? 'C' : 'c'
         );
     }
 
-    if (TraceMode & TRACE_FIELD_CC65_SP) {
+    if (rec->Mode & TRACE_FIELD_CC65_SP) {
 
         if (traceline_ptr != traceline) {
             /* Print field separator. */
@@ -1119,7 +1182,7 @@ static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
 
         traceline_ptr += sprintf (traceline_ptr,
             "  SP=%04X",
-            MemReadZPWord (StackPointerZPageAddress)
+            rec->CC65SP
         );
     }
 
@@ -1130,6 +1193,135 @@ static void PrintTraceInstructionOrInterrupt (const char * InterruptType)
 
 
 
+static void TraceFlush (void)
+/* Write the buffered part of the binary trace to the file. */
+{
+    if (TraceBufPos > 0) {
+        if (fwrite (TraceBuf, 1, TraceBufPos, TraceFile) != TraceBufPos) {
+            Error ("Error writing '%s': %s", TraceFileName, strerror (errno));
+        }
+        TraceBufPos = 0;
+    }
+}
+
+
+
+static void TraceClose (void)
+/* Flush and close the binary trace file. Called on exit, so errors must not
+ * terminate the program.
+ */
+{
+    if (TraceFile) {
+        if (fwrite (TraceBuf, 1, TraceBufPos, TraceFile) != TraceBufPos ||
+            fclose (TraceFile) != 0) {
+            Warning ("Error writing '%s': %s", TraceFileName, strerror (errno));
+        }
+        TraceFile = NULL;
+    }
+}
+
+
+
+static uint8_t * TraceAlloc (void)
+/* Return a pointer to space for one record in the output buffer. */
+{
+    uint8_t * ptr;
+    if (TraceBufPos + TRACE_RECORD_SIZE > sizeof (TraceBuf)) {
+        TraceFlush ();
+    }
+    ptr = TraceBuf + TraceBufPos;
+    TraceBufPos += TRACE_RECORD_SIZE;
+    return ptr;
+}
+
+
+
+static void WriteTraceRecord (const TraceRecord * rec)
+/* Add a record to the binary trace. The counters are stored as deltas to
+ * the previous record. If that is not possible, a sync record with the
+ * full counters is written first.
+ */
+{
+    uint8_t * ptr;
+    unsigned k;
+
+    if (!TraceSynced || rec->Insns - LastInsns > 1 || rec->Cycles - LastCycles > 0xFF) {
+        ptr = TraceAlloc ();
+        ptr[0] = TRACE_REC_SYNC;
+        for (k = 0; k < 7; ++k) {
+            ptr[1 + k] = (uint8_t) (rec->Insns >> (8 * k));
+        }
+        for (k = 0; k < 8; ++k) {
+            ptr[8 + k] = (uint8_t) (rec->Cycles >> (8 * k));
+        }
+        LastInsns = rec->Insns;
+        LastCycles = rec->Cycles;
+        TraceSynced = true;
+    }
+
+    ptr = TraceAlloc ();
+    ptr[0]  = rec->Type | (rec->CPU << 2) | ((uint8_t) (rec->Insns - LastInsns) << 4);
+    ptr[1]  = rec->Mode;
+    ptr[2]  = (uint8_t) (rec->Cycles - LastCycles);
+    ptr[3]  = (uint8_t) rec->PC;
+    ptr[4]  = (uint8_t) (rec->PC >> 8);
+    ptr[5]  = rec->Bytes[0];
+    ptr[6]  = rec->Bytes[1];
+    ptr[7]  = rec->Bytes[2];
+    ptr[8]  = rec->AC;
+    ptr[9]  = rec->XR;
+    ptr[10] = rec->YR;
+    ptr[11] = rec->SP;
+    ptr[12] = rec->SR;
+    ptr[13] = (uint8_t) rec->CC65SP;
+    ptr[14] = (uint8_t) (rec->CC65SP >> 8);
+    ptr[15] = 0;
+
+    LastInsns = rec->Insns;
+    LastCycles = rec->Cycles;
+}
+
+
+
+static void TraceInstructionOrInterrupt (uint8_t type)
+/* Trace the instruction or interrupt at the current program counter. */
+{
+    TraceRecord rec;
+    unsigned k;
+
+    /* The disassembler and the record format know the 6502 variants only */
+    if (CPU == CPU_65816) {
+        Error ("Tracing is not supported for the 65816");
+    }
+
+    rec.Type   = type;
+    rec.Mode   = TraceMode;
+    rec.CPU    = CPU;
+    rec.PC     = Regs.PC;
+    rec.AC     = Regs.AC;
+    rec.XR     = Regs.XR;
+    rec.YR     = Regs.YR;
+    rec.SP     = Regs.SP;
+    rec.SR     = Regs.SR;
+    rec.CC65SP = MemReadZPWord (StackPointerZPageAddress);
+    rec.Insns  = Peripherals.Counter.CpuInstructions;
+    rec.Cycles = Peripherals.Counter.ClockCycles;
+
+    /* Get the instruction bytes. Interrupts have none. */
+    rec.Length = type == TRACE_REC_INSN ? InstructionLength (CPU, MemReadByte (Regs.PC)) : 0;
+    for (k = 0; k < 3; ++k) {
+        rec.Bytes[k] = k < rec.Length ? MemReadByte (Regs.PC + k) : 0;
+    }
+
+    if (TraceFile) {
+        WriteTraceRecord (&rec);
+    } else {
+        PrintTraceRecord (&rec);
+    }
+}
+
+
+
 void TraceInit (uint8_t SPAddr)
 {
     StackPointerZPageAddress = SPAddr;
@@ -1137,21 +1329,111 @@ void TraceInit (uint8_t SPAddr)
 
 
 
+void TraceOpenFile (const char * Name)
+{
+    TraceFile = fopen (Name, "wb");
+    if (TraceFile == NULL) {
+        Error ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+    TraceFileName = Name;
+    if (fwrite (TraceFileHeader, 1, sizeof (TraceFileHeader), TraceFile) != sizeof (TraceFileHeader)) {
+        Error ("Error writing '%s': %s", Name, strerror (errno));
+    }
+
+    /* The simulator exits from many places, so make sure the buffered
+     * part is written in any case.
+     */
+    atexit (TraceClose);
+}
+
+
+
+void TraceDecodeFile (const char * Name)
+{
+    uint8_t header[sizeof (TraceFileHeader)];
+    size_t count, i;
+    unsigned k;
+    TraceRecord rec;
+    uint64_t insns = 0;
+    uint64_t cycles = 0;
+
+    FILE * f = fopen (Name, "rb");
+    if (f == NULL) {
+        Error ("Cannot open '%s': %s", Name, strerror (errno));
+    }
+    if (fread (header, 1, sizeof (header), f) != sizeof (header) ||
+        memcmp (header, TraceFileHeader, sizeof (header)) != 0) {
+        Error ("'%s': Not a sim65 binary trace file", Name);
+    }
+
+    while ((count = fread (TraceBuf, TRACE_RECORD_SIZE, sizeof (TraceBuf) / TRACE_RECORD_SIZE, f)) > 0) {
+
+        for (i = 0; i < count; ++i) {
+
+            const uint8_t * ptr = TraceBuf + i * TRACE_RECORD_SIZE;
+
+            if ((ptr[0] & 0x03) == TRACE_REC_SYNC) {
+                insns = 0;
+                cycles = 0;
+                for (k = 0; k < 7; ++k) {
+                    insns |= (uint64_t) ptr[1 + k] << (8 * k);
+                }
+                for (k = 0; k < 8; ++k) {
+                    cycles |= (uint64_t) ptr[8 + k] << (8 * k);
+                }
+                continue;
+            }
+
+            insns  += (ptr[0] >> 4) & 0x01;
+            cycles += ptr[2];
+
+            rec.Type     = ptr[0] & 0x03;
+            rec.CPU      = (ptr[0] >> 2) & 0x03;
+            rec.Mode     = ptr[1];
+            rec.PC       = ptr[3] | (ptr[4] << 8);
+            rec.Bytes[0] = ptr[5];
+            rec.Bytes[1] = ptr[6];
+            rec.Bytes[2] = ptr[7];
+            rec.AC       = ptr[8];
+            rec.XR       = ptr[9];
+            rec.YR       = ptr[10];
+            rec.SP       = ptr[11];
+            rec.SR       = ptr[12];
+            rec.CC65SP   = ptr[13] | (ptr[14] << 8);
+            rec.Insns    = insns;
+            rec.Cycles   = cycles;
+            if (rec.CPU > CPU_6502X) {
+                Error ("'%s': Invalid CPU type in trace record", Name);
+            }
+            rec.Length   = rec.Type == TRACE_REC_INSN ? InstructionLength (rec.CPU, rec.Bytes[0]) : 0;
+
+            PrintTraceRecord (&rec);
+        }
+    }
+
+    if (ferror (f)) {
+        Error ("Error reading from '%s': %s", Name, strerror (errno));
+    }
+    fclose (f);
+}
+
+
+
 void PrintTraceNMI (void)
 {
-    PrintTraceInstructionOrInterrupt("NMI");
+    TraceInstructionOrInterrupt (TRACE_REC_NMI);
 }
 
 
 
 void PrintTraceIRQ (void)
 {
-    PrintTraceInstructionOrInterrupt("IRQ");
+    TraceInstructionOrInterrupt (TRACE_REC_IRQ);
 }
 
 
 
 void PrintTraceInstruction (void)
 {
-    PrintTraceInstructionOrInterrupt(NULL);
+    TraceInstructionOrInterrupt (TRACE_REC_INSN);
 }
@@ -36,6 +36,10 @@
 #include <stdint.h>
 
 
+/* common */
+#include "thread.h"
+
+/* sim65 */
 #include "6502.h"
 
 /* The trace mode is a bitfield that determines how trace lines are displayed.
@@ -68,11 +72,32 @@
 #define TRACE_ENABLE_FULL           0x7f
 
 /* Currently active tracing mode. */
-extern uint8_t TraceMode;
+extern THREAD_LOCAL uint8_t TraceMode;
+
+unsigned GetInstructionLength (uint8_t Opcode);
+/* Return the number of bytes in the instruction with the given opcode for
+** the current CPU.
+*/
+
+void DisassembleInstruction (char * buf, uint16_t pc);
+/* Write the assembly text of the instruction at pc to buf, which must have
+ * room for at least 32 characters.
+ */
 
 void TraceInit (uint8_t SPAddr);
 /* Initialize the trace subsystem. */
 
+void TraceOpenFile (const char* Name);
+/* Write the trace to the given file in binary form instead of printing it.
+ * The file contains fixed-size records and is written in large blocks. It
+ * can be converted to the text format with TraceDecodeFile.
+ */
+
+void TraceDecodeFile (const char* Name);
+/* Print a binary trace file to stdout in the same format that is used when
+ * printing the trace directly.
+ */
+
 void PrintTraceNMI(void);
 /* Print trace line for an NMI interrupt. */
 
@@ -0,0 +1,78 @@
+; Verifies the 65816 core of sim65: native mode, 16 bit registers, long
+; addressing of the banks above bank zero and block moves.
+; sim65 --cpu 65816 sim65-65816.prg
+
+.p816
+.export _main
+
+.proc _main
+    ; switch to native mode with 16 bit registers
+    clc
+    xce
+    rep #$30
+.a16
+.i16
+
+    ; 16 bit arithmetic
+    lda #$1234
+    clc
+    adc #$4321
+    cmp #$5555
+    bne fail
+    xba
+    cmp #$5555
+    bne fail
+
+    ; banks above zero read as $FF before they are written
+    lda f:$020000
+    cmp #$FFFF
+    bne fail
+
+    ; store into bank 1 and read back
+    lda #$BEEF
+    sta f:$010000
+    ldx #$0002
+    lda #$CAFE
+    sta f:$010000,x
+    lda f:$010000
+    cmp #$BEEF
+    bne fail
+    lda f:$010002
+    cmp #$CAFE
+    bne fail
+
+    ; copy the four bytes to bank 2
+    lda #$0003
+    ldx #$0000
+    ldy #$1000
+    phb
+    mvn #$01,#$02
+    plb
+    lda f:$021000
+    cmp #$BEEF
+    bne fail
+    lda f:$021002
+    cmp #$CAFE
+    bne fail
+
+    ; bank zero is unchanged
+    lda $1000
+    cmp #$BEEF
+    beq fail
+
+    ; back to emulation mode for the exit
+    sep #$30
+.a8
+.i8
+    sec
+    xce
+    lda #0
+    rts
+
+fail:
+    sep #$30
+    sec
+    xce
+    lda #1
+    rts
+.endproc
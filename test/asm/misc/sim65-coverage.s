@@ -0,0 +1,33 @@
+; Verifies the coverage map and the report. The program is run without and
+; with an argument, and the report merges the two maps. One branch goes each
+; way in one of the runs, so it is covered only after merging.
+; sim65 --coverage sim65-coverage.1.cov --dbgfile sim65-coverage.dbg sim65-coverage.prg
+; sim65 --coverage sim65-coverage.2.cov --dbgfile sim65-coverage.dbg sim65-coverage.prg arg
+; sim65 --coverage-report sim65-coverage.txt sim65-coverage.1.cov sim65-coverage.2.cov
+; The lines of the report for this file must match sim65-coverage.ref.
+
+.export _main
+.import __argc
+.forceimport initmainargs
+
+.proc _main
+    lda __argc
+    cmp #2
+    bcc noarg               ; taken in the first run only
+    ldx #1
+    bne count               ; always taken
+noarg:
+    ldx #2
+count:
+    ldy #10
+loop:
+    dey
+    bne loop                ; taken and not taken
+    cpx #3
+    beq never               ; never taken
+    lda #0
+    rts
+never:
+    lda #1                  ; not executed
+    rts
+.endproc
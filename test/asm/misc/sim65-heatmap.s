@@ -0,0 +1,49 @@
+; Verifies the read and write counts of the heatmap, and the flag for reads
+; of memory that was never written. The BSS is cleared by the startup code,
+; so the uninitialized variable is outside of the program. The code is copied
+; to a fixed address, so the addresses in the report don't depend on the size
+; of the startup code.
+; sim65 --heatmap sim65-heatmap.txt --dbgfile sim65-heatmap.dbg sim65-heatmap.prg
+; The lines of the report for the variables must match sim65-heatmap.ref.
+
+.export _main
+
+; Never written
+unset           := $7100
+
+; Written once and read twice
+counted         := $7101
+
+; Ends the label range of counted
+unused          := $7102
+
+.rodata
+
+code:
+.org $7000
+
+run:
+    lda unset
+    lda unset
+    lda #1
+    sta counted
+    lda counted
+    lda counted
+    lda #0
+    rts
+
+code_end:
+.reloc
+code_size = code_end - run
+
+.code
+
+; Not a .proc: in a .proc, code_size could still be a local symbol defined
+; later, so its value wouldn't be known
+_main:
+    ; copy the code without a loop of its own
+    .repeat code_size, I
+    lda code+I
+    sta run+I
+    .endrepeat
+    jmp run
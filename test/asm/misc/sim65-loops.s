@@ -0,0 +1,66 @@
+; Verifies the loop report: the loop heads, the trips per activation, and
+; the page crossing penalties of absolute indexed and indirect indexed loads.
+; The loop is copied to a fixed address, so the addresses in the report don't
+; depend on the size of the startup code.
+; sim65 --loops sim65-loops.txt sim65-loops.prg
+; The report must match sim65-loops.ref.
+
+.export _main
+
+; The loads read the eight bytes before and after this page boundary
+table           := $7FF8
+
+; A zero page pointer at a fixed address, for the same reason
+ptr             := $80
+
+.rodata
+
+code:
+.org $7000
+code_start:
+
+; Each load crosses a page when its index is 8 or more
+count:
+    ldy #0
+@loop:
+    lda table,x
+    lda table,y
+    lda (ptr),y
+    iny
+    dex
+    bne @loop
+    rts
+
+; Runs the loop 10, 1, 4 and 20 times. The first activation is found when the
+; first back edge is taken.
+run:
+    lda #<table
+    sta ptr
+    lda #>table
+    sta ptr+1
+    ldx #10
+    jsr count
+    ldx #1
+    jsr count
+    ldx #4
+    jsr count
+    ldx #20
+    jsr count
+    lda #0
+    rts
+
+code_end:
+.reloc
+code_size = code_end - code_start
+
+.code
+
+; No .procs here: in a .proc, code_size and the zero page pointer could still
+; be local symbols defined later, so their values wouldn't be known
+_main:
+    ; copy the code without a loop of its own
+    .repeat code_size, I
+    lda code+I
+    sta code_start+I
+    .endrepeat
+    jmp run
@@ -0,0 +1,48 @@
+; Verifies that collecting a profile doesn't change the simulation.
+; sim65 -c sim65-profile.prg
+; sim65 -c --profile sim65-profile.prof --dbgfile sim65-profile.dbg sim65-profile.prg
+; Both must print the same number of cycles.
+
+.export _main
+
+.proc _main
+    ; add 1..100 ten times
+    lda #0
+    sta sum
+    sta sum+1
+    ldx #10
+loop:
+    jsr add100
+    dex
+    bne loop
+    ; check that the sum is 50500 ($C544)
+    lda sum
+    cmp #$44
+    bne fail
+    lda sum+1
+    cmp #$C5
+    bne fail
+    lda #0
+    rts
+fail:
+    lda #1
+    rts
+.endproc
+
+.proc add100
+    ldy #100
+loop:
+    tya
+    clc
+    adc sum
+    sta sum
+    bcc next
+    inc sum+1
+next:
+    dey
+    bne loop
+    rts
+.endproc
+
+.bss
+sum: .res 2
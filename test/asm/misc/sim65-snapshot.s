@@ -0,0 +1,54 @@
+; Verifies that a saved machine state continues like the original program.
+; sim65 -c --save-state sim65-snapshot.state --save-at 0x7F00 sim65-snapshot.prg
+; sim65 -c --load-state sim65-snapshot.state
+; Both must succeed and print the same number of cycles.
+
+.export _main
+
+; the state is saved when the PC reaches this address
+savepoint = $7F00
+
+.proc _main
+    ; copy "jmp resume" to the save point
+    ldx #2
+copy:
+    lda jump,x
+    sta savepoint,x
+    dex
+    bpl copy
+    ; some state in memory and registers
+    lda #$5A
+    sta value
+    lda #$12
+    ldx #$34
+    ldy #$56
+    sec
+    jmp savepoint
+resume:
+    ; check the registers and the memory
+    bcc fail
+    cmp #$12
+    bne fail
+    cpx #$34
+    bne fail
+    cpy #$56
+    bne fail
+    lda value
+    cmp #$5A
+    bne fail
+    ; spend some more cycles after the save point
+    ldx #0
+wait:
+    dex
+    bne wait
+    lda #0
+    rts
+fail:
+    lda #1
+    rts
+jump:
+    jmp resume
+.endproc
+
+.bss
+value: .res 1
@@ -0,0 +1,127 @@
+; Verifies the timer peripheral of sim65: a periodic IRQ, an IRQ that stays
+; pending while interrupts are disabled, and a one-shot NMI.
+; sim65 sim65-timer.prg
+
+.export _main
+
+TIMER_PERIOD    := $FFCC
+TIMER_CONTROL   := $FFD0
+TIMER_STATUS    := $FFD1
+
+TIMER_CONTROL_ENABLE    = $01
+TIMER_CONTROL_PERIODIC  = $02
+TIMER_CONTROL_NMI       = $04
+TIMER_STATUS_EXPIRED    = $01
+
+NMI_VECTOR      := $FFFA
+IRQ_VECTOR      := $FFFE
+
+.proc _main
+    sei
+    lda #<irq
+    sta IRQ_VECTOR
+    lda #>irq
+    sta IRQ_VECTOR+1
+    lda #<nmi
+    sta NMI_VECTOR
+    lda #>nmi
+    sta NMI_VECTOR+1
+
+    ; a periodic IRQ every 1000 cycles
+    lda #<1000
+    sta TIMER_PERIOD
+    lda #>1000
+    sta TIMER_PERIOD+1
+    lda #0
+    sta TIMER_PERIOD+2
+    sta TIMER_PERIOD+3
+    sta irqs
+    lda #TIMER_CONTROL_ENABLE | TIMER_CONTROL_PERIODIC
+    sta TIMER_CONTROL
+    cli
+wait5:
+    lda irqs
+    cmp #5
+    bcc wait5
+    sei
+    lda #0
+    sta TIMER_CONTROL
+    lda irqs
+    cmp #5
+    bne fail
+
+    ; the timer expires twice while interrupts are disabled, but only one
+    ; IRQ is taken
+    lda #0
+    sta irqs
+    lda #TIMER_CONTROL_ENABLE | TIMER_CONTROL_PERIODIC
+    sta TIMER_CONTROL
+    jsr delay
+    lda #0
+    sta TIMER_CONTROL
+    lda TIMER_STATUS
+    and #TIMER_STATUS_EXPIRED
+    beq fail
+    cli
+    nop
+    sei
+    lda irqs
+    cmp #1
+    bne fail
+
+    ; a one-shot NMI, which isn't masked by the I flag
+    lda #0
+    sta nmis
+    lda #TIMER_CONTROL_ENABLE | TIMER_CONTROL_NMI
+    sta TIMER_CONTROL
+    jsr delay
+    lda nmis
+    cmp #1
+    bne fail
+    lda TIMER_CONTROL
+    and #TIMER_CONTROL_ENABLE
+    bne fail
+
+    lda #0
+    rts
+
+fail:
+    lda #0
+    sta TIMER_CONTROL
+    lda #1
+    rts
+.endproc
+
+; waits for about 2800 cycles
+.proc delay
+    ldx #0
+loop:
+    nop
+    nop
+    nop
+    dex
+    bne loop
+    rts
+.endproc
+
+.proc irq
+    pha
+    lda #TIMER_STATUS_EXPIRED
+    sta TIMER_STATUS
+    inc irqs
+    pla
+    rti
+.endproc
+
+.proc nmi
+    pha
+    lda #TIMER_STATUS_EXPIRED
+    sta TIMER_STATUS
+    inc nmis
+    pla
+    rti
+.endproc
+
+.bss
+irqs: .res 1
+nmis: .res 1
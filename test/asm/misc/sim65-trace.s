@@ -0,0 +1,104 @@
+; Verifies that a binary trace decodes to the same text as the trace that
+; sim65 prints. The program selects other trace fields, turns the trace off
+; and on again, and takes an IRQ, so all record types are written. It writes
+; its output to stderr, so the output isn't mixed with the trace.
+; sim65 --trace sim65-trace.prg > sim65-trace.trace 2> sim65-trace.txt
+; sim65 --trace-file sim65-trace.bin sim65-trace.prg 2> sim65-trace.txt
+; sim65 --trace-decode sim65-trace.bin > sim65-trace.decoded
+; The two traces must be the same.
+
+.export _main
+.import _write
+.import pushax
+
+TRACE_MODE      := $FFCB
+TIMER_PERIOD    := $FFCC
+TIMER_CONTROL   := $FFD0
+TIMER_STATUS    := $FFD1
+
+TRACE_MODE_PC_ASM_REGS  = $16
+TRACE_MODE_FULL         = $7F
+
+TIMER_CONTROL_ENABLE    = $01
+TIMER_STATUS_EXPIRED    = $01
+
+IRQ_VECTOR      := $FFFE
+
+STDERR_FILENO   = 2
+
+.proc _main
+    ; only the PC, the instruction and the registers
+    lda #TRACE_MODE_PC_ASM_REGS
+    sta TRACE_MODE
+    ldx #3
+fields:
+    dex
+    bne fields
+
+    ; no trace at all, then the full trace again
+    lda #0
+    sta TRACE_MODE
+    ldx #50
+off:
+    dex
+    bne off
+    lda #TRACE_MODE_FULL
+    sta TRACE_MODE
+
+    ; a one-shot IRQ
+    sei
+    lda #<irq
+    sta IRQ_VECTOR
+    lda #>irq
+    sta IRQ_VECTOR+1
+    lda #50
+    sta TIMER_PERIOD
+    lda #0
+    sta TIMER_PERIOD+1
+    sta TIMER_PERIOD+2
+    sta TIMER_PERIOD+3
+    sta irqs
+    lda #TIMER_CONTROL_ENABLE
+    sta TIMER_CONTROL
+    cli
+wait:
+    lda irqs
+    beq wait
+    sei
+
+    ; write (STDERR_FILENO, msg, sizeof (msg))
+    lda #<STDERR_FILENO
+    ldx #>STDERR_FILENO
+    jsr pushax
+    lda #<msg
+    ldx #>msg
+    jsr pushax
+    lda #msglen
+    ldx #0
+    jsr _write
+    cmp #msglen
+    bne fail
+
+    lda #0
+    rts
+
+fail:
+    lda #1
+    rts
+.endproc
+
+.proc irq
+    pha
+    lda #TIMER_STATUS_EXPIRED
+    sta TIMER_STATUS
+    inc irqs
+    pla
+    rti
+.endproc
+
+.rodata
+msg: .byte "traced", $0A
+msglen = * - msg
+
+.bss
+irqs: .res 1
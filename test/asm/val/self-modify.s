@@ -0,0 +1,106 @@
+; test that sim65 notices changes to code that has already been executed
+; (the decoded insns and their operands are cached)
+
+        .import _exit
+        .export _main
+
+        .segment "DATA"
+
+target1:
+        .byte   $11
+target2:
+        .byte   $22
+
+        .segment "CODE"
+
+_main:
+        ldx     #1              ; test counter
+
+        ;---------------------------------------------------------------------
+        ; change the immediate operand of an insn that was executed before
+        ldy     #0
+imm:    lda     #$00
+        cpy     #0
+        bne     @L1
+        cmp     #$00
+        bne     exiterror
+        lda     #$42
+        sta     imm+1
+        iny
+        jmp     imm
+@L1:    cmp     #$42
+        bne     exiterror
+
+        ;---------------------------------------------------------------------
+        ; change the address of an absolute insn, one byte at a time
+        inx
+        ldy     #0
+abs:    lda     target1
+        cpy     #0
+        bne     @L2
+        cmp     #$11
+        bne     exiterror
+        lda     #<target2
+        sta     abs+1
+        lda     #>target2
+        sta     abs+2
+        iny
+        jmp     abs
+@L2:    cmp     #$22
+        bne     exiterror
+
+        ;---------------------------------------------------------------------
+        ; change the opcode
+        inx
+        ldy     #0
+opc:    lda     #$33
+        cpy     #0
+        bne     @L3
+        cmp     #$33
+        bne     exiterror
+        lda     #$A2            ; ldx #imm
+        sta     opc
+        iny
+        txa
+        pha
+        jmp     opc
+@L3:    cpx     #$33
+        bne     exiterror
+        pla
+        tax
+
+        ;---------------------------------------------------------------------
+        ; change an operand that is in the page following the opcode. No
+        ; code is executed in that page.
+        inx
+        ldy     #2
+@L4:    lda     cross,y
+        sta     crossaddr,y
+        dey
+        bpl     @L4
+        ldy     #0
+        jmp     crossaddr
+ret1:   cpy     #0
+        bne     exiterror
+        lda     #<ret2
+        sta     crossaddr+1
+        lda     #>ret2
+        sta     crossaddr+2
+        iny
+        jmp     crossaddr
+ret2:   cpy     #1
+        bne     exiterror
+
+        ; all tests passed
+        lda     #0
+        tax
+        jmp     _exit
+
+exiterror:
+        txa
+        ldx     #0
+        jmp     _exit
+
+        ; copied to the end of a page that is otherwise unused
+crossaddr = $7EFF
+cross:  jmp     ret1
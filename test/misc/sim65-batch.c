@@ -0,0 +1,9 @@
+/* Run by sim65 --batch with different arguments. The exit code is the number
+** of arguments, so the manifest can check that they are passed.
+*/
+
+int main (int argc, char* argv[])
+{
+    (void) argv;
+    return argc - 1;
+}
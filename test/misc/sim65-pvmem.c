@@ -0,0 +1,110 @@
+/* The memory and string functions of the pvmem module must give the same
+** results as the library, whether sim65 runs them natively or not. The test
+** is run with --pvmem native and with --pvmem emulated.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned failures = 0;
+
+static unsigned char buf[1024];
+static unsigned char ref[1024];
+static char str[600];
+
+static void check (const char* what, int ok)
+{
+    if (!ok) {
+        printf ("%s failed\n", what);
+        ++failures;
+    }
+}
+
+static void pattern (void)
+{
+    unsigned i;
+    for (i = 0; i < sizeof (buf); ++i) {
+        buf[i] = ref[i] = (unsigned char) (i * 7 + (i >> 8));
+    }
+}
+
+static int same (void)
+{
+    unsigned i;
+    for (i = 0; i < sizeof (buf); ++i) {
+        if (buf[i] != ref[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int sign (int v)
+{
+    return v < 0 ? -1 : v > 0;
+}
+
+int main (void)
+{
+    unsigned i;
+
+    /* memcpy of more than a page */
+    pattern ();
+    check ("memcpy result", memcpy (buf + 600, buf + 3, 300) == buf + 600);
+    for (i = 0; i < 300; ++i) {
+        ref[600 + i] = ref[3 + i];
+    }
+    check ("memcpy", same ());
+
+    /* memcpy of nothing */
+    pattern ();
+    memcpy (buf, buf + 100, 0);
+    check ("memcpy 0", same ());
+
+    /* memmove with overlapping blocks in both directions */
+    pattern ();
+    check ("memmove up result", memmove (buf + 10, buf, 500) == buf + 10);
+    for (i = 500; i-- > 0; ) {
+        ref[10 + i] = ref[i];
+    }
+    check ("memmove up", same ());
+
+    pattern ();
+    memmove (buf, buf + 10, 500);
+    for (i = 0; i < 500; ++i) {
+        ref[i] = ref[10 + i];
+    }
+    check ("memmove down", same ());
+
+    /* memset and bzero */
+    pattern ();
+    check ("memset result", memset (buf + 1, 0x1A5, 700) == buf + 1);
+    for (i = 0; i < 700; ++i) {
+        ref[1 + i] = 0xA5;
+    }
+    check ("memset", same ());
+
+    pattern ();
+    bzero (buf + 5, 257);
+    for (i = 0; i < 257; ++i) {
+        ref[5 + i] = 0;
+    }
+    check ("bzero", same ());
+
+    /* strlen of short and long strings */
+    check ("strlen 0", strlen ("") == 0);
+    memset (str, 'x', 599);
+    str[599] = '\0';
+    check ("strlen 599", strlen (str) == 599);
+    str[256] = '\0';
+    check ("strlen 256", strlen (str) == 256);
+
+    /* strcmp with equal strings, and differences in both directions */
+    check ("strcmp equal", strcmp ("sim65", "sim65") == 0);
+    check ("strcmp less", sign (strcmp ("sim65", "sim66")) == -1);
+    check ("strcmp greater", sign (strcmp ("sim65x", "sim65")) == 1);
+    check ("strcmp high", sign (strcmp ("\x80", "\x7F")) == 1);
+    check ("strcmp empty", sign (strcmp ("", "a")) == -1);
+
+    return failures;
+}
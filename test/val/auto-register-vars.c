@@ -0,0 +1,174 @@
+/* With auto-register-vars, the most used locals are moved into the register
+** bank, and locals whose live ranges don't overlap share the same register.
+** The register bank is saved on function entry and restored on every exit,
+** so callers, recursion and explicit register variables must not notice.
+** Locals whose address is taken must stay in memory.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#pragma auto-register-vars (on)
+
+static unsigned failures = 0;
+
+static void check (const char* what, long got, long expected)
+{
+    if (got != expected) {
+        printf ("%s: %ld, expected %ld\n", what, got, expected);
+        ++failures;
+    }
+}
+
+/* A loop with locals of different sizes */
+static long sums (const unsigned char* p, unsigned char n)
+{
+    unsigned char i;
+    unsigned s = 0;
+    long l = 0;
+    for (i = 0; i < n; ++i) {
+        s += p[i];
+        l += (long) p[i] << 12;
+    }
+    return l + s;
+}
+
+/* Two loops whose variables don't live at the same time */
+static unsigned twoloops (unsigned char n)
+{
+    unsigned r = 0;
+    unsigned char i;
+    unsigned j;
+    for (i = 0; i < n; ++i) {
+        r += i;
+    }
+    for (j = 1000; j < 1000 + n; ++j) {
+        r += j & 0x0F;
+    }
+    return r;
+}
+
+/* Direct recursion with a loop around the call */
+static unsigned tree (unsigned char depth)
+{
+    unsigned char i;
+    unsigned count = 1;
+    if (depth > 0) {
+        for (i = 0; i < 2; ++i) {
+            count += tree (depth - 1);
+        }
+    }
+    return count;
+}
+
+/* Indirect recursion */
+static unsigned char ping (unsigned char n);
+
+static unsigned char pong (unsigned char n)
+{
+    unsigned char i, r = 0;
+    for (i = 0; i < 2 && n > 0; ++i) {
+        r += ping (n - 1);
+    }
+    return r + 1;
+}
+
+static unsigned char ping (unsigned char n)
+{
+    unsigned char i, r = 0;
+    for (i = 0; i < 1 && n > 0; ++i) {
+        r += pong (n - 1);
+    }
+    return r;
+}
+
+/* Recursion through a function pointer */
+static unsigned (*again) (unsigned char);
+
+static unsigned through (unsigned char n)
+{
+    unsigned char i;
+    unsigned s = 0;
+    for (i = 0; i < n; ++i) {
+        s += again (i);
+    }
+    return s + n;
+}
+
+/* Locals whose address is taken */
+static void twice (unsigned* p)
+{
+    unsigned char i;
+    for (i = 0; i < 4; ++i) {
+        *p += *p;
+    }
+}
+
+static unsigned addr (void)
+{
+    unsigned char i;
+    unsigned v = 1;
+    unsigned* p = &v;
+    unsigned s = 0;
+    for (i = 0; i < 3; ++i) {
+        twice (p);
+        s += v;
+    }
+    return s;
+}
+
+/* Early returns from inside a loop */
+static int find (const char* s, char c)
+{
+    unsigned char i;
+    for (i = 0; s[i]; ++i) {
+        if (s[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* An explicit register variable in the caller */
+static unsigned explicit (const unsigned char* p, unsigned char n)
+{
+    register const unsigned char* q = p;
+    unsigned char i;
+    unsigned s = 0;
+    for (i = 0; i < n; ++i) {
+        s += *q++;
+        s += twoloops (i);
+    }
+    return s;
+}
+
+int main (void)
+{
+    static unsigned char data[20];
+    unsigned char i;
+    unsigned expected;
+    unsigned r;
+
+    for (i = 0; i < sizeof (data); ++i) {
+        data[i] = i * 13;
+    }
+
+    check ("sums", sums (data, 20), 2470L * 4096L + 2470L);
+    check ("twoloops", twoloops (20), 190 + 92 + 66);
+    check ("tree", tree (6), 127);
+    check ("ping", ping (6), 7);
+    again = through;
+    check ("through", through (4), 15);
+    check ("addr", addr (), 16 + 256 + 4096);
+    check ("find 1", find ("register", 's'), 4);
+    check ("find 2", find ("register", 'x'), -1);
+
+    expected = 0;
+    for (i = 0; i < 10; ++i) {
+        expected += data[i] + twoloops (i);
+    }
+    r = explicit (data, 10);
+    check ("explicit", r, expected);
+
+    return failures;
+}
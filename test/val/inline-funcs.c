@@ -0,0 +1,142 @@
+/* Calls of small static and inline functions are replaced by a copy of their
+** code if larger code is acceptable. The code size pragma makes this happen
+** for all optimized builds, not only for -Oi.
+*/
+
+#include <stdio.h>
+
+#pragma codesize (200)
+
+static unsigned failures = 0;
+
+static unsigned char twice (unsigned char x)
+{
+    return x + x;
+}
+
+inline unsigned char maxc (unsigned char a, unsigned char b)
+{
+    return a > b ? a : b;
+}
+
+static unsigned char quad (unsigned char x)
+{
+    /* Tail call of another candidate */
+    return twice (twice (x));
+}
+
+static unsigned char once (unsigned char n)
+{
+    unsigned char i, s = 0;
+    for (i = 0; i < n; ++i) {
+        s += i;
+    }
+    return s;
+}
+
+static void early (unsigned char x, unsigned char* p)
+{
+    if (x > 10) {
+        *p = 1;
+        return;
+    }
+    *p = 2;
+}
+
+static long lsum (long a, long b)
+{
+    return a + b;
+}
+
+static const char* name (unsigned char x)
+{
+    switch (x) {
+        case 0:  return "zero";
+        case 1:  return "one";
+        case 2:  return "two";
+        case 3:  return "three";
+        case 4:  return "four";
+        default: return "many";
+    }
+}
+
+static int fact (int n)
+{
+    return n <= 1 ? 1 : n * fact (n - 1);
+}
+
+static int even (unsigned n);
+
+static int odd (unsigned n)
+{
+    return n == 0 ? 0 : even (n - 1);
+}
+
+static int even (unsigned n)
+{
+    return n == 0 ? 1 : odd (n - 1);
+}
+
+static int inc (int x)
+{
+    return x + 1;
+}
+
+static int dec (int x)
+{
+    return x - 1;
+}
+
+/* inc is called directly as well, dec only through the table */
+static int (* const ops[2]) (int) = { inc, dec };
+
+static int apply (int (*f) (int), int x)
+{
+    return f (x);
+}
+
+static void check (const char* what, long got, long expected)
+{
+    if (got != expected) {
+        printf ("%s: %ld, expected %ld\n", what, got, expected);
+        ++failures;
+    }
+}
+
+int main (void)
+{
+    unsigned char c;
+    unsigned char i;
+
+    check ("twice", twice (21), 42);
+    check ("maxc 1", maxc (3, 7), 7);
+    check ("maxc 2", maxc (200, 7), 200);
+    check ("quad", quad (5), 20);
+    check ("once", once (10), 45);
+
+    early (20, &c);
+    check ("early 1", c, 1);
+    early (5, &c);
+    check ("early 2", c, 2);
+
+    check ("lsum", lsum (100000L, -1L), 99999L);
+    check ("name", name (3)[0], 't');
+    check ("name default", name (9)[0], 'm');
+
+    check ("fact", fact (7), 5040);
+    check ("even", even (10), 1);
+    check ("odd", odd (7), 1);
+
+    check ("inc", inc (1), 2);
+    check ("ops[0]", ops[0] (5), 6);
+    check ("ops[1]", ops[1] (5), 4);
+    check ("apply", apply (&inc, 9), 10);
+    check ("addr", ops[0] == &inc, 1);
+
+    for (i = 0, c = 0; i < 10; ++i) {
+        c = maxc (c, twice (i));
+    }
+    check ("loop", c, 18);
+
+    return failures;
+}
@@ -0,0 +1,80 @@
+/* The optimizer may keep a loop index in the y register only if nothing in
+** the loop accesses the index variable through a pointer. Zero page
+** variables may be pointed to like any other variable.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned failures = 0;
+
+unsigned char arr[10];
+
+#pragma data-name(push, "ZEROPAGE", "zp")
+#pragma bss-name(push, "ZEROPAGE", "zp")
+struct {
+    unsigned char buf[3];
+    unsigned char i;            /* Same as buf[3] */
+    unsigned char pad[6];
+} z;
+unsigned char* zp;
+#pragma bss-name(pop)
+#pragma data-name(pop)
+
+void store (void)
+{
+    for (z.i = 0; z.i < 10; ++z.i) {
+        arr[z.i] = 1;
+        zp[z.i] = 7;
+    }
+}
+
+void load (void)
+{
+    for (z.i = 0; z.i < 10; ++z.i) {
+        arr[z.i] = 2;
+        if (zp[z.i] != 0) {
+            break;
+        }
+    }
+}
+
+unsigned sum (void)
+{
+    unsigned s = 0;
+    unsigned char k;
+    for (k = 0; k < 10; ++k) {
+        s += arr[k];
+    }
+    return s;
+}
+
+int main (void)
+{
+    unsigned s;
+
+    zp = z.buf;
+
+    /* Storing 7 into zp[3] changes the index, so only the elements 0..3
+    ** and 8..9 are set.
+    */
+    memset (arr, 0, sizeof (arr));
+    store ();
+    s = sum ();
+    if (s != 6) {
+        printf ("store: sum is %u, expected 6\n", s);
+        ++failures;
+    }
+
+    /* zp[3] is the index itself and the first non zero element */
+    memset (arr, 0, sizeof (arr));
+    memset (&z, 0, sizeof (z));
+    load ();
+    s = sum ();
+    if (s != 8) {
+        printf ("load: sum is %u, expected 8\n", s);
+        ++failures;
+    }
+
+    return failures;
+}
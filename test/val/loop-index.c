@@ -0,0 +1,192 @@
+/* Array accesses with an unsigned char index, accesses through pointers and
+** pointer increments are rewritten to use the y register, and loop indices in
+** memory may be kept in y while the loop runs. Check the results where the
+** index or the pointer is used in other ways, too.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned failures = 0;
+
+static void check (const char* what, unsigned got, unsigned expected)
+{
+    if (got != expected) {
+        printf ("%s: %u, expected %u\n", what, got, expected);
+        ++failures;
+    }
+}
+
+struct rec {
+    unsigned char a;
+    unsigned      b;
+    unsigned char c[3];
+};
+
+unsigned char arr[256];
+unsigned char want;
+unsigned sum;
+struct rec recs[4];
+
+/* Indexed accesses may reach any variable outside of the zero page, so only
+** indices in the zero page can be kept in y.
+*/
+#pragma bss-name(push, "ZEROPAGE", "zp")
+unsigned char idx;
+struct rec* rp;
+unsigned char* zp;
+unsigned char* ip;
+#pragma bss-name(pop)
+
+/* Accesses through a pointer variable with constant offsets */
+static void members (void)
+{
+    rp = &recs[2];
+    rp->a = 7;
+    rp->b = 1000;
+    rp->c[2] = rp->a + 1;
+    sum = rp->a + rp->b + rp->c[2];
+}
+
+/* Array elements with an index in a variable */
+static void elements (void)
+{
+    arr[idx] = 10;
+    zp[idx] = arr[idx] + 1;
+    sum = arr[idx] + zp[idx];
+}
+
+/* Increments of pointers in memory, also across a page boundary. The
+** pointer is in a static frame here.
+*/
+#pragma static-frames (push, on)
+static void increments (void)
+{
+    unsigned char* p;
+    unsigned n = 0;
+    for (p = arr; p < arr + sizeof (arr); p += 3) {
+        n += *p;
+    }
+    for (p = arr; *p != 2; ++p) {
+        ++n;
+    }
+    sum = n + (p - arr);
+}
+#pragma static-frames (pop)
+
+/* The index is read by a called function */
+static void addidx (void)
+{
+    sum += idx;
+}
+
+static void called (void)
+{
+    sum = 0;
+    for (idx = 0; idx < 10; ++idx) {
+        arr[idx] = idx;
+        addidx ();
+    }
+}
+
+/* The loop is left early, so the index must be stored back */
+static void early (void)
+{
+    for (idx = 0; idx < 200; ++idx) {
+        if (arr[idx] == want) {
+            break;
+        }
+    }
+}
+
+/* The index is changed in the loop body */
+static void changed (void)
+{
+    sum = 0;
+    for (idx = 0; idx < 20; ++idx) {
+        sum += arr[idx];
+        if (arr[idx] == 5) {
+            idx += 3;
+        }
+    }
+}
+
+/* A loop that doesn't change the index */
+static void constant (void)
+{
+    unsigned char n;
+    for (n = 0; n < 5; ++n) {
+        arr[idx] += n;
+    }
+}
+
+/* The index is written through a pointer */
+static void aliased (void)
+{
+    for (idx = 0; idx < 10; ++idx) {
+        arr[idx] = 0xFF;
+        if (idx == 2) {
+            *ip = 6;
+        }
+    }
+}
+
+int main (void)
+{
+    static unsigned char zbuf[16];
+    unsigned char i;
+    unsigned s;
+
+    zp = zbuf;
+
+    members ();
+    check ("members", sum, 7 + 1000 + 8);
+    check ("members c", recs[2].c[2], 8);
+
+    idx = 4;
+    elements ();
+    check ("elements", sum, 10 + 11);
+    check ("zp", zbuf[4], 11);
+
+    for (s = 0; s < 256; ++s) {
+        arr[s] = 1;
+    }
+    arr[255] = 2;
+    increments ();
+    check ("increments", sum, 86 + 1 + 255 + 255);
+
+    called ();
+    check ("called", sum, 45);
+    check ("called idx", idx, 10);
+
+    for (s = 0; s < 256; ++s) {
+        arr[s] = s;
+    }
+    want = 77;
+    early ();
+    check ("early 1", idx, 77);
+    want = 250;
+    early ();
+    check ("early 2", idx, 200);
+
+    changed ();
+    check ("changed", sum, 0 + 1 + 2 + 3 + 4 + 5 + 9 + 10 + 11 + 12 + 13 +
+                           14 + 15 + 16 + 17 + 18 + 19);
+    check ("changed idx", idx, 20);
+
+    idx = 30;
+    constant ();
+    check ("constant", arr[30], 30 + 10);
+    check ("constant idx", idx, 30);
+
+    memset (arr, 0, sizeof (arr));
+    ip = &idx;
+    aliased ();
+    check ("aliased idx", idx, 10);
+    for (s = 0, i = 0; i < 20; ++i) {
+        s += arr[i];
+    }
+    check ("aliased sum", s, 6 * 0xFF);
+
+    return failures;
+}
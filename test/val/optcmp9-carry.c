@@ -0,0 +1,54 @@
+/* OptCmp9 replaced "asl a; bcc L" by "bpl L" even if the code at L relied on
+** the carry being clear. OptJumpTarget2 creates such code when it moves a
+** "clc" in front of the branch target. Static frames turn the loop below
+** into that shape.
+*/
+
+#include <stdio.h>
+
+#pragma static-frames (on)
+
+static unsigned failures = 0;
+
+static int cmp (int a, int b)
+{
+    return a < b ? -1 : a > b;
+}
+
+static void swap (int* a, int* b)
+{
+    int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void bsort (int* v, unsigned char n)
+{
+    unsigned char i, j;
+    for (i = 0; i + 1 < n; ++i) {
+        for (j = 0; j + 1 < n - i; ++j) {
+            if (cmp (v[j], v[j + 1]) > 0) {
+                swap (&v[j], &v[j + 1]);
+            }
+        }
+    }
+}
+
+int main (void)
+{
+    int v[40];
+    unsigned char i;
+
+    for (i = 0; i < 40; ++i) {
+        v[i] = (i * 37) % 41 - 20;
+    }
+    bsort (v, 40);
+    for (i = 1; i < 40; ++i) {
+        if (v[i - 1] > v[i]) {
+            printf ("v[%u] = %d > v[%u] = %d\n", i - 1, v[i - 1], i, v[i]);
+            ++failures;
+        }
+    }
+
+    return failures;
+}
@@ -0,0 +1,53 @@
+/* OptStore5 changed
+**
+**      lda     a
+**      ldx     b
+**      sta     b
+**      stx     a
+**
+** into code that reads a after it has been overwritten. Register variables
+** in static frames are swapped on function entry with exactly this code.
+*/
+
+#include <stdio.h>
+
+#pragma static-frames (on)
+#pragma auto-register-vars (on)
+
+static unsigned failures = 0;
+
+unsigned char g[8];
+
+static unsigned char sum (unsigned char n)
+{
+    unsigned char i, s = 0;
+    for (i = 0; i < n; ++i) {
+        s += g[i];
+    }
+    return s;
+}
+
+static unsigned char sums (unsigned char n)
+{
+    unsigned char i, s = 0;
+    for (i = 0; i < n; ++i) {
+        s += sum (i);
+    }
+    return s;
+}
+
+int main (void)
+{
+    unsigned char i, s;
+
+    for (i = 0; i < 8; ++i) {
+        g[i] = i + 1;
+    }
+    s = sums (8);
+    if (s != 84) {
+        printf ("sums (8) = %u, expected 84\n", s);
+        ++failures;
+    }
+
+    return failures;
+}
@@ -0,0 +1,85 @@
+/* A call through a function pointer may reach any function whose address is
+** taken, and from there everything these functions call. Functions that may
+** be reentered this way must keep their frames on the C stack.
+*/
+
+#include <stdio.h>
+
+#pragma static-frames (on)
+
+static unsigned failures = 0;
+
+static void check (const char* what, int got, int expected)
+{
+    if (got != expected) {
+        printf ("%s: %d, expected %d\n", what, got, expected);
+        ++failures;
+    }
+}
+
+/* Recursion through a pointer to the function itself */
+static int walk (int depth);
+
+static int (*walker) (int) = walk;
+
+static int walk (int depth)
+{
+    int here = depth * 3;
+    if (depth > 0) {
+        here += walker (depth - 1);
+    }
+    return here;
+}
+
+/* Indirect recursion through a pointer: visit is called directly, and calls
+** itself through step.
+*/
+static int visit (unsigned char n);
+
+static int step (unsigned char n)
+{
+    unsigned char k = n;
+    return visit (k - 1) + k;
+}
+
+static int (*stepper) (unsigned char) = step;
+
+static int visit (unsigned char n)
+{
+    unsigned char m = n;
+    int r = 0;
+    if (m > 0) {
+        r = stepper (m);
+    }
+    return r + m;
+}
+
+/* The address of a local is passed through a callback that reenters the
+** function.
+*/
+static void (*hook) (unsigned char* p, unsigned char depth);
+
+static unsigned char inner (unsigned char depth)
+{
+    unsigned char v = depth;
+    if (depth > 0) {
+        hook (&v, depth - 1);
+    }
+    return v;
+}
+
+static void bump (unsigned char* p, unsigned char depth)
+{
+    *p += inner (depth);
+}
+
+int main (void)
+{
+    check ("walk", walk (10), 165);
+    check ("visit", visit (10), 2 * 55);
+
+    hook = bump;
+    check ("inner", inner (5), 15);
+
+    return failures;
+}
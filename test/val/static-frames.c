@@ -0,0 +1,171 @@
+/* With static frames, the locals and parameters of functions that can't be
+** active more than once are kept in fixed memory instead of the C stack, and
+** frames of functions that are never active at the same time share memory.
+** Recursion, callbacks from library code, and locals whose address escapes
+** must still work.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma static-frames (on)
+
+static unsigned failures = 0;
+
+static void check (const char* what, long got, long expected)
+{
+    if (got != expected) {
+        printf ("%s: %ld, expected %ld\n", what, got, expected);
+        ++failures;
+    }
+}
+
+/* Direct recursion */
+static long fact (unsigned char n)
+{
+    long r = 1;
+    if (n > 1) {
+        r = n * fact (n - 1);
+    }
+    return r;
+}
+
+/* Indirect recursion */
+static unsigned char odd (unsigned char n);
+
+static unsigned char even (unsigned char n)
+{
+    unsigned char r = 1;
+    if (n > 0) {
+        r = odd (n - 1);
+    }
+    return r;
+}
+
+static unsigned char odd (unsigned char n)
+{
+    unsigned char r = 0;
+    if (n > 0) {
+        r = even (n - 1);
+    }
+    return r;
+}
+
+/* A callback from library code */
+static int cmp_calls = 0;
+
+static int cmp (const void* a, const void* b)
+{
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    ++cmp_calls;
+    return x < y ? -1 : x > y;
+}
+
+static int sorted (int* v, unsigned n)
+{
+    unsigned i;
+    qsort (v, n, sizeof (v[0]), cmp);
+    for (i = 1; i < n; ++i) {
+        if (v[i - 1] > v[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Locals whose address is passed to other functions */
+static void fill (unsigned char* p, unsigned char n, unsigned char v)
+{
+    unsigned char i;
+    for (i = 0; i < n; ++i) {
+        p[i] = v + i;
+    }
+}
+
+static unsigned char* saved;
+
+static void keep (unsigned char* p)
+{
+    saved = p;
+}
+
+static unsigned use_saved (void)
+{
+    /* Has locals of its own that must not overlap the caller's */
+    unsigned char tmp[8];
+    unsigned s = 0;
+    unsigned char i;
+    fill (tmp, sizeof (tmp), 100);
+    for (i = 0; i < 4; ++i) {
+        s += saved[i];
+    }
+    return s + tmp[7];
+}
+
+static unsigned escape (void)
+{
+    unsigned char buf[4];
+    unsigned char k = 5;
+    unsigned r;
+    fill (buf, sizeof (buf), k);
+    keep (buf);
+    r = use_saved ();
+    return r + buf[3];
+}
+
+/* The address of a local is kept in a pointer during a call that reenters
+** the function.
+*/
+static unsigned nested (unsigned char depth)
+{
+    unsigned char v = depth;
+    unsigned char* p = &v;
+    unsigned r = 0;
+    if (depth > 0) {
+        r = nested (depth - 1);
+    }
+    return r + *p;
+}
+
+/* Parameters of all sizes, and a struct local */
+struct pt {
+    int x;
+    long y;
+};
+
+static long mix (unsigned char a, int b, long c, struct pt* q)
+{
+    struct pt p;
+    p.x = a + b;
+    p.y = c;
+    *q = p;
+    return p.x + p.y;
+}
+
+int main (void)
+{
+    static int v[20];
+    struct pt q;
+    unsigned char i;
+
+    check ("fact", fact (10), 3628800L);
+    check ("even", even (11), 0);
+    check ("odd", odd (11), 1);
+
+    for (i = 0; i < 20; ++i) {
+        v[i] = (i * 7) % 20 - 10;
+    }
+    check ("qsort", sorted (v, 20), 1);
+    check ("qsort calls", cmp_calls > 0, 1);
+
+    check ("escape", escape (), 5 + 6 + 7 + 8 + 107 + 8);
+    check ("nested", nested (10), 55);
+
+    check ("mix", mix (200, -1000, 100000L, &q), 100000L - 800);
+    check ("mix x", q.x, -800);
+    check ("mix y", q.y, 100000L);
+
+    return failures;
+}
@@ -0,0 +1,213 @@
+/* Switch statements are compiled into jump tables, a binary search or a
+** chain of compares, depending on the case values and the code size factor.
+** Check all values against a reference that doesn't use a switch.
+*/
+
+#include <stdio.h>
+
+static unsigned failures = 0;
+
+static void check (const char* what, int v, int got, int expected)
+{
+    if (got != expected) {
+        printf ("%s (%d): %d, expected %d\n", what, v, got, expected);
+        ++failures;
+    }
+}
+
+/* Dense values with gaps, a shared label and a fallthrough */
+static int dense (unsigned char v)
+{
+    int r = 0;
+    switch (v) {
+        case 2:  r = 20; break;
+        case 3:  r = 30; break;
+        case 4:
+        case 5:  r = 45; break;
+        case 6:  r = 60; break;
+        case 8:  r = 1;         /* Fallthrough */
+        case 9:  r += 90; break;
+        case 10: r = 100; break;
+        case 11: r = 110; break;
+        case 13: r = 130; break;
+        case 14: return 140;
+        default: r = -1; break;
+    }
+    return r;
+}
+
+static int dense_ref (unsigned char v)
+{
+    if (v == 2)  return 20;
+    if (v == 3)  return 30;
+    if (v == 4 || v == 5) return 45;
+    if (v == 6)  return 60;
+    if (v == 8)  return 91;
+    if (v == 9)  return 90;
+    if (v == 10) return 100;
+    if (v == 11) return 110;
+    if (v == 13) return 130;
+    if (v == 14) return 140;
+    return -1;
+}
+
+/* Sparse values over the whole range of a char */
+static int sparse (unsigned char v)
+{
+    switch (v) {
+        case 0:   return 1;
+        case 7:   return 2;
+        case 31:  return 3;
+        case 64:  return 4;
+        case 100: return 5;
+        case 127: return 6;
+        case 128: return 7;
+        case 150: return 8;
+        case 200: return 9;
+        case 254: return 10;
+        case 255: return 11;
+    }
+    return 0;
+}
+
+static int sparse_ref (unsigned char v)
+{
+    static const unsigned char Vals[] = {
+        0, 7, 31, 64, 100, 127, 128, 150, 200, 254, 255
+    };
+    unsigned char I;
+    for (I = 0; I < sizeof (Vals); ++I) {
+        if (Vals[I] == v) {
+            return I + 1;
+        }
+    }
+    return 0;
+}
+
+/* Few values */
+static int small (unsigned char v)
+{
+    switch (v) {
+        case 1:  return 10;
+        case 3:  return 30;
+        case 200: return 2000;
+        default: return 0;
+    }
+}
+
+static int small_ref (unsigned char v)
+{
+    return v == 1? 10 : v == 3? 30 : v == 200? 2000 : 0;
+}
+
+/* Signed values around zero */
+static int signed_range (signed char v)
+{
+    switch (v) {
+        case -128: return -1280;
+        case -9:   return -90;
+        case -8:   return -80;
+        case -7:   return -70;
+        case -5:   return -50;
+        case -4:   return -40;
+        case -2:   return -20;
+        case -1:   return -10;
+        case 0:    return 1;
+        case 1:    return 10;
+        case 3:    return 30;
+        case 4:    return 40;
+        case 6:    return 60;
+        case 127:  return 1270;
+        default:   return 0;
+    }
+}
+
+static int signed_ref (signed char v)
+{
+    if (v == 0) {
+        return 1;
+    }
+    if (v == -128 || v == 127 || (v >= -9 && v <= 6 &&
+        v != -6 && v != -3 && v != 2 && v != 5)) {
+        return v * 10;
+    }
+    return 0;
+}
+
+/* Values that need more than one byte */
+static int wide (int v)
+{
+    switch (v) {
+        case -1000: return 1;
+        case -1:    return 2;
+        case 0:     return 3;
+        case 1:     return 4;
+        case 2:     return 5;
+        case 3:     return 6;
+        case 4:     return 7;
+        case 5:     return 8;
+        case 255:   return 9;
+        case 256:   return 10;
+        case 257:   return 11;
+        case 1000:  return 12;
+    }
+    return 0;
+}
+
+static int wide_ref (int v)
+{
+    static const int Vals[] = {
+        -1000, -1, 0, 1, 2, 3, 4, 5, 255, 256, 257, 1000
+    };
+    unsigned char I;
+    for (I = 0; I < sizeof (Vals) / sizeof (Vals[0]); ++I) {
+        if (Vals[I] == v) {
+            return I + 1;
+        }
+    }
+    return 0;
+}
+
+/* Ranges at the size limit of a jump table */
+#define C(n)    case n: return n + 1;
+#define C10(n)  C(n) C(n+1) C(n+2) C(n+3) C(n+4) C(n+5) C(n+6) C(n+7) C(n+8) C(n+9)
+
+static int range126 (unsigned char v)
+{
+    switch (v) {
+        C10(10) C10(20) C10(30) C10(40) C10(50) C10(60)
+        C10(70) C10(80) C10(90) C10(100) C10(110) C10(120)
+        C(130) C(131) C(132) C(133) C(134) C(135)
+    }
+    return 0;
+}
+
+static int range127 (unsigned char v)
+{
+    switch (v) {
+        C10(10) C10(20) C10(30) C10(40) C10(50) C10(60)
+        C10(70) C10(80) C10(90) C10(100) C10(110) C10(120)
+        C(130) C(131) C(132) C(133) C(134) C(135) C(136)
+    }
+    return 0;
+}
+
+int main (void)
+{
+    unsigned V;
+    int W;
+
+    for (V = 0; V < 256; ++V) {
+        check ("dense", V, dense (V), dense_ref (V));
+        check ("sparse", V, sparse (V), sparse_ref (V));
+        check ("small", V, small (V), small_ref (V));
+        check ("signed", (signed char) V, signed_range (V), signed_ref (V));
+        check ("range126", V, range126 (V), V >= 10 && V <= 135? V + 1 : 0);
+        check ("range127", V, range127 (V), V >= 10 && V <= 136? V + 1 : 0);
+    }
+    for (W = -1100; W <= 1100; ++W) {
+        check ("wide", W, wide (W), wide_ref (W));
+    }
+
+    return failures;
+}